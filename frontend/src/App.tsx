@@ -10,6 +10,7 @@ import {
   riskLevel,
   type AppRuleKind,
   type AppRuleRecord,
+  type DistractionForecast,
   type FocusLabel,
   type PredictionRecord,
   type SessionRecord,
@@ -29,17 +30,17 @@ const buildSignals = (record: PredictionRecord | null) => {
 
   const level = riskLevel(record.distractionRisk);
   const signals = [
-    `Focus state: ${focusStateLabel(record.focusState)}`,
+    `Focus state: ${focusStateLabel(record.smoothedState)}`,
     `Thrash: ${(record.thrashScore * 100).toFixed(0)}% · Drift: ${(record.driftScore * 100).toFixed(0)}% · Goal fit: ${(record.goalAlignment * 100).toFixed(0)}%`,
     `Risk level: ${level}`,
     `Focus score: ${formatScore(record.focusScore)}`,
   ];
 
-  if (record.focusState === "PSEUDO_PRODUCTIVE") {
+  if (record.smoothedState === "PSEUDO_PRODUCTIVE") {
     signals.push("Drift detected — tab/title churn or scattered typing in a work app.");
   } else if (record.thrashScore >= 0.6) {
     signals.push("Context-switch thrash — jumping between apps/windows rapidly.");
-  } else if (record.focusState === "DEEP_FOCUS") {
+  } else if (record.smoothedState === "DEEP_FOCUS") {
     signals.push("Deep work detected. Hyperfocus guardrail is watching.");
   } else if (level === "low") {
     signals.push("Focus is stable. Keep momentum.");
@@ -53,6 +54,7 @@ export default function App() {
   const [captureRunning, setCaptureRunning] = useState(false);
   const [permissionMessage, setPermissionMessage] = useState<string | null>(null);
   const [prediction, setPrediction] = useState<PredictionRecord | null>(null);
+  const [forecast, setForecast] = useState<DistractionForecast | null>(null);
   const [predictionHistory, setPredictionHistory] = useState<PredictionRecord[]>([]);
   const [sessionGoal, setSessionGoal] = useState("");
   const [sessionRecord, setSessionRecord] = useState<SessionRecord | null>(null);
@@ -151,6 +153,7 @@ export default function App() {
         setHyperfocusNote(payload.message);
       }),
     );
+    unsubs.push(api.onDistractionForecast(setForecast));
 
     return () => {
       void Promise.all(unsubs).then((handlers) => handlers.forEach((off) => off()));
@@ -295,10 +298,14 @@ export default function App() {
               <p className="metric-label">Distraction risk</p>
               <p className="metric-value">{formatPercent(prediction?.distractionRisk ?? null)}</p>
             </div>
+            <div className="metric">
+              <p className="metric-label">Distraction within 1 min</p>
+              <p className="metric-value">{formatPercent(forecast?.probability[1] ?? null)}</p>
+            </div>
             <div className="metric">
               <p className="metric-label">State</p>
               <p className="metric-value state-value">
-                {focusStateLabel(prediction?.focusState ?? null)}
+                {focusStateLabel(prediction?.smoothedState ?? null)}
               </p>
             </div>
           </div>
@@ -8,12 +8,20 @@ export type PredictionRecord = {
   focusScore: number;
   distractionRisk: number;
   focusState: string;
+  smoothedState: string;
   thrashScore: number;
   driftScore: number;
   goalAlignment: number;
+  timestampUs: number;
   timestamp: string;
 };
 
+export type DistractionForecast = {
+  timestampUs: number;
+  horizonSecs: number[];
+  probability: number[];
+};
+
 export type SessionRecord = {
   sessionId: string;
   goal: string;
@@ -29,9 +37,27 @@ export type PermissionStatus = {
   message: string;
 };
 
+export type CaptureSourceHealth = {
+  source: string;
+  alive: boolean;
+  eventsTotal: number;
+  eventsPerSec: number;
+  lastEventAgeMs: number | null;
+  lastHeartbeatAgeMs: number | null;
+  restarts: number;
+  lastError: string | null;
+};
+
+export type CaptureHealth = {
+  running: boolean;
+  paused: boolean;
+  sources: CaptureSourceHealth[];
+};
+
 export type HealthStatus = {
   status: string;
   captureRunning: boolean;
+  capture: CaptureHealth;
   permissions: PermissionStatus;
 };
 
@@ -75,15 +101,23 @@ function mapAppRule(raw: Record<string, unknown>): AppRuleRecord {
 }
 
 function mapPrediction(raw: Record<string, unknown>): PredictionRecord {
+  const timestampUs = Number(raw.timestamp_us ?? raw.timestampUs ?? 0);
+  const focusState = String(raw.focus_state ?? raw.focusState ?? "UNKNOWN");
   return {
     sessionId: String(raw.session_id ?? raw.sessionId ?? ""),
     focusScore: Number(raw.focus_score ?? raw.focusScore ?? 0),
     distractionRisk: Number(raw.distraction_risk ?? raw.distractionRisk ?? 0),
-    focusState: String(raw.focus_state ?? raw.focusState ?? "UNKNOWN"),
+    focusState,
+    // Stored records carry no smoothed state; fall back to the raw one.
+    smoothedState: String(raw.smoothed_state || raw.smoothedState || focusState),
     thrashScore: Number(raw.thrash_score ?? raw.thrashScore ?? 0),
     driftScore: Number(raw.drift_score ?? raw.driftScore ?? 0),
     goalAlignment: Number(raw.goal_alignment ?? raw.goalAlignment ?? 0.5),
-    timestamp: String(raw.timestamp ?? ""),
+    timestampUs,
+    // Live predictions carry only the clock reading; stored ones also have text.
+    timestamp: String(
+      raw.timestamp || (timestampUs ? new Date(timestampUs / 1000).toISOString() : ""),
+    ),
   };
 }
 
@@ -140,6 +174,7 @@ export const api = {
     } satisfies SessionRecap;
   },
   setFocusMode: (mode: string) => invoke("set_focus_mode", { mode }),
+  setCapturePaused: (paused: boolean) => invoke("set_capture_paused", { paused }),
   sendTestPrediction: async () => {
     const raw = await invoke<Record<string, unknown>>("send_test_prediction");
     return mapPrediction(raw);
@@ -164,6 +199,8 @@ export const api = {
     listen<Record<string, unknown>>("snapback", (event) => handler(event.payload)),
   onHyperfocus: (handler: (payload: { message: string }) => void) =>
     listen<{ message: string }>("hyperfocus", (event) => handler(event.payload)),
+  onDistractionForecast: (handler: (forecast: DistractionForecast) => void) =>
+    listen<DistractionForecast>("distraction_forecast", (event) => handler(event.payload)),
 };
 
 export const clamp = (value: number, min: number, max: number) =>
@@ -0,0 +1,76 @@
+"""
+App classification, mirroring src-tauri/src/engine/app_context.rs.
+
+Matching is by lowercase substring on the app name, so "Google Chrome",
+"chrome.exe" and "Chromium" all count as browsers. Personal allow/block rules
+live in the user's local database and are not part of training data, so only
+the default classification is ported.
+"""
+
+from __future__ import annotations
+
+from dataclasses import dataclass
+
+BROWSERS = ("chrome", "msedge", "firefox", "brave", "opera", "safari")
+IDES = ("code", "cursor", "devenv", "idea", "pycharm", "clion", "rider", "xcode")
+COMMUNICATION = ("slack", "discord", "teams", "outlook", "zoom", "messages")
+ENTERTAINMENT_APPS = ("spotify", "steam", "vlc", "netflix", "youtube")
+PRODUCTIVITY = ("word", "excel", "powerpnt", "notion", "obsidian", "pages", "figma")
+TERMINALS = ("terminal", "iterm", "warp", "alacritty", "kitty", "wezterm")
+
+DISTRACTING_TITLE_KEYWORDS = (
+    "youtube",
+    "netflix",
+    "twitter",
+    "reddit",
+    "instagram",
+    "tiktok",
+    "twitch",
+    "facebook",
+    "hulu",
+    "disney+",
+    "prime video",
+)
+
+
+@dataclass(frozen=True)
+class AppContext:
+    is_browser: bool
+    is_ide: bool
+    is_communication: bool
+    is_entertainment: bool
+    is_productivity: bool
+    is_terminal: bool
+    title_is_distracting: bool
+
+    @property
+    def productivity_category(self) -> str:
+        if self.is_ide:
+            return "Building"
+        if self.is_productivity:
+            return "Writing"
+        if self.is_browser:
+            return "Browsing"
+        if self.is_communication:
+            return "Communicating"
+        if self.is_entertainment:
+            return "Entertainment"
+        return "Unknown"
+
+
+def _any_in(needles: tuple, haystack: str) -> bool:
+    return any(needle in haystack for needle in needles)
+
+
+def classify(app_name: str, window_title: str) -> AppContext:
+    name = app_name.lower()
+    title = window_title.lower()
+    return AppContext(
+        is_browser=_any_in(BROWSERS, name),
+        is_ide=_any_in(IDES, name),
+        is_communication=_any_in(COMMUNICATION, name),
+        is_entertainment=_any_in(ENTERTAINMENT_APPS, name),
+        is_productivity=_any_in(PRODUCTIVITY, name),
+        is_terminal=_any_in(TERMINALS, name),
+        title_is_distracting=_any_in(DISTRACTING_TITLE_KEYWORDS, title),
+    )
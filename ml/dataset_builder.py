@@ -5,9 +5,10 @@ Join feature rows with label records for training datasets.
 from __future__ import annotations
 
 import csv
-from dataclasses import dataclass
-from typing import Dict, Iterable, List, Optional
+from dataclasses import dataclass, replace
+from typing import Dict, Iterable, List, Optional, Sequence
 
+from .feature_store import LABEL_MISSING, FeatureTable
 from .labeling import FocusLabel, LabelRecord, LabelSource
 
 LABEL_HEADERS = ["timestamp", "label", "source", "session_id", "notes"]
@@ -60,40 +61,41 @@ def read_labels_csv(path: str) -> List[LabelRecord]:
     return labels
 
 
-def join_features_with_labels(
-    feature_rows: Iterable[FeatureRow],
+def match_labels(
+    timestamps: Sequence[float],
     label_rows: Iterable[LabelRecord],
     label_window_seconds: int = 300,
-    keep_unlabeled: bool = False,
-) -> List[Dict[str, str]]:
+) -> List[Optional[LabelRecord]]:
+    """For each timestamp, the first label at or after it if that label is
+    within `label_window_seconds`, else None."""
     labels = sorted(label_rows, key=lambda record: record.timestamp)
-    labeled: List[Dict[str, str]] = []
+    matched: List[Optional[LabelRecord]] = [None] * len(timestamps)
 
     label_index = 0
 
-    for feature in sorted(feature_rows, key=lambda row: row.timestamp):
-        while label_index < len(labels) and labels[label_index].timestamp < feature.timestamp:
+    for idx in sorted(range(len(timestamps)), key=lambda i: timestamps[i]):
+        timestamp = timestamps[idx]
+        while label_index < len(labels) and labels[label_index].timestamp < timestamp:
             label_index += 1
 
-        next_label: Optional[LabelRecord] = None
-        if label_index < len(labels):
-            next_label = labels[label_index]
+        if label_index < len(labels) and labels[label_index].timestamp - timestamp <= label_window_seconds:
+            matched[idx] = labels[label_index]
+
+    return matched
 
-        if next_label is None:
-            if keep_unlabeled:
-                row = dict(feature.row)
-                row.update(
-                    {
-                        "label": "",
-                        "label_source": "",
-                        "label_session_id": "",
-                        "label_notes": "",
-                    }
-                )
-                labeled.append(row)
-            continue
 
-        if next_label.timestamp - feature.timestamp > label_window_seconds:
+def join_features_with_labels(
+    feature_rows: Iterable[FeatureRow],
+    label_rows: Iterable[LabelRecord],
+    label_window_seconds: int = 300,
+    keep_unlabeled: bool = False,
+) -> List[Dict[str, str]]:
+    features = sorted(feature_rows, key=lambda row: row.timestamp)
+    matched = match_labels([feature.timestamp for feature in features], label_rows, label_window_seconds)
+    labeled: List[Dict[str, str]] = []
+
+    for feature, next_label in zip(features, matched):
+        if next_label is None:
             if keep_unlabeled:
                 row = dict(feature.row)
                 row.update(
@@ -121,6 +123,20 @@ def join_features_with_labels(
     return labeled
 
 
+def label_feature_table(
+    table: FeatureTable,
+    label_rows: Iterable[LabelRecord],
+    label_window_seconds: int = 300,
+    keep_unlabeled: bool = False,
+) -> FeatureTable:
+    """`join_features_with_labels` for feature stores: labels are matched on
+    `timestamp_us` and the feature values stay typed."""
+    matched = match_labels([ts / 1_000_000 for ts in table.timestamp_us], label_rows, label_window_seconds)
+    labels = [LABEL_MISSING if record is None else int(record.label) for record in matched]
+    rows = [idx for idx, label in enumerate(labels) if keep_unlabeled or label != LABEL_MISSING]
+    return replace(table, labels=labels).select(rows)
+
+
 def write_labeled_csv(path: str, rows: Iterable[Dict[str, str]]) -> int:
     rows = list(rows)
     if not rows:
@@ -134,3 +150,21 @@ def write_labeled_csv(path: str, rows: Iterable[Dict[str, str]]) -> int:
             writer.writerow(row)
             count += 1
     return count
+
+
+def write_labeled_table_csv(path: str, table: FeatureTable) -> int:
+    """Writes a labeled feature table as a dataset CSV for `load_dataset`."""
+    with open(path, "w", newline="", encoding="utf-8") as handle:
+        writer = csv.writer(handle)
+        writer.writerow(["timestamp", "productivity_category", *table.columns, "label"])
+        for idx, ts_us in enumerate(table.timestamp_us):
+            label = table.labels[idx]
+            writer.writerow(
+                [
+                    f"{ts_us / 1_000_000:.6f}",
+                    table.productivity_category[idx],
+                    *(f"{float(v):.9g}" for v in table.values[idx]),
+                    "" if label == LABEL_MISSING else label,
+                ]
+            )
+    return len(table)
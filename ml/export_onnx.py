@@ -29,7 +29,9 @@ def export_xgboost_to_onnx(model_path: str, output_path: str) -> None:
     model.load_model(model_path)
     n_features = len(default_feature_columns())
     initial_type = [("input", FloatTensorType([None, n_features]))]
-    onnx_model = convert_sklearn(model, initial_types=initial_type)
+    # Without ZipMap the probabilities are a plain float tensor, which the Rust
+    # runtime reads as its `probabilities` output.
+    onnx_model = convert_sklearn(model, initial_types=initial_type, options={type(model): {"zipmap": False}})
     os.makedirs(os.path.dirname(output_path) or ".", exist_ok=True)
     with open(output_path, "wb") as handle:
         handle.write(onnx_model.SerializeToString())
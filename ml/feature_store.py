@@ -0,0 +1,449 @@
+"""
+Typed feature tables for training, without CSV string round-trips.
+
+Two on-disk formats, picked by extension:
+
+- `.parquet`: typed Arrow columns in row groups whose timestamp statistics
+  prune time-range reads (needs pyarrow).
+- `.sbf`: the built-in fallback. Row groups hold int64 timestamps, int8
+  labels, uint8 categories and a row-major float32 feature block laid out
+  like the engine's FeatureTensor; a JSON footer records each group's offset
+  and timestamp range. Reads mmap the file and view the blocks with numpy
+  when it is installed.
+
+Convert an existing CSV once with:
+
+    python -m ml.feature_store --input dataset.csv --output dataset.sbf
+"""
+
+from __future__ import annotations
+
+import argparse
+from array import array
+import csv
+from dataclasses import dataclass
+import json
+import mmap
+import os
+import struct
+from typing import Dict, Iterable, List, Optional, Sequence, Tuple
+
+from .training_pipeline import default_feature_columns
+
+try:
+    import numpy as np
+except ImportError:  # pragma: no cover - optional dependency
+    np = None
+
+STORE_MAGIC = b"SBF1"
+STORE_VERSION = 1
+STORE_HEADER = struct.Struct("<4sHH")
+STORE_TRAILER = struct.Struct("<I4s")
+
+ROW_GROUP_ROWS = 65_536
+# Label value for rows without a label (FocusLabel values are -1..2).
+LABEL_MISSING = -128
+CATEGORIES = ("Building", "Writing", "Browsing", "Communicating", "Entertainment", "Unknown")
+
+
+class FeatureStoreError(ValueError):
+    pass
+
+
+def is_store_path(path: str) -> bool:
+    return path.endswith((".parquet", ".sbf"))
+
+
+@dataclass
+class FeatureTable:
+    columns: List[str]
+    timestamp_us: Sequence[int]
+    # float32 ndarray (rows, columns) when numpy is installed, else row lists.
+    values: Sequence[Sequence[float]]
+    labels: Sequence[int]
+    productivity_category: List[str]
+
+    def __len__(self) -> int:
+        return len(self.timestamp_us)
+
+    @property
+    def timestamps(self) -> List[float]:
+        return [ts / 1_000_000 for ts in self.timestamp_us]
+
+    def select(self, rows: List[int]) -> "FeatureTable":
+        """The given rows, in the given order."""
+        if np is not None:
+            values = self.values[rows]
+        else:
+            values = [self.values[i] for i in rows]
+        return FeatureTable(
+            self.columns,
+            [self.timestamp_us[i] for i in rows],
+            values,
+            [self.labels[i] for i in rows],
+            [self.productivity_category[i] for i in rows],
+        )
+
+
+@dataclass(frozen=True)
+class RowGroup:
+    offset: int
+    rows: int
+    ts_min: int
+    ts_max: int
+
+    def overlaps(self, start_us: Optional[int], end_us: Optional[int]) -> bool:
+        if start_us is not None and self.ts_max < start_us:
+            return False
+        if end_us is not None and self.ts_min >= end_us:
+            return False
+        return True
+
+
+def _align(offset: int, to: int) -> int:
+    return (offset + to - 1) // to * to
+
+
+def _group_layout(group: RowGroup) -> Tuple[int, int, int, int]:
+    """Byte offsets of the timestamp, label, category and feature blocks."""
+    ts_at = group.offset
+    labels_at = ts_at + 8 * group.rows
+    cats_at = labels_at + group.rows
+    values_at = _align(cats_at + group.rows, 4)
+    return ts_at, labels_at, cats_at, values_at
+
+
+class FeatureStoreWriter:
+    """Streams rows into a store file, one row group per `row_group_rows`."""
+
+    def __init__(
+        self,
+        path: str,
+        columns: Optional[List[str]] = None,
+        row_group_rows: int = ROW_GROUP_ROWS,
+    ) -> None:
+        self.path = path
+        self.columns = list(columns or default_feature_columns())
+        self.row_group_rows = max(1, row_group_rows)
+        self.rows_written = 0
+        self._timestamps: List[int] = []
+        self._labels: List[int] = []
+        self._categories: List[int] = []
+        self._values: List[Sequence[float]] = []
+        if path.endswith(".parquet"):
+            self._sink = _ParquetSink(path, self.columns)
+        else:
+            self._sink = _SbfSink(path, self.columns)
+
+    def append(
+        self,
+        timestamp_us: int,
+        values: Sequence[float],
+        category: str = "Unknown",
+        label: int = LABEL_MISSING,
+    ) -> None:
+        if len(values) != len(self.columns):
+            raise FeatureStoreError(f"row has {len(values)} values, expected {len(self.columns)}")
+        self._timestamps.append(int(timestamp_us))
+        self._labels.append(int(label))
+        self._categories.append(CATEGORIES.index(category) if category in CATEGORIES else len(CATEGORIES) - 1)
+        self._values.append(values)
+        if len(self._timestamps) == self.row_group_rows:
+            self._flush()
+
+    def close(self) -> int:
+        self._flush()
+        self._sink.close()
+        return self.rows_written
+
+    def __enter__(self) -> "FeatureStoreWriter":
+        return self
+
+    def __exit__(self, *exc) -> None:
+        self.close()
+
+    def _flush(self) -> None:
+        if not self._timestamps:
+            return
+        self._sink.write_group(self._timestamps, self._labels, self._categories, self._values)
+        self.rows_written += len(self._timestamps)
+        self._timestamps, self._labels, self._categories, self._values = [], [], [], []
+
+
+class _SbfSink:
+    def __init__(self, path: str, columns: List[str]) -> None:
+        self.columns = columns
+        self.groups: List[RowGroup] = []
+        self.handle = open(path, "wb")
+        self.handle.write(STORE_HEADER.pack(STORE_MAGIC, STORE_VERSION, 0))
+
+    def write_group(
+        self,
+        timestamps: List[int],
+        labels: List[int],
+        categories: List[int],
+        values: List[Sequence[float]],
+    ) -> None:
+        offset = _align(self.handle.tell(), 8)
+        self._pad_to(offset)
+        group = RowGroup(offset, len(timestamps), min(timestamps), max(timestamps))
+        _, _, _, values_at = _group_layout(group)
+
+        self.handle.write(array("q", timestamps).tobytes())
+        self.handle.write(array("b", labels).tobytes())
+        self.handle.write(array("B", categories).tobytes())
+        self._pad_to(values_at)
+        block = array("f")
+        for row in values:
+            block.extend(float(v) for v in row)
+        self.handle.write(block.tobytes())
+        self.groups.append(group)
+
+    def close(self) -> None:
+        footer = json.dumps(
+            {
+                "columns": self.columns,
+                "categories": list(CATEGORIES),
+                "row_groups": [[g.offset, g.rows, g.ts_min, g.ts_max] for g in self.groups],
+            }
+        ).encode("utf-8")
+        self.handle.write(footer)
+        self.handle.write(STORE_TRAILER.pack(len(footer), STORE_MAGIC))
+        self.handle.close()
+
+    def _pad_to(self, offset: int) -> None:
+        self.handle.write(b"\0" * (offset - self.handle.tell()))
+
+
+class _ParquetSink:
+    def __init__(self, path: str, columns: List[str]) -> None:
+        import pyarrow as pa
+        import pyarrow.parquet as pq
+
+        self.pa = pa
+        self.columns = columns
+        self.schema = pa.schema(
+            [
+                pa.field("timestamp_us", pa.int64()),
+                pa.field("label", pa.int8()),
+                pa.field("productivity_category", pa.string()),
+            ]
+            + [pa.field(name, pa.float32()) for name in columns]
+        )
+        self.writer = pq.ParquetWriter(path, self.schema)
+
+    def write_group(
+        self,
+        timestamps: List[int],
+        labels: List[int],
+        categories: List[int],
+        values: List[Sequence[float]],
+    ) -> None:
+        pa = self.pa
+        arrays = [
+            pa.array(timestamps, pa.int64()),
+            pa.array(labels, pa.int8()),
+            pa.array([CATEGORIES[c] for c in categories], pa.string()),
+        ] + [pa.array(column, pa.float32()) for column in zip(*values)]
+        self.writer.write_table(pa.Table.from_arrays(arrays, schema=self.schema))
+
+    def close(self) -> None:
+        self.writer.close()
+
+
+def read_feature_table(
+    path: str,
+    columns: Optional[List[str]] = None,
+    start_us: Optional[int] = None,
+    end_us: Optional[int] = None,
+) -> FeatureTable:
+    """Rows with `start_us <= timestamp_us < end_us`, skipping row groups
+    whose timestamp range falls outside."""
+    if path.endswith(".parquet"):
+        return _read_parquet(path, columns, start_us, end_us)
+    return _read_sbf(path, columns, start_us, end_us)
+
+
+def read_sbf_footer(path: str) -> Tuple[List[str], List[str], List[RowGroup]]:
+    with open(path, "rb") as handle:
+        size = os.fstat(handle.fileno()).st_size
+        if size < STORE_HEADER.size + STORE_TRAILER.size:
+            raise FeatureStoreError(f"{path}: file too small")
+        magic, version, _reserved = STORE_HEADER.unpack(handle.read(STORE_HEADER.size))
+        if magic != STORE_MAGIC:
+            raise FeatureStoreError(f"{path}: not a feature store file")
+        if version != STORE_VERSION:
+            raise FeatureStoreError(f"{path}: unsupported feature store version {version}")
+        handle.seek(size - STORE_TRAILER.size)
+        footer_len, magic = STORE_TRAILER.unpack(handle.read(STORE_TRAILER.size))
+        if magic != STORE_MAGIC or footer_len > size:
+            raise FeatureStoreError(f"{path}: missing footer; was the writer closed?")
+        handle.seek(size - STORE_TRAILER.size - footer_len)
+        footer = json.loads(handle.read(footer_len).decode("utf-8"))
+    groups = [RowGroup(*entry) for entry in footer["row_groups"]]
+    return footer["columns"], footer["categories"], groups
+
+
+def _read_sbf(
+    path: str,
+    columns: Optional[List[str]],
+    start_us: Optional[int],
+    end_us: Optional[int],
+) -> FeatureTable:
+    stored, categories, groups = read_sbf_footer(path)
+    wanted = _column_indices(path, stored, columns)
+    groups = [g for g in groups if g.overlaps(start_us, end_us)]
+    width = len(stored)
+
+    timestamps: List[int] = []
+    labels: List[int] = []
+    cats: List[str] = []
+    blocks = []
+    with open(path, "rb") as handle, mmap.mmap(handle.fileno(), 0, access=mmap.ACCESS_READ) as data:
+        for group in groups:
+            ts_at, labels_at, cats_at, values_at = _group_layout(group)
+            group_ts = array("q", data[ts_at:labels_at])
+            keep = [i for i, ts in enumerate(group_ts) if _in_range(ts, start_us, end_us)]
+            whole = len(keep) == group.rows
+            group_labels = array("b", data[labels_at:cats_at])
+            group_cats = data[cats_at : cats_at + group.rows]
+            timestamps.extend(group_ts if whole else (group_ts[i] for i in keep))
+            labels.extend(group_labels if whole else (group_labels[i] for i in keep))
+            cats.extend(categories[group_cats[i]] for i in keep)
+            if np is not None:
+                blocks.append(_numpy_block(data, values_at, group.rows, width, keep, wanted))
+            else:
+                flat = array("f", data[values_at : values_at + 4 * group.rows * width])
+                blocks.extend([flat[i * width + j] for j in wanted] for i in keep)
+
+    if np is not None:
+        values = np.concatenate(blocks) if blocks else np.zeros((0, len(wanted)), np.float32)
+    else:
+        values = blocks
+    return FeatureTable([stored[j] for j in wanted], timestamps, values, labels, cats)
+
+
+def _numpy_block(data: mmap.mmap, offset: int, rows: int, width: int, keep: List[int], wanted: List[int]):
+    # The view pins the mmap until it goes out of scope; return a copy.
+    block = np.frombuffer(data, np.float32, rows * width, offset).reshape(rows, width)
+    if len(keep) != rows:
+        block = block[keep]
+    return block[:, wanted]
+
+
+def _read_parquet(
+    path: str,
+    columns: Optional[List[str]],
+    start_us: Optional[int],
+    end_us: Optional[int],
+) -> FeatureTable:
+    import pyarrow.parquet as pq
+
+    filters = []
+    if start_us is not None:
+        filters.append(("timestamp_us", ">=", start_us))
+    if end_us is not None:
+        filters.append(("timestamp_us", "<", end_us))
+    schema = pq.read_schema(path)
+    stored = [name for name in schema.names if name not in ("timestamp_us", "label", "productivity_category")]
+    names = [stored[j] for j in _column_indices(path, stored, columns)]
+    # Row-group statistics on timestamp_us let pyarrow skip whole groups.
+    table = pq.read_table(
+        path,
+        columns=["timestamp_us", "label", "productivity_category", *names],
+        filters=filters or None,
+    )
+    if np is not None:
+        values = np.empty((table.num_rows, len(names)), np.float32)
+        for j, name in enumerate(names):
+            values[:, j] = table.column(name).to_numpy()
+    else:
+        values = [list(row) for row in zip(*(table.column(name).to_pylist() for name in names))]
+    return FeatureTable(
+        names,
+        table.column("timestamp_us").to_pylist(),
+        values,
+        table.column("label").to_pylist(),
+        table.column("productivity_category").to_pylist(),
+    )
+
+
+def _column_indices(path: str, stored: List[str], columns: Optional[List[str]]) -> List[int]:
+    if columns is None:
+        return list(range(len(stored)))
+    missing = [name for name in columns if name not in stored]
+    if missing:
+        raise FeatureStoreError(f"{path}: no column(s) {', '.join(missing)}")
+    return [stored.index(name) for name in columns]
+
+
+def _in_range(ts_us: int, start_us: Optional[int], end_us: Optional[int]) -> bool:
+    return (start_us is None or ts_us >= start_us) and (end_us is None or ts_us < end_us)
+
+
+def _parse_float(value: Optional[str]) -> float:
+    try:
+        return float((value or "0").strip())
+    except ValueError:
+        return 0.0
+
+
+def write_rows(
+    path: str,
+    rows: Iterable[Dict[str, str]],
+    columns: Optional[List[str]] = None,
+    label_column: str = "label",
+) -> int:
+    """Store CSV-style rows (feature CSVs or joined datasets); strings are
+    parsed once here instead of on every training load."""
+    with FeatureStoreWriter(path, columns) as writer:
+        for row in rows:
+            label_raw = (row.get(label_column) or "").strip()
+            writer.append(
+                round(_parse_float(row.get("timestamp")) * 1_000_000),
+                [_parse_float(row.get(name)) for name in writer.columns],
+                category=row.get("productivity_category") or "Unknown",
+                label=int(label_raw) if label_raw else LABEL_MISSING,
+            )
+    return writer.rows_written
+
+
+def write_table(path: str, table: FeatureTable) -> int:
+    """Stores a feature table as is, labels included."""
+    with FeatureStoreWriter(path, table.columns) as writer:
+        for idx, ts_us in enumerate(table.timestamp_us):
+            writer.append(ts_us, table.values[idx], table.productivity_category[idx], table.labels[idx])
+    return writer.rows_written
+
+
+def convert_csv(
+    input_path: str,
+    output_path: str,
+    columns: Optional[List[str]] = None,
+    label_column: str = "label",
+) -> int:
+    with open(input_path, "r", newline="", encoding="utf-8") as handle:
+        return write_rows(output_path, csv.DictReader(handle), columns, label_column)
+
+
+def parse_args(argv: Optional[List[str]] = None) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Convert a feature or dataset CSV to a feature store.")
+    parser.add_argument("--input", required=True, help="Feature or labeled dataset CSV.")
+    parser.add_argument("--output", required=True, help="Output .sbf or .parquet path.")
+    parser.add_argument("--feature-columns", default=None)
+    parser.add_argument("--label-column", default="label")
+    return parser.parse_args(argv)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    args = parse_args(argv)
+    columns = None
+    if args.feature_columns:
+        columns = [c.strip() for c in args.feature_columns.split(",") if c.strip()]
+    count = convert_csv(args.input, args.output, columns, args.label_column)
+    print(f"Wrote {count} rows to {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
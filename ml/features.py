@@ -7,52 +7,28 @@ from __future__ import annotations
 from collections import deque
 import csv
 from dataclasses import dataclass
-from datetime import datetime
+from datetime import datetime, timezone
 import math
 import os
 import struct
 from typing import Deque, Iterable, List, Optional, Tuple
 
+from .app_context import classify
 from .event_schema import EventRecord, EventType
+from .journal_reader import CaptureEventType, JournalEvent
+from .sketch import WindowedSketch
+
+# Keystrokes further apart than this split typing bursts.
+BURST_GAP_US = 1_000_000
+SKETCH_SLOTS = 6
+TIMING_QUANTILES = (0.1, 0.5, 0.9)
+# Trailing spans behind the *_2min and *_15min columns; the engine's
+# DEFAULT_HORIZONS_SECS (src-tauri/src/engine/horizons.rs).
+HORIZON_SPANS_SECS = (120, 900)
 
 MOUSE_MOVE_STRUCT = struct.Struct("<iiI")
 IDLE_STRUCT = struct.Struct("<I")
 
-BROWSERS = {
-    "chrome.exe",
-    "msedge.exe",
-    "firefox.exe",
-    "brave.exe",
-    "opera.exe",
-}
-IDES = {
-    "code.exe",
-    "devenv.exe",
-    "idea64.exe",
-    "pycharm64.exe",
-    "clion64.exe",
-    "rider64.exe",
-}
-COMMUNICATION = {
-    "slack.exe",
-    "discord.exe",
-    "teams.exe",
-    "outlook.exe",
-    "zoom.exe",
-}
-ENTERTAINMENT = {
-    "spotify.exe",
-    "steam.exe",
-    "vlc.exe",
-}
-PRODUCTIVITY = {
-    "winword.exe",
-    "excel.exe",
-    "powerpnt.exe",
-    "notion.exe",
-    "obsidian.exe",
-}
-
 
 @dataclass(frozen=True)
 class FeatureVector:
@@ -66,6 +42,12 @@ class FeatureVector:
     keystroke_interval_mean: float
     keystroke_interval_std: float
     keystroke_interval_trend: float
+    keystroke_interval_p10: float
+    keystroke_interval_p50: float
+    keystroke_interval_p90: float
+    burst_length_p10: float
+    burst_length_p50: float
+    burst_length_p90: float
     mouse_move_count: int
     mouse_distance_pixels: float
     mouse_speed_mean: float
@@ -90,6 +72,12 @@ class FeatureVector:
     productivity_category: str
     is_pseudo_productive: bool
     recent_event_sequence: Optional[List[int]]
+    switches_per_min_2min: float = 0.0
+    keystroke_rate_2min: float = 0.0
+    idle_time_2min: float = 0.0
+    switches_per_min_15min: float = 0.0
+    keystroke_rate_15min: float = 0.0
+    idle_time_15min: float = 0.0
 
     @staticmethod
     def headers() -> List[str]:
@@ -104,6 +92,12 @@ class FeatureVector:
             "keystroke_interval_mean",
             "keystroke_interval_std",
             "keystroke_interval_trend",
+            "keystroke_interval_p10",
+            "keystroke_interval_p50",
+            "keystroke_interval_p90",
+            "burst_length_p10",
+            "burst_length_p50",
+            "burst_length_p90",
             "mouse_move_count",
             "mouse_distance_pixels",
             "mouse_speed_mean",
@@ -127,6 +121,12 @@ class FeatureVector:
             "focus_momentum",
             "productivity_category",
             "is_pseudo_productive",
+            "switches_per_min_2min",
+            "keystroke_rate_2min",
+            "idle_time_2min",
+            "switches_per_min_15min",
+            "keystroke_rate_15min",
+            "idle_time_15min",
             "recent_event_sequence",
         ]
 
@@ -145,6 +145,12 @@ class FeatureVector:
             f"{self.keystroke_interval_mean:.6f}",
             f"{self.keystroke_interval_std:.6f}",
             f"{self.keystroke_interval_trend:.6f}",
+            f"{self.keystroke_interval_p10:.6f}",
+            f"{self.keystroke_interval_p50:.6f}",
+            f"{self.keystroke_interval_p90:.6f}",
+            f"{self.burst_length_p10:.2f}",
+            f"{self.burst_length_p50:.2f}",
+            f"{self.burst_length_p90:.2f}",
             str(self.mouse_move_count),
             f"{self.mouse_distance_pixels:.2f}",
             f"{self.mouse_speed_mean:.2f}",
@@ -168,6 +174,12 @@ class FeatureVector:
             f"{self.focus_momentum:.2f}",
             self.productivity_category,
             str(int(self.is_pseudo_productive)),
+            f"{self.switches_per_min_2min:.4f}",
+            f"{self.keystroke_rate_2min:.4f}",
+            f"{self.idle_time_2min:.2f}",
+            f"{self.switches_per_min_15min:.4f}",
+            f"{self.keystroke_rate_15min:.4f}",
+            f"{self.idle_time_15min:.2f}",
             sequence,
         ]
 
@@ -209,98 +221,198 @@ def _std(values: Iterable[float]) -> float:
 
 
 def _linear_slope(values: List[float]) -> float:
-    if len(values) < 2:
+    """Least-squares slope against the index; x-terms are closed-form."""
+    n = len(values)
+    if n < 2:
         return 0.0
-    xs = list(range(len(values)))
-    mean_x = _mean(xs)
-    mean_y = _mean(values)
-    num = sum((x - mean_x) * (y - mean_y) for x, y in zip(xs, values))
-    den = sum((x - mean_x) ** 2 for x in xs)
-    if den == 0:
-        return 0.0
-    return num / den
-
-
-def _event_time(event: EventRecord) -> float:
-    return event.timestamp_us / 1_000_000.0
+    sum_y = math.fsum(values)
+    sum_iy = math.fsum(i * y for i, y in enumerate(values))
+    mean_x = (n - 1) / 2.0
+    sxx = n * (n * n - 1) / 12.0
+    return (sum_iy - mean_x * sum_y) / sxx
+
+
+# Legacy NFGL log codes (`event_schema.EventType`) -> capture codes. Wheel,
+# window state and lock events have no capture equivalent and are dropped.
+_LEGACY_EVENT_TYPES = {
+    EventType.KEY_PRESS: CaptureEventType.KEY_PRESS,
+    EventType.KEY_RELEASE: CaptureEventType.KEY_RELEASE,
+    EventType.MOUSE_MOVE: CaptureEventType.MOUSE_MOVE,
+    EventType.MOUSE_CLICK: CaptureEventType.MOUSE_CLICK,
+    EventType.WINDOW_FOCUS_CHANGE: CaptureEventType.WINDOW_FOCUS_CHANGE,
+    EventType.WINDOW_TITLE_CHANGE: CaptureEventType.WINDOW_TITLE_CHANGE,
+    EventType.IDLE_START: CaptureEventType.IDLE_START,
+    EventType.IDLE_END: CaptureEventType.IDLE_END,
+}
 
 
-def _parse_mouse_move(event: EventRecord) -> Tuple[int, int, int]:
-    x, y, speed = MOUSE_MOVE_STRUCT.unpack_from(event.data_raw)
-    return x, y, speed
+def capture_event_from_record(record: EventRecord) -> Optional[JournalEvent]:
+    """Convert a legacy log record to the capture schema the extractor reads."""
+    event_type = _LEGACY_EVENT_TYPES.get(record.event_type)
+    if event_type is None:
+        return None
+    x = y = speed = idle_ms = 0
+    if event_type == CaptureEventType.MOUSE_MOVE:
+        x, y, speed = MOUSE_MOVE_STRUCT.unpack_from(record.data_raw)
+    elif event_type in (CaptureEventType.IDLE_START, CaptureEventType.IDLE_END):
+        idle_ms = IDLE_STRUCT.unpack_from(record.data_raw)[0]
+    return JournalEvent(
+        timestamp_us=record.timestamp_us,
+        event_type=event_type,
+        app_name=record.app_name,
+        window_title="",
+        mouse_x=x,
+        mouse_y=y,
+        mouse_speed=speed,
+        idle_duration_ms=idle_ms,
+        title_churn=0,
+    )
 
 
-def _idle_duration_ms(event: EventRecord) -> int:
-    return IDLE_STRUCT.unpack_from(event.data_raw)[0]
+def _whole(delta_us: int, unit_us: int) -> int:
+    """Integer division truncating toward zero, like Rust's `/` on i64."""
+    quotient = abs(delta_us) // unit_us
+    return quotient if delta_us >= 0 else -quotient
+
+
+class ActivityHorizons:
+    """Python twin of the engine's `BucketRing`: keystroke, focus-switch and
+    idle totals over trailing whole-second spans, the current second included,
+    kept as running sums over a ring of per-second buckets."""
+
+    def __init__(self, spans_secs: Tuple[int, ...] = HORIZON_SPANS_SECS) -> None:
+        self.spans_secs = spans_secs
+        # [keystrokes, focus switches, idle ms] per second.
+        self.buckets = [[0, 0, 0] for _ in range(max(spans_secs))]
+        self.current_sec: Optional[int] = None
+        self.completed = [[0, 0, 0] for _ in spans_secs]
+
+    def record(self, event: JournalEvent) -> None:
+        # Events stamped before the current second count toward it.
+        sec = event.timestamp_us // 1_000_000
+        self.advance_to(sec)
+        bucket = self.buckets[self.current_sec % len(self.buckets)]
+        if event.event_type == CaptureEventType.KEY_PRESS:
+            bucket[0] += 1
+        elif event.event_type == CaptureEventType.WINDOW_FOCUS_CHANGE:
+            bucket[1] += 1
+        elif event.event_type in (CaptureEventType.IDLE_START, CaptureEventType.IDLE_END):
+            bucket[2] += event.idle_duration_ms
+
+    def advance_to(self, sec: int) -> None:
+        current = self.current_sec
+        if current is None:
+            self.current_sec = sec
+            return
+        if sec <= current:
+            return
+        size = len(self.buckets)
+        if sec - current >= size:
+            self.buckets = [[0, 0, 0] for _ in range(size)]
+            self.completed = [[0, 0, 0] for _ in self.spans_secs]
+            self.current_sec = sec
+            return
+        for nxt in range(current + 1, sec + 1):
+            finished = self.buckets[(nxt - 1) % size]
+            for span, total in zip(self.spans_secs, self.completed):
+                leaving = self.buckets[(nxt - span) % size] if nxt - span <= current else (0, 0, 0)
+                for i in range(3):
+                    total[i] += finished[i] - leaving[i]
+            self.buckets[nxt % size] = [0, 0, 0]
+        self.current_sec = sec
+
+    def rates(self) -> List[Tuple[float, float, float]]:
+        """(switches per minute, keystrokes per second, idle seconds) per span."""
+        current = [0, 0, 0]
+        if self.current_sec is not None:
+            current = self.buckets[self.current_sec % len(self.buckets)]
+        rates = []
+        for span, total in zip(self.spans_secs, self.completed):
+            keys, switches, idle_ms = (t + c for t, c in zip(total, current))
+            rates.append((switches * 60.0 / span, keys / span, idle_ms / 1000.0))
+        return rates
 
 
-def _classify_app(app_name: str) -> Tuple[bool, bool, bool, bool, bool]:
-    name = app_name.lower()
-    return (
-        name in BROWSERS,
-        name in IDES,
-        name in COMMUNICATION,
-        name in ENTERTAINMENT,
-        name in PRODUCTIVITY,
-    )
+class FeatureExtractor:
+    """Python twin of the Rust `FeatureExtractor` (src-tauri/src/engine/features.rs).
 
+    Reads capture-schema events (`JournalEvent`) and keeps time in integer
+    microseconds, as the engine does. `ml/tests/test_feature_parity.py` checks
+    both against the same golden vectors.
+    """
 
-class FeatureExtractor:
     def __init__(
         self,
         window_seconds: int = 30,
         long_window_seconds: int = 300,
         break_threshold_seconds: int = 300,
     ) -> None:
-        self.window_seconds = window_seconds
-        self.long_window_seconds = long_window_seconds
-        self.break_threshold_seconds = break_threshold_seconds
+        self.window_us = window_seconds * 1_000_000
+        self.long_window_us = long_window_seconds * 1_000_000
+        self.break_threshold_us = break_threshold_seconds * 1_000_000
 
-        self.events_30s: Deque[EventRecord] = deque()
-        self.events_5min: Deque[EventRecord] = deque()
+        self.events_30s: Deque[JournalEvent] = deque()
+        self.events_5min: Deque[JournalEvent] = deque()
         self.recent_event_types: Deque[int] = deque(maxlen=10)
 
-        self.session_start_ts: Optional[float] = None
-        self.last_break_ts: Optional[float] = None
+        self.session_start_us: Optional[int] = None
+        self.last_break_us: Optional[int] = None
         self.current_app_name: str = ""
-        self.current_app_start_ts: Optional[float] = None
+        self.current_window_title: str = ""
+        self.current_app_start_us: Optional[int] = None
         self.focus_momentum: float = 0.0
 
+        self.interval_sketch = WindowedSketch(self.window_us, SKETCH_SLOTS)
+        self.burst_sketch = WindowedSketch(self.window_us, SKETCH_SLOTS)
+        self.last_key_us: Optional[int] = None
+        self.burst_len = 0
+        self.activity = ActivityHorizons()
+
     def update_focus_score(self, score: float, alpha: float = 0.2) -> None:
         self.focus_momentum = alpha * score + (1 - alpha) * self.focus_momentum
 
-    def update(self, event: EventRecord) -> FeatureVector:
-        now = _event_time(event)
-        if self.session_start_ts is None:
-            self.session_start_ts = now
-            self.last_break_ts = now
+    def update(self, event: JournalEvent) -> FeatureVector:
+        now = event.timestamp_us
+        if self.session_start_us is None:
+            self.session_start_us = now
+            self.last_break_us = now
             self.current_app_name = event.app_name
-            self.current_app_start_ts = now
+            self.current_window_title = event.window_title
+            self.current_app_start_us = now
 
         self.events_30s.append(event)
         self.events_5min.append(event)
         self.recent_event_types.append(int(event.event_type))
 
         self._trim(now)
+        self.activity.record(event)
+        self._update_typing_sketches(event)
         self._update_break_state(event, now)
         self._update_current_app(event, now)
 
         return self.extract_features(now)
 
-    def extract_features(self, now: Optional[float] = None) -> FeatureVector:
+    def extract_features(self, now: Optional[int] = None) -> FeatureVector:
         if not self.events_5min:
-            timestamp = now or datetime.utcnow().timestamp()
+            now = now if now is not None else int(datetime.now(timezone.utc).timestamp() * 1e6)
+            dt = datetime.fromtimestamp(now / 1_000_000.0, timezone.utc)
             return FeatureVector(
-                timestamp=timestamp,
+                timestamp=now / 1_000_000.0,
                 seconds_since_session_start=0,
-                hour_of_day=datetime.utcnow().hour,
-                day_of_week=datetime.utcnow().weekday(),
+                hour_of_day=dt.hour,
+                day_of_week=dt.weekday(),
                 minutes_since_last_break=0,
                 keystroke_count=0,
                 keystroke_rate=0.0,
                 keystroke_interval_mean=0.0,
                 keystroke_interval_std=0.0,
                 keystroke_interval_trend=0.0,
+                keystroke_interval_p10=0.0,
+                keystroke_interval_p50=0.0,
+                keystroke_interval_p90=0.0,
+                burst_length_p10=0.0,
+                burst_length_p50=0.0,
+                burst_length_p90=0.0,
                 mouse_move_count=0,
                 mouse_distance_pixels=0.0,
                 mouse_speed_mean=0.0,
@@ -327,147 +439,141 @@ class FeatureExtractor:
                 recent_event_sequence=list(self.recent_event_types),
             )
 
-        now_ts = now or _event_time(self.events_5min[-1])
-        oldest_30s = _event_time(self.events_30s[0]) if self.events_30s else now_ts
-        oldest_5min = _event_time(self.events_5min[0]) if self.events_5min else now_ts
-        span_30s = max(1e-6, min(self.window_seconds, now_ts - oldest_30s))
-        span_5min = max(1e-6, min(self.long_window_seconds, now_ts - oldest_5min))
-
-        keystrokes = [e for e in self.events_30s if e.event_type == EventType.KEY_PRESS]
-        key_times = [_event_time(e) for e in keystrokes]
-        intervals = [key_times[i] - key_times[i - 1] for i in range(1, len(key_times))]
-        keystroke_interval_mean = _mean(intervals)
-        keystroke_interval_std = _std(intervals)
-        keystroke_interval_trend = _linear_slope(intervals)
-
-        mouse_moves = [e for e in self.events_30s if e.event_type == EventType.MOUSE_MOVE]
-        mouse_clicks = [e for e in self.events_30s if e.event_type == EventType.MOUSE_CLICK]
-        speeds = []
+        now = now if now is not None else self.events_5min[-1].timestamp_us
+        oldest_30s = self.events_30s[0].timestamp_us if self.events_30s else now
+        span_30s = max(1e-6, min(self.window_us, now - oldest_30s) / 1_000_000.0)
+
+        key_times = [
+            e.timestamp_us for e in self.events_30s if e.event_type == CaptureEventType.KEY_PRESS
+        ]
+        intervals = [(b - a) / 1_000_000.0 for a, b in zip(key_times, key_times[1:])]
+        interval_q = self.interval_sketch.quantiles(TIMING_QUANTILES)
+        burst_q = self.burst_sketch.quantiles(TIMING_QUANTILES)
+
+        mouse_moves = [e for e in self.events_30s if e.event_type == CaptureEventType.MOUSE_MOVE]
+        speeds = [float(e.mouse_speed) for e in mouse_moves]
         distances = []
         accelerations = []
-        for i, event in enumerate(mouse_moves):
-            x, y, speed = _parse_mouse_move(event)
-            speeds.append(speed)
-            if i > 0:
-                prev_ts = _event_time(mouse_moves[i - 1])
-                dt = max(1e-6, _event_time(event) - prev_ts)
-                distances.append(speed * dt)
-                prev_speed = speeds[i - 1]
-                accelerations.append(abs(speed - prev_speed) / dt)
-        mouse_speed_mean = _mean(speeds)
-        mouse_speed_std = _std(speeds)
-        mouse_distance_pixels = sum(distances)
-        mouse_acceleration_mean = _mean(accelerations)
-
-        context_switches_30s = sum(
-            1 for e in self.events_30s if e.event_type == EventType.WINDOW_FOCUS_CHANGE
-        )
-        context_switches_5min = sum(
-            1 for e in self.events_5min if e.event_type == EventType.WINDOW_FOCUS_CHANGE
-        )
-        unique_apps_5min = len({e.app_name for e in self.events_5min if e.app_name})
-        time_in_current_app = 0
-        if self.current_app_start_ts is not None:
-            time_in_current_app = int(now_ts - self.current_app_start_ts)
+        for prev, event in zip(mouse_moves, mouse_moves[1:]):
+            dt = max(1e-6, (event.timestamp_us - prev.timestamp_us) / 1_000_000.0)
+            distances.append(event.mouse_speed * dt)
+            accelerations.append(abs(event.mouse_speed - prev.mouse_speed) / dt)
 
-        idle_events_30s = [
-            e
-            for e in self.events_30s
-            if e.event_type in (EventType.IDLE_START, EventType.IDLE_END)
-        ]
-        idle_time_30s = sum(_idle_duration_ms(e) for e in idle_events_30s) / 1000.0
+        time_in_current_app = 0
+        if self.current_app_start_us is not None:
+            time_in_current_app = _whole(now - self.current_app_start_us, 1_000_000)
 
-        idle_events_5min = [
-            e
-            for e in self.events_5min
-            if e.event_type in (EventType.IDLE_START, EventType.IDLE_END)
-        ]
-        idle_event_count_5min = len(idle_events_5min)
-        idle_timestamps = sorted(_event_time(e) for e in idle_events_5min)
+        idle_types = (CaptureEventType.IDLE_START, CaptureEventType.IDLE_END)
+        idle_time_30s = (
+            sum(e.idle_duration_ms for e in self.events_30s if e.event_type in idle_types)
+            / 1000.0
+        )
+        # Arrival order, as the engine's window keeps it.
+        idle_timestamps = [e.timestamp_us for e in self.events_5min if e.event_type in idle_types]
         if not idle_timestamps:
-            longest_active_stretch_5min = int(min(self.long_window_seconds, span_5min))
+            longest_active_stretch_5min = _whole(self.long_window_us, 1_000_000)
         else:
-            window_start = now_ts - self.long_window_seconds
-            boundaries = [window_start] + idle_timestamps + [now_ts]
-            longest_active_stretch_5min = int(
-                max(b - a for a, b in zip(boundaries, boundaries[1:]))
+            boundaries = [now - self.long_window_us] + idle_timestamps + [now]
+            longest_active_stretch_5min = max(
+                _whole(b - a, 1_000_000) for a, b in zip(boundaries, boundaries[1:])
             )
 
-        window_title_changed_30s = any(
-            e.event_type == EventType.WINDOW_TITLE_CHANGE for e in self.events_30s
-        )
-        window_title_length = 0
-
-        is_browser, is_ide, is_comm, is_ent, is_prod = _classify_app(self.current_app_name)
-        productivity_category = "Unknown"
-        if is_ide:
-            productivity_category = "Building"
-        elif is_prod:
-            productivity_category = "Writing"
-        elif is_browser:
-            productivity_category = "Browsing"
-        elif is_comm:
-            productivity_category = "Communicating"
-        elif is_ent:
-            productivity_category = "Entertainment"
-
-        is_pseudo_productive = False
+        ctx = classify(self.current_app_name, self.current_window_title)
 
         minutes_since_last_break = 0
-        if self.last_break_ts is not None:
-            minutes_since_last_break = int(max(0.0, (now_ts - self.last_break_ts) / 60.0))
+        if self.last_break_us is not None:
+            minutes_since_last_break = max(0, _whole(now - self.last_break_us, 60_000_000))
+
+        (switches_2min, keys_2min, idle_2min), (switches_15min, keys_15min, idle_15min) = self.activity.rates()
 
-        dt = datetime.fromtimestamp(now_ts)
+        dt = datetime.fromtimestamp(now / 1_000_000.0, timezone.utc)
         return FeatureVector(
-            timestamp=now_ts,
-            seconds_since_session_start=int(now_ts - (self.session_start_ts or now_ts)),
+            timestamp=now / 1_000_000.0,
+            seconds_since_session_start=_whole(now - (self.session_start_us or now), 1_000_000),
             hour_of_day=dt.hour,
             day_of_week=dt.weekday(),
             minutes_since_last_break=minutes_since_last_break,
-            keystroke_count=len(keystrokes),
-            keystroke_rate=len(keystrokes) / span_30s,
-            keystroke_interval_mean=keystroke_interval_mean,
-            keystroke_interval_std=keystroke_interval_std,
-            keystroke_interval_trend=keystroke_interval_trend,
+            keystroke_count=len(key_times),
+            keystroke_rate=len(key_times) / span_30s,
+            keystroke_interval_mean=_mean(intervals),
+            keystroke_interval_std=_std(intervals),
+            keystroke_interval_trend=_linear_slope(intervals),
+            keystroke_interval_p10=interval_q[0],
+            keystroke_interval_p50=interval_q[1],
+            keystroke_interval_p90=interval_q[2],
+            burst_length_p10=burst_q[0],
+            burst_length_p50=burst_q[1],
+            burst_length_p90=burst_q[2],
             mouse_move_count=len(mouse_moves),
-            mouse_distance_pixels=mouse_distance_pixels,
-            mouse_speed_mean=mouse_speed_mean,
-            mouse_speed_std=mouse_speed_std,
-            mouse_acceleration_mean=mouse_acceleration_mean,
-            mouse_click_count=len(mouse_clicks),
-            context_switches_30s=context_switches_30s,
-            context_switches_5min=context_switches_5min,
+            mouse_distance_pixels=sum(distances),
+            mouse_speed_mean=_mean(speeds),
+            mouse_speed_std=_std(speeds),
+            mouse_acceleration_mean=_mean(accelerations),
+            mouse_click_count=sum(
+                1 for e in self.events_30s if e.event_type == CaptureEventType.MOUSE_CLICK
+            ),
+            context_switches_30s=sum(
+                1 for e in self.events_30s if e.event_type == CaptureEventType.WINDOW_FOCUS_CHANGE
+            ),
+            context_switches_5min=sum(
+                1 for e in self.events_5min if e.event_type == CaptureEventType.WINDOW_FOCUS_CHANGE
+            ),
             time_in_current_app=time_in_current_app,
-            unique_apps_5min=unique_apps_5min,
+            unique_apps_5min=len({e.app_name for e in self.events_5min}),
             idle_time_30s=idle_time_30s,
-            idle_event_count_5min=idle_event_count_5min,
+            idle_event_count_5min=len(idle_timestamps),
             longest_active_stretch_5min=longest_active_stretch_5min,
-            window_title_length=window_title_length,
-            window_title_changed_30s=window_title_changed_30s,
-            is_browser=is_browser,
-            is_ide=is_ide,
-            is_communication=is_comm,
-            is_entertainment=is_ent,
-            is_productivity=is_prod,
+            window_title_length=len(self.current_window_title.encode("utf-8")),
+            window_title_changed_30s=any(
+                e.event_type == CaptureEventType.WINDOW_TITLE_CHANGE for e in self.events_30s
+            ),
+            is_browser=ctx.is_browser,
+            is_ide=ctx.is_ide,
+            is_communication=ctx.is_communication,
+            is_entertainment=ctx.is_entertainment or ctx.title_is_distracting,
+            is_productivity=ctx.is_productivity,
             focus_momentum=self.focus_momentum,
-            productivity_category=productivity_category,
-            is_pseudo_productive=is_pseudo_productive,
+            productivity_category=ctx.productivity_category,
+            is_pseudo_productive=False,
             recent_event_sequence=list(self.recent_event_types),
+            switches_per_min_2min=switches_2min,
+            keystroke_rate_2min=keys_2min,
+            idle_time_2min=idle_2min,
+            switches_per_min_15min=switches_15min,
+            keystroke_rate_15min=keys_15min,
+            idle_time_15min=idle_15min,
         )
 
-    def _trim(self, now: float) -> None:
-        while self.events_30s and now - _event_time(self.events_30s[0]) > self.window_seconds:
+    def _trim(self, now: int) -> None:
+        while self.events_30s and now - self.events_30s[0].timestamp_us > self.window_us:
             self.events_30s.popleft()
-        while self.events_5min and now - _event_time(self.events_5min[0]) > self.long_window_seconds:
+        while self.events_5min and now - self.events_5min[0].timestamp_us > self.long_window_us:
             self.events_5min.popleft()
 
-    def _update_break_state(self, event: EventRecord, now: float) -> None:
-        if event.event_type in (EventType.IDLE_START, EventType.IDLE_END):
-            duration = _idle_duration_ms(event) / 1000.0
-            if duration >= self.break_threshold_seconds:
-                self.last_break_ts = now
-
-    def _update_current_app(self, event: EventRecord, now: float) -> None:
-        if event.event_type == EventType.WINDOW_FOCUS_CHANGE:
+    def _update_typing_sketches(self, event: JournalEvent) -> None:
+        now_us = event.timestamp_us
+        self.interval_sketch.advance(now_us)
+        self.burst_sketch.advance(now_us)
+        paused = self.last_key_us is not None and now_us - self.last_key_us > BURST_GAP_US
+        if paused and self.burst_len > 0:
+            self.burst_sketch.record(now_us, float(self.burst_len))
+            self.burst_len = 0
+        if event.event_type != CaptureEventType.KEY_PRESS:
+            return
+        if self.last_key_us is not None:
+            self.interval_sketch.record(now_us, (now_us - self.last_key_us) / 1_000_000.0)
+        self.burst_len += 1
+        self.last_key_us = now_us
+
+    def _update_break_state(self, event: JournalEvent, now: int) -> None:
+        if event.event_type in (CaptureEventType.IDLE_START, CaptureEventType.IDLE_END):
+            if event.idle_duration_ms * 1_000 >= self.break_threshold_us:
+                self.last_break_us = now
+
+    def _update_current_app(self, event: JournalEvent, now: int) -> None:
+        if event.event_type == CaptureEventType.WINDOW_FOCUS_CHANGE:
             self.current_app_name = event.app_name
-            self.current_app_start_ts = now
+            self.current_window_title = event.window_title
+            self.current_app_start_us = now
+        elif event.event_type == CaptureEventType.WINDOW_TITLE_CHANGE:
+            self.current_window_title = event.window_title
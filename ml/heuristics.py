@@ -0,0 +1,281 @@
+"""
+Heuristic classifier mirror, for tuning its constants offline.
+
+src-tauri/src/engine/classifier.rs scores each prediction from a handful of
+inputs and ~50 constants held in `HeuristicParams`
+(src-tauri/src/engine/heuristic_params.rs). `snapback --replay <journal>
+--heuristic-inputs-out inputs.csv` writes those inputs per prediction; this
+module re-scores such rows under any parameter set with the same arithmetic,
+in the same order, so results match the app to the last bit. The parity
+fixture `ml/tests/fixtures/heuristics` is produced by the Rust side.
+"""
+
+from __future__ import annotations
+
+import json
+import math
+from dataclasses import dataclass
+from typing import Dict, Iterable, List, Mapping, Sequence
+
+from .dataset_builder import join_features_with_labels, read_features_csv, read_labels_csv
+from .training_pipeline import LABEL_VALUE_TO_INDEX
+
+PARAMS_FILE = "heuristics.json"
+
+STATE_LABELS = ["DISTRACTED", "PSEUDO_PRODUCTIVE", "PRODUCTIVE", "DEEP_FOCUS"]
+FOCUS_LEVELS = [25.0, 50.0, 75.0, 100.0]
+FOCUS_MODES = ["deep", "normal", "recovery"]
+
+# `HEURISTIC_INPUT_NAMES` in classifier.rs.
+INPUT_NAMES = [
+    "context_switches_30s",
+    "context_switches_5min",
+    "extra_apps_5min",
+    "window_title_changed_30s",
+    "title_churn_rate_30s",
+    "keystroke_count",
+    "keystroke_interval_std",
+    "keystroke_rate",
+    "time_in_current_app",
+    "idle_time_30s",
+    "is_work_app",
+    "is_browser_or_chat",
+    "goal_bias",
+    "is_entertainment",
+    "is_communication",
+    "personal_block",
+]
+
+# `PARAM_NAMES` and `DEFAULTS` in heuristic_params.rs.
+DEFAULT_PARAMS: Dict[str, float] = {
+    "thrash.switches_30s_scale": 4.0,
+    "thrash.switches_5min_scale": 10.0,
+    "thrash.extra_apps_scale": 5.0,
+    "thrash.switches_30s_weight": 0.45,
+    "thrash.switches_5min_weight": 0.25,
+    "thrash.extra_apps_weight": 0.30,
+    "drift.churn_scale": 12.0,
+    "drift.changed_base": 0.7,
+    "drift.changed_churn_weight": 0.3,
+    "drift.churn_weight": 0.7,
+    "drift.min_keystrokes": 3.0,
+    "drift.keystroke_std_scale": 1.2,
+    "drift.switches_30s_scale": 3.0,
+    "drift.title_weight": 0.45,
+    "drift.keystroke_weight": 0.30,
+    "drift.switch_weight": 0.25,
+    "drift.goal_bias_weight": 0.25,
+    "context.work_app": 1.0,
+    "context.browser_or_chat": 0.85,
+    "context.other": 0.4,
+    "deep.settled_scale": 180.0,
+    "deep.min_keystrokes": 4.0,
+    "deep.keystroke_std_scale": 1.0,
+    "deep.untyped_steadiness": 0.3,
+    "deep.switches_30s_scale": 2.0,
+    "deep.settled_weight": 0.35,
+    "deep.typing_weight": 0.25,
+    "deep.switch_weight": 0.20,
+    "deep.stability_weight": 0.20,
+    "deep.share": 0.65,
+    "distracted.thrash_weight": 0.30,
+    "distracted.idle_scale": 8.0,
+    "distracted.idle_weight": 0.15,
+    "distracted.keystroke_rate_scale": 4.0,
+    "distracted.low_typing_weight": 0.10,
+    "distracted.app_time_scale": 120.0,
+    "distracted.short_stay_weight": 0.10,
+    "distracted.entertainment_weight": 0.20,
+    "distracted.communication_weight": 0.05,
+    "distracted.goal_bias_weight": 0.35,
+    "pseudo.distracted_damping": 0.6,
+    "risk.thrash_weight": 0.15,
+    "override.thrash": 0.75,
+    "override.drift": 0.55,
+    "risk_threshold.deep": 0.55,
+    "risk_threshold.normal": 0.7,
+    "risk_threshold.recovery": 0.85,
+}
+PARAM_NAMES = list(DEFAULT_PARAMS)
+
+
+@dataclass(frozen=True)
+class HeuristicScores:
+    focus_score: float
+    distraction_risk: float
+    thrash_score: float
+    drift_score: float
+    focus_state: str
+
+
+def validate_params(params: Mapping[str, float]) -> Dict[str, float]:
+    """Defaults overridden by `params`, checked as heuristic_params.rs does."""
+    merged = dict(DEFAULT_PARAMS)
+    for name, value in params.items():
+        if name not in DEFAULT_PARAMS:
+            raise ValueError(f"unknown heuristic parameter {name!r}")
+        merged[name] = float(value)
+    for name, value in merged.items():
+        if not math.isfinite(value) or value < 0.0 or (name.endswith("_scale") and value == 0.0):
+            raise ValueError(f"heuristic parameter {name!r} = {value} is not a finite non-negative number")
+    return merged
+
+
+def load_params(path: str) -> Dict[str, float]:
+    with open(path, "r", encoding="utf-8") as handle:
+        return validate_params(json.load(handle))
+
+
+def save_params(path: str, params: Mapping[str, float]) -> None:
+    """Writes only values that differ from the defaults, like a hand-edited file."""
+    overrides = {name: params[name] for name in PARAM_NAMES if params[name] != DEFAULT_PARAMS[name]}
+    with open(path, "w", encoding="utf-8") as handle:
+        json.dump(overrides, handle, indent=2)
+        handle.write("\n")
+
+
+def _clamp(value: float) -> float:
+    return min(max(value, 0.0), 1.0)
+
+
+def score_row(x: Sequence[float], p: Mapping[str, float], focus_mode: str = "normal") -> HeuristicScores:
+    """`Classifier::predict` on one `INPUT_NAMES` row, without a model."""
+    (
+        switches_30s_count,
+        switches_5min_count,
+        extra_apps,
+        title_changed,
+        churn_rate,
+        keystroke_count,
+        keystroke_std,
+        keystroke_rate,
+        time_in_app,
+        idle_time,
+        is_work_app,
+        is_browser_or_chat,
+        bias,
+        is_entertainment,
+        is_communication,
+        personal_block,
+    ) = x
+
+    switches_30s = min(switches_30s_count / p["thrash.switches_30s_scale"], 1.0)
+    switches_5min = min(switches_5min_count / p["thrash.switches_5min_scale"], 1.0)
+    unique_apps = max(min(extra_apps / p["thrash.extra_apps_scale"], 1.0), 0.0)
+    thrash = _clamp(
+        switches_30s * p["thrash.switches_30s_weight"]
+        + switches_5min * p["thrash.switches_5min_weight"]
+        + unique_apps * p["thrash.extra_apps_weight"]
+    )
+
+    churn = min(churn_rate / p["drift.churn_scale"], 1.0)
+    if title_changed:
+        title_churn = p["drift.changed_base"] + p["drift.changed_churn_weight"] * churn
+    else:
+        title_churn = p["drift.churn_weight"] * churn
+    if keystroke_count >= p["drift.min_keystrokes"]:
+        keystroke_chaos = min(keystroke_std / p["drift.keystroke_std_scale"], 1.0)
+    else:
+        keystroke_chaos = 0.0
+    unsettled = min(switches_30s_count / p["drift.switches_30s_scale"], 1.0)
+    browser_or_other = is_browser_or_chat * p["context.browser_or_chat"] + (1.0 - is_browser_or_chat) * p[
+        "context.other"
+    ]
+    work_context = is_work_app * p["context.work_app"] + (1.0 - is_work_app) * browser_or_other
+    drift = _clamp(
+        (
+            title_churn * p["drift.title_weight"]
+            + keystroke_chaos * p["drift.keystroke_weight"]
+            + unsettled * p["drift.switch_weight"]
+        )
+        * work_context
+    )
+    drift = _clamp(drift - bias * p["drift.goal_bias_weight"])
+
+    settled = min(time_in_app / p["deep.settled_scale"], 1.0)
+    if keystroke_count >= p["deep.min_keystrokes"]:
+        steady_typing = max(1.0 - min(keystroke_std / p["deep.keystroke_std_scale"], 1.0), 0.0)
+    else:
+        steady_typing = p["deep.untyped_steadiness"]
+    low_switch = max(1.0 - min(switches_30s_count / p["deep.switches_30s_scale"], 1.0), 0.0)
+    stability = (1.0 - thrash) * (1.0 - drift)
+    deep = _clamp(
+        settled * p["deep.settled_weight"]
+        + steady_typing * p["deep.typing_weight"]
+        + low_switch * p["deep.switch_weight"]
+        + stability * p["deep.stability_weight"]
+    )
+
+    distracted = 0.0
+    distracted += thrash * p["distracted.thrash_weight"]
+    distracted += min(idle_time / p["distracted.idle_scale"], 1.0) * p["distracted.idle_weight"]
+    distracted += (1.0 - min(keystroke_rate / p["distracted.keystroke_rate_scale"], 1.0)) * p[
+        "distracted.low_typing_weight"
+    ]
+    distracted += (1.0 - min(time_in_app / p["distracted.app_time_scale"], 1.0)) * p[
+        "distracted.short_stay_weight"
+    ]
+    distracted += is_entertainment * p["distracted.entertainment_weight"]
+    distracted += is_communication * p["distracted.communication_weight"]
+    distracted = _clamp(distracted - bias * p["distracted.goal_bias_weight"])
+
+    pseudo = _clamp(drift * (1.0 - distracted * p["pseudo.distracted_damping"]))
+    remaining = max(1.0 - distracted - pseudo, 0.0)
+    productive = remaining * (1.0 - deep * p["deep.share"])
+    deep_prob = remaining * deep * p["deep.share"]
+    probas = [distracted, pseudo, productive, max(deep_prob, 0.0)]
+
+    total = sum(probas)
+    probas = [0.25] * 4 if total <= 0.0 else [value / total for value in probas]
+    risk = _clamp(probas[0] + thrash * p["risk.thrash_weight"])
+    focus_score = sum(level * value for level, value in zip(FOCUS_LEVELS, probas))
+    # Rust's `max_by` keeps the last of equal maxima.
+    best = 0
+    for idx in range(1, len(probas)):
+        if probas[idx] >= probas[best]:
+            best = idx
+    state = STATE_LABELS[best]
+
+    if risk >= p[f"risk_threshold.{focus_mode}"] or thrash >= p["override.thrash"] or personal_block:
+        state = "DISTRACTED"
+    elif drift >= p["override.drift"] and state != "DEEP_FOCUS":
+        state = "PSEUDO_PRODUCTIVE"
+    return HeuristicScores(focus_score, risk, thrash, drift, state)
+
+
+def predict_states(
+    rows: Iterable[Sequence[float]], params: Mapping[str, float], focus_mode: str = "normal"
+) -> List[int]:
+    """`STATE_LABELS` index of each row's final state."""
+    index = {label: idx for idx, label in enumerate(STATE_LABELS)}
+    return [index[score_row(row, params, focus_mode).focus_state] for row in rows]
+
+
+@dataclass
+class LabeledInputs:
+    timestamps: List[float]
+    rows: List[List[float]]
+    labels: List[int]
+
+
+def load_labeled_inputs(
+    inputs_path: str,
+    labels_path: str,
+    label_window_seconds: int = 300,
+) -> LabeledInputs:
+    """Joins a `--heuristic-inputs-out` CSV with label records the way the
+    training datasets are joined; unlabeled rows are dropped."""
+    joined = join_features_with_labels(
+        read_features_csv(inputs_path),
+        read_labels_csv(labels_path),
+        label_window_seconds=label_window_seconds,
+    )
+    data = LabeledInputs(timestamps=[], rows=[], labels=[])
+    for row in joined:
+        label = int(row["label"])
+        if label not in LABEL_VALUE_TO_INDEX:
+            continue
+        data.timestamps.append(float(row["timestamp"]))
+        data.rows.append([float(row[name]) for name in INPUT_NAMES])
+        data.labels.append(LABEL_VALUE_TO_INDEX[label])
+    return data
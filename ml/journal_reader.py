@@ -0,0 +1,217 @@
+"""
+Read the raw event journal written by the Tauri app (src-tauri/src/journal).
+
+Segments (`events-NNNNNN.sbj`) hold checksummed blocks of length-prefixed
+records; strings live in the `.sym` sidecar next to each segment.
+"""
+
+from __future__ import annotations
+
+from contextlib import contextmanager
+from dataclasses import dataclass
+from enum import IntEnum
+import mmap
+import os
+import struct
+from typing import Iterable, Iterator, List, Optional, Tuple
+import zlib
+
+SEGMENT_MAGIC = b"SBJ1"
+SYMBOL_MAGIC = b"SBS1"
+FORMAT_VERSION = 1
+
+FILE_HEADER = struct.Struct("<4sHHII")
+BLOCK_HEADER = struct.Struct("<III")
+RECORD_LEN = struct.Struct("<H")
+RECORD_BODY = struct.Struct("<qBIIiiIII")
+TIMESTAMP = struct.Struct("<q")
+SYMBOL_ENTRY = struct.Struct("<II")
+
+
+class CaptureEventType(IntEnum):
+    """Event codes used by the Rust capture layer (`types::EventType`)."""
+
+    KEY_PRESS = 1
+    KEY_RELEASE = 2
+    MOUSE_MOVE = 3
+    MOUSE_CLICK = 4
+    WINDOW_FOCUS_CHANGE = 5
+    WINDOW_TITLE_CHANGE = 6
+    IDLE_START = 7
+    IDLE_END = 8
+
+
+class JournalFormatError(ValueError):
+    pass
+
+
+@dataclass(frozen=True)
+class JournalEvent:
+    timestamp_us: int
+    event_type: CaptureEventType
+    app_name: str
+    window_title: str
+    mouse_x: int
+    mouse_y: int
+    mouse_speed: int
+    idle_duration_ms: int
+    title_churn: int
+
+    @property
+    def timestamp_secs(self) -> float:
+        return self.timestamp_us / 1_000_000.0
+
+
+def segment_paths(path: str) -> List[str]:
+    if os.path.isfile(path):
+        return [path]
+    names = sorted(name for name in os.listdir(path) if name.endswith(".sbj"))
+    return [os.path.join(path, name) for name in names]
+
+
+def _check_header(data: bytes, magic: bytes, path: str) -> None:
+    if len(data) < FILE_HEADER.size:
+        raise JournalFormatError(f"{path}: file too small")
+    found, version, _flags, _seq, _reserved = FILE_HEADER.unpack_from(data)
+    if found != magic:
+        raise JournalFormatError(f"{path}: not a journal file")
+    if version != FORMAT_VERSION:
+        raise JournalFormatError(f"{path}: unsupported journal version {version}")
+
+
+def read_symbols(path: str) -> List[str]:
+    with open(path, "rb") as handle:
+        data = handle.read()
+    _check_header(data, SYMBOL_MAGIC, path)
+
+    symbols: List[str] = []
+    offset = FILE_HEADER.size
+    while len(data) - offset >= SYMBOL_ENTRY.size:
+        symbol_id, length = SYMBOL_ENTRY.unpack_from(data, offset)
+        start = offset + SYMBOL_ENTRY.size
+        if start + length > len(data):
+            break  # torn tail entry; no sealed block references it
+        if symbol_id != len(symbols):
+            raise JournalFormatError(f"{path}: symbol ids out of order at byte {offset}")
+        symbols.append(data[start : start + length].decode("utf-8", errors="replace"))
+        offset = start + length
+    return symbols
+
+
+@dataclass
+class JournalReader:
+    """Reads a journal directory or a single segment file.
+
+    With `strict=False` a torn or corrupt block ends its segment quietly, which
+    is what a crash mid-write leaves behind.
+    """
+
+    path: str
+    strict: bool = False
+
+    def iter_events(self, limit: Optional[int] = None) -> Iterator[JournalEvent]:
+        count = 0
+        for segment in segment_paths(self.path):
+            for event in self._iter_segment(segment):
+                if limit is not None and count >= limit:
+                    return
+                yield event
+                count += 1
+
+    def read_events(self, limit: Optional[int] = None) -> List[JournalEvent]:
+        return list(self.iter_events(limit=limit))
+
+    def iter_segment_timestamps(self, segment: str) -> Iterator[int]:
+        """Record timestamps of one segment, without decoding the rest."""
+        for _, ts_us in self.iter_segment_index(segment):
+            yield ts_us
+
+    def iter_segment_index(self, segment: str) -> Iterator[Tuple[int, int]]:
+        """(byte offset of the enclosing block, timestamp) of each record in
+        one segment, without decoding the rest."""
+        with self._open_segment(segment) as data:
+            for block_offset, body_start in self._iter_records(data, segment):
+                (ts_us,) = TIMESTAMP.unpack_from(data, body_start)
+                yield block_offset, ts_us
+
+    def iter_segment_events(
+        self, segment: str, block_offset: int = FILE_HEADER.size
+    ) -> Iterator[JournalEvent]:
+        """Events of one segment from the block at `block_offset` on, which
+        must be a block start from `iter_segment_index`; earlier blocks are
+        neither read nor checked."""
+        return self._iter_segment(segment, block_offset)
+
+    def _iter_segment(self, path: str, block_offset: int = FILE_HEADER.size) -> Iterable[JournalEvent]:
+        symbols = read_symbols(os.path.splitext(path)[0] + ".sym")
+        with self._open_segment(path) as data:
+            for _, body_start in self._iter_records(data, path, block_offset):
+                fields = RECORD_BODY.unpack_from(data, body_start)
+                yield _event_from_fields(fields, symbols)
+
+    @contextmanager
+    def _open_segment(self, path: str) -> Iterator[memoryview]:
+        with open(path, "rb") as handle:
+            if os.fstat(handle.fileno()).st_size == 0:
+                raise JournalFormatError(f"{path}: file too small")
+            with mmap.mmap(handle.fileno(), 0, access=mmap.ACCESS_READ) as data:
+                _check_header(data[: FILE_HEADER.size], SEGMENT_MAGIC, path)
+                view = memoryview(data)
+                try:
+                    yield view
+                finally:
+                    view.release()
+
+    def _iter_records(
+        self, data: memoryview, path: str, offset: int = FILE_HEADER.size
+    ) -> Iterator[Tuple[int, int]]:
+        """(block offset, record body offset) of each record in checksummed
+        blocks, from the block at `offset` on."""
+        while offset < len(data):
+            if len(data) - offset < BLOCK_HEADER.size:
+                self._fail(f"{path}: truncated block at byte {offset}")
+                return
+            payload_len, record_count, crc = BLOCK_HEADER.unpack_from(data, offset)
+            start = offset + BLOCK_HEADER.size
+            end = start + payload_len
+            if end > len(data):
+                self._fail(f"{path}: truncated block at byte {offset}")
+                return
+            if zlib.crc32(data[start:end]) != crc:
+                self._fail(f"{path}: checksum mismatch in block at byte {offset}")
+                return
+
+            cursor = start
+            for _ in range(record_count):
+                (length,) = RECORD_LEN.unpack_from(data, cursor)
+                body_start = cursor + RECORD_LEN.size
+                if length < RECORD_BODY.size or body_start + length > end:
+                    self._fail(f"{path}: malformed record at byte {cursor}")
+                    return
+                yield offset, body_start
+                cursor = body_start + length
+            offset = end
+
+    def _fail(self, message: str) -> None:
+        if self.strict:
+            raise JournalFormatError(message)
+
+
+def _event_from_fields(fields: tuple, symbols: List[str]) -> JournalEvent:
+    ts_us, event_type, app_sym, title_sym, x, y, speed, idle_ms, churn = fields
+    try:
+        app_name = symbols[app_sym]
+        window_title = symbols[title_sym]
+    except IndexError as exc:
+        raise JournalFormatError("record references an unknown symbol") from exc
+    return JournalEvent(
+        timestamp_us=ts_us,
+        event_type=CaptureEventType(event_type),
+        app_name=app_name,
+        window_title=window_title,
+        mouse_x=x,
+        mouse_y=y,
+        mouse_speed=speed,
+        idle_duration_ms=idle_ms,
+        title_churn=churn,
+    )
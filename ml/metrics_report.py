@@ -12,7 +12,7 @@ from dataclasses import dataclass
 from typing import Dict, Optional
 
 from .event_log_reader import EventLogReader
-from .features import FeatureExtractor
+from .features import FeatureExtractor, capture_event_from_record
 
 
 @dataclass(frozen=True)
@@ -50,7 +50,9 @@ def collect_metrics(
         if event.app_name:
             unique_apps.add(event.app_name)
         if extractor is not None:
-            extractor.update(event)
+            capture_event = capture_event_from_record(event)
+            if capture_event is not None:
+                extractor.update(capture_event)
 
     duration_seconds = 0.0
     if total_events > 1 and first_ts is not None and last_ts is not None:
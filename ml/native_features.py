@@ -0,0 +1,101 @@
+"""
+Batch feature extraction through the engine's Rust extractor.
+
+The `snapback_features` extension (native/) compiles src-tauri's feature code
+for Python; build it into the active environment with:
+
+    pip install maturin numpy
+    maturin develop --release -m native/Cargo.toml
+
+Without the extension these functions fall back to the Python twin in
+ml/features.py (kept in step by test_feature_parity), so results match but
+run at Python speed.
+"""
+
+from __future__ import annotations
+
+from dataclasses import dataclass
+from typing import Iterable, List, Sequence
+
+from .features import FeatureExtractor
+from .journal_reader import JournalEvent, JournalReader
+from .training_pipeline import default_feature_columns
+
+try:
+    import snapback_features as _native
+except ImportError:  # pragma: no cover - depends on the local build
+    _native = None
+
+
+@dataclass(frozen=True)
+class FeatureMatrix:
+    columns: List[str]
+    # float32 ndarray (rows, columns) from the extension, else lists of floats.
+    values: Sequence[Sequence[float]]
+    # Index of the event each row was taken after.
+    event_index: Sequence[int]
+    productivity_category: List[str]
+
+    def __len__(self) -> int:
+        return len(self.event_index)
+
+
+def native_available() -> bool:
+    return _native is not None
+
+
+def journal_features(path: str, emit_interval_us: int = 0) -> FeatureMatrix:
+    """Features for a journal directory or segment.
+
+    A row is kept once `emit_interval_us` of event time has passed since the
+    previous one (0 keeps every event), like the engine's prediction cadence.
+    """
+    if _native is not None:
+        values, event_index, categories = _native.extract_journal(path, emit_interval_us)
+        return FeatureMatrix(list(_native.FEATURE_NAMES), values, event_index, categories)
+    return events_features(JournalReader(path).iter_events(), emit_interval_us)
+
+
+def events_features(events: Iterable[JournalEvent], emit_interval_us: int = 0) -> FeatureMatrix:
+    if _native is not None:
+        return _native_columns(list(events), emit_interval_us)
+
+    columns = default_feature_columns()
+    extractor = FeatureExtractor()
+    values: List[List[float]] = []
+    event_index: List[int] = []
+    categories: List[str] = []
+    last_emit_us = None
+    for idx, event in enumerate(events):
+        features = extractor.update(event)
+        if last_emit_us is not None and event.timestamp_us - last_emit_us < emit_interval_us:
+            continue
+        last_emit_us = event.timestamp_us
+        values.append([float(getattr(features, name)) for name in columns])
+        event_index.append(idx)
+        categories.append(features.productivity_category)
+    return FeatureMatrix(columns, values, event_index, categories)
+
+
+def _native_columns(events: List[JournalEvent], emit_interval_us: int) -> FeatureMatrix:
+    import numpy as np
+
+    symbol_ids = {}
+
+    def intern(text: str) -> int:
+        return symbol_ids.setdefault(text, len(symbol_ids))
+
+    app_id = np.fromiter((intern(e.app_name) for e in events), np.uint32, len(events))
+    title_id = np.fromiter((intern(e.window_title) for e in events), np.uint32, len(events))
+    values, event_index, categories = _native.extract_columns(
+        np.fromiter((e.timestamp_us for e in events), np.int64, len(events)),
+        np.fromiter((int(e.event_type) for e in events), np.uint8, len(events)),
+        app_id,
+        title_id,
+        np.fromiter((e.mouse_speed for e in events), np.uint32, len(events)),
+        np.fromiter((e.idle_duration_ms for e in events), np.uint32, len(events)),
+        np.fromiter((e.title_churn for e in events), np.uint32, len(events)),
+        list(symbol_ids),
+        emit_interval_us,
+    )
+    return FeatureMatrix(list(_native.FEATURE_NAMES), values, event_index, categories)
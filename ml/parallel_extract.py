@@ -0,0 +1,228 @@
+"""
+Build a training feature table from a long journal using every core.
+
+The journal is cut into shards at session gaps (or UTC day boundaries) by a
+timestamp-only scan. Each shard is replayed through a fresh extractor in a
+worker process, so feature state restarts per shard just as it does when the
+app starts a new session. Workers write fixed-width part files and the parent
+merges them back into timestamp order while streaming the output:
+
+    python -m ml.parallel_extract --journal ~/.snapback/journal --output features.csv
+
+Output is a feature store for `.sbf` or `.parquet` paths (see
+ml/feature_store.py), else CSV; `train_cli --features-csv` reads all three.
+"""
+
+from __future__ import annotations
+
+import argparse
+from concurrent.futures import ProcessPoolExecutor
+import csv
+from dataclasses import dataclass
+from datetime import datetime, timezone
+import heapq
+import os
+import struct
+import tempfile
+from typing import Iterator, List, Optional, Tuple
+
+from .feature_store import CATEGORIES, FeatureStoreWriter, is_store_path
+from .journal_reader import FILE_HEADER, JournalEvent, JournalReader, segment_paths
+from .native_features import events_features
+from .training_pipeline import default_feature_columns
+
+SESSION_GAP_US = 30 * 60 * 1_000_000
+SHARD_BY = ("session", "day")
+
+_COLUMNS = default_feature_columns()
+_PART_ROW = struct.Struct(f"<qB{len(_COLUMNS)}f")
+
+
+@dataclass(frozen=True)
+class Shard:
+    index: int
+    # (segment index, record index) of the first record, and one past the last.
+    start: Tuple[int, int]
+    stop: Tuple[int, int]
+    first_us: int
+    records: int
+    # (byte offset, record index) of the block holding the first record, so
+    # a worker seeks there instead of decoding the segment from record 0.
+    start_block: Tuple[int, int] = (FILE_HEADER.size, 0)
+
+
+def output_headers() -> List[str]:
+    return ["timestamp", "timestamp_us", "productivity_category", *_COLUMNS]
+
+
+def _starts_shard(ts_us: int, prev_us: Optional[int], by: str, gap_us: int) -> bool:
+    if prev_us is None:
+        return True
+    if by == "day":
+        day = datetime.fromtimestamp(ts_us // 1_000_000, timezone.utc).date()
+        prev_day = datetime.fromtimestamp(prev_us // 1_000_000, timezone.utc).date()
+        return day != prev_day
+    return ts_us - prev_us >= gap_us
+
+
+def plan_shards(journal: str, by: str = "session", session_gap_us: int = SESSION_GAP_US) -> List[Shard]:
+    """Shard boundaries from a timestamp scan; no events are decoded."""
+    if by not in SHARD_BY:
+        raise ValueError(f"unknown shard key {by!r}; expected one of {SHARD_BY}")
+
+    reader = JournalReader(journal)
+    starts: List[Tuple[Tuple[int, int], Tuple[int, int], int, int]] = []
+    prev_us = None
+    total = 0
+    end = (0, 0)
+    for seg_idx, segment in enumerate(segment_paths(journal)):
+        record = -1
+        block = (FILE_HEADER.size, 0)
+        for record, (block_offset, ts_us) in enumerate(reader.iter_segment_index(segment)):
+            if block_offset != block[0]:
+                block = (block_offset, record)
+            if _starts_shard(ts_us, prev_us, by, session_gap_us):
+                starts.append(((seg_idx, record), block, ts_us, total))
+            prev_us = ts_us
+            total += 1
+        if record >= 0:
+            end = (seg_idx, record + 1)
+
+    shards = []
+    for idx, (start, start_block, first_us, ordinal) in enumerate(starts):
+        if idx + 1 < len(starts):
+            stop, next_ordinal = starts[idx + 1][0], starts[idx + 1][3]
+        else:
+            stop, next_ordinal = end, total
+        shards.append(Shard(idx, start, stop, first_us, next_ordinal - ordinal, start_block))
+    return shards
+
+
+def _shard_events(segments: List[str], shard: Shard) -> Iterator[JournalEvent]:
+    (start_seg, start_rec), (stop_seg, stop_rec) = shard.start, shard.stop
+    block_offset, block_rec = shard.start_block
+    reader = JournalReader(segments[start_seg])
+    for seg_idx in range(start_seg, stop_seg + 1):
+        if seg_idx == start_seg:
+            events = reader.iter_segment_events(segments[seg_idx], block_offset)
+            first_rec = block_rec
+        else:
+            events = reader.iter_segment_events(segments[seg_idx])
+            first_rec = 0
+        for record, event in enumerate(events, start=first_rec):
+            if seg_idx == start_seg and record < start_rec:
+                continue
+            if seg_idx == stop_seg and record >= stop_rec:
+                return
+            yield event
+
+
+def _extract_shard(job: Tuple[List[str], Shard, int, str]) -> Tuple[int, int]:
+    segments, shard, emit_interval_us, part_path = job
+    events = list(_shard_events(segments, shard))
+    matrix = events_features(events, emit_interval_us)
+    with open(part_path, "wb") as handle:
+        for row, event_idx in enumerate(matrix.event_index):
+            handle.write(
+                _PART_ROW.pack(
+                    events[event_idx].timestamp_us,
+                    CATEGORIES.index(matrix.productivity_category[row]),
+                    *matrix.values[row],
+                )
+            )
+    return shard.index, len(matrix)
+
+
+def _read_part(path: str) -> Iterator[tuple]:
+    with open(path, "rb") as handle:
+        while True:
+            chunk = handle.read(_PART_ROW.size * 4096)
+            if not chunk:
+                return
+            yield from _PART_ROW.iter_unpack(chunk)
+
+
+def _merged_rows(part_paths: List[str]) -> Iterator[tuple]:
+    # Ties keep shard order; heapq.merge is stable across its inputs.
+    return heapq.merge(*(_read_part(path) for path in part_paths), key=lambda row: row[0])
+
+
+def _write_csv(path: str, rows: Iterator[tuple]) -> int:
+    count = 0
+    with open(path, "w", newline="", encoding="utf-8") as handle:
+        writer = csv.writer(handle)
+        writer.writerow(output_headers())
+        for ts_us, category, *values in rows:
+            writer.writerow(
+                [f"{ts_us / 1_000_000:.6f}", ts_us, CATEGORIES[category]]
+                + [f"{value:.9g}" for value in values]
+            )
+            count += 1
+    return count
+
+
+def _write_store(path: str, rows: Iterator[tuple]) -> int:
+    with FeatureStoreWriter(path, _COLUMNS) as writer:
+        for ts_us, category, *values in rows:
+            writer.append(ts_us, values, category=CATEGORIES[category])
+    return writer.rows_written
+
+
+def extract_parallel(
+    journal: str,
+    output: str,
+    by: str = "session",
+    workers: Optional[int] = None,
+    emit_interval_us: int = 0,
+    session_gap_us: int = SESSION_GAP_US,
+) -> int:
+    """Write the feature table for `journal` to `output`; returns the row count."""
+    segments = segment_paths(journal)
+    shards = plan_shards(journal, by=by, session_gap_us=session_gap_us)
+    workers = max(1, min(workers or os.cpu_count() or 1, max(1, len(shards))))
+
+    with tempfile.TemporaryDirectory(prefix="snapback-shards-") as scratch:
+        part_paths = [os.path.join(scratch, f"shard-{s.index:06d}.bin") for s in shards]
+        jobs = [(segments, s, emit_interval_us, part_paths[s.index]) for s in shards]
+        # Longest shards first so one big session doesn't start last.
+        jobs.sort(key=lambda job: job[1].records, reverse=True)
+        if workers == 1:
+            for job in jobs:
+                _extract_shard(job)
+        else:
+            with ProcessPoolExecutor(max_workers=workers) as pool:
+                list(pool.map(_extract_shard, jobs))
+
+        rows = _merged_rows(part_paths)
+        if is_store_path(output):
+            return _write_store(output, rows)
+        return _write_csv(output, rows)
+
+
+def parse_args(argv: Optional[List[str]] = None) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Extract training features from a journal in parallel.")
+    parser.add_argument("--journal", required=True, help="Journal directory or segment file.")
+    parser.add_argument("--output", required=True, help="Output .csv, .sbf or .parquet path.")
+    parser.add_argument("--by", choices=SHARD_BY, default="session")
+    parser.add_argument("--session-gap-minutes", type=float, default=SESSION_GAP_US / 60_000_000)
+    parser.add_argument("--workers", type=int, default=None, help="Defaults to the CPU count.")
+    parser.add_argument("--emit-interval-ms", type=int, default=0, help="Minimum gap between rows.")
+    return parser.parse_args(argv)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    args = parse_args(argv)
+    count = extract_parallel(
+        args.journal,
+        args.output,
+        by=args.by,
+        workers=args.workers,
+        emit_interval_us=args.emit_interval_ms * 1_000,
+        session_gap_us=int(args.session_gap_minutes * 60_000_000),
+    )
+    print(f"Wrote {count} feature rows to {args.output}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,103 @@
+"""
+Fixed-memory streaming quantiles (DDSketch) for timing features.
+
+Mirrors src-tauri/src/engine/sketch.rs: same bins, same slot ids, same
+quantile rule, so both sides produce the same estimates.
+"""
+
+from __future__ import annotations
+
+import math
+from typing import List, Sequence
+
+RELATIVE_ACCURACY = 0.02
+MIN_VALUE = 1e-3
+BINS = 512
+
+_GAMMA = (1.0 + RELATIVE_ACCURACY) / (1.0 - RELATIVE_ACCURACY)
+_EMPTY_SLOT = None
+
+
+def _bin_for(value: float) -> int:
+    if not value > MIN_VALUE:
+        return 0
+    key = math.ceil(math.log(value / MIN_VALUE) / math.log(_GAMMA))
+    return min(int(key), BINS - 1)
+
+
+def _bin_value(key: int) -> float:
+    if key == 0:
+        return 0.0
+    return MIN_VALUE * 2.0 * _GAMMA**key / (_GAMMA + 1.0)
+
+
+class DDSketch:
+    def __init__(self) -> None:
+        self.bins: List[int] = [0] * BINS
+        self.count = 0
+
+    def add(self, value: float) -> None:
+        self.bins[_bin_for(value)] += 1
+        self.count += 1
+
+    def subtract(self, other: "DDSketch") -> None:
+        for key, n in enumerate(other.bins):
+            self.bins[key] -= n
+        self.count -= other.count
+
+    def clear(self) -> None:
+        self.bins = [0] * BINS
+        self.count = 0
+
+    def quantiles(self, qs: Sequence[float]) -> List[float]:
+        """Estimates for ascending quantiles; an empty sketch reports zeros."""
+        out = [0.0] * len(qs)
+        if self.count == 0:
+            return out
+        last = self.count - 1
+        nxt = 0
+        seen = 0
+        for key, n in enumerate(self.bins):
+            if n == 0:
+                continue
+            seen += n
+            while nxt < len(qs) and math.floor(min(max(qs[nxt], 0.0), 1.0) * last) < seen:
+                out[nxt] = _bin_value(key)
+                nxt += 1
+            if nxt == len(qs):
+                break
+        return out
+
+
+class WindowedSketch:
+    """A sketch over the trailing ``slots * slot_us`` of event time."""
+
+    def __init__(self, span_us: int, slots: int) -> None:
+        slots = max(1, slots)
+        self.slot_us = max(1, span_us // slots)
+        self.slot_ids: List[object] = [_EMPTY_SLOT] * slots
+        self.slots = [DDSketch() for _ in range(slots)]
+        self.newest_slot: object = _EMPTY_SLOT
+        self.total = DDSketch()
+
+    def advance(self, now_us: int) -> None:
+        oldest_live = now_us // self.slot_us - (len(self.slots) - 1)
+        for idx, slot_id in enumerate(self.slot_ids):
+            if slot_id is not _EMPTY_SLOT and slot_id < oldest_live:
+                self.total.subtract(self.slots[idx])
+                self.slots[idx].clear()
+                self.slot_ids[idx] = _EMPTY_SLOT
+
+    def record(self, at_us: int, value: float) -> None:
+        slot_id = at_us // self.slot_us
+        if self.newest_slot is not _EMPTY_SLOT:
+            slot_id = max(slot_id, self.newest_slot)
+        self.newest_slot = slot_id
+        self.advance(max(at_us, slot_id * self.slot_us))
+        idx = slot_id % len(self.slots)
+        self.slot_ids[idx] = slot_id
+        self.slots[idx].add(value)
+        self.total.add(value)
+
+    def quantiles(self, qs: Sequence[float]) -> List[float]:
+        return self.total.quantiles(qs)
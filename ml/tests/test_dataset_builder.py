@@ -5,10 +5,12 @@ import unittest
 
 from ml.dataset_builder import (
     join_features_with_labels,
+    label_feature_table,
     read_features_csv,
     read_labels_csv,
     write_labeled_csv,
 )
+from ml.feature_store import LABEL_MISSING, convert_csv, read_feature_table
 from ml.features import FeatureVector, write_features_csv
 from ml.labeling import FocusLabel, LabelRecord, LabelSource
 
@@ -25,6 +27,12 @@ def make_feature(timestamp: float, keystrokes: int) -> FeatureVector:
         keystroke_interval_mean=0.5,
         keystroke_interval_std=0.1,
         keystroke_interval_trend=0.0,
+        keystroke_interval_p10=0.0,
+        keystroke_interval_p50=0.0,
+        keystroke_interval_p90=0.0,
+        burst_length_p10=0.0,
+        burst_length_p50=0.0,
+        burst_length_p90=0.0,
         mouse_move_count=0,
         mouse_distance_pixels=0.0,
         mouse_speed_mean=0.0,
@@ -100,6 +108,29 @@ class TestDatasetBuilder(unittest.TestCase):
             self.assertEqual(len(joined), 1)
             self.assertEqual(joined[0]["label"], "")
 
+    def test_label_feature_table_matches_csv_join(self) -> None:
+        features = [make_feature(10.0, 5), make_feature(20.0, 6), make_feature(40.0, 7)]
+        labels = [LabelRecord(25.0, FocusLabel.PRODUCTIVE, LabelSource.HOTKEY, "s1")]
+
+        with tempfile.TemporaryDirectory() as tmp:
+            feature_path = os.path.join(tmp, "features.csv")
+            store_path = os.path.join(tmp, "features.sbf")
+            write_features_csv(feature_path, features)
+            convert_csv(feature_path, store_path)
+
+            joined = join_features_with_labels(read_features_csv(feature_path), labels, label_window_seconds=20)
+            table = label_feature_table(read_feature_table(store_path), labels, label_window_seconds=20)
+
+            self.assertEqual(table.timestamps, [float(row["timestamp"]) for row in joined])
+            self.assertEqual(list(table.labels), [int(row["label"]) for row in joined])
+            keys = table.columns.index("keystroke_count")
+            self.assertEqual([float(row[keys]) for row in table.values], [5.0, 6.0])
+
+            unlabeled = label_feature_table(
+                read_feature_table(store_path), labels, label_window_seconds=1, keep_unlabeled=True
+            )
+            self.assertEqual(list(unlabeled.labels), [LABEL_MISSING] * 3)
+
 
 if __name__ == "__main__":
     unittest.main()
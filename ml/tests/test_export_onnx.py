@@ -1,12 +1,150 @@
+"""
+ONNX export parity.
+
+`fixtures/tree_model/model.onnx` is `fixtures/tree_model/model.json` exported
+to ONNX; onnxruntime here and the Rust `onnx` feature
+(`engine::onnx_model::tests::fixture_matches_reference_probabilities`) must
+reproduce the tree fixture's `golden_probas.csv`. Regenerate with
+`SNAPBACK_UPDATE_ONNX_FIXTURE=1 python -m unittest ml.tests.test_export_onnx`;
+with xgboost and skl2onnx installed the model goes through
+`export_xgboost_to_onnx`, otherwise the same TreeEnsembleClassifier graph is
+built with `onnx.helper`.
+"""
+
+import math
+import os
 import unittest
 
+from ml.tests.test_tree_model import FIXTURE_DIR, MODEL_PATH, _read_golden
+from ml.tree_model import TreeEnsemble
+from ml.training_pipeline import default_feature_columns
+
+try:
+    import onnx
+    from onnx import TensorProto, helper
+except ImportError:  # pragma: no cover - optional dependency
+    onnx = None
+
+try:
+    import onnxruntime
+except ImportError:  # pragma: no cover - optional dependency
+    onnxruntime = None
+
+ONNX_PATH = os.path.join(FIXTURE_DIR, "model.onnx")
+# Names `engine::onnx_model` reads.
+INPUT_NAME = "input"
+PROBABILITY_OUTPUT = "probabilities"
+# onnxruntime sums leaves and takes the softmax in its own order.
+TOLERANCE = 1e-5
+
+
+def _tree_ensemble_graph(model: TreeEnsemble):
+    """The TreeEnsembleClassifier skl2onnx writes for an XGBoost classifier."""
+    if model.label_index != list(range(model.class_count)):
+        raise ValueError("the fixture exporter only handles models over all labels in order")
+    nodes = {key: [] for key in ("treeids", "nodeids", "featureids", "values", "modes", "true", "false", "missing")}
+    leaves = {key: [] for key in ("treeids", "nodeids", "ids", "weights")}
+    for tree_id, (tree, cls) in enumerate(zip(model.trees, model.tree_class)):
+        for node, left in enumerate(tree.left):
+            is_leaf = left < 0
+            nodes["treeids"].append(tree_id)
+            nodes["nodeids"].append(node)
+            nodes["featureids"].append(0 if is_leaf else tree.feature[node])
+            nodes["values"].append(0.0 if is_leaf else tree.condition[node])
+            nodes["modes"].append("LEAF" if is_leaf else "BRANCH_LT")
+            nodes["true"].append(0 if is_leaf else left)
+            nodes["false"].append(0 if is_leaf else tree.right[node])
+            nodes["missing"].append(0 if is_leaf else int(tree.default_left[node]))
+            if is_leaf:
+                leaves["treeids"].append(tree_id)
+                leaves["nodeids"].append(node)
+                leaves["ids"].append(cls)
+                leaves["weights"].append(tree.condition[node])
+
+    width = len(default_feature_columns())
+    classifier = helper.make_node(
+        "TreeEnsembleClassifier",
+        [INPUT_NAME],
+        ["label", PROBABILITY_OUTPUT],
+        domain="ai.onnx.ml",
+        base_values=[model.base_margin] * model.class_count,
+        classlabels_int64s=list(range(model.class_count)),
+        post_transform="SOFTMAX",
+        nodes_treeids=nodes["treeids"],
+        nodes_nodeids=nodes["nodeids"],
+        nodes_featureids=nodes["featureids"],
+        nodes_values=nodes["values"],
+        nodes_modes=nodes["modes"],
+        nodes_truenodeids=nodes["true"],
+        nodes_falsenodeids=nodes["false"],
+        nodes_missing_value_tracks_true=nodes["missing"],
+        nodes_hitrates=[1.0] * len(nodes["treeids"]),
+        class_treeids=leaves["treeids"],
+        class_nodeids=leaves["nodeids"],
+        class_ids=leaves["ids"],
+        class_weights=leaves["weights"],
+    )
+    graph = helper.make_graph(
+        [classifier],
+        "snapback_tree_fixture",
+        [helper.make_tensor_value_info(INPUT_NAME, TensorProto.FLOAT, [None, width])],
+        [
+            helper.make_tensor_value_info("label", TensorProto.INT64, [None]),
+            helper.make_tensor_value_info(PROBABILITY_OUTPUT, TensorProto.FLOAT, [None, model.class_count]),
+        ],
+    )
+    return helper.make_model(
+        graph,
+        opset_imports=[helper.make_opsetid("", 15), helper.make_opsetid("ai.onnx.ml", 1)],
+        ir_version=8,
+    )
+
+
+def _write_fixture() -> None:
+    from ml import export_onnx
+
+    try:
+        export_onnx.export_xgboost_to_onnx(MODEL_PATH, ONNX_PATH)
+    except RuntimeError:
+        exported = _tree_ensemble_graph(TreeEnsemble.load(MODEL_PATH))
+        onnx.checker.check_model(exported)
+        with open(ONNX_PATH, "wb") as handle:
+            handle.write(exported.SerializeToString())
+
 
 class ExportOnnxTests(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls) -> None:
+        if os.environ.get("SNAPBACK_UPDATE_ONNX_FIXTURE"):
+            _write_fixture()
+
     def test_module_imports(self) -> None:
         from ml import export_onnx
 
         self.assertTrue(callable(export_onnx.main))
 
+    @unittest.skipIf(onnx is None, "onnx not installed")
+    def test_fixture_has_the_names_the_runtime_reads(self) -> None:
+        model = onnx.load(ONNX_PATH)
+        onnx.checker.check_model(model)
+        self.assertEqual([i.name for i in model.graph.input], [INPUT_NAME])
+        self.assertIn(PROBABILITY_OUTPUT, [o.name for o in model.graph.output])
+        dims = model.graph.input[0].type.tensor_type.shape.dim
+        self.assertEqual(dims[1].dim_value, len(default_feature_columns()))
+
+    @unittest.skipIf(onnxruntime is None, "onnxruntime not installed")
+    def test_onnxruntime_matches_golden(self) -> None:
+        rows, expected = _read_golden()
+        self.assertTrue(any(math.isnan(v) for row in rows for v in row))
+        session = onnxruntime.InferenceSession(ONNX_PATH, providers=["CPUExecutionProvider"])
+        import numpy as np
+
+        (probas,) = session.run([PROBABILITY_OUTPUT], {INPUT_NAME: np.asarray(rows, dtype=np.float32)})
+        self.assertEqual(len(probas), len(expected))
+        for idx, (got, want) in enumerate(zip(probas.tolist(), expected)):
+            for g, w in zip(got, want):
+                self.assertAlmostEqual(g, w, delta=TOLERANCE, msg=f"row {idx}")
+
 
 if __name__ == "__main__":
     unittest.main()
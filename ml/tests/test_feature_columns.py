@@ -0,0 +1,27 @@
+import os
+import re
+import unittest
+
+from ml.training_pipeline import default_feature_columns
+
+TENSOR_RS = os.path.join(
+    os.path.dirname(__file__), "..", "..", "src-tauri", "src", "engine", "tensor.rs"
+)
+
+
+def rust_feature_names() -> list:
+    with open(TENSOR_RS, "r", encoding="utf-8") as handle:
+        source = handle.read()
+    match = re.search(r"pub const FEATURE_NAMES[^=]*=\s*\[(.*?)\];", source, re.S)
+    if match is None:
+        raise AssertionError("FEATURE_NAMES not found in tensor.rs")
+    return re.findall(r'"([^"]+)"', match.group(1))
+
+
+class TestFeatureColumns(unittest.TestCase):
+    def test_training_columns_match_rust_tensor_layout(self) -> None:
+        self.assertEqual(default_feature_columns(), rust_feature_names())
+
+
+if __name__ == "__main__":
+    unittest.main()
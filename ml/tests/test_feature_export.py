@@ -18,6 +18,12 @@ def make_feature(seed: int) -> FeatureVector:
         keystroke_interval_mean=0.2,
         keystroke_interval_std=0.1,
         keystroke_interval_trend=-0.05,
+        keystroke_interval_p10=0.0,
+        keystroke_interval_p50=0.0,
+        keystroke_interval_p90=0.0,
+        burst_length_p10=0.0,
+        burst_length_p50=0.0,
+        burst_length_p90=0.0,
         mouse_move_count=seed + 2,
         mouse_distance_pixels=120.0,
         mouse_speed_mean=200.0,
@@ -0,0 +1,59 @@
+"""
+Golden-vector parity between ml/features.py and the Rust engine.
+
+The fixture journal and golden_features.csv are written by the Rust test
+`engine::features::tests::features_match_golden_vectors`; regenerate both with
+`SNAPBACK_UPDATE_PARITY=1 cargo test features_match_golden_vectors` after an
+intended feature change.
+"""
+
+import csv
+import os
+import unittest
+
+from ml.features import FeatureExtractor
+from ml.journal_reader import JournalReader
+from ml.training_pipeline import default_feature_columns
+
+FIXTURE_DIR = os.path.join(os.path.dirname(__file__), "fixtures", "parity")
+
+# Same tolerances as the Rust side.
+ABS_TOL = 1e-6
+REL_TOL = 1e-5
+
+
+def _numeric(value) -> float:
+    return float(int(value)) if isinstance(value, bool) else float(value)
+
+
+class TestFeatureParity(unittest.TestCase):
+    def test_python_extractor_matches_golden_vectors(self) -> None:
+        extractor = FeatureExtractor()
+        features = [extractor.update(e) for e in JournalReader(FIXTURE_DIR, strict=True).iter_events()]
+
+        with open(os.path.join(FIXTURE_DIR, "golden_features.csv"), newline="", encoding="utf-8") as handle:
+            reader = csv.reader(handle)
+            header = next(reader)
+            self.assertEqual(header[:2], ["event", "productivity_category"])
+            columns = header[2:]
+            self.assertEqual(columns, default_feature_columns())
+            rows = list(reader)
+
+        self.assertGreater(len(rows), 0)
+        drift = []
+        for row in rows:
+            idx = int(row[0])
+            actual = features[idx]
+            if actual.productivity_category != row[1]:
+                drift.append(f"event {idx}: productivity_category {actual.productivity_category} vs golden {row[1]}")
+            for name, cell in zip(columns, row[2:]):
+                expected = float(cell)
+                value = _numeric(getattr(actual, name))
+                if abs(value - expected) > ABS_TOL + REL_TOL * abs(expected):
+                    drift.append(f"event {idx}: {name} = {value} vs golden {expected}")
+
+        self.assertFalse(drift, f"{len(drift)} values drifted:\n" + "\n".join(drift[:20]))
+
+
+if __name__ == "__main__":
+    unittest.main()
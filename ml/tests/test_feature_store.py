@@ -0,0 +1,99 @@
+import csv
+import os
+import tempfile
+import unittest
+
+from ml.feature_store import (
+    LABEL_MISSING,
+    FeatureStoreError,
+    FeatureStoreWriter,
+    convert_csv,
+    read_feature_table,
+    read_sbf_footer,
+)
+from ml.training_pipeline import default_feature_columns, load_dataset
+
+try:
+    import pyarrow  # noqa: F401
+except ImportError:
+    pyarrow = None
+
+COLUMNS = ["keystroke_rate", "mouse_speed_mean", "is_ide"]
+
+
+def _write_rows(path: str, count: int, row_group_rows: int = 4) -> None:
+    with FeatureStoreWriter(path, COLUMNS, row_group_rows=row_group_rows) as writer:
+        for i in range(count):
+            writer.append(
+                1_000_000 * (i + 1),
+                [i * 0.5, i * 1.25, float(i % 2)],
+                category="Building" if i % 2 else "Browsing",
+                label=LABEL_MISSING if i == 3 else i % 3 - 1,
+            )
+
+
+class TestFeatureStore(unittest.TestCase):
+    def _roundtrip(self, suffix: str) -> None:
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "features" + suffix)
+            _write_rows(path, 10)
+
+            table = read_feature_table(path)
+            self.assertEqual(table.columns, COLUMNS)
+            self.assertEqual(list(table.timestamp_us), [1_000_000 * (i + 1) for i in range(10)])
+            self.assertEqual(list(table.labels)[:5], [-1, 0, 1, LABEL_MISSING, 0])
+            self.assertEqual(table.productivity_category[:2], ["Browsing", "Building"])
+            self.assertEqual([float(v) for v in table.values[7]], [3.5, 8.75, 1.0])
+
+            window = read_feature_table(path, columns=["is_ide"], start_us=3_000_000, end_us=6_000_000)
+            self.assertEqual(list(window.timestamp_us), [3_000_000, 4_000_000, 5_000_000])
+            self.assertEqual([[float(v) for v in row] for row in window.values], [[0.0], [1.0], [0.0]])
+
+    def test_sbf_roundtrip_and_time_range(self) -> None:
+        self._roundtrip(".sbf")
+
+    @unittest.skipIf(pyarrow is None, "pyarrow not installed")
+    def test_parquet_roundtrip_and_time_range(self) -> None:
+        self._roundtrip(".parquet")
+
+    def test_row_group_ranges_allow_pruning(self) -> None:
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "features.sbf")
+            _write_rows(path, 10)
+            columns, _, groups = read_sbf_footer(path)
+            self.assertEqual(columns, COLUMNS)
+            self.assertEqual([g.rows for g in groups], [4, 4, 2])
+            self.assertEqual([(g.ts_min, g.ts_max) for g in groups][1], (5_000_000, 8_000_000))
+            self.assertEqual([g.overlaps(9_000_000, None) for g in groups], [False, False, True])
+
+            with self.assertRaises(FeatureStoreError):
+                read_feature_table(path, columns=["missing"])
+            with open(path, "r+b") as handle:
+                handle.truncate(os.path.getsize(path) - 1)
+            with self.assertRaises(FeatureStoreError):
+                read_feature_table(path)
+
+    def test_load_dataset_matches_csv(self) -> None:
+        columns = default_feature_columns()
+        with tempfile.TemporaryDirectory() as tmp:
+            csv_path = os.path.join(tmp, "dataset.csv")
+            store_path = os.path.join(tmp, "dataset.sbf")
+            with open(csv_path, "w", newline="", encoding="utf-8") as handle:
+                writer = csv.DictWriter(handle, fieldnames=["timestamp", *columns, "label"])
+                writer.writeheader()
+                for i in range(6):
+                    row = {name: f"{(i + j) * 0.25:.2f}" for j, name in enumerate(columns)}
+                    row.update({"timestamp": f"{100.5 + i}", "label": "" if i == 2 else str(i % 4 - 1)})
+                    writer.writerow(row)
+
+            self.assertEqual(convert_csv(csv_path, store_path), 6)
+            from_csv = load_dataset(csv_path)
+            from_store = load_dataset(store_path)
+            self.assertEqual(from_store.labels, from_csv.labels)
+            self.assertEqual(from_store.timestamps, from_csv.timestamps)
+            for stored, parsed in zip(from_store.features, from_csv.features):
+                self.assertEqual([float(v) for v in stored], parsed)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -1,18 +1,39 @@
 import unittest
 
 from ml.event_schema import EventRecord, EventType
-from ml.features import FeatureExtractor, MOUSE_MOVE_STRUCT, IDLE_STRUCT
+from ml.features import FeatureExtractor, MOUSE_MOVE_STRUCT, IDLE_STRUCT, capture_event_from_record
+from ml.journal_reader import CaptureEventType, JournalEvent
 
 
-def make_event(event_type: EventType, ts_us: int, app_name: str, data_raw: bytes = b"") -> EventRecord:
-    data = data_raw.ljust(16, b"\x00")
+def make_event(
+    event_type: CaptureEventType,
+    ts_us: int,
+    app_name: str,
+    window_title: str = "",
+    mouse_speed: int = 0,
+    idle_duration_ms: int = 0,
+) -> JournalEvent:
+    return JournalEvent(
+        timestamp_us=ts_us,
+        event_type=event_type,
+        app_name=app_name,
+        window_title=window_title,
+        mouse_x=0,
+        mouse_y=0,
+        mouse_speed=mouse_speed,
+        idle_duration_ms=idle_duration_ms,
+        title_churn=0,
+    )
+
+
+def make_record(event_type: EventType, ts_us: int, app_name: str, data_raw: bytes = b"") -> EventRecord:
     return EventRecord(
         timestamp_us=ts_us,
         event_type=event_type,
         process_id=4242,
         app_name=app_name,
         window_handle=0,
-        data_raw=data,
+        data_raw=data_raw.ljust(16, b"\x00"),
         reserved=0,
     )
 
@@ -21,9 +42,9 @@ class TestFeatureExtractor(unittest.TestCase):
     def test_keystroke_rate_and_intervals(self) -> None:
         extractor = FeatureExtractor(window_seconds=30)
         events = [
-            make_event(EventType.KEY_PRESS, 0, "code.exe"),
-            make_event(EventType.KEY_PRESS, 500_000, "code.exe"),
-            make_event(EventType.KEY_PRESS, 1_000_000, "code.exe"),
+            make_event(CaptureEventType.KEY_PRESS, 0, "code.exe"),
+            make_event(CaptureEventType.KEY_PRESS, 500_000, "code.exe"),
+            make_event(CaptureEventType.KEY_PRESS, 1_000_000, "code.exe"),
         ]
         for event in events:
             features = extractor.update(event)
@@ -32,13 +53,28 @@ class TestFeatureExtractor(unittest.TestCase):
         self.assertAlmostEqual(features.keystroke_interval_mean, 0.5, places=3)
         self.assertTrue(features.is_ide)
 
+    def test_burst_length_percentiles(self) -> None:
+        extractor = FeatureExtractor(window_seconds=30)
+        ts = 0
+        for burst in (3, 5, 5, 8, 8):
+            for _ in range(burst):
+                features = extractor.update(make_event(CaptureEventType.KEY_PRESS, ts, "code.exe"))
+                ts += 200_000
+            ts += 2_000_000
+        features = extractor.update(make_event(CaptureEventType.MOUSE_CLICK, ts, "code.exe"))
+
+        self.assertAlmostEqual(features.burst_length_p10, 3.0, delta=0.1)
+        self.assertAlmostEqual(features.burst_length_p50, 5.0, delta=0.1)
+        self.assertAlmostEqual(features.burst_length_p90, 8.0, delta=0.2)
+        self.assertAlmostEqual(features.keystroke_interval_p10, 0.2, delta=0.005)
+
     def test_context_switches_and_apps(self) -> None:
         extractor = FeatureExtractor(window_seconds=30, long_window_seconds=300)
         events = [
-            make_event(EventType.WINDOW_FOCUS_CHANGE, 0, "code.exe"),
-            make_event(EventType.KEY_PRESS, 1_000_000, "code.exe"),
-            make_event(EventType.WINDOW_FOCUS_CHANGE, 2_000_000, "chrome.exe"),
-            make_event(EventType.KEY_PRESS, 3_000_000, "chrome.exe"),
+            make_event(CaptureEventType.WINDOW_FOCUS_CHANGE, 0, "code.exe"),
+            make_event(CaptureEventType.KEY_PRESS, 1_000_000, "code.exe"),
+            make_event(CaptureEventType.WINDOW_FOCUS_CHANGE, 2_000_000, "chrome.exe"),
+            make_event(CaptureEventType.KEY_PRESS, 3_000_000, "chrome.exe"),
         ]
         for event in events:
             features = extractor.update(event)
@@ -49,13 +85,10 @@ class TestFeatureExtractor(unittest.TestCase):
 
     def test_mouse_speed_and_idle(self) -> None:
         extractor = FeatureExtractor(window_seconds=30)
-        move1 = MOUSE_MOVE_STRUCT.pack(0, 0, 100)
-        move2 = MOUSE_MOVE_STRUCT.pack(10, 0, 300)
-        idle = IDLE_STRUCT.pack(10_000)
         events = [
-            make_event(EventType.MOUSE_MOVE, 0, "code.exe", move1),
-            make_event(EventType.MOUSE_MOVE, 1_000_000, "code.exe", move2),
-            make_event(EventType.IDLE_END, 2_000_000, "code.exe", idle),
+            make_event(CaptureEventType.MOUSE_MOVE, 0, "code.exe", mouse_speed=100),
+            make_event(CaptureEventType.MOUSE_MOVE, 1_000_000, "code.exe", mouse_speed=300),
+            make_event(CaptureEventType.IDLE_END, 2_000_000, "code.exe", idle_duration_ms=10_000),
         ]
         for event in events:
             features = extractor.update(event)
@@ -64,6 +97,31 @@ class TestFeatureExtractor(unittest.TestCase):
         self.assertGreater(features.mouse_speed_mean, 0.0)
         self.assertAlmostEqual(features.idle_time_30s, 10.0, places=2)
 
+    def test_classifies_by_app_name_and_title(self) -> None:
+        extractor = FeatureExtractor()
+        extractor.update(make_event(CaptureEventType.WINDOW_FOCUS_CHANGE, 0, "Cursor", "main.rs"))
+        features = extractor.update(
+            make_event(CaptureEventType.WINDOW_FOCUS_CHANGE, 1_000_000, "Google Chrome", "Cats – YouTube")
+        )
+
+        self.assertTrue(features.is_browser)
+        self.assertTrue(features.is_entertainment)
+        self.assertEqual(features.productivity_category, "Browsing")
+        self.assertEqual(features.window_title_length, len("Cats – YouTube".encode("utf-8")))
+
+    def test_legacy_records_use_capture_codes(self) -> None:
+        move = capture_event_from_record(
+            make_record(EventType.MOUSE_MOVE, 0, "code.exe", MOUSE_MOVE_STRUCT.pack(3, 4, 250))
+        )
+        focus = capture_event_from_record(make_record(EventType.WINDOW_FOCUS_CHANGE, 0, "code.exe"))
+        idle = capture_event_from_record(
+            make_record(EventType.IDLE_END, 0, "code.exe", IDLE_STRUCT.pack(9_000))
+        )
+
+        self.assertEqual((move.event_type, move.mouse_speed), (CaptureEventType.MOUSE_MOVE, 250))
+        self.assertEqual(focus.event_type, CaptureEventType.WINDOW_FOCUS_CHANGE)
+        self.assertEqual(idle.idle_duration_ms, 9_000)
+        self.assertIsNone(capture_event_from_record(make_record(EventType.MOUSE_WHEEL, 0, "code.exe")))
 
 if __name__ == "__main__":
     unittest.main()
@@ -0,0 +1,131 @@
+"""
+Heuristic mirror parity and tuning.
+
+`fixtures/heuristics/golden_scores.csv` holds heuristic inputs and the scores
+the Rust classifier gave them under the default parameters and
+`fixtures/heuristics/params.json`
+(`engine::classifier::tests::heuristic_matches_golden_scores`, regenerated
+with `SNAPBACK_UPDATE_HEURISTICS=1`). ml/heuristics.py must reproduce them
+exactly.
+"""
+
+import csv
+import json
+import os
+import re
+import tempfile
+import unittest
+
+from ml.heuristics import (
+    DEFAULT_PARAMS,
+    INPUT_NAMES,
+    PARAM_NAMES,
+    load_params,
+    predict_states,
+    score_row,
+)
+from ml.tune_heuristics import evaluate, main, tune
+
+ENGINE_DIR = os.path.join(os.path.dirname(__file__), "..", "..", "src-tauri", "src", "engine")
+FIXTURE_DIR = os.path.join(os.path.dirname(__file__), "fixtures", "heuristics")
+
+
+def _rust_array(file_name: str, const: str) -> str:
+    with open(os.path.join(ENGINE_DIR, file_name), "r", encoding="utf-8") as handle:
+        source = handle.read()
+    match = re.search(rf"const {const}[^=]*=\s*\[(.*?)\];", source, re.S)
+    if match is None:
+        raise AssertionError(f"{const} not found in {file_name}")
+    return re.sub(r"//[^\n]*", "", match.group(1))
+
+
+def _read_golden():
+    with open(os.path.join(FIXTURE_DIR, "golden_scores.csv"), newline="", encoding="utf-8") as handle:
+        reader = csv.DictReader(handle)
+        rows = list(reader)
+    assert reader.fieldnames[2 : 2 + len(INPUT_NAMES)] == INPUT_NAMES
+    return rows
+
+
+class TestHeuristics(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls) -> None:
+        cls.golden = _read_golden()
+        cls.params = {
+            "default": dict(DEFAULT_PARAMS),
+            "fixture": load_params(os.path.join(FIXTURE_DIR, "params.json")),
+        }
+
+    def test_names_and_defaults_match_rust(self) -> None:
+        self.assertEqual(re.findall(r'"([^"]+)"', _rust_array("heuristic_params.rs", "PARAM_NAMES")), PARAM_NAMES)
+        defaults = [float(v) for v in re.findall(r"[\d.]+", _rust_array("heuristic_params.rs", "DEFAULTS"))]
+        self.assertEqual(defaults, [DEFAULT_PARAMS[name] for name in PARAM_NAMES])
+        self.assertEqual(re.findall(r'"([^"]+)"', _rust_array("classifier.rs", "HEURISTIC_INPUT_NAMES")), INPUT_NAMES)
+
+    def test_scores_match_rust_classifier(self) -> None:
+        self.assertEqual({row["params"] for row in self.golden}, set(self.params))
+        for idx, row in enumerate(self.golden):
+            inputs = [float(row[name]) for name in INPUT_NAMES]
+            scores = score_row(inputs, self.params[row["params"]], row["focus_mode"])
+            msg = f"row {idx}"
+            self.assertEqual(scores.focus_state, row["focus_state"], msg)
+            self.assertEqual(scores.focus_score, float(row["focus_score"]), msg)
+            self.assertEqual(scores.distraction_risk, float(row["distraction_risk"]), msg)
+            self.assertEqual(scores.thrash_score, float(row["thrash_score"]), msg)
+            self.assertEqual(scores.drift_score, float(row["drift_score"]), msg)
+
+    def test_rejects_unknown_and_invalid_params(self) -> None:
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "heuristics.json")
+            for bad in ({"thrash.switch_weight": 0.5}, {"deep.settled_scale": 0}, {"override.drift": -1}):
+                with open(path, "w", encoding="utf-8") as handle:
+                    json.dump(bad, handle)
+                with self.assertRaises(ValueError):
+                    load_params(path)
+
+    def test_tuning_recovers_labels_from_other_params(self) -> None:
+        rows = [[float(r[name]) for name in INPUT_NAMES] for r in self.golden if r["focus_mode"] == "normal"]
+        labels = predict_states(rows, self.params["fixture"])
+        baseline = evaluate(rows, labels, DEFAULT_PARAMS)
+        tuned, score = tune(rows, labels, rounds=2)
+        self.assertGreater(score, baseline)
+        self.assertEqual(score, evaluate(rows, labels, tuned))
+
+    def test_cli_writes_loadable_params(self) -> None:
+        golden = [r for r in self.golden if r["params"] == "default" and r["focus_mode"] == "normal"]
+        target = self.params["fixture"]
+        with tempfile.TemporaryDirectory() as tmp:
+            inputs_path = os.path.join(tmp, "inputs.csv")
+            labels_path = os.path.join(tmp, "labels.csv")
+            output_path = os.path.join(tmp, "heuristics.json")
+            with open(inputs_path, "w", newline="", encoding="utf-8") as inputs, open(
+                labels_path, "w", newline="", encoding="utf-8"
+            ) as labels:
+                input_writer = csv.writer(inputs)
+                label_writer = csv.writer(labels)
+                input_writer.writerow(["timestamp"] + INPUT_NAMES)
+                label_writer.writerow(["timestamp", "label", "source", "session_id", "notes"])
+                for i, row in enumerate(golden):
+                    values = [row[name] for name in INPUT_NAMES]
+                    input_writer.writerow([1000 + 10 * i] + values)
+                    state = score_row([float(v) for v in values], target).focus_state
+                    label_writer.writerow([1000 + 10 * i, state, "MANUAL", "s1", ""])
+
+            self.assertEqual(
+                main(
+                    ["--inputs", inputs_path, "--labels", labels_path, "--output", output_path]
+                    + ["--rounds", "1", "--holdout", "0"]
+                ),
+                0,
+            )
+            with open(output_path, "r", encoding="utf-8") as handle:
+                self.assertLessEqual(set(json.load(handle)), set(PARAM_NAMES))
+            tuned = load_params(output_path)
+
+        rows = [[float(r[name]) for name in INPUT_NAMES] for r in golden]
+        labels = predict_states(rows, target)
+        self.assertGreaterEqual(evaluate(rows, labels, tuned), evaluate(rows, labels, DEFAULT_PARAMS))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,44 @@
+import os
+import shutil
+import tempfile
+import unittest
+
+from ml.journal_reader import (
+    CaptureEventType,
+    JournalFormatError,
+    JournalReader,
+)
+
+FIXTURE_DIR = os.path.join(os.path.dirname(__file__), "fixtures", "journal")
+
+
+class TestJournalReader(unittest.TestCase):
+    def test_reads_journal_written_by_rust(self) -> None:
+        events = JournalReader(FIXTURE_DIR, strict=True).read_events()
+        self.assertEqual(len(events), 6)
+        self.assertEqual(events[0].event_type, CaptureEventType.WINDOW_FOCUS_CHANGE)
+        self.assertEqual(events[0].window_title, "main.rs — snapback")
+        self.assertEqual((events[2].mouse_x, events[2].mouse_y), (-40, 900))
+        self.assertAlmostEqual(events[2].timestamp_secs, 1_700_000_001.25)
+        self.assertEqual(events[4].title_churn, 4)
+        self.assertEqual(events[5].app_name, "Google Chrome")
+
+    def test_corrupt_block_is_detected(self) -> None:
+        tmp = tempfile.mkdtemp()
+        try:
+            for name in os.listdir(FIXTURE_DIR):
+                shutil.copy(os.path.join(FIXTURE_DIR, name), tmp)
+            segment = os.path.join(tmp, "events-000001.sbj")
+            with open(segment, "r+b") as handle:
+                handle.seek(-3, os.SEEK_END)
+                handle.write(b"\xff")
+
+            self.assertEqual(JournalReader(tmp).read_events(), [])
+            with self.assertRaises(JournalFormatError):
+                JournalReader(tmp, strict=True).read_events()
+        finally:
+            shutil.rmtree(tmp)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,42 @@
+import csv
+import os
+import unittest
+
+from ml.journal_reader import JournalReader
+from ml.native_features import events_features, journal_features, native_available
+from ml.training_pipeline import default_feature_columns
+
+FIXTURE_DIR = os.path.join(os.path.dirname(__file__), "fixtures", "parity")
+
+
+class TestNativeFeatures(unittest.TestCase):
+    def test_journal_matrix_matches_golden_rows(self) -> None:
+        matrix = journal_features(FIXTURE_DIR)
+        self.assertEqual(matrix.columns, default_feature_columns())
+        self.assertEqual(list(matrix.event_index), list(range(len(matrix))))
+
+        with open(os.path.join(FIXTURE_DIR, "golden_features.csv"), newline="", encoding="utf-8") as handle:
+            rows = list(csv.reader(handle))[1:]
+        for row in rows[::25]:
+            idx = int(row[0])
+            self.assertEqual(matrix.productivity_category[idx], row[1])
+            for value, cell in zip(matrix.values[idx], row[2:]):
+                self.assertAlmostEqual(float(value), float(cell), delta=1e-6 + 1e-5 * abs(float(cell)))
+
+    def test_emit_interval_thins_rows(self) -> None:
+        events = JournalReader(FIXTURE_DIR).read_events()
+        matrix = events_features(events, emit_interval_us=5_000_000)
+        self.assertLess(len(matrix), len(events) // 4)
+        stamps = [events[i].timestamp_us for i in matrix.event_index]
+        self.assertTrue(all(b - a >= 5_000_000 for a, b in zip(stamps, stamps[1:])))
+
+    @unittest.skipUnless(native_available(), "snapback_features extension not built")
+    def test_columns_and_journal_paths_agree(self) -> None:
+        events = JournalReader(FIXTURE_DIR).read_events()
+        from_columns = events_features(events)
+        from_journal = journal_features(FIXTURE_DIR)
+        self.assertEqual(from_columns.values.tolist(), from_journal.values.tolist())
+
+
+if __name__ == "__main__":
+    unittest.main()
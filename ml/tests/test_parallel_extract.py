@@ -0,0 +1,130 @@
+import csv
+import os
+import shutil
+import tempfile
+import unittest
+import zlib
+
+from ml.dataset_builder import read_features_csv
+from ml.feature_store import read_feature_table
+from ml.journal_reader import BLOCK_HEADER, FILE_HEADER, RECORD_LEN, JournalReader, segment_paths
+from ml.native_features import events_features
+from ml.parallel_extract import extract_parallel, output_headers, plan_shards
+
+FIXTURE_DIR = os.path.join(os.path.dirname(__file__), "fixtures", "parity")
+# The fixture's only long gap is a 320 s break.
+FIVE_MINUTES_US = 300 * 1_000_000
+
+
+def _read_rows(path: str):
+    with open(path, newline="", encoding="utf-8") as handle:
+        reader = csv.reader(handle)
+        header = next(reader)
+        return header, list(reader)
+
+
+def _reblock(segment: str, records_per_block: int) -> None:
+    """Rewrite a segment with at most `records_per_block` records per block."""
+    with open(segment, "rb") as handle:
+        data = handle.read()
+    records = []
+    offset = FILE_HEADER.size
+    while offset < len(data):
+        payload_len, record_count, _crc = BLOCK_HEADER.unpack_from(data, offset)
+        cursor = offset + BLOCK_HEADER.size
+        for _ in range(record_count):
+            (length,) = RECORD_LEN.unpack_from(data, cursor)
+            records.append(data[cursor : cursor + RECORD_LEN.size + length])
+            cursor += RECORD_LEN.size + length
+        offset += BLOCK_HEADER.size + payload_len
+    with open(segment, "wb") as handle:
+        handle.write(data[: FILE_HEADER.size])
+        for first in range(0, len(records), records_per_block):
+            block = records[first : first + records_per_block]
+            payload = b"".join(block)
+            handle.write(BLOCK_HEADER.pack(len(payload), len(block), zlib.crc32(payload)))
+            handle.write(payload)
+
+
+class TestParallelExtract(unittest.TestCase):
+    def test_plan_splits_at_session_gaps(self) -> None:
+        events = JournalReader(FIXTURE_DIR).read_events()
+        shards = plan_shards(FIXTURE_DIR, by="session", session_gap_us=FIVE_MINUTES_US)
+        self.assertEqual(len(shards), 2)
+        self.assertEqual(shards[0].start, (0, 0))
+        self.assertEqual(shards[0].stop, shards[1].start)
+        self.assertEqual(shards[1].stop, (0, len(events)))
+        self.assertEqual(sum(s.records for s in shards), len(events))
+        split = shards[1].start[1]
+        self.assertGreaterEqual(events[split].timestamp_us - events[split - 1].timestamp_us, FIVE_MINUTES_US)
+
+        self.assertEqual(len(plan_shards(FIXTURE_DIR, by="day")), 1)
+        with self.assertRaises(ValueError):
+            plan_shards(FIXTURE_DIR, by="week")
+
+    def test_sharded_output_matches_per_shard_extraction(self) -> None:
+        events = JournalReader(FIXTURE_DIR).read_events()
+        shards = plan_shards(FIXTURE_DIR, session_gap_us=FIVE_MINUTES_US)
+        expected = []
+        for shard in shards:
+            chunk = events[shard.start[1] : shard.stop[1]]
+            matrix = events_features(chunk, emit_interval_us=2_000_000)
+            for row, idx in enumerate(matrix.event_index):
+                expected.append((chunk[idx].timestamp_us, matrix.values[row]))
+
+        with tempfile.TemporaryDirectory() as tmpdir:
+            outputs = []
+            for workers in (1, 2):
+                path = os.path.join(tmpdir, f"features-{workers}.csv")
+                count = extract_parallel(
+                    FIXTURE_DIR,
+                    path,
+                    workers=workers,
+                    emit_interval_us=2_000_000,
+                    session_gap_us=FIVE_MINUTES_US,
+                )
+                header, rows = _read_rows(path)
+                self.assertEqual(header, output_headers())
+                self.assertEqual(count, len(expected))
+                outputs.append(rows)
+            self.assertEqual(outputs[0], outputs[1])
+
+            stamps = [int(row[1]) for row in outputs[0]]
+            self.assertEqual(stamps, sorted(stamps))
+            for row, (ts_us, values) in zip(outputs[0], expected):
+                self.assertEqual(int(row[1]), ts_us)
+                for cell, value in zip(row[3:], values):
+                    self.assertAlmostEqual(float(cell), float(value), delta=1e-6 + 1e-5 * abs(float(value)))
+
+            feature_rows = read_features_csv(os.path.join(tmpdir, "features-1.csv"))
+            self.assertEqual(len(feature_rows), len(expected))
+            self.assertAlmostEqual(feature_rows[0].timestamp, expected[0][0] / 1_000_000, places=6)
+
+            store_path = os.path.join(tmpdir, "features.sbf")
+            extract_parallel(FIXTURE_DIR, store_path, workers=2, emit_interval_us=2_000_000, session_gap_us=FIVE_MINUTES_US)
+            table = read_feature_table(store_path)
+            self.assertEqual(list(table.timestamp_us), stamps)
+            self.assertEqual(table.productivity_category, [row[2] for row in outputs[0]])
+
+    def test_shards_start_at_their_first_block(self) -> None:
+        with tempfile.TemporaryDirectory() as tmpdir:
+            journal = os.path.join(tmpdir, "journal")
+            shutil.copytree(FIXTURE_DIR, journal)
+            _reblock(segment_paths(journal)[0], records_per_block=64)
+
+            shards = plan_shards(journal, session_gap_us=FIVE_MINUTES_US)
+            self.assertEqual(shards[0].start_block, (FILE_HEADER.size, 0))
+            block_offset, block_record = shards[1].start_block
+            self.assertGreater(block_offset, FILE_HEADER.size)
+            self.assertEqual(block_record, shards[1].start[1] // 64 * 64)
+
+            outputs = []
+            for source in (FIXTURE_DIR, journal):
+                path = os.path.join(tmpdir, f"features-{len(outputs)}.csv")
+                extract_parallel(source, path, workers=2, emit_interval_us=2_000_000, session_gap_us=FIVE_MINUTES_US)
+                outputs.append(_read_rows(path))
+            self.assertEqual(outputs[0], outputs[1])
+
+
+if __name__ == "__main__":
+    unittest.main()
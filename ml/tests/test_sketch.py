@@ -0,0 +1,33 @@
+import unittest
+
+from ml.sketch import RELATIVE_ACCURACY, DDSketch, WindowedSketch
+
+
+class TestSketch(unittest.TestCase):
+    def test_quantiles_are_within_relative_accuracy(self) -> None:
+        sketch = DDSketch()
+        values = [0.01 * i**1.3 for i in range(1, 10_001)]
+        for value in values:
+            sketch.add(value)
+        qs = (0.1, 0.5, 0.9)
+        for q, estimate in zip(qs, sketch.quantiles(qs)):
+            exact = values[int(q * (len(values) - 1))]
+            self.assertLessEqual(abs(estimate - exact), RELATIVE_ACCURACY * exact)
+        self.assertEqual(DDSketch().quantiles([0.5]), [0.0])
+
+    def test_windowed_sketch_forgets_old_slots(self) -> None:
+        window = WindowedSketch(30_000_000, 6)
+        for i in range(100):
+            window.record(i * 100_000, 0.1)
+        self.assertEqual(window.total.count, 100)
+        for i in range(10):
+            window.record(60_000_000 + i * 100_000, 2.0)
+        self.assertEqual(window.total.count, 10)
+        self.assertAlmostEqual(window.quantiles([0.5])[0], 2.0, delta=2.0 * RELATIVE_ACCURACY)
+
+        window.advance(200_000_000)
+        self.assertEqual(window.total.count, 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
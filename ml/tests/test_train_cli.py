@@ -4,6 +4,7 @@ import tempfile
 import unittest
 
 from ml.dataset_builder import join_features_with_labels, read_features_csv, write_labeled_csv
+from ml.feature_store import convert_csv, read_feature_table
 from ml.features import FeatureVector, write_features_csv
 from ml.labeling import FocusLabel, LabelRecord, LabelSource
 from ml.train_cli import run_training
@@ -21,6 +22,12 @@ def make_feature(timestamp: float, keystrokes: int) -> FeatureVector:
         keystroke_interval_mean=0.5,
         keystroke_interval_std=0.1,
         keystroke_interval_trend=0.0,
+        keystroke_interval_p10=0.0,
+        keystroke_interval_p50=0.0,
+        keystroke_interval_p90=0.0,
+        burst_length_p10=0.0,
+        burst_length_p50=0.0,
+        burst_length_p90=0.0,
         mouse_move_count=0,
         mouse_distance_pixels=0.0,
         mouse_speed_mean=0.0,
@@ -120,6 +127,45 @@ class TestTrainCli(unittest.TestCase):
             self.assertTrue(os.path.exists(model_path))
             self.assertTrue(os.path.exists(metrics_path))
 
+    def test_run_training_with_feature_store(self) -> None:
+        features = [make_feature(10.0, 5), make_feature(20.0, 6), make_feature(30.0, 7)]
+
+        with tempfile.TemporaryDirectory() as tmp:
+            feature_path = os.path.join(tmp, "features.csv")
+            store_path = os.path.join(tmp, "features.sbf")
+            labels_path = os.path.join(tmp, "labels.csv")
+            dataset_path = os.path.join(tmp, "dataset.sbf")
+
+            write_features_csv(feature_path, features)
+            convert_csv(feature_path, store_path)
+            with open(labels_path, "w", newline="", encoding="utf-8") as handle:
+                writer = csv.writer(handle)
+                writer.writerow(["timestamp", "label", "source", "session_id", "notes"])
+                writer.writerow([25.0, int(FocusLabel.PRODUCTIVE), "HOTKEY", "s1", ""])
+                writer.writerow([35.0, int(FocusLabel.DISTRACTED), "HOTKEY", "s1", ""])
+
+            metrics = run_training(
+                dataset_path=None,
+                features_path=store_path,
+                labels_path=labels_path,
+                output_dataset_path=dataset_path,
+                output_model_path=None,
+                output_metrics_path=None,
+                label_window_seconds=20,
+                backend="majority",
+                n_splits=2,
+                feature_columns=None,
+                label_column="label",
+            )
+
+            self.assertIn("recall_distracted", metrics)
+            dataset = read_feature_table(dataset_path)
+            self.assertEqual(list(dataset.timestamp_us), [10_000_000, 20_000_000, 30_000_000])
+            self.assertEqual(
+                list(dataset.labels),
+                [int(FocusLabel.PRODUCTIVE), int(FocusLabel.PRODUCTIVE), int(FocusLabel.DISTRACTED)],
+            )
+
 
 if __name__ == "__main__":
     unittest.main()
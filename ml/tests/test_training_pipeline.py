@@ -20,6 +20,12 @@ def make_feature(timestamp: float, keystrokes: int) -> FeatureVector:
         keystroke_interval_mean=0.5,
         keystroke_interval_std=0.1,
         keystroke_interval_trend=0.0,
+        keystroke_interval_p10=0.0,
+        keystroke_interval_p50=0.0,
+        keystroke_interval_p90=0.0,
+        burst_length_p10=0.0,
+        burst_length_p50=0.0,
+        burst_length_p90=0.0,
         mouse_move_count=0,
         mouse_distance_pixels=0.0,
         mouse_speed_mean=0.0,
@@ -0,0 +1,193 @@
+"""
+Tree-ensemble evaluation parity.
+
+`fixtures/tree_model` holds an XGBoost JSON model and the probabilities it
+gives for a set of feature rows; the Rust evaluator
+(`engine::tree_model::tests::matches_reference_probabilities`), ml/tree_model.py
+and, when installed, xgboost itself must all reproduce them. Regenerate with
+`SNAPBACK_UPDATE_TREE_FIXTURE=1 python -m unittest ml.tests.test_tree_model`;
+with xgboost installed the model is trained by xgboost, otherwise random trees
+are written in its JSON schema.
+"""
+
+import csv
+import json
+import math
+import os
+import random
+import unittest
+
+from ml.tree_model import TreeEnsemble, f32
+from ml.training_pipeline import LABEL_INDICES_ATTR, default_feature_columns
+
+try:
+    import xgboost as xgb
+except ImportError:  # pragma: no cover - optional dependency
+    xgb = None
+
+FIXTURE_DIR = os.path.join(os.path.dirname(__file__), "fixtures", "tree_model")
+MODEL_PATH = os.path.join(FIXTURE_DIR, "model.json")
+GOLDEN_PATH = os.path.join(FIXTURE_DIR, "golden_probas.csv")
+PARITY_FEATURES = os.path.join(os.path.dirname(__file__), "fixtures", "parity", "golden_features.csv")
+PROBA_COLUMNS = ["p_distracted", "p_pseudo_productive", "p_productive", "p_deep_focus"]
+TOLERANCE = 1e-6
+
+
+def _feature_rows():
+    with open(PARITY_FEATURES, newline="", encoding="utf-8") as handle:
+        rows = [[f32(float(v)) for v in row[2:]] for row in list(csv.reader(handle))[1:]]
+    picked = rows[::12]
+    # Missing values exercise each split's default direction.
+    rng = random.Random(7)
+    for row in picked[:: max(1, len(picked) // 6)]:
+        gapped = list(row)
+        for idx in rng.sample(range(len(gapped)), 12):
+            gapped[idx] = math.nan
+        picked.append(gapped)
+    return rows, picked
+
+
+def _random_tree(rng, rows, tree_id, max_depth=5):
+    columns = len(rows[0])
+    nodes = [{"depth": 0, "parent": 2147483647}]
+    idx = 0
+    while idx < len(nodes):
+        node = nodes[idx]
+        if node["depth"] == max_depth or (node["depth"] > 0 and rng.random() < 0.3):
+            node["leaf"] = f32(rng.uniform(-0.4, 0.4))
+        else:
+            feature = rng.randrange(columns)
+            node.update(
+                feature=feature,
+                threshold=rng.choice(rows)[feature],
+                default_left=rng.random() < 0.5,
+                left=len(nodes),
+                right=len(nodes) + 1,
+            )
+            nodes.append({"depth": node["depth"] + 1, "parent": idx})
+            nodes.append({"depth": node["depth"] + 1, "parent": idx})
+        idx += 1
+
+    count = len(nodes)
+    return {
+        "base_weights": [n.get("leaf", 0.0) for n in nodes],
+        "categories": [],
+        "categories_nodes": [],
+        "categories_segments": [],
+        "categories_sizes": [],
+        "default_left": [int(n.get("default_left", False)) for n in nodes],
+        "id": tree_id,
+        "left_children": [n.get("left", -1) for n in nodes],
+        "loss_changes": [0.0] * count,
+        "parents": [n["parent"] for n in nodes],
+        "right_children": [n.get("right", -1) for n in nodes],
+        "split_conditions": [n.get("threshold", n.get("leaf")) for n in nodes],
+        "split_indices": [n.get("feature", 0) for n in nodes],
+        "split_type": [0] * count,
+        "sum_hessian": [1.0] * count,
+        "tree_param": {
+            "num_deleted": "0",
+            "num_feature": str(columns),
+            "num_nodes": str(count),
+            "size_leaf_vector": "1",
+        },
+    }
+
+
+def _random_model(rows, rounds=6, classes=4):
+    rng = random.Random(42)
+    trees = [_random_tree(rng, rows, i) for i in range(rounds * classes)]
+    columns = str(len(rows[0]))
+    return {
+        "learner": {
+            "attributes": {LABEL_INDICES_ATTR: ",".join(str(c) for c in range(classes))},
+            "feature_names": [],
+            "feature_types": [],
+            "gradient_booster": {
+                "model": {
+                    "gbtree_model_param": {"num_parallel_tree": "1", "num_trees": str(len(trees))},
+                    "iteration_indptr": [r * classes for r in range(rounds + 1)],
+                    "tree_info": [i % classes for i in range(len(trees))],
+                    "trees": trees,
+                },
+                "name": "gbtree",
+            },
+            "learner_model_param": {
+                "base_score": "5E-1",
+                "boost_from_average": "1",
+                "num_class": str(classes),
+                "num_feature": columns,
+                "num_target": "1",
+            },
+            "objective": {"name": "multi:softprob", "softmax_multiclass_param": {"num_class": str(classes)}},
+        },
+        "version": [2, 1, 0],
+    }
+
+
+def _xgboost_probas(rows):
+    booster = xgb.Booster(model_file=MODEL_PATH)
+    return booster.predict(xgb.DMatrix(rows, missing=math.nan)).tolist()
+
+
+def _write_fixture():
+    all_rows, rows = _feature_rows()
+    os.makedirs(FIXTURE_DIR, exist_ok=True)
+    if xgb is not None:
+        # Synthetic labels with structure across several features.
+        labels = [
+            0 if row[33] > 0 else 3 if row[5] > 3.0 else 2 if row[21] == 0 else 1 for row in all_rows
+        ]
+        model = xgb.XGBClassifier(n_estimators=8, max_depth=5, objective="multi:softprob")
+        model.fit(all_rows, labels)
+        model.get_booster().set_attr(**{LABEL_INDICES_ATTR: "0,1,2,3"})
+        model.save_model(MODEL_PATH)
+        probas = _xgboost_probas(rows)
+    else:
+        with open(MODEL_PATH, "w", encoding="utf-8") as handle:
+            json.dump(_random_model(all_rows), handle)
+        model = TreeEnsemble.load(MODEL_PATH)
+        probas = [model.predict_proba(row) for row in rows]
+
+    with open(GOLDEN_PATH, "w", newline="", encoding="utf-8") as handle:
+        writer = csv.writer(handle, lineterminator="\n")
+        writer.writerow(default_feature_columns() + PROBA_COLUMNS)
+        for row, proba in zip(rows, probas):
+            writer.writerow([repr(v) for v in row] + [repr(p) for p in proba])
+
+
+def _read_golden():
+    with open(GOLDEN_PATH, newline="", encoding="utf-8") as handle:
+        reader = csv.reader(handle)
+        header = next(reader)
+        width = len(default_feature_columns())
+        assert header == default_feature_columns() + PROBA_COLUMNS
+        rows = [[float(v) for v in line] for line in reader]
+    return [row[:width] for row in rows], [row[width:] for row in rows]
+
+
+class TestTreeModel(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls) -> None:
+        if os.environ.get("SNAPBACK_UPDATE_TREE_FIXTURE"):
+            _write_fixture()
+        cls.rows, cls.expected = _read_golden()
+
+    def _assert_matches(self, probas) -> None:
+        self.assertEqual(len(probas), len(self.expected))
+        for idx, (got, want) in enumerate(zip(probas, self.expected)):
+            for g, w in zip(got, want):
+                self.assertAlmostEqual(g, w, delta=TOLERANCE, msg=f"row {idx}")
+
+    def test_reference_evaluator_matches_golden(self) -> None:
+        model = TreeEnsemble.load(MODEL_PATH)
+        self.assertTrue(any(math.isnan(v) for row in self.rows for v in row))
+        self._assert_matches([model.predict_proba(row) for row in self.rows])
+
+    @unittest.skipIf(xgb is None, "xgboost not installed")
+    def test_xgboost_matches_golden(self) -> None:
+        self._assert_matches(_xgboost_probas(self.rows))
+
+
+if __name__ == "__main__":
+    unittest.main()
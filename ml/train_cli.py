@@ -12,11 +12,22 @@ from typing import List, Optional
 
 from .dataset_builder import (
     join_features_with_labels,
+    label_feature_table,
     read_features_csv,
     read_labels_csv,
     write_labeled_csv,
+    write_labeled_table_csv,
+)
+from .feature_store import is_store_path, read_feature_table, write_rows, write_table
+from .labeling import LabelRecord
+from .training_pipeline import (
+    Dataset,
+    dataset_from_table,
+    default_feature_columns,
+    load_dataset,
+    save_model,
+    train_baseline,
 )
-from .training_pipeline import load_dataset, save_model, train_baseline
 
 
 def run_training(
@@ -33,29 +44,36 @@ def run_training(
     label_column: str,
 ) -> dict:
     temp_path = None
+    dataset: Optional[Dataset] = None
     if dataset_path is None:
         if not features_path or not labels_path:
             raise ValueError("Provide --dataset or both --features-csv and --labels-csv.")
 
-        feature_rows = read_features_csv(features_path)
         label_rows = read_labels_csv(labels_path)
-        joined = join_features_with_labels(
-            feature_rows,
-            label_rows,
-            label_window_seconds=label_window_seconds,
-        )
-
-        if output_dataset_path is None:
-            temp = tempfile.NamedTemporaryFile(delete=False, suffix=".csv")
-            output_dataset_path = temp.name
-            temp.close()
-            temp_path = output_dataset_path
-
-        write_labeled_csv(output_dataset_path, joined)
-        dataset_path = output_dataset_path
+        if is_store_path(features_path):
+            dataset = _join_feature_store(
+                features_path,
+                label_rows,
+                output_dataset_path,
+                label_window_seconds,
+                feature_columns,
+                label_column,
+            )
+        else:
+            dataset_path = _join_features_csv(
+                features_path,
+                label_rows,
+                output_dataset_path,
+                label_window_seconds,
+                feature_columns,
+                label_column,
+            )
+            if output_dataset_path is None:
+                temp_path = dataset_path
 
     try:
-        dataset = load_dataset(dataset_path, feature_columns=feature_columns, label_column=label_column)
+        if dataset is None:
+            dataset = load_dataset(dataset_path, feature_columns=feature_columns, label_column=label_column)
         result = train_baseline(dataset, backend=backend, n_splits=n_splits)
         if output_model_path:
             save_model(result.model, output_model_path)
@@ -69,12 +87,64 @@ def run_training(
             os.remove(temp_path)
 
 
+def _join_feature_store(
+    features_path: str,
+    label_rows: List[LabelRecord],
+    output_dataset_path: Optional[str],
+    label_window_seconds: int,
+    feature_columns: Optional[List[str]],
+    label_column: str,
+) -> Dataset:
+    """Labels a feature store in memory; the values never become strings."""
+    if label_column != "label":
+        raise ValueError("feature stores keep their label in the 'label' column")
+    table = read_feature_table(features_path, columns=feature_columns or default_feature_columns())
+    table = label_feature_table(table, label_rows, label_window_seconds=label_window_seconds)
+    if output_dataset_path is not None:
+        if is_store_path(output_dataset_path):
+            write_table(output_dataset_path, table)
+        else:
+            write_labeled_table_csv(output_dataset_path, table)
+    return dataset_from_table(table)
+
+
+def _join_features_csv(
+    features_path: str,
+    label_rows: List[LabelRecord],
+    output_dataset_path: Optional[str],
+    label_window_seconds: int,
+    feature_columns: Optional[List[str]],
+    label_column: str,
+) -> str:
+    """Joins a feature CSV with labels and writes the dataset; returns its
+    path, a temporary file when `output_dataset_path` is None."""
+    feature_rows = read_features_csv(features_path)
+    joined = join_features_with_labels(
+        feature_rows,
+        label_rows,
+        label_window_seconds=label_window_seconds,
+    )
+
+    if output_dataset_path is None:
+        # Stored typed, so load_dataset skips re-parsing strings.
+        suffix = ".sbf" if label_column == "label" else ".csv"
+        temp = tempfile.NamedTemporaryFile(delete=False, suffix=suffix)
+        output_dataset_path = temp.name
+        temp.close()
+
+    if is_store_path(output_dataset_path):
+        write_rows(output_dataset_path, joined, columns=feature_columns, label_column=label_column)
+    else:
+        write_labeled_csv(output_dataset_path, joined)
+    return output_dataset_path
+
+
 def parse_args(argv: Optional[List[str]] = None) -> argparse.Namespace:
     parser = argparse.ArgumentParser(description="Train Neural Focus baseline model.")
-    parser.add_argument("--dataset", dest="dataset_path", help="Path to labeled dataset CSV.")
-    parser.add_argument("--features-csv", dest="features_path", help="Path to features CSV.")
+    parser.add_argument("--dataset", dest="dataset_path", help="Labeled dataset (.csv, .sbf or .parquet).")
+    parser.add_argument("--features-csv", dest="features_path", help="Features (.csv, .sbf or .parquet).")
     parser.add_argument("--labels-csv", dest="labels_path", help="Path to labels CSV.")
-    parser.add_argument("--output-dataset", dest="output_dataset_path", help="Write joined dataset CSV here.")
+    parser.add_argument("--output-dataset", dest="output_dataset_path", help="Write joined dataset here (.csv, .sbf or .parquet).")
     parser.add_argument("--output-model", dest="output_model_path", help="Write trained model here.")
     parser.add_argument("--output-metrics", dest="output_metrics_path", help="Write metrics JSON here.")
     parser.add_argument("--label-window-seconds", type=int, default=300)
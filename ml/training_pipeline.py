@@ -18,6 +18,10 @@ except ImportError:  # pragma: no cover - optional dependency
     xgb = None
 
 
+# Learner attribute listing the label index of each XGBoost class; read by
+# src-tauri/src/engine/tree_model.rs and ml/tree_model.py.
+LABEL_INDICES_ATTR = "snapback_label_indices"
+
 LABEL_VALUE_TO_INDEX = {
     int(FocusLabel.DISTRACTED): 0,
     int(FocusLabel.PSEUDO_PRODUCTIVE): 1,
@@ -37,6 +41,12 @@ def default_feature_columns() -> List[str]:
         "keystroke_interval_mean",
         "keystroke_interval_std",
         "keystroke_interval_trend",
+        "keystroke_interval_p10",
+        "keystroke_interval_p50",
+        "keystroke_interval_p90",
+        "burst_length_p10",
+        "burst_length_p50",
+        "burst_length_p90",
         "mouse_move_count",
         "mouse_distance_pixels",
         "mouse_speed_mean",
@@ -59,11 +69,18 @@ def default_feature_columns() -> List[str]:
         "is_productivity",
         "focus_momentum",
         "is_pseudo_productive",
+        "switches_per_min_2min",
+        "keystroke_rate_2min",
+        "idle_time_2min",
+        "switches_per_min_15min",
+        "keystroke_rate_15min",
+        "idle_time_15min",
     ]
 
 
 @dataclass
 class Dataset:
+    # Row lists, or a float32 ndarray when loaded from a feature store.
     features: List[List[float]]
     labels: List[int]
     timestamps: List[float]
@@ -75,6 +92,11 @@ def load_dataset(
     label_column: str = "label",
 ) -> Dataset:
     feature_columns = feature_columns or default_feature_columns()
+    from .feature_store import is_store_path
+
+    if is_store_path(path):
+        return _load_store_dataset(path, feature_columns, label_column)
+
     features: List[List[float]] = []
     labels: List[int] = []
     timestamps: List[float] = []
@@ -105,6 +127,25 @@ def load_dataset(
     return Dataset(features=features, labels=labels, timestamps=timestamps)
 
 
+def _load_store_dataset(path: str, feature_columns: List[str], label_column: str) -> Dataset:
+    from .feature_store import read_feature_table
+
+    if label_column != "label":
+        raise ValueError("feature stores keep their label in the 'label' column")
+    return dataset_from_table(read_feature_table(path, columns=feature_columns))
+
+
+def dataset_from_table(table) -> Dataset:
+    """The labeled rows of a `FeatureTable`, values kept as they are."""
+    keep = [i for i, label in enumerate(table.labels) if label in LABEL_VALUE_TO_INDEX]
+    labeled = table.select(keep)
+    return Dataset(
+        features=labeled.values,
+        labels=[LABEL_VALUE_TO_INDEX[label] for label in labeled.labels],
+        timestamps=labeled.timestamps,
+    )
+
+
 def time_series_splits(n_samples: int, n_splits: int = 5) -> Iterable[Tuple[List[int], List[int]]]:
     if n_samples < 2:
         return []
@@ -218,7 +259,7 @@ def train_baseline(
     backend: str = "auto",
     n_splits: int = 5,
 ) -> TrainingResult:
-    if not dataset.features:
+    if len(dataset.features) == 0:
         raise ValueError("dataset is empty")
 
     if backend == "auto":
@@ -247,6 +288,8 @@ def train_baseline(
             eval_metric="mlogloss",
         )
         model.fit(X_train, y_train)
+        # Model class -> Dataset label index, for runtimes that read the JSON.
+        model.get_booster().set_attr(**{LABEL_INDICES_ATTR: ",".join(str(label) for label in classes)})
 
         probas_raw = model.predict_proba(dataset.features)
         probas_raw = _to_list(probas_raw)
@@ -0,0 +1,106 @@
+"""
+Reference evaluator for saved XGBoost JSON models, mirroring
+src-tauri/src/engine/tree_model.rs.
+
+XGBoost's own predictor is the ground truth; this exists so the Rust
+evaluator's fixture can be checked (and regenerated) without xgboost, and so
+offline tools can score rows without loading the full library. Sums and the
+softmax are rounded to float32 at each step, as XGBoost's CPU predictor does.
+"""
+
+from __future__ import annotations
+
+import json
+import math
+import struct
+from dataclasses import dataclass
+from typing import List, Sequence
+
+from .training_pipeline import LABEL_INDICES_ATTR
+
+CLASS_COUNT = 4
+
+_F32 = struct.Struct("<f")
+
+
+def f32(value: float) -> float:
+    return _F32.unpack(_F32.pack(value))[0]
+
+
+@dataclass(frozen=True)
+class _Tree:
+    left: List[int]
+    right: List[int]
+    feature: List[int]
+    condition: List[float]
+    default_left: List[bool]
+
+    def leaf_value(self, row: Sequence[float]) -> float:
+        node = 0
+        while self.left[node] >= 0:
+            value = f32(row[self.feature[node]])
+            if math.isnan(value):
+                node = self.left[node] if self.default_left[node] else self.right[node]
+            elif value < self.condition[node]:
+                node = self.left[node]
+            else:
+                node = self.right[node]
+        return self.condition[node]
+
+
+class TreeEnsemble:
+    def __init__(self, payload: dict) -> None:
+        learner = payload["learner"]
+        objective = learner["objective"]["name"]
+        if objective not in ("multi:softprob", "multi:softmax"):
+            raise ValueError(f"unsupported objective {objective!r}")
+
+        params = learner["learner_model_param"]
+        self.class_count = int(params["num_class"])
+        base_score = str(params["base_score"]).strip("[]").split(",")[0]
+        self.base_margin = f32(float(base_score))
+
+        attr = learner.get("attributes", {}).get(LABEL_INDICES_ATTR)
+        if attr is not None:
+            self.label_index = [int(idx) for idx in attr.split(",")]
+        elif self.class_count == CLASS_COUNT:
+            self.label_index = list(range(CLASS_COUNT))
+        else:
+            raise ValueError(f"{self.class_count}-class model without {LABEL_INDICES_ATTR}")
+
+        model = learner["gradient_booster"]["model"]
+        self.tree_class = [int(c) for c in model["tree_info"]]
+        self.trees = [
+            _Tree(
+                left=tree["left_children"],
+                right=tree["right_children"],
+                feature=tree["split_indices"],
+                condition=[f32(c) for c in tree["split_conditions"]],
+                default_left=[bool(d) for d in tree["default_left"]],
+            )
+            for tree in model["trees"]
+        ]
+
+    @classmethod
+    def load(cls, path: str) -> "TreeEnsemble":
+        with open(path, "r", encoding="utf-8") as handle:
+            return cls(json.load(handle))
+
+    def margins(self, row: Sequence[float]) -> List[float]:
+        margins = [self.base_margin] * self.class_count
+        for tree, cls in zip(self.trees, self.tree_class):
+            margins[cls] = f32(margins[cls] + tree.leaf_value(row))
+        return margins
+
+    def predict_proba(self, row: Sequence[float]) -> List[float]:
+        """Probabilities in STATE_LABELS order (DISTRACTED .. DEEP_FOCUS)."""
+        margins = self.margins(row)
+        top = max(margins)
+        exps = [f32(math.exp(f32(m - top))) for m in margins]
+        total = 0.0
+        for value in exps:
+            total = f32(total + value)
+        probas = [0.0] * CLASS_COUNT
+        for cls, value in enumerate(exps):
+            probas[self.label_index[cls]] = f32(value / total)
+        return probas
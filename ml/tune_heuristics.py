@@ -0,0 +1,174 @@
+"""
+Tune the heuristic classifier's constants against labeled sessions.
+
+Replay the session journals once with
+`snapback --replay <journal> --heuristic-inputs-out inputs.csv`, then:
+
+    python -m ml.tune_heuristics --inputs inputs.csv --labels labels.csv --output heuristics.json
+
+The search is a coordinate grid search: each round tries every parameter at a
+few multiples of its current value and keeps any change that improves the
+metric on the earlier sessions; the later `--holdout` fraction, by time, is
+only reported. Copy the result to the app data dir as `heuristics.json`, and
+check it end to end with `snapback --replay <journal> --heuristics heuristics.json`.
+"""
+
+from __future__ import annotations
+
+import argparse
+from typing import Dict, List, Mapping, Optional, Sequence, Tuple
+
+from .heuristics import (
+    DEFAULT_PARAMS,
+    FOCUS_MODES,
+    PARAM_NAMES,
+    STATE_LABELS,
+    LabeledInputs,
+    load_labeled_inputs,
+    load_params,
+    predict_states,
+    save_params,
+)
+
+DEFAULT_STEPS = (0.5, 0.75, 0.9, 1.1, 1.25, 1.5)
+METRICS = ("macro_f1", "accuracy")
+
+
+def accuracy(predicted: Sequence[int], labels: Sequence[int]) -> float:
+    if not labels:
+        return 0.0
+    return sum(p == y for p, y in zip(predicted, labels)) / len(labels)
+
+
+def macro_f1(predicted: Sequence[int], labels: Sequence[int]) -> float:
+    """Mean F1 over the states that occur in either sequence."""
+    scores = []
+    for cls in range(len(STATE_LABELS)):
+        tp = sum(p == cls and y == cls for p, y in zip(predicted, labels))
+        fp = sum(p == cls and y != cls for p, y in zip(predicted, labels))
+        fn = sum(p != cls and y == cls for p, y in zip(predicted, labels))
+        if tp + fp + fn == 0:
+            continue
+        scores.append(2 * tp / (2 * tp + fp + fn))
+    return sum(scores) / len(scores) if scores else 0.0
+
+
+def evaluate(
+    rows: Sequence[Sequence[float]],
+    labels: Sequence[int],
+    params: Mapping[str, float],
+    focus_mode: str = "normal",
+    metric: str = "macro_f1",
+) -> float:
+    predicted = predict_states(rows, params, focus_mode)
+    return macro_f1(predicted, labels) if metric == "macro_f1" else accuracy(predicted, labels)
+
+
+def _candidate(params: Mapping[str, float], name: str, value: float) -> Optional[Dict[str, float]]:
+    # Weights and thresholds stay probabilities; scales only need to stay positive.
+    if value <= 0.0 and name.endswith("_scale"):
+        return None
+    if value > 1.0 and not name.endswith("_scale") and not name.endswith("_keystrokes"):
+        return None
+    candidate = dict(params)
+    candidate[name] = value
+    return candidate
+
+
+def tune(
+    rows: Sequence[Sequence[float]],
+    labels: Sequence[int],
+    params: Optional[Mapping[str, float]] = None,
+    names: Optional[Sequence[str]] = None,
+    steps: Sequence[float] = DEFAULT_STEPS,
+    rounds: int = 3,
+    focus_mode: str = "normal",
+    metric: str = "macro_f1",
+) -> Tuple[Dict[str, float], float]:
+    """Coordinate grid search from `params` (defaults when omitted); returns
+    the best parameters found and their score."""
+    best = dict(params or DEFAULT_PARAMS)
+    best_score = evaluate(rows, labels, best, focus_mode, metric)
+    for _ in range(rounds):
+        improved = False
+        for name in names or PARAM_NAMES:
+            current = best[name]
+            for step in steps:
+                candidate = _candidate(best, name, current * step)
+                if candidate is None:
+                    continue
+                score = evaluate(rows, labels, candidate, focus_mode, metric)
+                if score > best_score:
+                    best, best_score, improved = candidate, score, True
+        if not improved:
+            break
+    return best, best_score
+
+
+def split_by_time(data: LabeledInputs, holdout: float) -> Tuple[LabeledInputs, LabeledInputs]:
+    order = sorted(range(len(data.rows)), key=lambda idx: data.timestamps[idx])
+    cut = len(order) - int(len(order) * holdout)
+
+    def take(indices: List[int]) -> LabeledInputs:
+        return LabeledInputs(
+            timestamps=[data.timestamps[i] for i in indices],
+            rows=[data.rows[i] for i in indices],
+            labels=[data.labels[i] for i in indices],
+        )
+
+    return take(order[:cut]), take(order[cut:])
+
+
+def parse_args(argv: Optional[List[str]] = None) -> argparse.Namespace:
+    parser = argparse.ArgumentParser(description="Tune Snapback's heuristic classifier constants.")
+    parser.add_argument("--inputs", dest="inputs_path", required=True, help="--heuristic-inputs-out CSV")
+    parser.add_argument("--labels", dest="labels_path", required=True, help="Label records CSV")
+    parser.add_argument("--output", dest="output_path", required=True, help="Where to write heuristics.json")
+    parser.add_argument("--start", dest="start_path", help="Parameters to start from (default: built-in)")
+    parser.add_argument("--params", help="Comma-separated parameter names to tune (default: all)")
+    parser.add_argument("--rounds", type=int, default=3)
+    parser.add_argument("--metric", choices=METRICS, default="macro_f1")
+    parser.add_argument("--focus-mode", choices=FOCUS_MODES, default="normal")
+    parser.add_argument("--holdout", type=float, default=0.2, help="Latest fraction of rows kept for reporting")
+    parser.add_argument("--label-window-seconds", type=int, default=300)
+    return parser.parse_args(argv)
+
+
+def main(argv: Optional[List[str]] = None) -> int:
+    args = parse_args(argv)
+    data = load_labeled_inputs(args.inputs_path, args.labels_path, args.label_window_seconds)
+    if not data.rows:
+        raise SystemExit("no labeled rows: do the label timestamps overlap the replay?")
+    train, holdout = split_by_time(data, args.holdout)
+    start = load_params(args.start_path) if args.start_path else dict(DEFAULT_PARAMS)
+    names = [n.strip() for n in args.params.split(",") if n.strip()] if args.params else None
+    for name in names or []:
+        if name not in DEFAULT_PARAMS:
+            raise SystemExit(f"unknown heuristic parameter {name!r}")
+
+    tuned, _ = tune(
+        train.rows,
+        train.labels,
+        params=start,
+        names=names,
+        rounds=args.rounds,
+        focus_mode=args.focus_mode,
+        metric=args.metric,
+    )
+    save_params(args.output_path, tuned)
+
+    print(f"rows: {len(train.rows)} tuning, {len(holdout.rows)} holdout")
+    for split, part in (("tuning", train), ("holdout", holdout)):
+        if not part.rows:
+            continue
+        before = evaluate(part.rows, part.labels, start, args.focus_mode, args.metric)
+        after = evaluate(part.rows, part.labels, tuned, args.focus_mode, args.metric)
+        print(f"- {split} {args.metric}: {before:.4f} -> {after:.4f}")
+    changed = [name for name in PARAM_NAMES if tuned[name] != start[name]]
+    for name in changed:
+        print(f"- {name}: {start[name]:g} -> {tuned[name]:g}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,249 @@
+//! Column-oriented batch extraction. Kept free of Python types so it can be
+//! tested with plain `cargo test --no-default-features`.
+
+use std::path::Path;
+
+use thiserror::Error;
+
+use crate::engine::features::FeatureExtractor;
+use crate::engine::tensor::FEATURE_COUNT;
+use crate::journal::{segment_paths, JournalError, JournalSegment};
+use crate::types::{CaptureEvent, EventType};
+
+#[derive(Debug, Error)]
+pub enum BatchError {
+    #[error("column {name} has {len} rows, expected {expected}")]
+    Length {
+        name: &'static str,
+        len: usize,
+        expected: usize,
+    },
+    #[error("event {0}: unknown event type {1}")]
+    EventType(usize, u8),
+    #[error("event {0}: symbol {1} is out of range")]
+    Symbol(usize, u32),
+    #[error(transparent)]
+    Journal(#[from] JournalError),
+}
+
+/// One event per index. Strings are ids into `symbols`, as in the journal.
+pub struct EventColumns<'a> {
+    pub timestamp_us: &'a [i64],
+    pub event_type: &'a [u8],
+    pub app_id: &'a [u32],
+    pub title_id: &'a [u32],
+    pub mouse_speed: &'a [u32],
+    pub idle_duration_ms: &'a [u32],
+    pub title_churn: &'a [u32],
+    pub symbols: &'a [String],
+}
+
+#[derive(Debug, Default)]
+pub struct FeatureBatch {
+    /// Row-major, `events.len() × FEATURE_COUNT`.
+    pub matrix: Vec<f32>,
+    /// Index of the event each row was taken after.
+    pub events: Vec<u64>,
+    pub categories: Vec<&'static str>,
+}
+
+/// Feeds events through one extractor and keeps a row whenever
+/// `emit_interval_us` of event time has passed since the last kept row
+/// (0 keeps every event), like the engine's prediction cadence.
+struct BatchBuilder {
+    extractor: FeatureExtractor,
+    emit_interval_us: i64,
+    last_emit_us: Option<i64>,
+    /// Reused so string fields are copied into existing buffers.
+    scratch: CaptureEvent,
+    batch: FeatureBatch,
+}
+
+impl BatchBuilder {
+    fn new(emit_interval_us: i64) -> Self {
+        Self {
+            extractor: FeatureExtractor::new(),
+            emit_interval_us,
+            last_emit_us: None,
+            scratch: CaptureEvent {
+                event_type: EventType::KeyPress,
+                timestamp_us: 0,
+                app_name: String::new(),
+                window_title: String::new(),
+                mouse_x: 0,
+                mouse_y: 0,
+                mouse_speed: 0,
+                idle_duration_ms: 0,
+                title_churn: 0,
+            },
+            batch: FeatureBatch::default(),
+        }
+    }
+
+    fn push(&mut self, index: usize) {
+        let features = self.extractor.update(&self.scratch, &[]);
+        let now = features.timestamp_us;
+        if self
+            .last_emit_us
+            .is_some_and(|last| now - last < self.emit_interval_us)
+        {
+            return;
+        }
+        self.last_emit_us = Some(now);
+        self.batch
+            .matrix
+            .extend_from_slice(features.tensor().as_slice());
+        self.batch.events.push(index as u64);
+        self.batch
+            .categories
+            .push(features.context.productivity_category);
+    }
+}
+
+fn check_len(name: &'static str, len: usize, expected: usize) -> Result<(), BatchError> {
+    if len == expected {
+        Ok(())
+    } else {
+        Err(BatchError::Length {
+            name,
+            len,
+            expected,
+        })
+    }
+}
+
+pub fn extract_columns(
+    columns: &EventColumns,
+    emit_interval_us: i64,
+) -> Result<FeatureBatch, BatchError> {
+    let n = columns.timestamp_us.len();
+    check_len("event_type", columns.event_type.len(), n)?;
+    check_len("app_id", columns.app_id.len(), n)?;
+    check_len("title_id", columns.title_id.len(), n)?;
+    check_len("mouse_speed", columns.mouse_speed.len(), n)?;
+    check_len("idle_duration_ms", columns.idle_duration_ms.len(), n)?;
+    check_len("title_churn", columns.title_churn.len(), n)?;
+    let symbol = |i: usize, id: u32| {
+        columns
+            .symbols
+            .get(id as usize)
+            .ok_or(BatchError::Symbol(i, id))
+    };
+
+    let mut builder = BatchBuilder::new(emit_interval_us);
+    builder.batch.matrix.reserve(n * FEATURE_COUNT);
+    for i in 0..n {
+        let code = columns.event_type[i];
+        let event = &mut builder.scratch;
+        event.event_type = EventType::from_u8(code).ok_or(BatchError::EventType(i, code))?;
+        event.timestamp_us = columns.timestamp_us[i];
+        event.app_name.clone_from(symbol(i, columns.app_id[i])?);
+        event
+            .window_title
+            .clone_from(symbol(i, columns.title_id[i])?);
+        event.mouse_speed = columns.mouse_speed[i];
+        event.idle_duration_ms = columns.idle_duration_ms[i];
+        event.title_churn = columns.title_churn[i];
+        builder.push(i);
+    }
+    Ok(builder.batch)
+}
+
+/// Reads a journal directory (or one segment) straight from disk, skipping
+/// Python event objects entirely. Damaged segments end early, as in replay.
+pub fn extract_journal(path: &Path, emit_interval_us: i64) -> Result<FeatureBatch, BatchError> {
+    let mut builder = BatchBuilder::new(emit_interval_us);
+    let mut index = 0;
+    for segment_path in segment_paths(path)? {
+        let segment = JournalSegment::open(&segment_path)?;
+        for event in segment.events() {
+            let Ok(event) = event else { break };
+            let scratch = &mut builder.scratch;
+            scratch.event_type = event.event_type;
+            scratch.timestamp_us = event.timestamp_us;
+            scratch.app_name.clear();
+            scratch.app_name.push_str(event.app_name);
+            scratch.window_title.clear();
+            scratch.window_title.push_str(event.window_title);
+            scratch.mouse_x = event.mouse_x;
+            scratch.mouse_y = event.mouse_y;
+            scratch.mouse_speed = event.mouse_speed;
+            scratch.idle_duration_ms = event.idle_duration_ms;
+            scratch.title_churn = event.title_churn;
+            builder.push(index);
+            index += 1;
+        }
+    }
+    Ok(builder.batch)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn parity_journal() -> std::path::PathBuf {
+        Path::new(env!("CARGO_MANIFEST_DIR")).join("../ml/tests/fixtures/parity")
+    }
+
+    #[test]
+    fn columns_and_journal_paths_agree() {
+        let dir = parity_journal();
+        let mut symbols: Vec<String> = Vec::new();
+        let mut intern = |s: &str| match symbols.iter().position(|x| x == s) {
+            Some(id) => id as u32,
+            None => {
+                symbols.push(s.to_string());
+                symbols.len() as u32 - 1
+            }
+        };
+        let (mut ts, mut kind, mut app, mut title) = (vec![], vec![], vec![], vec![]);
+        let (mut speed, mut idle, mut churn) = (vec![], vec![], vec![]);
+        for path in segment_paths(&dir).unwrap() {
+            let segment = JournalSegment::open(&path).unwrap();
+            for event in segment.events() {
+                let event = event.unwrap();
+                ts.push(event.timestamp_us);
+                kind.push(event.event_type as u8);
+                app.push(intern(event.app_name));
+                title.push(intern(event.window_title));
+                speed.push(event.mouse_speed);
+                idle.push(event.idle_duration_ms);
+                churn.push(event.title_churn);
+            }
+        }
+        let columns = EventColumns {
+            timestamp_us: &ts,
+            event_type: &kind,
+            app_id: &app,
+            title_id: &title,
+            mouse_speed: &speed,
+            idle_duration_ms: &idle,
+            title_churn: &churn,
+            symbols: &symbols,
+        };
+
+        let from_columns = extract_columns(&columns, 0).unwrap();
+        let from_journal = extract_journal(&dir, 0).unwrap();
+        assert_eq!(from_columns.events.len(), ts.len());
+        assert_eq!(from_columns.matrix, from_journal.matrix);
+        assert_eq!(from_columns.categories, from_journal.categories);
+
+        let sampled = extract_journal(&dir, 5_000_000).unwrap();
+        assert!(sampled.events.len() < ts.len() / 4);
+        for pair in sampled.events.windows(2) {
+            assert!(ts[pair[1] as usize] - ts[pair[0] as usize] >= 5_000_000);
+        }
+
+        let short = EventColumns {
+            title_churn: &churn[1..],
+            ..columns
+        };
+        assert!(matches!(
+            extract_columns(&short, 0),
+            Err(BatchError::Length {
+                name: "title_churn",
+                ..
+            })
+        ));
+    }
+}
@@ -0,0 +1,33 @@
+//! Python extension exposing the engine's `FeatureExtractor`, so offline
+//! training computes features with the production code instead of the Python
+//! twin in `ml/features.py`. The engine modules are compiled in from
+//! `src-tauri/src` by path, not copied.
+
+// Only part of each shared module is reachable from here, so the allows
+// sit on the shared modules alone; this crate's own code stays checked.
+#[path = "../../src-tauri/src/clock.rs"]
+#[allow(dead_code, unused_imports)]
+mod clock;
+#[path = "../../src-tauri/src/journal/mod.rs"]
+#[allow(dead_code, unused_imports)]
+mod journal;
+#[path = "../../src-tauri/src/types.rs"]
+#[allow(dead_code, unused_imports)]
+mod types;
+
+#[path = "../../src-tauri/src/engine"]
+#[allow(dead_code, unused_imports)]
+mod engine {
+    pub mod app_context;
+    pub mod features;
+    pub mod goal_alignment;
+    pub mod horizons;
+    pub mod sketch;
+    pub mod stats;
+    pub mod tensor;
+    pub mod window;
+}
+
+pub mod batch;
+#[cfg(feature = "python")]
+mod python;
@@ -0,0 +1,86 @@
+//! `snapback_features` module: numpy columns or a journal path in, a
+//! `(rows, FEATURE_COUNT)` float32 matrix out, in `FEATURE_NAMES` order.
+
+use std::path::PathBuf;
+
+use numpy::{PyArray1, PyArray2, PyArrayMethods, PyReadonlyArray1};
+use pyo3::exceptions::PyValueError;
+use pyo3::prelude::*;
+
+use crate::batch::{self, BatchError, EventColumns, FeatureBatch};
+use crate::engine::tensor::{FEATURE_COUNT, FEATURE_NAMES};
+
+type BatchResult<'py> = (
+    Bound<'py, PyArray2<f32>>,
+    Bound<'py, PyArray1<u64>>,
+    Vec<&'static str>,
+);
+
+fn to_py_err(err: BatchError) -> PyErr {
+    PyValueError::new_err(err.to_string())
+}
+
+fn into_python(py: Python<'_>, batch: FeatureBatch) -> PyResult<BatchResult<'_>> {
+    let rows = batch.events.len();
+    let matrix = PyArray1::from_vec_bound(py, batch.matrix).reshape([rows, FEATURE_COUNT])?;
+    let events = PyArray1::from_vec_bound(py, batch.events);
+    Ok((matrix, events, batch.categories))
+}
+
+/// Features for columnar events. Returns `(matrix, event_index, category)`;
+/// `emit_interval_us` thins rows to one per interval of event time.
+#[pyfunction]
+#[pyo3(signature = (
+    timestamp_us, event_type, app_id, title_id, mouse_speed, idle_duration_ms,
+    title_churn, symbols, emit_interval_us = 0
+))]
+#[allow(clippy::too_many_arguments)]
+fn extract_columns<'py>(
+    py: Python<'py>,
+    timestamp_us: PyReadonlyArray1<'py, i64>,
+    event_type: PyReadonlyArray1<'py, u8>,
+    app_id: PyReadonlyArray1<'py, u32>,
+    title_id: PyReadonlyArray1<'py, u32>,
+    mouse_speed: PyReadonlyArray1<'py, u32>,
+    idle_duration_ms: PyReadonlyArray1<'py, u32>,
+    title_churn: PyReadonlyArray1<'py, u32>,
+    symbols: Vec<String>,
+    emit_interval_us: i64,
+) -> PyResult<BatchResult<'py>> {
+    let columns = EventColumns {
+        timestamp_us: timestamp_us.as_slice()?,
+        event_type: event_type.as_slice()?,
+        app_id: app_id.as_slice()?,
+        title_id: title_id.as_slice()?,
+        mouse_speed: mouse_speed.as_slice()?,
+        idle_duration_ms: idle_duration_ms.as_slice()?,
+        title_churn: title_churn.as_slice()?,
+        symbols: &symbols,
+    };
+    let batch = py
+        .allow_threads(|| batch::extract_columns(&columns, emit_interval_us))
+        .map_err(to_py_err)?;
+    into_python(py, batch)
+}
+
+/// Features for every event in a journal directory or segment file.
+#[pyfunction]
+#[pyo3(signature = (path, emit_interval_us = 0))]
+fn extract_journal(
+    py: Python<'_>,
+    path: PathBuf,
+    emit_interval_us: i64,
+) -> PyResult<BatchResult<'_>> {
+    let batch = py
+        .allow_threads(|| batch::extract_journal(&path, emit_interval_us))
+        .map_err(to_py_err)?;
+    into_python(py, batch)
+}
+
+#[pymodule]
+fn snapback_features(m: &Bound<'_, PyModule>) -> PyResult<()> {
+    m.add("FEATURE_NAMES", FEATURE_NAMES.to_vec())?;
+    m.add_function(wrap_pyfunction!(extract_columns, m)?)?;
+    m.add_function(wrap_pyfunction!(extract_journal, m)?)?;
+    Ok(())
+}
@@ -1,3 +1,15 @@
+#[cfg(feature = "compiled-model")]
+#[path = "src/engine/fnv.rs"]
+mod fnv;
+#[cfg(feature = "compiled-model")]
+#[path = "src/engine/xgboost_json.rs"]
+mod xgboost_json;
+#[cfg(feature = "compiled-model")]
+#[path = "build/model_codegen.rs"]
+mod model_codegen;
+
 fn main() {
+    #[cfg(feature = "compiled-model")]
+    model_codegen::generate();
     tauri_build::build()
 }
@@ -0,0 +1,137 @@
+//! `compiled-model` feature: turns the XGBoost JSON model named by
+//! `SNAPBACK_COMPILED_MODEL` into `$OUT_DIR/compiled_model.rs`, one function
+//! of nested constant comparisons per tree, so the optimiser sees the whole
+//! ensemble. Models are read and checked by `engine::xgboost_json`, as for
+//! `engine::tree_model`, so both accept the same files.
+
+use std::fmt::Write;
+use std::path::{Path, PathBuf};
+
+use serde_json::Value;
+
+use crate::fnv;
+use crate::xgboost_json::{parse_model, SourceTree};
+
+pub const MODEL_ENV: &str = "SNAPBACK_COMPILED_MODEL";
+const OUTPUT_FILE: &str = "compiled_model.rs";
+
+pub fn generate() {
+    println!("cargo:rerun-if-env-changed={MODEL_ENV}");
+    let Some(model) = std::env::var_os(MODEL_ENV) else {
+        panic!("the `compiled-model` feature needs {MODEL_ENV} set to a trained model.json");
+    };
+    let manifest_dir = PathBuf::from(std::env::var_os("CARGO_MANIFEST_DIR").unwrap());
+    let path = manifest_dir.join(model);
+    println!("cargo:rerun-if-changed={}", path.display());
+
+    let source = match render(&path) {
+        Ok(source) => source,
+        Err(err) => panic!("compiled-model: {}: {err}", path.display()),
+    };
+    let out = PathBuf::from(std::env::var_os("OUT_DIR").unwrap()).join(OUTPUT_FILE);
+    std::fs::write(&out, source).expect("write compiled model");
+}
+
+fn render(path: &Path) -> Result<String, String> {
+    let json = std::fs::read_to_string(path).map_err(|err| err.to_string())?;
+    let root: Value = serde_json::from_str(&json).map_err(|err| err.to_string())?;
+    let model = parse_model(&root).map_err(|err| err.to_string())?;
+    let class_count = model.class_count;
+    let label_index = &model.label_index[..class_count];
+    let base_margin = literal(model.base_score)?;
+
+    let mut out = String::new();
+    writeln!(
+        out,
+        "// @generated by build.rs from {}; do not edit.",
+        path.display()
+    )
+    .unwrap();
+    writeln!(out).unwrap();
+    writeln!(out, "/// Model file the ensemble was generated from.").unwrap();
+    writeln!(
+        out,
+        "pub const SOURCE_PATH: &str = {:?};",
+        path.display().to_string()
+    )
+    .unwrap();
+    writeln!(
+        out,
+        "/// `fnv::hash` of that file, as `TreeEnsemble::fingerprint` gives it."
+    )
+    .unwrap();
+    writeln!(
+        out,
+        "pub const FINGERPRINT: u64 = {:#x};",
+        fnv::hash(json.as_bytes())
+    )
+    .unwrap();
+    writeln!(out, "pub const TREE_COUNT: usize = {};", model.trees.len()).unwrap();
+    writeln!(out, "const CLASS_COUNT: usize = {class_count};").unwrap();
+    writeln!(out, "const BASE_MARGIN: f32 = {base_margin};").unwrap();
+    writeln!(
+        out,
+        "const LABEL_INDEX: [usize; CLASS_COUNT] = {label_index:?};"
+    )
+    .unwrap();
+    let num_feature = model.num_feature;
+    writeln!(out, "const _: () = assert!({num_feature} <= FEATURE_COUNT, \"model has more features than the engine\");").unwrap();
+    writeln!(out).unwrap();
+
+    let mut margins = String::new();
+    for (idx, (tree, class)) in model.trees.iter().zip(&model.tree_class).enumerate() {
+        writeln!(out, "#[inline(always)]").unwrap();
+        writeln!(out, "fn tree_{idx}(x: &[f32; FEATURE_COUNT]) -> f32 {{").unwrap();
+        emit(tree, &mut out, 0, 1)?;
+        writeln!(out, "}}").unwrap();
+        writeln!(out).unwrap();
+        // Summed in tree order, as XGBoost and `TreeEnsemble::margins` do.
+        writeln!(margins, "    m[{class}] += tree_{idx}(x);").unwrap();
+    }
+
+    writeln!(
+        out,
+        "/// Raw per-class margins (before softmax), in model class order."
+    )
+    .unwrap();
+    writeln!(
+        out,
+        "pub fn margins(x: &[f32; FEATURE_COUNT]) -> [f32; CLASS_COUNT] {{"
+    )
+    .unwrap();
+    writeln!(out, "    let mut m = [BASE_MARGIN; CLASS_COUNT];").unwrap();
+    out.push_str(&margins);
+    writeln!(out, "    m").unwrap();
+    writeln!(out, "}}").unwrap();
+    Ok(out)
+}
+
+/// Exact `f32` literal; `{:?}` prints the shortest round-tripping form.
+fn literal(value: f32) -> Result<String, String> {
+    if !value.is_finite() {
+        return Err(format!("non-finite constant {value}"));
+    }
+    Ok(format!("{value:?}_f32"))
+}
+
+/// Emits node `node` of `tree` as an expression. `!(v >= t)` sends NaN left
+/// and `v < t` sends it right, matching XGBoost's missing-value defaults.
+fn emit(tree: &SourceTree, out: &mut String, node: usize, indent: usize) -> Result<(), String> {
+    let pad = "    ".repeat(indent);
+    let threshold = literal(tree.condition[node])?;
+    if tree.is_leaf(node) {
+        writeln!(out, "{pad}{threshold}").unwrap();
+        return Ok(());
+    }
+    let value = format!("x[{}]", tree.feature[node]);
+    if tree.default_left[node] {
+        writeln!(out, "{pad}if !({value} >= {threshold}) {{").unwrap();
+    } else {
+        writeln!(out, "{pad}if {value} < {threshold} {{").unwrap();
+    }
+    emit(tree, out, tree.left[node] as usize, indent + 1)?;
+    writeln!(out, "{pad}}} else {{").unwrap();
+    emit(tree, out, tree.right[node] as usize, indent + 1)?;
+    writeln!(out, "{pad}}}").unwrap();
+    Ok(())
+}
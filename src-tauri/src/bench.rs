@@ -3,8 +3,25 @@ use std::time::{Duration, Instant};
 use sysinfo::{CpuRefreshKind, MemoryRefreshKind, ProcessRefreshKind, RefreshKind, System};
 
 use crate::engine::classifier::Classifier;
-use crate::engine::features::FeatureVector;
-use crate::types::FocusMode;
+use crate::engine::features::{FeatureContext, FeatureExtractor, FeatureVector};
+use crate::engine::forecast::DistractionForecaster;
+use crate::engine::model_registry::ModelRegistry;
+use crate::engine::online_model::OnlineModel;
+use crate::engine::stats;
+use crate::engine::tree_model::{self, TreeEnsemble};
+use crate::types::{CaptureEvent, EventType, FocusMode};
+
+/// Events held in the 5-minute window for `--features` runs.
+const FEATURE_WINDOW_SIZES: [usize; 3] = [1_000, 10_000, 100_000];
+
+/// Slice lengths for `--stats`: keystroke intervals in a quiet 30 s window up
+/// to mouse samples in a busy 5 min one.
+const STATS_SLICE_LENS: [usize; 4] = [32, 256, 2_048, 16_384];
+
+/// `--batch` scores a day of 1 Hz feature rows.
+const BATCH_ROWS: usize = 86_400;
+/// Timed passes over the day per scoring path.
+const BATCH_PASSES: usize = 5;
 
 #[derive(Debug, Clone)]
 pub struct BenchArgs {
@@ -12,6 +29,14 @@ pub struct BenchArgs {
     pub warmup: usize,
     pub soak_seconds: u64,
     pub goal: Option<String>,
+    pub features: bool,
+    pub stats: bool,
+    pub onnx_model: Option<String>,
+    pub tree_model: Option<String>,
+    pub compiled_model: bool,
+    pub batch: bool,
+    pub online: bool,
+    pub forecast: bool,
 }
 
 impl Default for BenchArgs {
@@ -21,6 +46,14 @@ impl Default for BenchArgs {
             warmup: 1_000,
             soak_seconds: 0,
             goal: None,
+            features: false,
+            stats: false,
+            onnx_model: None,
+            tree_model: None,
+            compiled_model: false,
+            batch: false,
+            online: false,
+            forecast: false,
         }
     }
 }
@@ -59,14 +92,21 @@ pub fn parse_bench_args(args: &[String]) -> BenchArgs {
         out.soak_seconds = soak;
     }
     out.goal = parse_string_flag(args, "--goal");
+    out.features = args.iter().any(|a| a == "--features");
+    out.stats = args.iter().any(|a| a == "--stats");
+    out.onnx_model = parse_string_flag(args, "--onnx-model");
+    out.tree_model = parse_string_flag(args, "--tree-model");
+    out.compiled_model = args.iter().any(|a| a == "--compiled-model");
+    out.batch = args.iter().any(|a| a == "--batch");
+    out.online = args.iter().any(|a| a == "--online");
+    out.forecast = args.iter().any(|a| a == "--forecast");
 
     out
 }
 
 fn stable_features() -> FeatureVector {
     FeatureVector {
-        app_name: "Cursor".to_string(),
-        window_title: "classifier.rs — Snapback".to_string(),
+        context: FeatureContext::new("Cursor", "classifier.rs — Snapback"),
         context_switches_30s: 0,
         context_switches_5min: 1,
         unique_apps_5min: 1,
@@ -80,7 +120,7 @@ fn stable_features() -> FeatureVector {
         is_communication: false,
         is_ide: true,
         is_productivity: false,
-        ..FeatureVector::empty(0.0)
+        ..FeatureVector::empty(0)
     }
 }
 
@@ -123,7 +163,433 @@ fn current_process_cpu_percent(sys: &System) -> Option<f32> {
     Some(p.cpu_usage())
 }
 
+/// Synthetic but typical mix: mostly typing and mouse, an app switch every
+/// 500 events, an idle period every 5000.
+fn synthetic_event(i: usize, spacing_us: i64) -> CaptureEvent {
+    const APPS: [&str; 5] = ["Cursor", "Google Chrome", "Slack", "Terminal", "Figma"];
+    let event_type = if i % 5_000 == 0 {
+        EventType::IdleEnd
+    } else if i % 500 == 0 {
+        EventType::WindowFocusChange
+    } else {
+        match i % 10 {
+            0..=5 => EventType::KeyPress,
+            6 | 7 => EventType::MouseMove,
+            _ => EventType::MouseClick,
+        }
+    };
+    CaptureEvent {
+        event_type,
+        timestamp_us: 1_700_000_000_000_000 + i as i64 * spacing_us,
+        app_name: APPS[(i / 500) % APPS.len()].to_string(),
+        window_title: "classifier.rs — Snapback".to_string(),
+        mouse_x: (i % 1920) as i32,
+        mouse_y: (i % 1080) as i32,
+        mouse_speed: (i % 700) as u32,
+        idle_duration_ms: if event_type == EventType::IdleEnd {
+            4_000
+        } else {
+            0
+        },
+        title_churn: 0,
+    }
+}
+
+/// Per-event `FeatureExtractor::update` latency with the long window held at
+/// each size in `FEATURE_WINDOW_SIZES`.
+fn run_feature_benchmark(args: &BenchArgs) {
+    println!("mode=features");
+    println!("runs={}", args.runs);
+    for size in FEATURE_WINDOW_SIZES {
+        let spacing_us = (300_000_000 / size as i64).max(1);
+        let mut extractor = FeatureExtractor::new();
+        for i in 0..size + args.warmup {
+            let _ = extractor.update(&synthetic_event(i, spacing_us), &[]);
+        }
+
+        let mut times: Vec<u128> = Vec::with_capacity(args.runs);
+        for i in size + args.warmup..size + args.warmup + args.runs {
+            let event = synthetic_event(i, spacing_us);
+            let t0 = Instant::now();
+            let _ = extractor.update(&event, &[]);
+            times.push(t0.elapsed().as_micros());
+        }
+        times.sort_unstable();
+        println!(
+            "window_events={} latency_us_p50={} latency_us_p95={} latency_us_p99={}",
+            size,
+            pctl(&times, 50.0),
+            pctl(&times, 95.0),
+            pctl(&times, 99.0)
+        );
+    }
+}
+
+/// Nanoseconds per mean + std + slope call, scalar reference vs. the
+/// dispatched kernels. Each sample times a batch so short slices register.
+fn run_stats_benchmark(args: &BenchArgs) {
+    const BATCH: usize = 64;
+    type StatsFn = fn(&[f64]) -> f64;
+    let reference: [StatsFn; 3] = [
+        stats::scalar::mean,
+        stats::scalar::std_dev,
+        stats::scalar::linear_slope,
+    ];
+    let dispatched: [StatsFn; 3] = [stats::mean, stats::std_dev, stats::linear_slope];
+
+    println!("mode=stats");
+    println!("runs={}", args.runs);
+    println!("stats_kernel={}", stats::kernel_name());
+    for len in STATS_SLICE_LENS {
+        let values: Vec<f64> = (0..len)
+            .map(|i| 0.08 + ((i * 7_919) % 97) as f64 * 0.004)
+            .collect();
+        for (name, fns) in [("scalar", reference), (stats::kernel_name(), dispatched)] {
+            let mut times: Vec<u128> = Vec::with_capacity(args.runs);
+            for run in 0..args.warmup + args.runs {
+                let t0 = Instant::now();
+                for _ in 0..BATCH {
+                    for f in fns {
+                        std::hint::black_box(f(std::hint::black_box(&values)));
+                    }
+                }
+                if run >= args.warmup {
+                    times.push(t0.elapsed().as_nanos() / BATCH as u128);
+                }
+            }
+            times.sort_unstable();
+            println!(
+                "slice_len={} kernel={} ns_p50={} ns_p95={} ns_p99={}",
+                len,
+                name,
+                pctl(&times, 50.0),
+                pctl(&times, 95.0),
+                pctl(&times, 99.0)
+            );
+        }
+    }
+}
+
+/// A day of feature rows, one per second of synthetic activity, as the live
+/// pipeline would emit them.
+fn day_of_features() -> Vec<FeatureVector> {
+    const EVENTS_PER_ROW: usize = 10;
+    let mut extractor = FeatureExtractor::new();
+    let mut rows = Vec::with_capacity(BATCH_ROWS);
+    for i in 0..BATCH_ROWS * EVENTS_PER_ROW {
+        let features = extractor.update(&synthetic_event(i, 100_000), &[]);
+        if i % EVENTS_PER_ROW == EVENTS_PER_ROW - 1 {
+            rows.push(features);
+        }
+    }
+    rows
+}
+
+/// `predict` row by row vs. `predict_batch` over the same day of rows, with
+/// the heuristics or, given `--tree-model`, that model served through a
+/// `ModelRegistry`.
+fn run_batch_benchmark(args: &BenchArgs) -> i32 {
+    let mut classifier = Classifier::new(FocusMode::Normal);
+    let mut model_dir = None;
+    if let Some(path) = args.tree_model.as_deref() {
+        let dir = std::env::temp_dir().join(format!("snapback_bench_{}", std::process::id()));
+        let copied = std::fs::create_dir_all(&dir)
+            .and_then(|_| std::fs::copy(path, dir.join(tree_model::MODEL_FILE)));
+        if let Err(err) = copied {
+            eprintln!("failed to stage {path}: {err}");
+            return 1;
+        }
+        let models = ModelRegistry::open(&dir);
+        if models.active().is_none() {
+            eprintln!("failed to load {path}");
+            return 1;
+        }
+        classifier.set_model_registry(Some(models));
+        model_dir = Some(dir);
+    }
+    let rows = day_of_features();
+
+    println!("mode=batch");
+    println!("rows={}", rows.len());
+    println!(
+        "model={}",
+        if model_dir.is_some() {
+            "tree"
+        } else {
+            "heuristic"
+        }
+    );
+    let mut single = Vec::with_capacity(BATCH_PASSES);
+    let mut batched = Vec::with_capacity(BATCH_PASSES);
+    for _ in 0..BATCH_PASSES {
+        let t0 = Instant::now();
+        for row in &rows {
+            std::hint::black_box(classifier.predict(row, None, &[]));
+        }
+        single.push(t0.elapsed().as_micros());
+
+        let t0 = Instant::now();
+        std::hint::black_box(classifier.predict_batch(&rows, None, &[]));
+        batched.push(t0.elapsed().as_micros());
+    }
+    for (path, times) in [("predict", &mut single), ("predict_batch", &mut batched)] {
+        times.sort_unstable();
+        println!(
+            "path={} ms_p50={:.2} ms_min={:.2}",
+            path,
+            pctl(times, 50.0) as f64 / 1_000.0,
+            times[0] as f64 / 1_000.0
+        );
+    }
+
+    if let Some(dir) = model_dir {
+        let _ = std::fs::remove_dir_all(dir);
+    }
+    0
+}
+
+/// Interleaves the prediction closures run by run and prints nanoseconds per
+/// call for each, so they see the same cache and frequency conditions.
+fn print_model_latencies(args: &BenchArgs, models: &mut [(&str, &mut dyn FnMut())]) {
+    let mut times: Vec<Vec<u128>> = vec![Vec::with_capacity(args.runs); models.len()];
+    for run in 0..args.warmup + args.runs {
+        for (slot, (_, predict)) in times.iter_mut().zip(models.iter_mut()) {
+            let t0 = Instant::now();
+            predict();
+            if run >= args.warmup {
+                slot.push(t0.elapsed().as_nanos());
+            }
+        }
+    }
+    for ((name, _), times) in models.iter().zip(times.iter_mut()) {
+        times.sort_unstable();
+        println!(
+            "model={} ns_p50={} ns_p95={} ns_p99={}",
+            name,
+            pctl(times, 50.0),
+            pctl(times, 95.0),
+            pctl(times, 99.0)
+        );
+    }
+}
+
+/// The on-device model's prediction and SGD step next to heuristic scoring.
+fn run_online_benchmark(args: &BenchArgs) -> i32 {
+    let classifier = Classifier::new(FocusMode::Normal);
+    let features = stable_features();
+    let tensor = features.tensor();
+    let mut model = OnlineModel::default();
+    for class in 0..64 {
+        model.update(&tensor, class % 4);
+    }
+    let mut trained = model.clone();
+
+    println!("mode=online");
+    println!("runs={}", args.runs);
+    println!("stats_kernel={}", stats::kernel_name());
+    print_model_latencies(
+        args,
+        &mut [
+            ("heuristic", &mut || {
+                std::hint::black_box(classifier.predict(&features, None, &[]));
+            }),
+            ("online_predict", &mut || {
+                std::hint::black_box(model.predict_probas(std::hint::black_box(&tensor)));
+            }),
+            ("online_update", &mut || {
+                trained.update(std::hint::black_box(&tensor), 2);
+            }),
+        ],
+    );
+    0
+}
+
+/// One tick of the distraction forecaster next to the heuristic scoring it
+/// runs after; both share the engine's 1 Hz tick.
+fn run_forecast_benchmark(args: &BenchArgs) -> i32 {
+    let classifier = Classifier::new(FocusMode::Normal);
+    let features = stable_features();
+    let scores = classifier.predict(&features, None, &[]);
+    let mut forecaster = DistractionForecaster::default();
+    let mut timestamp_us = 0_i64;
+    // Fill the ring so every timed tick also trains on matured ticks.
+    for _ in 0..300 {
+        timestamp_us += 1_000_000;
+        forecaster.observe(timestamp_us, &scores);
+    }
+
+    println!("mode=forecast");
+    println!("runs={}", args.runs);
+    print_model_latencies(
+        args,
+        &mut [
+            ("heuristic", &mut || {
+                std::hint::black_box(classifier.predict(&features, None, &[]));
+            }),
+            ("forecast", &mut || {
+                timestamp_us += 1_000_000;
+                std::hint::black_box(forecaster.observe(timestamp_us, &scores));
+            }),
+        ],
+    );
+    0
+}
+
+/// Heuristic scoring vs. the pure-Rust tree evaluator on the same row.
+fn run_tree_benchmark(args: &BenchArgs, path: &str) -> i32 {
+    let model = match TreeEnsemble::load(std::path::Path::new(path)) {
+        Ok(model) => model,
+        Err(err) => {
+            eprintln!("failed to load {path}: {err}");
+            return 1;
+        }
+    };
+    let classifier = Classifier::new(FocusMode::Normal);
+    let features = stable_features();
+    let tensor = features.tensor();
+
+    println!("mode=tree_model");
+    println!("runs={}", args.runs);
+    println!("trees={} depth={}", model.tree_count(), model.depth());
+    print_model_latencies(
+        args,
+        &mut [
+            ("heuristic", &mut || {
+                std::hint::black_box(classifier.predict(&features, None, &[]));
+            }),
+            ("tree", &mut || {
+                std::hint::black_box(model.predict_probas(std::hint::black_box(&tensor)));
+            }),
+        ],
+    );
+    0
+}
+
+/// Heuristic scoring vs. the interpreted and compiled evaluators on the
+/// model `build.rs` compiled in.
+#[cfg(feature = "compiled-model")]
+fn run_compiled_benchmark(args: &BenchArgs) -> i32 {
+    use crate::engine::compiled_model;
+
+    let path = compiled_model::SOURCE_PATH;
+    let model = match TreeEnsemble::load(std::path::Path::new(path)) {
+        Ok(model) => model,
+        Err(err) => {
+            eprintln!("failed to load {path}: {err}");
+            return 1;
+        }
+    };
+    let classifier = Classifier::new(FocusMode::Normal);
+    let features = stable_features();
+    let tensor = features.tensor();
+
+    println!("mode=compiled_model");
+    println!("runs={}", args.runs);
+    println!("trees={} depth={}", model.tree_count(), model.depth());
+    print_model_latencies(
+        args,
+        &mut [
+            ("heuristic", &mut || {
+                std::hint::black_box(classifier.predict(&features, None, &[]));
+            }),
+            ("tree", &mut || {
+                std::hint::black_box(model.predict_probas(std::hint::black_box(&tensor)));
+            }),
+            ("compiled", &mut || {
+                std::hint::black_box(compiled_model::predict_probas(std::hint::black_box(
+                    &tensor,
+                )));
+            }),
+        ],
+    );
+    0
+}
+
+/// Heuristic scoring vs. one ONNX session run on the same row.
+#[cfg(feature = "onnx")]
+fn run_onnx_benchmark(args: &BenchArgs, path: &str) -> i32 {
+    use crate::engine::onnx_model::OnnxModel;
+
+    let mut model = match OnnxModel::load(std::path::Path::new(path)) {
+        Ok(model) => model,
+        Err(err) => {
+            eprintln!("failed to load {path}: {err}");
+            return 1;
+        }
+    };
+    let classifier = Classifier::new(FocusMode::Normal);
+    let features = stable_features();
+    let tensor = features.tensor();
+    if let Err(err) = model.predict_probas(&tensor) {
+        eprintln!("ONNX run failed: {err}");
+        return 1;
+    }
+
+    println!("mode=onnx");
+    println!("runs={}", args.runs);
+    print_model_latencies(
+        args,
+        &mut [
+            ("heuristic", &mut || {
+                std::hint::black_box(classifier.predict(&features, None, &[]));
+            }),
+            ("onnx", &mut || {
+                let _ = std::hint::black_box(model.predict_probas(std::hint::black_box(&tensor)));
+            }),
+        ],
+    );
+    0
+}
+
 pub fn run_benchmark(args: BenchArgs) -> i32 {
+    if args.batch {
+        println!("SNAPBACK_BENCH v1");
+        return run_batch_benchmark(&args);
+    }
+    if args.online {
+        println!("SNAPBACK_BENCH v1");
+        return run_online_benchmark(&args);
+    }
+    if args.forecast {
+        println!("SNAPBACK_BENCH v1");
+        return run_forecast_benchmark(&args);
+    }
+    if let Some(path) = args.tree_model.as_deref() {
+        println!("SNAPBACK_BENCH v1");
+        return run_tree_benchmark(&args, path);
+    }
+    if args.compiled_model {
+        println!("SNAPBACK_BENCH v1");
+        #[cfg(feature = "compiled-model")]
+        return run_compiled_benchmark(&args);
+        #[cfg(not(feature = "compiled-model"))]
+        {
+            eprintln!("--compiled-model needs a build with `--features compiled-model`");
+            return 1;
+        }
+    }
+    if let Some(path) = args.onnx_model.as_deref() {
+        println!("SNAPBACK_BENCH v1");
+        #[cfg(feature = "onnx")]
+        return run_onnx_benchmark(&args, path);
+        #[cfg(not(feature = "onnx"))]
+        {
+            eprintln!("--onnx-model {path} needs a build with `--features onnx`");
+            return 1;
+        }
+    }
+
+    if args.features || args.stats {
+        println!("SNAPBACK_BENCH v1");
+        if args.features {
+            run_feature_benchmark(&args);
+        }
+        if args.stats {
+            run_stats_benchmark(&args);
+        }
+        return 0;
+    }
+
     let bench_start = Instant::now();
 
     let mut sys = refresh_system();
@@ -203,4 +669,3 @@ pub fn run_benchmark(args: BenchArgs) -> i32 {
 
     0
 }
-
@@ -0,0 +1,440 @@
+//! Owns the capture threads: start/stop/pause, liveness, and automatic restarts.
+//!
+//! Each source (window poller, input hook) reports a heartbeat and event counters
+//! through lock-free atomics, so `get_health` can tell a dead hook from an idle user.
+
+use std::sync::atomic::{AtomicBool, AtomicU32, AtomicU64, Ordering};
+use std::sync::mpsc::Sender;
+use std::sync::{Arc, RwLock};
+use std::thread;
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+use crate::capture::thread::{spawn_input_listener, spawn_window_poller};
+use crate::clock::SharedClock;
+use crate::types::{CaptureEvent, CaptureHealth, CaptureSourceHealth};
+
+const SUPERVISOR_TICK: Duration = Duration::from_secs(1);
+/// A source that stayed up this long is considered healthy again; its backoff resets.
+const STABLE_RUN_MS: u64 = 60_000;
+const MAX_BACKOFF_MS: u64 = 60_000;
+
+#[derive(Debug, Clone, Copy)]
+pub struct CaptureConfig {
+    /// Title-only rewrites closer together than this are collapsed into one event.
+    pub title_debounce_ms: u64,
+}
+
+impl Default for CaptureConfig {
+    fn default() -> Self {
+        Self {
+            title_debounce_ms: 1_500,
+        }
+    }
+}
+
+/// Per-source counters. Written by the source thread, read by `health()`.
+pub(crate) struct SourceStats {
+    name: &'static str,
+    alive: AtomicBool,
+    events_total: AtomicU64,
+    /// `f64::to_bits` of the last sampled events/sec (written by the supervisor).
+    events_per_sec_bits: AtomicU64,
+    last_event_ms: AtomicU64,
+    last_heartbeat_ms: AtomicU64,
+    restarts: AtomicU32,
+    last_error: parking_lot::Mutex<Option<String>>,
+}
+
+impl SourceStats {
+    fn new(name: &'static str) -> Self {
+        Self {
+            name,
+            alive: AtomicBool::new(false),
+            events_total: AtomicU64::new(0),
+            events_per_sec_bits: AtomicU64::new(0.0_f64.to_bits()),
+            last_event_ms: AtomicU64::new(0),
+            last_heartbeat_ms: AtomicU64::new(0),
+            restarts: AtomicU32::new(0),
+            last_error: parking_lot::Mutex::new(None),
+        }
+    }
+
+    pub fn heartbeat(&self) {
+        self.last_heartbeat_ms.store(now_ms(), Ordering::Relaxed);
+    }
+
+    pub fn set_error(&self, err: impl Into<String>) {
+        *self.last_error.lock() = Some(err.into());
+    }
+
+    /// The source works again; stop reporting its last failure.
+    pub fn clear_error(&self) {
+        *self.last_error.lock() = None;
+    }
+
+    fn is_alive(&self) -> bool {
+        self.alive.load(Ordering::Acquire)
+    }
+
+    fn record_event(&self) {
+        self.events_total.fetch_add(1, Ordering::Relaxed);
+        self.last_event_ms.store(now_ms(), Ordering::Relaxed);
+    }
+
+    fn snapshot(&self, now_ms: u64) -> CaptureSourceHealth {
+        let age = |ts: u64| (ts > 0).then(|| now_ms.saturating_sub(ts));
+        CaptureSourceHealth {
+            source: self.name.to_string(),
+            alive: self.is_alive(),
+            events_total: self.events_total.load(Ordering::Relaxed),
+            events_per_sec: f64::from_bits(self.events_per_sec_bits.load(Ordering::Relaxed)),
+            last_event_age_ms: age(self.last_event_ms.load(Ordering::Relaxed)),
+            last_heartbeat_age_ms: age(self.last_heartbeat_ms.load(Ordering::Relaxed)),
+            restarts: self.restarts.load(Ordering::Relaxed),
+            last_error: self.last_error.lock().clone(),
+        }
+    }
+}
+
+/// Clears `alive` when a source thread exits, including by panic.
+pub(crate) struct AliveGuard<'a>(&'a SourceStats);
+
+impl<'a> AliveGuard<'a> {
+    pub fn new(stats: &'a SourceStats) -> Self {
+        stats.alive.store(true, Ordering::Release);
+        Self(stats)
+    }
+}
+
+impl Drop for AliveGuard<'_> {
+    fn drop(&mut self) {
+        self.0.alive.store(false, Ordering::Release);
+    }
+}
+
+/// State shared between the controller, the supervisor and the source threads.
+pub(crate) struct CaptureShared {
+    pub config: CaptureConfig,
+    /// Stamps events. Liveness and backoff bookkeeping use wall `now_ms()`.
+    pub clock: SharedClock,
+    running: AtomicBool,
+    paused: AtomicBool,
+    pub window: SourceStats,
+    pub input: SourceStats,
+    /// Last (app, title) seen by the window poller; input events are tagged with it.
+    pub last_window: RwLock<Option<(String, String)>>,
+}
+
+impl CaptureShared {
+    fn new(config: CaptureConfig, clock: SharedClock) -> Self {
+        Self {
+            config,
+            clock,
+            running: AtomicBool::new(false),
+            paused: AtomicBool::new(false),
+            window: SourceStats::new("window"),
+            input: SourceStats::new("input"),
+            last_window: RwLock::new(None),
+        }
+    }
+
+    pub fn is_running(&self) -> bool {
+        self.running.load(Ordering::Acquire)
+    }
+
+    pub fn is_paused(&self) -> bool {
+        self.paused.load(Ordering::Acquire)
+    }
+
+    /// Forward an event unless capture is stopped or paused.
+    /// Returns `false` once the engine has dropped its receiver.
+    pub fn deliver(
+        &self,
+        stats: &SourceStats,
+        event_tx: &Sender<CaptureEvent>,
+        event: CaptureEvent,
+    ) -> bool {
+        if !self.is_running() || self.is_paused() {
+            return true;
+        }
+        if event_tx.send(event).is_err() {
+            return false;
+        }
+        stats.record_event();
+        true
+    }
+}
+
+/// Supervisor-local bookkeeping for one source.
+struct SourceSlot {
+    spawned: bool,
+    spawned_at_ms: u64,
+    failures: u32,
+    next_attempt_ms: u64,
+    rate_total: u64,
+    rate_at_ms: u64,
+}
+
+impl SourceSlot {
+    fn new() -> Self {
+        Self {
+            spawned: false,
+            spawned_at_ms: 0,
+            failures: 0,
+            next_attempt_ms: 0,
+            rate_total: 0,
+            rate_at_ms: 0,
+        }
+    }
+
+    /// Spawn the source if it is not alive, with exponential backoff between restarts.
+    fn ensure<F>(&mut self, stats: &SourceStats, now: u64, spawn: F) -> Option<thread::JoinHandle<()>>
+    where
+        F: FnOnce() -> thread::JoinHandle<()>,
+    {
+        if stats.is_alive() || now < self.next_attempt_ms {
+            return None;
+        }
+
+        if self.spawned {
+            if now.saturating_sub(self.spawned_at_ms) >= STABLE_RUN_MS {
+                self.failures = 0;
+            }
+            self.failures += 1;
+            stats.restarts.fetch_add(1, Ordering::Relaxed);
+            log::warn!(
+                "capture source '{}' stopped; restarting (attempt {})",
+                stats.name,
+                self.failures
+            );
+        }
+
+        // Mark alive before the thread starts so the next tick cannot double-spawn.
+        stats.alive.store(true, Ordering::Release);
+        self.spawned = true;
+        self.spawned_at_ms = now;
+        self.next_attempt_ms = now + restart_backoff_ms(self.failures);
+        Some(spawn())
+    }
+
+    fn sample_rate(&mut self, stats: &SourceStats, now: u64) {
+        let total = stats.events_total.load(Ordering::Relaxed);
+        if self.rate_at_ms > 0 && now > self.rate_at_ms {
+            let rate = events_per_sec(total.saturating_sub(self.rate_total), now - self.rate_at_ms);
+            stats.events_per_sec_bits.store(rate.to_bits(), Ordering::Relaxed);
+        }
+        self.rate_total = total;
+        self.rate_at_ms = now;
+    }
+}
+
+fn restart_backoff_ms(failures: u32) -> u64 {
+    if failures == 0 {
+        return 0;
+    }
+    (1_000_u64 << (failures - 1).min(6)).min(MAX_BACKOFF_MS)
+}
+
+fn events_per_sec(delta: u64, elapsed_ms: u64) -> f64 {
+    if elapsed_ms == 0 {
+        return 0.0;
+    }
+    delta as f64 * 1000.0 / elapsed_ms as f64
+}
+
+fn supervise(shared: Arc<CaptureShared>, event_tx: Sender<CaptureEvent>) {
+    let mut window = SourceSlot::new();
+    let mut input = SourceSlot::new();
+    let mut window_handle: Option<thread::JoinHandle<()>> = None;
+
+    while shared.is_running() {
+        let now = now_ms();
+
+        if let Some(handle) = window.ensure(&shared.window, now, || {
+            spawn_window_poller(Arc::clone(&shared), event_tx.clone())
+        }) {
+            window_handle = Some(handle);
+        }
+        // The input hook is never joined: see `spawn_input_listener`.
+        let _ = input.ensure(&shared.input, now, || {
+            spawn_input_listener(Arc::clone(&shared), event_tx.clone())
+        });
+
+        window.sample_rate(&shared.window, now);
+        input.sample_rate(&shared.input, now);
+
+        thread::sleep(SUPERVISOR_TICK);
+    }
+
+    if let Some(handle) = window_handle {
+        let _ = handle.join();
+    }
+}
+
+pub struct CaptureController {
+    shared: Arc<CaptureShared>,
+    event_tx: Sender<CaptureEvent>,
+    supervisor: parking_lot::Mutex<Option<thread::JoinHandle<()>>>,
+}
+
+impl CaptureController {
+    pub fn new(event_tx: Sender<CaptureEvent>, clock: SharedClock) -> Self {
+        Self::with_config(event_tx, CaptureConfig::default(), clock)
+    }
+
+    pub fn with_config(
+        event_tx: Sender<CaptureEvent>,
+        config: CaptureConfig,
+        clock: SharedClock,
+    ) -> Self {
+        Self {
+            shared: Arc::new(CaptureShared::new(config, clock)),
+            event_tx,
+            supervisor: parking_lot::Mutex::new(None),
+        }
+    }
+
+    /// Start the supervisor, which (re)spawns each source as needed. No-op if running.
+    pub fn start(&self) {
+        let mut supervisor = self.supervisor.lock();
+        if self.shared.running.swap(true, Ordering::AcqRel) {
+            return;
+        }
+        let shared = Arc::clone(&self.shared);
+        let event_tx = self.event_tx.clone();
+        *supervisor = Some(thread::spawn(move || supervise(shared, event_tx)));
+    }
+
+    /// Stop delivering events and join the supervisor and window poller.
+    pub fn stop(&self) {
+        let mut supervisor = self.supervisor.lock();
+        self.shared.running.store(false, Ordering::Release);
+        if let Some(handle) = supervisor.take() {
+            let _ = handle.join();
+        }
+    }
+
+    /// Keep sources alive (heartbeats continue) but drop their events.
+    pub fn set_paused(&self, paused: bool) {
+        self.shared.paused.store(paused, Ordering::Release);
+    }
+
+    /// True when capture is started, not paused, and every source is alive.
+    pub fn is_capturing(&self) -> bool {
+        self.shared.is_running()
+            && !self.shared.is_paused()
+            && self.shared.window.is_alive()
+            && self.shared.input.is_alive()
+    }
+
+    pub fn health(&self) -> CaptureHealth {
+        let now = now_ms();
+        CaptureHealth {
+            running: self.shared.is_running(),
+            paused: self.shared.is_paused(),
+            sources: vec![
+                self.shared.window.snapshot(now),
+                self.shared.input.snapshot(now),
+            ],
+        }
+    }
+}
+
+impl Drop for CaptureController {
+    fn drop(&mut self) {
+        self.stop();
+    }
+}
+
+pub(crate) fn now_ms() -> u64 {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map(|d| d.as_millis() as u64)
+        .unwrap_or(0)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::types::EventType;
+
+    fn key_event() -> CaptureEvent {
+        CaptureEvent {
+            event_type: EventType::KeyPress,
+            timestamp_us: 1_000_000,
+            app_name: "Cursor".to_string(),
+            window_title: "main.rs".to_string(),
+            mouse_x: 0,
+            mouse_y: 0,
+            mouse_speed: 0,
+            idle_duration_ms: 0,
+            title_churn: 0,
+        }
+    }
+
+    #[test]
+    fn restart_backoff_doubles_and_caps() {
+        assert_eq!(restart_backoff_ms(0), 0);
+        assert_eq!(restart_backoff_ms(1), 1_000);
+        assert_eq!(restart_backoff_ms(2), 2_000);
+        assert_eq!(restart_backoff_ms(4), 8_000);
+        assert_eq!(restart_backoff_ms(30), MAX_BACKOFF_MS);
+    }
+
+    #[test]
+    fn paused_or_stopped_capture_drops_events() {
+        let (tx, rx) = std::sync::mpsc::channel();
+        let shared = CaptureShared::new(CaptureConfig::default(), crate::clock::system_clock());
+
+        assert!(shared.deliver(&shared.input, &tx, key_event()));
+        assert!(rx.try_recv().is_err(), "stopped capture must not deliver");
+
+        shared.running.store(true, Ordering::Release);
+        shared.paused.store(true, Ordering::Release);
+        shared.deliver(&shared.input, &tx, key_event());
+        assert!(rx.try_recv().is_err(), "paused capture must not deliver");
+
+        shared.paused.store(false, Ordering::Release);
+        shared.deliver(&shared.input, &tx, key_event());
+        assert!(rx.try_recv().is_ok());
+        assert_eq!(shared.input.snapshot(now_ms()).events_total, 1);
+    }
+
+    #[test]
+    fn recovered_source_clears_its_error() {
+        let stats = SourceStats::new("test");
+        stats.set_error("active window unavailable");
+        assert!(stats.snapshot(now_ms()).last_error.is_some());
+        stats.clear_error();
+        assert_eq!(stats.snapshot(now_ms()).last_error, None);
+    }
+
+    #[test]
+    fn dead_source_is_respawned_after_backoff() {
+        let stats = SourceStats::new("test");
+        let mut slot = SourceSlot::new();
+        let spawn = || thread::spawn(|| {});
+
+        assert!(slot.ensure(&stats, 10_000, spawn).is_some());
+        assert!(slot.ensure(&stats, 10_500, spawn).is_none(), "alive source is left alone");
+
+        stats.alive.store(false, Ordering::Release);
+        assert!(slot.ensure(&stats, 10_500, spawn).is_some());
+        assert_eq!(stats.restarts.load(Ordering::Relaxed), 1);
+
+        stats.alive.store(false, Ordering::Release);
+        assert!(slot.ensure(&stats, 11_000, spawn).is_none(), "still backing off");
+        assert!(slot.ensure(&stats, 12_500, spawn).is_some());
+        assert_eq!(stats.restarts.load(Ordering::Relaxed), 2);
+    }
+
+    #[test]
+    fn rate_sampling_reports_events_per_second() {
+        let stats = SourceStats::new("test");
+        let mut slot = SourceSlot::new();
+        slot.sample_rate(&stats, 1_000);
+        stats.events_total.store(30, Ordering::Relaxed);
+        slot.sample_rate(&stats, 3_000);
+        assert_eq!(stats.snapshot(3_000).events_per_sec, 15.0);
+    }
+}
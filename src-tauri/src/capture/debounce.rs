@@ -0,0 +1,123 @@
+//! Collapse bursts of title-only rewrites (progress bars, typing in a tab, build
+//! status) into one `WindowTitleChange`, while counting how many were folded in.
+
+/// A settled title plus the number of raw rewrites it stands for.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct SettledTitle {
+    pub app_name: String,
+    pub window_title: String,
+    pub churn: u32,
+}
+
+#[derive(Debug)]
+struct PendingTitle {
+    app_name: String,
+    window_title: String,
+    first_ms: u64,
+    last_ms: u64,
+    churn: u32,
+}
+
+pub struct TitleDebouncer {
+    /// Emit once the title has been stable this long.
+    quiet_ms: u64,
+    /// Emit anyway after this long so a title that never settles still shows up.
+    max_hold_ms: u64,
+    pending: Option<PendingTitle>,
+}
+
+impl TitleDebouncer {
+    pub fn new(quiet_ms: u64) -> Self {
+        Self {
+            quiet_ms,
+            max_hold_ms: quiet_ms.saturating_mul(4),
+            pending: None,
+        }
+    }
+
+    pub fn on_title_change(&mut self, app_name: &str, window_title: &str, now_ms: u64) {
+        match self.pending.as_mut() {
+            Some(p) => {
+                p.window_title.clear();
+                p.window_title.push_str(window_title);
+                p.last_ms = now_ms;
+                p.churn += 1;
+            }
+            None => {
+                self.pending = Some(PendingTitle {
+                    app_name: app_name.to_string(),
+                    window_title: window_title.to_string(),
+                    first_ms: now_ms,
+                    last_ms: now_ms,
+                    churn: 1,
+                });
+            }
+        }
+    }
+
+    /// The app changed: the pending title is superseded. Returns its churn so the
+    /// focus event can still carry it into the churn rate.
+    pub fn on_focus_change(&mut self) -> u32 {
+        self.pending.take().map_or(0, |p| p.churn)
+    }
+
+    pub fn poll(&mut self, now_ms: u64) -> Option<SettledTitle> {
+        let p = self.pending.as_ref()?;
+        let quiet = now_ms.saturating_sub(p.last_ms) >= self.quiet_ms;
+        let held_too_long = now_ms.saturating_sub(p.first_ms) >= self.max_hold_ms;
+        if !(quiet || held_too_long) {
+            return None;
+        }
+        self.pending.take().map(|p| SettledTitle {
+            app_name: p.app_name,
+            window_title: p.window_title,
+            churn: p.churn,
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn burst_collapses_to_last_title() {
+        let mut d = TitleDebouncer::new(1_000);
+        d.on_title_change("Code", "a.rs ●", 0);
+        d.on_title_change("Code", "a.rs", 300);
+        d.on_title_change("Code", "a.rs ●", 600);
+        assert!(d.poll(1_200).is_none(), "still churning");
+
+        let settled = d.poll(1_600).expect("settled after quiet period");
+        assert_eq!(settled.window_title, "a.rs ●");
+        assert_eq!(settled.churn, 3);
+        assert!(d.poll(5_000).is_none());
+    }
+
+    #[test]
+    fn endless_churn_is_flushed_after_max_hold() {
+        let mut d = TitleDebouncer::new(1_000);
+        let mut emitted = None;
+        for i in 0..20 {
+            let now = i * 500;
+            d.on_title_change("Chrome", &format!("Building {i}%"), now);
+            if let Some(s) = d.poll(now) {
+                emitted = Some((now, s));
+                break;
+            }
+        }
+        let (at, settled) = emitted.expect("max hold forces an emit");
+        assert_eq!(at, 4_000);
+        assert_eq!(settled.churn, 9);
+    }
+
+    #[test]
+    fn focus_change_drops_pending_title_but_keeps_churn() {
+        let mut d = TitleDebouncer::new(1_000);
+        d.on_title_change("Code", "a.rs", 0);
+        d.on_title_change("Code", "b.rs", 100);
+        assert_eq!(d.on_focus_change(), 2);
+        assert!(d.poll(10_000).is_none());
+        assert_eq!(d.on_focus_change(), 0);
+    }
+}
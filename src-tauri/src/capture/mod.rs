@@ -1,6 +1,8 @@
 pub mod active_window;
+pub mod controller;
+pub mod debounce;
 pub mod permissions;
 pub mod thread;
 
+pub use controller::CaptureController;
 pub use permissions::check_permissions;
-pub use thread::start_capture_thread;
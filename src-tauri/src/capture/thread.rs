@@ -1,136 +1,176 @@
-use std::sync::{Arc, RwLock};
+use std::sync::mpsc::Sender;
+use std::sync::Arc;
 use std::thread;
-use std::time::{Duration, SystemTime, UNIX_EPOCH};
+use std::time::{Duration, Instant};
 
 use rdev::{Event, EventType, Key};
 
 use crate::capture::active_window::get_active_window_info;
+use crate::capture::controller::{now_ms, AliveGuard, CaptureShared};
+use crate::capture::debounce::TitleDebouncer;
 use crate::types::{CaptureEvent, EventType as AppEventType};
 
-pub fn start_capture_thread(
-    event_tx: std::sync::mpsc::Sender<CaptureEvent>,
+const WINDOW_POLL_INTERVAL: Duration = Duration::from_millis(500);
+const MOUSE_SAMPLE_INTERVAL: Duration = Duration::from_millis(50);
+
+/// Poll the focused window until the controller stops. Exits on its own, so the
+/// supervisor can join it. Title-only rewrites go through `TitleDebouncer`;
+/// `last_window`, which input events are tagged with, only takes a title once
+/// it has been emitted.
+pub(crate) fn spawn_window_poller(
+    shared: Arc<CaptureShared>,
+    event_tx: Sender<CaptureEvent>,
 ) -> thread::JoinHandle<()> {
-    let last_window: Arc<RwLock<Option<(String, String)>>> = Arc::new(RwLock::new(None));
-    let last_mouse_sample: Arc<RwLock<SystemTime>> =
-        Arc::new(RwLock::new(SystemTime::now()));
-
-    let poll_window = Arc::clone(&last_window);
-    let poll_tx = event_tx.clone();
-    thread::spawn(move || loop {
-        if let Some(info) = get_active_window_info() {
-            let mut title_only = false;
-            if let Some(current) = poll_window
-                .read()
-                .ok()
-                .and_then(|g| g.clone())
-            {
-                if current.0 == info.app_name && current.1 == info.window_title {
-                    continue;
+    thread::spawn(move || {
+        let stats = &shared.window;
+        let _alive = AliveGuard::new(stats);
+        let mut titles = TitleDebouncer::new(shared.config.title_debounce_ms);
+        // The window as last polled, which may be ahead of `last_window`. A
+        // restarted poller picks up where the last one reported.
+        let mut polled = shared.last_window.read().ok().and_then(|g| g.clone());
+
+        while shared.is_running() {
+            stats.heartbeat();
+            let now = now_ms();
+
+            if let Some(info) = get_active_window_info() {
+                stats.clear_error();
+                let app_changed = polled.as_ref().map_or(true, |p| p.0 != info.app_name);
+                let title_changed = polled.as_ref().is_some_and(|p| p.1 != info.window_title);
+
+                if app_changed {
+                    let churn = titles.on_focus_change();
+                    let event = window_event(
+                        &shared,
+                        AppEventType::WindowFocusChange,
+                        &info.app_name,
+                        &info.window_title,
+                        churn,
+                    );
+                    set_last_window(&shared, &info.app_name, &info.window_title);
+                    if !shared.deliver(stats, &event_tx, event) {
+                        break;
+                    }
+                } else if title_changed {
+                    titles.on_title_change(&info.app_name, &info.window_title, now);
+                }
+
+                if app_changed || title_changed {
+                    polled = Some((info.app_name, info.window_title));
                 }
-                title_only = current.0 == info.app_name && current.1 != info.window_title;
+            } else {
+                stats.set_error("active window unavailable");
             }
 
-            let now = timestamp_secs();
-            let _ = poll_tx.send(CaptureEvent {
-                event_type: if title_only {
-                    AppEventType::WindowTitleChange
-                } else {
-                    AppEventType::WindowFocusChange
-                },
-                timestamp_secs: now,
-                app_name: info.app_name.clone(),
-                window_title: info.window_title.clone(),
-                mouse_x: 0,
-                mouse_y: 0,
-                mouse_speed: 0,
-                idle_duration_ms: 0,
-            });
-            if let Ok(mut guard) = poll_window.write() {
-                *guard = Some((info.app_name, info.window_title));
+            if let Some(settled) = titles.poll(now) {
+                let event = window_event(
+                    &shared,
+                    AppEventType::WindowTitleChange,
+                    &settled.app_name,
+                    &settled.window_title,
+                    settled.churn,
+                );
+                set_last_window(&shared, &settled.app_name, &settled.window_title);
+                if !shared.deliver(stats, &event_tx, event) {
+                    break;
+                }
             }
+
+            thread::sleep(WINDOW_POLL_INTERVAL);
         }
-        thread::sleep(Duration::from_millis(500));
-    });
+    })
+}
 
+fn set_last_window(shared: &CaptureShared, app_name: &str, window_title: &str) {
+    if let Ok(mut guard) = shared.last_window.write() {
+        *guard = Some((app_name.to_string(), window_title.to_string()));
+    }
+}
+
+fn window_event(
+    shared: &CaptureShared,
+    event_type: AppEventType,
+    app_name: &str,
+    window_title: &str,
+    title_churn: u32,
+) -> CaptureEvent {
+    CaptureEvent {
+        event_type,
+        timestamp_us: shared.clock.now_us(),
+        app_name: app_name.to_string(),
+        window_title: window_title.to_string(),
+        mouse_x: 0,
+        mouse_y: 0,
+        mouse_speed: 0,
+        idle_duration_ms: 0,
+        title_churn,
+    }
+}
+
+/// Run the OS input hook. `rdev::listen` blocks for the life of the process and
+/// cannot be interrupted, so stop/pause are honoured by dropping events instead.
+pub(crate) fn spawn_input_listener(
+    shared: Arc<CaptureShared>,
+    event_tx: Sender<CaptureEvent>,
+) -> thread::JoinHandle<()> {
     thread::spawn(move || {
+        let _alive = AliveGuard::new(&shared.input);
+
+        let callback_shared = Arc::clone(&shared);
+        let mut last_mouse_sample: Option<Instant> = None;
         let callback = move |event: Event| {
-            let now = timestamp_secs();
-            match event.event_type {
+            let shared = &callback_shared;
+            shared.input.heartbeat();
+
+            let now = shared.clock.now_us();
+            let (event_type, mouse_x, mouse_y) = match event.event_type {
                 EventType::KeyPress(key) => {
                     if matches!(key, Key::Unknown(_)) {
                         return;
                     }
-                    let (app, title) = read_window(&last_window);
-                    let _ = event_tx.send(CaptureEvent {
-                        event_type: AppEventType::KeyPress,
-                        timestamp_secs: now,
-                        app_name: app,
-                        window_title: title,
-                        mouse_x: 0,
-                        mouse_y: 0,
-                        mouse_speed: 0,
-                        idle_duration_ms: 0,
-                    });
-                }
-                EventType::ButtonPress(_) => {
-                    let (app, title) = read_window(&last_window);
-                    let _ = event_tx.send(CaptureEvent {
-                        event_type: AppEventType::MouseClick,
-                        timestamp_secs: now,
-                        app_name: app,
-                        window_title: title,
-                        mouse_x: 0,
-                        mouse_y: 0,
-                        mouse_speed: 0,
-                        idle_duration_ms: 0,
-                    });
+                    (AppEventType::KeyPress, 0, 0)
                 }
+                EventType::ButtonPress(_) => (AppEventType::MouseClick, 0, 0),
                 EventType::MouseMove { x, y } => {
-                    let should_sample = last_mouse_sample
-                        .read()
-                        .ok()
-                        .and_then(|t| t.elapsed().ok())
-                        .map(|d| d >= Duration::from_millis(50))
-                        .unwrap_or(true);
-                    if !should_sample {
+                    if last_mouse_sample.is_some_and(|t| t.elapsed() < MOUSE_SAMPLE_INTERVAL) {
                         return;
                     }
-                    if let Ok(mut sample) = last_mouse_sample.write() {
-                        *sample = SystemTime::now();
-                    }
-                    let (app, title) = read_window(&last_window);
-                    let _ = event_tx.send(CaptureEvent {
-                        event_type: AppEventType::MouseMove,
-                        timestamp_secs: now,
-                        app_name: app,
-                        window_title: title,
-                        mouse_x: x as i32,
-                        mouse_y: y as i32,
-                        mouse_speed: 0,
-                        idle_duration_ms: 0,
-                    });
+                    last_mouse_sample = Some(Instant::now());
+                    (AppEventType::MouseMove, x as i32, y as i32)
                 }
-                _ => {}
-            }
+                _ => return,
+            };
+
+            let (app, title) = read_window(shared);
+            shared.deliver(
+                &shared.input,
+                &event_tx,
+                CaptureEvent {
+                    event_type,
+                    timestamp_us: now,
+                    app_name: app,
+                    window_title: title,
+                    mouse_x,
+                    mouse_y,
+                    mouse_speed: 0,
+                    idle_duration_ms: 0,
+                    title_churn: 0,
+                },
+            );
         };
 
         if let Err(err) = rdev::listen(callback) {
-            log::error!("capture thread stopped: {err:?}");
+            log::error!("input capture stopped: {err:?}");
+            shared.input.set_error(format!("{err:?}"));
         }
     })
 }
 
-fn read_window(last_window: &Arc<RwLock<Option<(String, String)>>>) -> (String, String) {
-    last_window
+fn read_window(shared: &CaptureShared) -> (String, String) {
+    shared
+        .last_window
         .read()
         .ok()
         .and_then(|g| g.clone())
         .unwrap_or_else(|| ("Unknown".to_string(), String::new()))
 }
-
-fn timestamp_secs() -> f64 {
-    SystemTime::now()
-        .duration_since(UNIX_EPOCH)
-        .map(|d| d.as_secs_f64())
-        .unwrap_or(0.0)
-}
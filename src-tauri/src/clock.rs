@@ -0,0 +1,147 @@
+//! The engine's single time source. Every timestamp is integer microseconds
+//! since the Unix epoch, taken from a `Clock`, so live capture, replay, soak
+//! runs and tests all share one timeline.
+
+use std::sync::atomic::{AtomicI64, Ordering};
+use std::sync::Arc;
+use std::time::{Instant, SystemTime, UNIX_EPOCH};
+
+/// Microseconds since the Unix epoch. Implementations never go backwards.
+pub trait Clock: Send + Sync {
+    fn now_us(&self) -> i64;
+}
+
+pub type SharedClock = Arc<dyn Clock>;
+
+pub fn system_clock() -> SharedClock {
+    Arc::new(SystemClock::new())
+}
+
+pub fn us_to_secs(us: i64) -> f64 {
+    us as f64 / 1_000_000.0
+}
+
+/// RFC 3339 text for a clock reading. For storage and display, not hot paths.
+pub fn format_rfc3339(us: i64) -> String {
+    chrono::DateTime::from_timestamp_micros(us)
+        .unwrap_or_default()
+        .to_rfc3339()
+}
+
+fn wall_now_us() -> i64 {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map(|d| d.as_micros() as i64)
+        .unwrap_or(0)
+}
+
+/// Wall time read once, then advanced by a monotonic `Instant`, so NTP or
+/// manual clock changes cannot reorder events.
+pub struct SystemClock {
+    origin_us: i64,
+    origin: Instant,
+}
+
+impl SystemClock {
+    pub fn new() -> Self {
+        Self {
+            origin_us: wall_now_us(),
+            origin: Instant::now(),
+        }
+    }
+}
+
+impl Default for SystemClock {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Clock for SystemClock {
+    fn now_us(&self) -> i64 {
+        self.origin_us + self.origin.elapsed().as_micros() as i64
+    }
+}
+
+/// Time that only moves when told to; replay sets it from each event.
+#[derive(Default)]
+pub struct VirtualClock {
+    now_us: AtomicI64,
+}
+
+impl VirtualClock {
+    pub fn new(start_us: i64) -> Self {
+        Self {
+            now_us: AtomicI64::new(start_us),
+        }
+    }
+
+    /// Move to `us`. Never goes backwards, so out-of-order events cannot make
+    /// elapsed times negative.
+    pub fn set_us(&self, us: i64) {
+        self.now_us.fetch_max(us, Ordering::Relaxed);
+    }
+
+    pub fn advance_us(&self, delta_us: i64) {
+        self.now_us.fetch_add(delta_us.max(0), Ordering::Relaxed);
+    }
+}
+
+impl Clock for VirtualClock {
+    fn now_us(&self) -> i64 {
+        self.now_us.load(Ordering::Relaxed)
+    }
+}
+
+/// Real time sped up by `factor`, for soak runs that cover hours of timers
+/// (hyperfocus alerts, distraction minimums) in minutes.
+pub struct AcceleratedClock {
+    origin_us: i64,
+    origin: Instant,
+    factor: f64,
+}
+
+impl AcceleratedClock {
+    pub fn new(factor: f64) -> Self {
+        Self {
+            origin_us: wall_now_us(),
+            origin: Instant::now(),
+            factor: factor.max(0.0),
+        }
+    }
+}
+
+impl Clock for AcceleratedClock {
+    fn now_us(&self) -> i64 {
+        let elapsed_us = self.origin.elapsed().as_micros() as f64 * self.factor;
+        self.origin_us + elapsed_us as i64
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn clocks_are_monotonic_and_accelerated_runs_faster() {
+        let system = SystemClock::new();
+        let fast = AcceleratedClock::new(1_000.0);
+        let (s0, f0) = (system.now_us(), fast.now_us());
+        std::thread::sleep(std::time::Duration::from_millis(5));
+        let (s1, f1) = (system.now_us(), fast.now_us());
+
+        assert!(s1 >= s0 + 5_000);
+        assert!(f1 - f0 >= 5_000_000, "1000x over 5ms should be >= 5s");
+    }
+
+    #[test]
+    fn virtual_clock_ignores_stale_readings() {
+        let clock = VirtualClock::new(10);
+        clock.set_us(50);
+        clock.set_us(20);
+        assert_eq!(clock.now_us(), 50);
+        clock.advance_us(-5);
+        assert_eq!(clock.now_us(), 50);
+        assert_eq!(format_rfc3339(0), "1970-01-01T00:00:00+00:00");
+    }
+}
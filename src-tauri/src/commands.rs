@@ -10,7 +10,8 @@ use crate::types::{
 pub fn get_health(state: State<'_, AppState>) -> HealthStatus {
     HealthStatus {
         status: "online".to_string(),
-        capture_running: *state.capture_running.lock(),
+        capture_running: state.capture.is_capturing(),
+        capture: state.capture.health(),
         permissions: state.permissions.lock().clone(),
     }
 }
@@ -91,7 +92,9 @@ pub fn submit_label(state: State<'_, AppState>, request: LabelRequest) -> Result
             request.label,
             request.notes.as_deref(),
         )
-        .map_err(|e| e.to_string())
+        .map_err(|e| e.to_string())?;
+    state.learn_from_label(request.label);
+    Ok(())
 }
 
 #[tauri::command]
@@ -114,6 +117,12 @@ pub fn set_focus_mode(state: State<'_, AppState>, mode: String) -> Result<(), St
     Ok(())
 }
 
+#[tauri::command]
+pub fn set_capture_paused(state: State<'_, AppState>, paused: bool) -> Result<(), String> {
+    state.capture.set_paused(paused);
+    Ok(())
+}
+
 #[tauri::command]
 pub fn dismiss_snapback(app: tauri::AppHandle) -> Result<(), String> {
     if let Some(window) = app.get_webview_window("snapback") {
@@ -133,6 +142,7 @@ pub fn send_test_prediction(state: State<'_, AppState>) -> Result<PredictionReco
         .map(|s| s.session_id)
         .unwrap_or_else(|| "demo-session".to_string());
 
+    let timestamp_us = state.clock.now_us();
     let record = PredictionRecord {
         session_id,
         focus_score: 72.0,
@@ -141,7 +151,9 @@ pub fn send_test_prediction(state: State<'_, AppState>) -> Result<PredictionReco
         thrash_score: 0.12,
         drift_score: 0.18,
         goal_alignment: 0.82,
-        timestamp: chrono::Utc::now().to_rfc3339(),
+        timestamp_us,
+        timestamp: crate::clock::format_rfc3339(timestamp_us),
+        smoothed_state: "PRODUCTIVE".to_string(),
     };
     state
         .storage
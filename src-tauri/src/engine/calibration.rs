@@ -0,0 +1,147 @@
+//! Per-user calibration of class probabilities from the user's own labels.
+//!
+//! Each class keeps `BINS` reliability bins over the probability the
+//! classifier gave it. A label adds one observation to the bin each class fell
+//! in, counting a hit for the labelled class. Calibrated probabilities blend a
+//! bin's hit rate with the raw probability, weighted by how many labels the bin
+//! has seen, then renormalise. Both steps touch one bin per class, so labels
+//! apply immediately and cost nothing to keep up to date; predictions whose
+//! bins no label has reached pass through unchanged.
+
+use crate::types::{CalibrationBin, FocusLabel};
+
+pub const BINS: usize = 10;
+const CLASSES: usize = 4;
+/// Labels a bin needs before its hit rate counts as much as the model.
+const PRIOR_WEIGHT: f64 = 4.0;
+/// How long after a prediction a label still describes it.
+pub const LABEL_WINDOW_US: i64 = 300_000_000;
+
+/// `STATE_LABELS` index of a label.
+pub fn class_index(label: FocusLabel) -> usize {
+    match label {
+        FocusLabel::Distracted => 0,
+        FocusLabel::PseudoProductive => 1,
+        FocusLabel::Productive => 2,
+        FocusLabel::DeepFocus => 3,
+    }
+}
+
+fn bin_of(probability: f64) -> usize {
+    // `as` saturates, and maps NaN to bin 0.
+    ((probability * BINS as f64) as usize).min(BINS - 1)
+}
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Calibration {
+    count: [[f64; BINS]; CLASSES],
+    hits: [[f64; BINS]; CLASSES],
+    labels: u64,
+}
+
+impl Default for Calibration {
+    fn default() -> Self {
+        Self {
+            count: [[0.0; BINS]; CLASSES],
+            hits: [[0.0; BINS]; CLASSES],
+            labels: 0,
+        }
+    }
+}
+
+impl Calibration {
+    /// Rebuilds the state `observe` handed out; unknown bins are skipped.
+    pub fn from_bins(bins: &[CalibrationBin]) -> Self {
+        let mut calibration = Self::default();
+        for bin in bins {
+            if bin.class_index >= CLASSES || bin.bin >= BINS {
+                continue;
+            }
+            calibration.count[bin.class_index][bin.bin] = bin.count;
+            calibration.hits[bin.class_index][bin.bin] = bin.hits;
+        }
+        // Every label lands in exactly one bin per class.
+        calibration.labels = calibration.count[0].iter().sum::<f64>() as u64;
+        calibration
+    }
+
+    pub fn labels(&self) -> u64 {
+        self.labels
+    }
+
+    /// Records that the user was in `label` when the classifier answered
+    /// `raw` (normalised, uncalibrated). Returns the bins that changed, for
+    /// persisting.
+    pub fn observe(
+        &mut self,
+        label: FocusLabel,
+        raw: &[f64; CLASSES],
+    ) -> [CalibrationBin; CLASSES] {
+        let truth = class_index(label);
+        self.labels += 1;
+        std::array::from_fn(|class| {
+            let bin = bin_of(raw[class]);
+            self.count[class][bin] += 1.0;
+            self.hits[class][bin] += if class == truth { 1.0 } else { 0.0 };
+            CalibrationBin {
+                class_index: class,
+                bin,
+                count: self.count[class][bin],
+                hits: self.hits[class][bin],
+            }
+        })
+    }
+
+    /// Calibrated copy of normalised `probas`.
+    pub fn apply(&self, probas: [f64; CLASSES]) -> [f64; CLASSES] {
+        if self.labels == 0 {
+            return probas;
+        }
+        let mut calibrated = [0.0; CLASSES];
+        let mut seen = 0.0;
+        for (class, p) in probas.iter().enumerate() {
+            let bin = bin_of(*p);
+            let count = self.count[class][bin];
+            seen += count;
+            calibrated[class] = (self.hits[class][bin] + PRIOR_WEIGHT * p) / (count + PRIOR_WEIGHT);
+        }
+        let total: f64 = calibrated.iter().sum();
+        if seen == 0.0 || total <= 0.0 {
+            return probas;
+        }
+        calibrated.map(|p| p / total)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const RAW: [f64; 4] = [0.15, 0.2, 0.55, 0.1];
+
+    #[test]
+    fn unlabelled_calibration_is_the_identity() {
+        assert_eq!(Calibration::default().apply(RAW), RAW);
+    }
+
+    #[test]
+    fn labels_pull_probability_toward_the_labelled_state() {
+        let mut calibration = Calibration::default();
+        let mut bins = Vec::new();
+        for _ in 0..6 {
+            bins.extend(calibration.observe(FocusLabel::Distracted, &RAW));
+        }
+        let calibrated = calibration.apply(RAW);
+        assert!(calibrated[0] > 0.5, "{calibrated:?}");
+        assert!(calibrated[2] < RAW[2], "{calibrated:?}");
+        assert!((calibrated.iter().sum::<f64>() - 1.0).abs() < 1e-12);
+
+        // Rows elsewhere in the distribution are left alone.
+        let other = [0.05, 0.05, 0.05, 0.85];
+        assert_eq!(calibration.apply(other), other);
+
+        // Replaying the persisted bins (latest value per bin wins) restores it.
+        assert_eq!(Calibration::from_bins(&bins), calibration);
+        assert_eq!(calibration.labels(), 6);
+    }
+}
@@ -1,16 +1,41 @@
+use std::collections::HashMap;
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
 use crate::engine::app_context::classify;
-use crate::engine::features::FeatureVector;
+use crate::engine::calibration::{class_index, Calibration};
+use crate::engine::features::{FeatureContext, FeatureVector};
+use crate::engine::fnv;
 use crate::engine::goal_alignment::{alignment_bias, alignment_score};
-use crate::types::{AppRuleRecord, FocusMode};
+use crate::engine::heuristic_params::{HeuristicParams, Param as P};
+use crate::engine::model_registry::ModelRegistry;
+use crate::engine::online_model::OnlineModel;
+use crate::engine::tensor::FeatureTensor;
+use crate::types::{AppRuleRecord, CalibrationBin, FocusLabel, FocusMode};
 
 #[derive(Debug, Clone)]
 pub struct PredictionScores {
     pub focus_score: f64,
     pub distraction_risk: f64,
     pub focus_state: String,
+    /// `focus_state` was forced by a rule (blocked app, thrash, drift, risk
+    /// threshold) rather than read off `probas`.
+    pub overridden: bool,
     pub thrash_score: f64,
     pub drift_score: f64,
     pub goal_alignment: f64,
+    /// Normalised heuristic or trained-model probabilities, in
+    /// `STATE_LABELS` order, before calibration and before the on-device
+    /// model is mixed in; what a label for this prediction calibrates
+    /// against.
+    pub raw_probas: [f64; 4],
+    /// Calibrated probabilities with the on-device model mixed in; the
+    /// scores above come from these.
+    pub probas: [f64; 4],
+    /// `probas` and `focus_state` after `StateFilter` has smoothed them over
+    /// time; equal to the per-second values until then.
+    pub smoothed_probas: [f64; 4],
+    pub smoothed_state: String,
 }
 
 const FOCUS_LEVELS: [f64; 4] = [25.0, 50.0, 75.0, 100.0];
@@ -21,203 +46,666 @@ const STATE_LABELS: [&str; 4] = [
     "DEEP_FOCUS",
 ];
 
+/// Most likely state; the last of equal maxima wins.
+pub(crate) fn state_label(probas: &[f64; 4]) -> &'static str {
+    probas
+        .iter()
+        .enumerate()
+        .max_by(|a, b| a.1.partial_cmp(b.1).unwrap_or(std::cmp::Ordering::Equal))
+        .map_or("UNKNOWN", |(idx, _)| STATE_LABELS[idx])
+}
+
 fn clamp(value: f64, min: f64, max: f64) -> f64 {
     value.max(min).min(max)
 }
 
+/// Rows `predict_batch` scores per heuristic kernel call.
+const BATCH_LANES: usize = 8;
+
+pub const HEURISTIC_INPUT_COUNT: usize = 16;
+
+/// Columns of `Classifier::heuristic_inputs`, which is everything the
+/// heuristic mix and its overrides read. ml/heuristics.py re-scores these
+/// rows under candidate `HeuristicParams`.
+pub const HEURISTIC_INPUT_NAMES: [&str; HEURISTIC_INPUT_COUNT] = [
+    "context_switches_30s",
+    "context_switches_5min",
+    "extra_apps_5min",
+    "window_title_changed_30s",
+    "title_churn_rate_30s",
+    "keystroke_count",
+    "keystroke_interval_std",
+    "keystroke_rate",
+    "time_in_current_app",
+    "idle_time_30s",
+    "is_work_app",
+    "is_browser_or_chat",
+    "goal_bias",
+    "is_entertainment",
+    "is_communication",
+    "personal_block",
+];
+
+/// What the heuristic mix needs from the window's app and title. It only
+/// changes with the context, so batches resolve it once per window.
+#[derive(Debug, Clone, Copy)]
+struct ContextTerms {
+    goal_alignment: f64,
+    bias: f64,
+    is_entertainment: bool,
+    is_communication: bool,
+    personal_block: bool,
+}
+
+impl ContextTerms {
+    fn resolve(
+        context: &FeatureContext,
+        session_goal: Option<&str>,
+        rules: &[AppRuleRecord],
+    ) -> Self {
+        let ctx = classify(&context.app_name, &context.window_title, rules);
+        let goal_alignment = session_goal
+            .filter(|g| !g.trim().is_empty())
+            .map(|g| alignment_score(g, &ctx, &context.window_title))
+            .unwrap_or(0.5);
+        Self {
+            goal_alignment,
+            bias: alignment_bias(session_goal, &ctx, &context.window_title),
+            is_entertainment: ctx.is_entertainment || ctx.personal_block,
+            is_communication: ctx.is_communication && !ctx.personal_allow,
+            personal_block: ctx.personal_block,
+        }
+    }
+}
+
+/// Heuristic inputs for `N` rows, one array per input, so the kernel's lane
+/// loop compiles to vector arithmetic.
+#[derive(Debug, Clone, Copy)]
+struct HeuristicInputs<const N: usize> {
+    context_switches_30s: [f64; N],
+    context_switches_5min: [f64; N],
+    extra_apps_5min: [f64; N],
+    window_title_changed_30s: [f64; N],
+    title_churn_rate_30s: [f64; N],
+    keystroke_count: [f64; N],
+    keystroke_interval_std: [f64; N],
+    keystroke_rate: [f64; N],
+    time_in_current_app: [f64; N],
+    idle_time_30s: [f64; N],
+    is_work_app: [f64; N],
+    is_browser_or_chat: [f64; N],
+    bias: [f64; N],
+    is_entertainment: [f64; N],
+    is_communication: [f64; N],
+}
+
+impl<const N: usize> HeuristicInputs<N> {
+    fn new() -> Self {
+        Self {
+            context_switches_30s: [0.0; N],
+            context_switches_5min: [0.0; N],
+            extra_apps_5min: [0.0; N],
+            window_title_changed_30s: [0.0; N],
+            title_churn_rate_30s: [0.0; N],
+            keystroke_count: [0.0; N],
+            keystroke_interval_std: [0.0; N],
+            keystroke_rate: [0.0; N],
+            time_in_current_app: [0.0; N],
+            idle_time_30s: [0.0; N],
+            is_work_app: [0.0; N],
+            is_browser_or_chat: [0.0; N],
+            bias: [0.0; N],
+            is_entertainment: [0.0; N],
+            is_communication: [0.0; N],
+        }
+    }
+
+    fn set(&mut self, lane: usize, features: &FeatureVector, terms: &ContextTerms) {
+        self.context_switches_30s[lane] = features.context_switches_30s as f64;
+        self.context_switches_5min[lane] = features.context_switches_5min as f64;
+        self.extra_apps_5min[lane] = features.unique_apps_5min.saturating_sub(1) as f64;
+        self.window_title_changed_30s[lane] = flag(features.window_title_changed_30s);
+        self.title_churn_rate_30s[lane] = features.title_churn_rate_30s;
+        self.keystroke_count[lane] = features.keystroke_count as f64;
+        self.keystroke_interval_std[lane] = features.keystroke_interval_std;
+        self.keystroke_rate[lane] = features.keystroke_rate;
+        self.time_in_current_app[lane] = features.time_in_current_app as f64;
+        self.idle_time_30s[lane] = features.idle_time_30s;
+        self.is_work_app[lane] = flag(features.is_ide || features.is_productivity);
+        self.is_browser_or_chat[lane] = flag(features.is_browser || features.is_communication);
+        self.bias[lane] = terms.bias;
+        self.is_entertainment[lane] = flag(terms.is_entertainment);
+        self.is_communication[lane] = flag(terms.is_communication);
+    }
+
+    /// Lane `lane` in `HEURISTIC_INPUT_NAMES` order.
+    fn row(&self, lane: usize, personal_block: bool) -> [f64; HEURISTIC_INPUT_COUNT] {
+        [
+            self.context_switches_30s[lane],
+            self.context_switches_5min[lane],
+            self.extra_apps_5min[lane],
+            self.window_title_changed_30s[lane],
+            self.title_churn_rate_30s[lane],
+            self.keystroke_count[lane],
+            self.keystroke_interval_std[lane],
+            self.keystroke_rate[lane],
+            self.time_in_current_app[lane],
+            self.idle_time_30s[lane],
+            self.is_work_app[lane],
+            self.is_browser_or_chat[lane],
+            self.bias[lane],
+            self.is_entertainment[lane],
+            self.is_communication[lane],
+            flag(personal_block),
+        ]
+    }
+}
+
+/// 1.0 or 0.0; a conversion, not a branch, so flags can gate terms by
+/// multiplication.
+fn flag(value: bool) -> f64 {
+    f64::from(u8::from(value))
+}
+
+#[derive(Debug, Clone, Copy)]
+struct HeuristicOutputs<const N: usize> {
+    probas: [[f64; 4]; N],
+    thrash: [f64; N],
+    drift: [f64; N],
+}
+
 /// Rapid context jumping across apps/windows (thrash).
-fn thrash_score(features: &FeatureVector) -> f64 {
-    let switches_30s = (features.context_switches_30s as f64 / 4.0).min(1.0);
-    let switches_5min = (features.context_switches_5min as f64 / 10.0).min(1.0);
-    let unique_apps = ((features.unique_apps_5min.saturating_sub(1)) as f64 / 5.0)
+#[inline(always)]
+fn thrash_score<const N: usize>(x: &HeuristicInputs<N>, lane: usize, p: &HeuristicParams) -> f64 {
+    let switches_30s = (x.context_switches_30s[lane] / p[P::ThrashSwitches30sScale]).min(1.0);
+    let switches_5min = (x.context_switches_5min[lane] / p[P::ThrashSwitches5minScale]).min(1.0);
+    let unique_apps = (x.extra_apps_5min[lane] / p[P::ThrashExtraAppsScale])
         .min(1.0)
         .max(0.0);
-    clamp(switches_30s * 0.45 + switches_5min * 0.25 + unique_apps * 0.30, 0.0, 1.0)
+    clamp(
+        switches_30s * p[P::ThrashSwitches30sWeight]
+            + switches_5min * p[P::ThrashSwitches5minWeight]
+            + unique_apps * p[P::ThrashExtraAppsWeight],
+        0.0,
+        1.0,
+    )
 }
 
 /// Busy-work drift: churning tabs/titles or erratic typing while still in "work" apps.
-fn drift_score(features: &FeatureVector) -> f64 {
-    let title_churn = if features.window_title_changed_30s { 1.0 } else { 0.0 };
-    let keystroke_chaos = if features.keystroke_count >= 3 {
-        (features.keystroke_interval_std / 1.2).min(1.0)
-    } else {
-        0.0
-    };
-    let unsettled = (features.context_switches_30s as f64 / 3.0).min(1.0);
-    let in_work_context = if features.is_ide || features.is_productivity {
-        1.0
-    } else if features.is_browser || features.is_communication {
-        0.85
-    } else {
-        0.4
-    };
+#[inline(always)]
+fn drift_score<const N: usize>(x: &HeuristicInputs<N>, lane: usize, p: &HeuristicParams) -> f64 {
+    // One settled title change is normal work; sustained churn saturates the signal.
+    let churn = (x.title_churn_rate_30s[lane] / p[P::DriftChurnScale]).min(1.0);
+    let changed = x.window_title_changed_30s[lane];
+    let title_churn = changed * (p[P::DriftChangedBase] + p[P::DriftChangedChurnWeight] * churn)
+        + (1.0 - changed) * (p[P::DriftChurnWeight] * churn);
+    let keystroke_chaos = flag(x.keystroke_count[lane] >= p[P::DriftMinKeystrokes])
+        * (x.keystroke_interval_std[lane] / p[P::DriftKeystrokeStdScale]).min(1.0);
+    let unsettled = (x.context_switches_30s[lane] / p[P::DriftSwitches30sScale]).min(1.0);
+    // Work apps count fully, browsers and chat mostly, anything else little.
+    let browser_or_other = x.is_browser_or_chat[lane] * p[P::ContextBrowserOrChat]
+        + (1.0 - x.is_browser_or_chat[lane]) * p[P::ContextOther];
+    let work_context =
+        x.is_work_app[lane] * p[P::ContextWorkApp] + (1.0 - x.is_work_app[lane]) * browser_or_other;
     clamp(
-        (title_churn * 0.45 + keystroke_chaos * 0.30 + unsettled * 0.25) * in_work_context,
+        (title_churn * p[P::DriftTitleWeight]
+            + keystroke_chaos * p[P::DriftKeystrokeWeight]
+            + unsettled * p[P::DriftSwitchWeight])
+            * work_context,
         0.0,
         1.0,
     )
 }
 
 /// Stable deep-work signal: low thrash/drift, sustained time, steady typing.
-fn deep_work_score(features: &FeatureVector, thrash: f64, drift: f64) -> f64 {
-    let settled = (features.time_in_current_app as f64 / 180.0).min(1.0);
-    let steady_typing = if features.keystroke_count >= 4 {
-        (1.0 - (features.keystroke_interval_std / 1.0).min(1.0)).max(0.0)
-    } else {
-        0.3
-    };
-    let low_switch = (1.0 - (features.context_switches_30s as f64 / 2.0).min(1.0)).max(0.0);
+#[inline(always)]
+fn deep_work_score<const N: usize>(
+    x: &HeuristicInputs<N>,
+    lane: usize,
+    p: &HeuristicParams,
+    thrash: f64,
+    drift: f64,
+) -> f64 {
+    let settled = (x.time_in_current_app[lane] / p[P::DeepSettledScale]).min(1.0);
+    let typed = flag(x.keystroke_count[lane] >= p[P::DeepMinKeystrokes]);
+    let steady_typing = typed
+        * (1.0 - (x.keystroke_interval_std[lane] / p[P::DeepKeystrokeStdScale]).min(1.0)).max(0.0)
+        + (1.0 - typed) * p[P::DeepUntypedSteadiness];
+    let low_switch =
+        (1.0 - (x.context_switches_30s[lane] / p[P::DeepSwitches30sScale]).min(1.0)).max(0.0);
     let stability = (1.0 - thrash) * (1.0 - drift);
     clamp(
-        settled * 0.35 + steady_typing * 0.25 + low_switch * 0.20 + stability * 0.20,
+        settled * p[P::DeepSettledWeight]
+            + steady_typing * p[P::DeepTypingWeight]
+            + low_switch * p[P::DeepSwitchWeight]
+            + stability * p[P::DeepStabilityWeight],
         0.0,
         1.0,
     )
 }
 
-fn heuristic_probas(
-    features: &FeatureVector,
-    session_goal: Option<&str>,
-    rules: &[AppRuleRecord],
-) -> ([f64; 4], f64, f64) {
-    let ctx = classify(&features.app_name, &features.window_title, rules);
-    let bias = alignment_bias(session_goal, &ctx, &features.window_title);
-
-    let thrash = thrash_score(features);
-    let mut drift = drift_score(features);
-    drift = clamp(drift - bias * 0.25, 0.0, 1.0);
-    let deep = deep_work_score(features, thrash, drift);
-
-    let idle_time = features.idle_time_30s;
-    let keystroke_rate = features.keystroke_rate;
-    let time_in_app = features.time_in_current_app as f64;
-    let is_entertainment = if ctx.is_entertainment || ctx.personal_block {
-        1.0
-    } else {
-        0.0
-    };
-    let is_communication = if ctx.is_communication && !ctx.personal_allow {
-        1.0
-    } else {
-        0.0
+/// The heuristic mix for `N` rows. Every lane runs the same branch-free
+/// arithmetic (flags gate terms by multiplying with 1.0 or 0.0), so one row
+/// and a batch lane give bit-identical results.
+#[inline(always)]
+fn heuristic_probas<const N: usize>(
+    x: &HeuristicInputs<N>,
+    p: &HeuristicParams,
+) -> HeuristicOutputs<N> {
+    let mut out = HeuristicOutputs {
+        probas: [[0.0; 4]; N],
+        thrash: [0.0; N],
+        drift: [0.0; N],
     };
+    for lane in 0..N {
+        let bias = x.bias[lane];
+        let thrash = thrash_score(x, lane, p);
+        let drift = clamp(
+            drift_score(x, lane, p) - bias * p[P::DriftGoalBiasWeight],
+            0.0,
+            1.0,
+        );
+        let deep = deep_work_score(x, lane, p, thrash, drift);
 
-    let mut distracted = 0.0;
-    distracted += thrash * 0.30;
-    distracted += (idle_time / 8.0).min(1.0) * 0.15;
-    distracted += (1.0 - (keystroke_rate / 4.0).min(1.0)) * 0.10;
-    distracted += (1.0 - (time_in_app / 120.0).min(1.0)) * 0.10;
-    distracted += is_entertainment * 0.20;
-    distracted += is_communication * 0.05;
-    distracted = clamp(distracted - bias * 0.35, 0.0, 1.0);
-
-    let pseudo = clamp(drift * (1.0 - distracted * 0.6), 0.0, 1.0);
-    let remaining = (1.0 - distracted - pseudo).max(0.0);
-    let productive = remaining * (1.0 - deep * 0.65);
-    let deep_prob = remaining * deep * 0.65;
-
-    (
-        [distracted, pseudo, productive, deep_prob.max(0.0)],
-        thrash,
-        drift,
-    )
+        let mut distracted = 0.0;
+        distracted += thrash * p[P::DistractedThrashWeight];
+        distracted += (x.idle_time_30s[lane] / p[P::DistractedIdleScale]).min(1.0)
+            * p[P::DistractedIdleWeight];
+        distracted += (1.0
+            - (x.keystroke_rate[lane] / p[P::DistractedKeystrokeRateScale]).min(1.0))
+            * p[P::DistractedLowTypingWeight];
+        distracted += (1.0 - (x.time_in_current_app[lane] / p[P::DistractedAppTimeScale]).min(1.0))
+            * p[P::DistractedShortStayWeight];
+        distracted += x.is_entertainment[lane] * p[P::DistractedEntertainmentWeight];
+        distracted += x.is_communication[lane] * p[P::DistractedCommunicationWeight];
+        distracted = clamp(distracted - bias * p[P::DistractedGoalBiasWeight], 0.0, 1.0);
+
+        let pseudo = clamp(
+            drift * (1.0 - distracted * p[P::PseudoDistractedDamping]),
+            0.0,
+            1.0,
+        );
+        let remaining = (1.0 - distracted - pseudo).max(0.0);
+        let productive = remaining * (1.0 - deep * p[P::DeepShare]);
+        let deep_prob = remaining * deep * p[P::DeepShare];
+
+        out.probas[lane] = [distracted, pseudo, productive, deep_prob.max(0.0)];
+        out.thrash[lane] = thrash;
+        out.drift[lane] = drift;
+    }
+    out
+}
+
+fn normalized(probas: [f64; 4]) -> [f64; 4] {
+    let total: f64 = probas.iter().sum();
+    if total <= 0.0 {
+        [0.25, 0.25, 0.25, 0.25]
+    } else {
+        probas.map(|p| p / total)
+    }
 }
 
 fn scores_from_probas(
+    raw_probas: [f64; 4],
     probas: [f64; 4],
     thrash: f64,
     drift: f64,
     goal_alignment: f64,
+    params: &HeuristicParams,
 ) -> PredictionScores {
-    let total: f64 = probas.iter().sum();
-    let probas = if total <= 0.0 {
-        [0.25, 0.25, 0.25, 0.25]
-    } else {
-        probas.map(|p| p / total)
-    };
-
-    let distraction_risk = clamp(probas[0] + thrash * 0.15, 0.0, 1.0);
+    let distraction_risk = clamp(probas[0] + thrash * params[P::RiskThrashWeight], 0.0, 1.0);
     let focus_score: f64 = probas
         .iter()
         .enumerate()
         .map(|(i, p)| FOCUS_LEVELS[i] * p)
         .sum();
 
-    let focus_state = probas
-        .iter()
-        .enumerate()
-        .max_by(|a, b| a.1.partial_cmp(b.1).unwrap_or(std::cmp::Ordering::Equal))
-        .map(|(idx, _)| STATE_LABELS[idx].to_string())
-        .unwrap_or_else(|| "UNKNOWN".to_string());
+    let focus_state = state_label(&probas).to_string();
 
     PredictionScores {
         focus_score,
         distraction_risk,
         focus_state,
+        overridden: false,
         thrash_score: thrash,
         drift_score: drift,
         goal_alignment,
+        raw_probas,
+        probas,
+        smoothed_probas: probas,
+        smoothed_state: String::new(),
     }
 }
 
 pub struct Classifier {
     focus_mode: FocusMode,
+    params: HeuristicParams,
+    calibration: Calibration,
+    /// `calibration_source` the calibration was learned under.
+    calibrated_for: u64,
+    online: OnlineModel,
+    models: Option<Arc<ModelRegistry>>,
+    #[cfg(feature = "compiled-model")]
+    compiled_model: bool,
 }
 
 impl Classifier {
     pub fn new(focus_mode: FocusMode) -> Self {
-        Self { focus_mode }
+        let mut classifier = Self {
+            focus_mode,
+            params: HeuristicParams::default(),
+            calibration: Calibration::default(),
+            calibrated_for: 0,
+            online: OnlineModel::default(),
+            models: None,
+            #[cfg(feature = "compiled-model")]
+            compiled_model: false,
+        };
+        classifier.calibrated_for = classifier.calibration_source();
+        classifier
+    }
+
+    /// Score with the registry's tree model, when it has one, instead of the
+    /// heuristic mix.
+    pub fn set_model_registry(&mut self, models: Option<Arc<ModelRegistry>>) {
+        self.models = models;
+    }
+
+    /// Fall back to the model `build.rs` compiled in when the registry has none.
+    #[cfg(feature = "compiled-model")]
+    pub fn set_compiled_model(&mut self, enabled: bool) {
+        self.compiled_model = enabled;
     }
 
     pub fn set_focus_mode(&mut self, mode: FocusMode) {
         self.focus_mode = mode;
     }
 
+    pub fn set_heuristic_params(&mut self, params: HeuristicParams) {
+        self.params = params;
+    }
+
+    /// Bins learned under `source`; see `calibration_source`.
+    pub fn set_calibration(&mut self, calibration: Calibration, source: u64) {
+        self.calibration = calibration;
+        self.calibrated_for = source;
+    }
+
+    /// Identifies what produces the probabilities calibration learns from:
+    /// the tree, compiled or ONNX model that serves, by fingerprint, or else
+    /// the heuristic parameters. Bins learned under one source say nothing
+    /// about another.
+    pub fn calibration_source(&self) -> u64 {
+        let tagged =
+            |tag: &[u8], fingerprint: u64| fnv::extend(fnv::hash(tag), &fingerprint.to_le_bytes());
+        if let Some(model) = self.models.as_ref().and_then(|models| models.active()) {
+            return tagged(b"tree", model.fingerprint());
+        }
+        #[cfg(feature = "compiled-model")]
+        if self.compiled_model {
+            return tagged(b"compiled", crate::engine::compiled_model::FINGERPRINT);
+        }
+        #[cfg(feature = "onnx")]
+        if let Some(fingerprint) = crate::engine::onnx_model::fingerprint() {
+            return tagged(b"onnx", fingerprint);
+        }
+        tagged(b"heuristic", self.params.fingerprint())
+    }
+
+    /// `calibration_source` the current calibration belongs to.
+    pub fn calibrated_for(&self) -> u64 {
+        self.calibrated_for
+    }
+
+    /// Starts calibration over when its source no longer serves: the
+    /// registry swapped models, or other heuristic parameters are in use.
+    /// True when it did.
+    pub fn sync_calibration(&mut self) -> bool {
+        let source = self.calibration_source();
+        if source == self.calibrated_for {
+            return false;
+        }
+        self.calibration = Calibration::default();
+        self.calibrated_for = source;
+        true
+    }
+
+    pub fn set_online_model(&mut self, online: OnlineModel) {
+        self.online = online;
+    }
+
+    pub fn online_model(&self) -> &OnlineModel {
+        &self.online
+    }
+
+    /// Learns from a user label for the prediction made from `features`
+    /// with the given `raw_probas` under calibration source `source`: trains
+    /// the on-device model and, unless the source has changed since,
+    /// calibrates later predictions. Returns the calibration bins to persist.
+    pub fn observe_label(
+        &mut self,
+        label: FocusLabel,
+        raw_probas: &[f64; 4],
+        features: &FeatureTensor,
+        source: u64,
+    ) -> Option<[CalibrationBin; 4]> {
+        self.online.update(features, class_index(label));
+        (source == self.calibrated_for).then(|| self.calibration.observe(label, raw_probas))
+    }
+
+    /// The row the heuristic scores for `features`, in `HEURISTIC_INPUT_NAMES`
+    /// order; replays write these out for offline tuning.
+    pub fn heuristic_inputs(
+        &self,
+        features: &FeatureVector,
+        session_goal: Option<&str>,
+        rules: &[AppRuleRecord],
+    ) -> [f64; HEURISTIC_INPUT_COUNT] {
+        let terms = ContextTerms::resolve(&features.context, session_goal, rules);
+        let mut inputs = HeuristicInputs::<1>::new();
+        inputs.set(0, features, &terms);
+        inputs.row(0, terms.personal_block)
+    }
+
     pub fn predict(
         &self,
         features: &FeatureVector,
         session_goal: Option<&str>,
         rules: &[AppRuleRecord],
     ) -> PredictionScores {
-        let ctx = classify(&features.app_name, &features.window_title, rules);
-        let goal_alignment = session_goal
-            .filter(|g| !g.trim().is_empty())
-            .map(|g| alignment_score(g, &ctx, &features.window_title))
-            .unwrap_or(0.5);
+        // Timings only feed shadow comparisons.
+        let shadow = self.models.as_ref().filter(|models| models.is_shadowing());
+        let clock = shadow.map(|_| Instant::now());
+        let terms = ContextTerms::resolve(&features.context, session_goal, rules);
+        let mut inputs = HeuristicInputs::<1>::new();
+        inputs.set(0, features, &terms);
+        let heuristic = heuristic_probas(&inputs, &self.params);
+        let heuristic_time = elapsed(clock);
 
-        let (probas, thrash, drift) = heuristic_probas(features, session_goal, rules);
-        let mut scores = scores_from_probas(probas, thrash, drift, goal_alignment);
+        let clock = shadow.map(|_| Instant::now());
+        let model_probas = self.model_probas(features);
+        if let Some(models) = shadow {
+            let (served, time) = match model_probas {
+                Some(model_probas) => (model_probas, elapsed(clock)),
+                None => (heuristic.probas[0], heuristic_time),
+            };
+            models.shadow(&features.tensor(), &served, time);
+        }
 
-        #[cfg(feature = "onnx")]
-        if let Some(onnx_scores) = self.try_onnx_predict(features) {
-            scores = onnx_scores;
+        self.finish(
+            model_probas.unwrap_or(heuristic.probas[0]),
+            features,
+            heuristic.thrash[0],
+            heuristic.drift[0],
+            &terms,
+        )
+    }
+
+    /// `predict` for many rows at once, for replays and offline evaluation;
+    /// results match calling `predict` on each row. Context classification
+    /// runs once per distinct window, the heuristic runs `BATCH_LANES` rows
+    /// per kernel call, and the model scores the whole batch in one call.
+    /// Shadow comparisons are not recorded.
+    pub fn predict_batch(
+        &self,
+        rows: &[FeatureVector],
+        session_goal: Option<&str>,
+        rules: &[AppRuleRecord],
+    ) -> Vec<PredictionScores> {
+        if rows.is_empty() {
+            return Vec::new();
+        }
+        let mut resolved: HashMap<(&str, &str), ContextTerms> = HashMap::new();
+        let mut terms: Vec<ContextTerms> = Vec::with_capacity(rows.len());
+        for (idx, row) in rows.iter().enumerate() {
+            let context = &row.context;
+            // Consecutive rows usually share a window (and its `Arc`s).
+            if idx > 0
+                && rows[idx - 1].context.window_title == context.window_title
+                && rows[idx - 1].context.app_name == context.app_name
+            {
+                terms.push(terms[idx - 1]);
+                continue;
+            }
+            let key = (&*context.app_name, &*context.window_title);
+            let resolved = *resolved
+                .entry(key)
+                .or_insert_with(|| ContextTerms::resolve(context, session_goal, rules));
+            terms.push(resolved);
+        }
+
+        let model_probas = self.model_probas_batch(rows);
+        let mut scores = Vec::with_capacity(rows.len());
+        let mut inputs = HeuristicInputs::<BATCH_LANES>::new();
+        for (block, (rows, terms)) in rows
+            .chunks(BATCH_LANES)
+            .zip(terms.chunks(BATCH_LANES))
+            .enumerate()
+        {
+            for (lane, (row, terms)) in rows.iter().zip(terms).enumerate() {
+                inputs.set(lane, row, terms);
+            }
+            let heuristic = heuristic_probas(&inputs, &self.params);
+            for (lane, (row, terms)) in rows.iter().zip(terms).enumerate() {
+                let probas = model_probas
+                    .as_ref()
+                    .map_or(heuristic.probas[lane], |p| p[block * BATCH_LANES + lane]);
+                scores.push(self.finish(
+                    probas,
+                    row,
+                    heuristic.thrash[lane],
+                    heuristic.drift[lane],
+                    terms,
+                ));
+            }
         }
+        scores
+    }
 
-        let threshold = self.focus_mode.risk_threshold();
-        if scores.distraction_risk >= threshold || thrash >= 0.75 || ctx.personal_block {
+    /// Scores the heuristic or model `probas`: calibration only ever sees
+    /// them, so a label is not counted once by the on-device model and again
+    /// by the bins; the on-device model is mixed in after.
+    fn finish(
+        &self,
+        probas: [f64; 4],
+        features: &FeatureVector,
+        thrash: f64,
+        drift: f64,
+        terms: &ContextTerms,
+    ) -> PredictionScores {
+        let params = &self.params;
+        let raw_probas = normalized(probas);
+        let served = self.blend_online(self.calibration.apply(raw_probas), features);
+        let mut scores = scores_from_probas(
+            raw_probas,
+            served,
+            thrash,
+            drift,
+            terms.goal_alignment,
+            params,
+        );
+        let threshold = params.risk_threshold(self.focus_mode);
+        if scores.distraction_risk >= threshold
+            || thrash >= params[P::OverrideThrash]
+            || terms.personal_block
+        {
             scores.focus_state = "DISTRACTED".to_string();
-        } else if drift >= 0.55 && scores.focus_state != "DEEP_FOCUS" {
+            scores.overridden = true;
+        } else if drift >= params[P::OverrideDrift] && scores.focus_state != "DEEP_FOCUS" {
             scores.focus_state = "PSEUDO_PRODUCTIVE".to_string();
+            scores.overridden = true;
         }
-
+        scores.smoothed_state.clone_from(&scores.focus_state);
         scores
     }
 
-    #[cfg(feature = "onnx")]
-    fn try_onnx_predict(&self, features: &FeatureVector) -> Option<PredictionScores> {
-        crate::engine::onnx_model::predict(features)
+    /// Mixes the on-device model into `probas` by its confidence; a no-op
+    /// until it has seen a label.
+    fn blend_online(&self, probas: [f64; 4], features: &FeatureVector) -> [f64; 4] {
+        let weight = self.online.confidence();
+        let total: f64 = probas.iter().sum();
+        if weight == 0.0 || total <= 0.0 {
+            return probas;
+        }
+        let online = self.online.predict_probas(&features.tensor());
+        std::array::from_fn(|c| (1.0 - weight) * probas[c] / total + weight * online[c])
+    }
+
+    /// Trained-model probabilities: the registry's tree model when it has
+    /// one, else the compiled-in model when enabled, else the ONNX model in
+    /// `onnx` builds.
+    fn model_probas(&self, features: &FeatureVector) -> Option<[f64; 4]> {
+        if let Some(model) = self.models.as_ref().and_then(|models| models.active()) {
+            return Some(model.predict_probas(&features.tensor()));
+        }
+        #[cfg(feature = "compiled-model")]
+        if self.compiled_model {
+            return Some(crate::engine::compiled_model::predict_probas(
+                &features.tensor(),
+            ));
+        }
+        #[cfg(feature = "onnx")]
+        if let Some(probas) = crate::engine::onnx_model::predict(&features.tensor()) {
+            return Some(probas);
+        }
+        None
+    }
+
+    /// `model_probas` for every row, from the same model.
+    fn model_probas_batch(&self, rows: &[FeatureVector]) -> Option<Vec<[f64; 4]>> {
+        let tensors = || rows.iter().map(FeatureVector::tensor).collect::<Vec<_>>();
+        if let Some(model) = self.models.as_ref().and_then(|models| models.active()) {
+            return Some(model.predict_batch(&tensors()));
+        }
+        #[cfg(feature = "compiled-model")]
+        if self.compiled_model {
+            return Some(
+                tensors()
+                    .iter()
+                    .map(crate::engine::compiled_model::predict_probas)
+                    .collect(),
+            );
+        }
+        #[cfg(feature = "onnx")]
+        if let Some(probas) = crate::engine::onnx_model::predict_batch(&tensors()) {
+            return Some(probas);
+        }
+        None
     }
 }
 
+fn elapsed(clock: Option<Instant>) -> Duration {
+    clock.map(|started| started.elapsed()).unwrap_or_default()
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
-    use crate::engine::features::FeatureVector;
+    use crate::engine::features::{FeatureContext, FeatureVector};
 
     fn stable_features() -> FeatureVector {
         FeatureVector {
-            app_name: "Cursor".to_string(),
-            window_title: "classifier.rs — Snapback".to_string(),
+            context: FeatureContext::new("Cursor", "classifier.rs — Snapback"),
             context_switches_30s: 0,
             context_switches_5min: 1,
             unique_apps_5min: 1,
@@ -231,7 +719,7 @@ mod tests {
             is_communication: false,
             is_ide: true,
             is_productivity: false,
-            ..FeatureVector::empty(0.0)
+            ..FeatureVector::empty(0)
         }
     }
 
@@ -273,6 +761,23 @@ mod tests {
         assert_eq!(scores.focus_state, "PSEUDO_PRODUCTIVE");
     }
 
+    #[test]
+    fn title_churn_rate_raises_drift() {
+        let single_change = FeatureVector {
+            window_title_changed_30s: true,
+            title_churn_rate_30s: 2.0,
+            ..stable_features()
+        };
+        let churning = FeatureVector {
+            title_churn_rate_30s: 20.0,
+            ..single_change.clone()
+        };
+        let classifier = Classifier::new(FocusMode::Normal);
+        let calm = classifier.predict(&single_change, None, &[]);
+        let busy = classifier.predict(&churning, None, &[]);
+        assert!(busy.drift_score > calm.drift_score);
+    }
+
     #[test]
     fn deep_focus_when_stable_and_settled() {
         let scores = Classifier::new(FocusMode::Normal).predict(&stable_features(), None, &[]);
@@ -292,8 +797,7 @@ mod tests {
             keystroke_interval_std: 0.7,
             keystroke_count: 8,
             is_ide: true,
-            app_name: "Cursor".to_string(),
-            window_title: "classifier.rs".to_string(),
+            context: FeatureContext::new("Cursor", "classifier.rs"),
             ..stable_features()
         };
         let without_goal = Classifier::new(FocusMode::Normal).predict(&features, None, &[]);
@@ -309,14 +813,13 @@ mod tests {
     #[test]
     fn personal_block_rule_increases_distraction() {
         let features = FeatureVector {
-            app_name: "Notion".to_string(),
-            window_title: "Weekly plan".to_string(),
+            context: FeatureContext::new("Notion", "Weekly plan"),
             is_productivity: true,
             is_ide: false,
             is_entertainment: false,
             keystroke_rate: 2.0,
             time_in_current_app: 120,
-            ..FeatureVector::empty(0.0)
+            ..FeatureVector::empty(0)
         };
         let rules = vec![crate::types::AppRuleRecord {
             id: 1,
@@ -331,4 +834,257 @@ mod tests {
         assert!(blocked_scores.distraction_risk >= default_scores.distraction_risk);
         assert_eq!(blocked_scores.focus_state, "DISTRACTED");
     }
+
+    fn varied_rows() -> Vec<FeatureVector> {
+        let contexts = [
+            FeatureContext::new("Cursor", "classifier.rs — Snapback"),
+            FeatureContext::new("Google Chrome", "YouTube"),
+            FeatureContext::new("Notion", "Weekly plan"),
+        ];
+        // Not a multiple of BATCH_LANES, and contexts recur out of order.
+        (0..37)
+            .map(|i| FeatureVector {
+                context: contexts[(i / 3 + i % 2) % contexts.len()].clone(),
+                context_switches_30s: i % 6,
+                unique_apps_5min: i % 7,
+                window_title_changed_30s: i % 4 == 0,
+                title_churn_rate_30s: (i % 5) as f64 * 4.0,
+                keystroke_count: i % 12,
+                keystroke_interval_std: (i % 9) as f64 * 0.2,
+                time_in_current_app: (i * 17) as i64,
+                idle_time_30s: (i % 10) as f64,
+                is_browser: i % 3 == 1,
+                ..stable_features()
+            })
+            .collect()
+    }
+
+    fn assert_same_scores(batch: &[PredictionScores], single: &[PredictionScores]) {
+        assert_eq!(batch.len(), single.len());
+        for (idx, (b, s)) in batch.iter().zip(single).enumerate() {
+            assert_eq!(b.focus_state, s.focus_state, "row {idx}");
+            assert_eq!(
+                b.focus_score.to_bits(),
+                s.focus_score.to_bits(),
+                "row {idx}"
+            );
+            assert_eq!(
+                b.distraction_risk.to_bits(),
+                s.distraction_risk.to_bits(),
+                "row {idx}"
+            );
+            assert_eq!(
+                b.thrash_score.to_bits(),
+                s.thrash_score.to_bits(),
+                "row {idx}"
+            );
+            assert_eq!(
+                b.drift_score.to_bits(),
+                s.drift_score.to_bits(),
+                "row {idx}"
+            );
+            assert_eq!(
+                b.goal_alignment.to_bits(),
+                s.goal_alignment.to_bits(),
+                "row {idx}"
+            );
+        }
+    }
+
+    #[test]
+    fn batch_matches_row_by_row_predictions() {
+        let rows = varied_rows();
+        let rules = vec![crate::types::AppRuleRecord {
+            id: 1,
+            pattern: "notion".to_string(),
+            rule_type: crate::types::AppRuleKind::Block,
+            note: None,
+            created_at: String::new(),
+            updated_at: String::new(),
+        }];
+        let goal = Some("implement the rust classifier feature");
+
+        let mut classifier = Classifier::new(FocusMode::Normal);
+        let single: Vec<_> = rows
+            .iter()
+            .map(|row| classifier.predict(row, goal, &rules))
+            .collect();
+        assert_same_scores(&classifier.predict_batch(&rows, goal, &rules), &single);
+        assert!(classifier.predict_batch(&[], goal, &rules).is_empty());
+
+        // And with a tree model serving.
+        let dir = std::env::temp_dir().join(format!("snapback_batch_{}", uuid::Uuid::new_v4()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let fixture = std::path::Path::new(env!("CARGO_MANIFEST_DIR"))
+            .join("../ml/tests/fixtures/tree_model/model.json");
+        std::fs::copy(fixture, dir.join(crate::engine::tree_model::MODEL_FILE)).unwrap();
+        classifier.set_model_registry(Some(ModelRegistry::open(&dir)));
+        let single: Vec<_> = rows
+            .iter()
+            .map(|row| classifier.predict(row, None, &[]))
+            .collect();
+        assert_same_scores(&classifier.predict_batch(&rows, None, &[]), &single);
+        let _ = std::fs::remove_dir_all(dir);
+    }
+
+    #[test]
+    fn labels_calibrate_later_predictions() {
+        let features = FeatureVector {
+            time_in_current_app: 40,
+            ..stable_features()
+        };
+        let mut classifier = Classifier::new(FocusMode::Normal);
+        let before = classifier.predict(&features, None, &[]);
+        assert_ne!(before.focus_state, "DEEP_FOCUS");
+        for _ in 0..8 {
+            let source = classifier.calibrated_for();
+            classifier.observe_label(
+                FocusLabel::DeepFocus,
+                &before.raw_probas,
+                &features.tensor(),
+                source,
+            );
+        }
+        let after = classifier.predict(&features, None, &[]);
+        assert_eq!(after.focus_state, "DEEP_FOCUS");
+        assert!(after.focus_score > before.focus_score);
+    }
+
+    #[test]
+    fn calibration_restarts_when_its_source_changes() {
+        let features = stable_features();
+        let mut classifier = Classifier::new(FocusMode::Normal);
+        assert!(!classifier.sync_calibration());
+        let raw_probas = classifier.predict(&features, None, &[]).raw_probas;
+        let heuristic = classifier.calibrated_for();
+        let label = |classifier: &mut Classifier, source: u64| {
+            classifier.observe_label(
+                FocusLabel::DeepFocus,
+                &raw_probas,
+                &features.tensor(),
+                source,
+            )
+        };
+        assert!(label(&mut classifier, heuristic).is_some());
+        assert_eq!(classifier.calibration.labels(), 1);
+
+        // Other heuristic constants.
+        let mut params = HeuristicParams::default();
+        params.0[P::DeepShare as usize] *= 0.5;
+        classifier.set_heuristic_params(params);
+        assert!(classifier.sync_calibration());
+        assert_eq!(classifier.calibration.labels(), 0);
+        // A label for a prediction made before the change is not counted.
+        assert!(label(&mut classifier, heuristic).is_none());
+        assert_eq!(classifier.calibration.labels(), 0);
+        let tuned = classifier.calibrated_for();
+        assert!(label(&mut classifier, tuned).is_some());
+
+        // A model swapped in by the registry.
+        let dir = std::env::temp_dir().join(format!("snapback_calib_{}", uuid::Uuid::new_v4()));
+        std::fs::create_dir_all(&dir).unwrap();
+        let fixture = std::path::Path::new(env!("CARGO_MANIFEST_DIR"))
+            .join("../ml/tests/fixtures/tree_model/model.json");
+        let models = ModelRegistry::open(&dir);
+        classifier.set_model_registry(Some(models.clone()));
+        assert!(!classifier.sync_calibration());
+        std::fs::copy(fixture, dir.join(crate::engine::tree_model::MODEL_FILE)).unwrap();
+        assert!(models.refresh());
+        assert!(classifier.sync_calibration());
+        assert_eq!(classifier.calibration.labels(), 0);
+        assert!(!classifier.sync_calibration());
+        let _ = std::fs::remove_dir_all(dir);
+    }
+
+    #[test]
+    fn online_model_blends_in_after_labels() {
+        let features = stable_features();
+        let mut classifier = Classifier::new(FocusMode::Normal);
+        let before = classifier.predict(&features, None, &[]);
+        for _ in 0..30 {
+            let source = classifier.calibrated_for();
+            classifier.observe_label(
+                FocusLabel::Distracted,
+                &before.raw_probas,
+                &features.tensor(),
+                source,
+            );
+        }
+        let after = classifier.predict(&features, None, &[]);
+        assert!(after.probas[0] > before.probas[0], "{:?}", after.probas);
+        assert!((after.probas.iter().sum::<f64>() - 1.0).abs() < 1e-12);
+        // Calibration keeps learning from the heuristic alone.
+        assert_eq!(after.raw_probas, before.raw_probas);
+
+        let rows = varied_rows();
+        let single: Vec<_> = rows
+            .iter()
+            .map(|row| classifier.predict(row, None, &[]))
+            .collect();
+        assert_same_scores(&classifier.predict_batch(&rows, None, &[]), &single);
+    }
+
+    fn heuristic_fixture_dir() -> std::path::PathBuf {
+        std::path::Path::new(env!("CARGO_MANIFEST_DIR")).join("../ml/tests/fixtures/heuristics")
+    }
+
+    /// Heuristic inputs and scores for `varied_rows` under the default and
+    /// the fixture's parameters, in every focus mode.
+    fn golden_heuristic_scores() -> String {
+        let params = [
+            ("default", HeuristicParams::default()),
+            (
+                "fixture",
+                HeuristicParams::load(&heuristic_fixture_dir().join("params.json")).unwrap(),
+            ),
+        ];
+        let rules = vec![crate::types::AppRuleRecord {
+            id: 1,
+            pattern: "notion".to_string(),
+            rule_type: crate::types::AppRuleKind::Block,
+            note: None,
+            created_at: String::new(),
+            updated_at: String::new(),
+        }];
+        let mut golden = format!(
+            "params,focus_mode,{},focus_score,distraction_risk,thrash_score,drift_score,focus_state\n",
+            HEURISTIC_INPUT_NAMES.join(",")
+        );
+        for (name, params) in params {
+            for mode in [FocusMode::Deep, FocusMode::Normal, FocusMode::Recovery] {
+                let mut classifier = Classifier::new(mode);
+                classifier.set_heuristic_params(params);
+                for (i, row) in varied_rows().iter().enumerate() {
+                    let goal = (i % 2 == 0).then_some("implement the rust classifier feature");
+                    golden.push_str(&format!("{name},{}", mode.as_str()));
+                    for value in classifier.heuristic_inputs(row, goal, &rules) {
+                        golden.push_str(&format!(",{value}"));
+                    }
+                    let scores = classifier.predict(row, goal, &rules);
+                    golden.push_str(&format!(
+                        ",{},{},{},{},{}\n",
+                        scores.focus_score,
+                        scores.distraction_risk,
+                        scores.thrash_score,
+                        scores.drift_score,
+                        scores.focus_state
+                    ));
+                }
+            }
+        }
+        golden
+    }
+
+    /// Shared with ml/heuristics.py, which must score the same inputs the
+    /// same way. Set `SNAPBACK_UPDATE_HEURISTICS=1` to regenerate after an
+    /// intended change to the mix.
+    #[test]
+    fn heuristic_matches_golden_scores() {
+        let path = heuristic_fixture_dir().join("golden_scores.csv");
+        let golden = golden_heuristic_scores();
+        if std::env::var_os("SNAPBACK_UPDATE_HEURISTICS").is_some() {
+            std::fs::write(&path, &golden).unwrap();
+        }
+        assert_eq!(std::fs::read_to_string(path).unwrap(), golden);
+    }
 }
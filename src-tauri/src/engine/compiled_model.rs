@@ -0,0 +1,80 @@
+//! Tree ensemble compiled into the binary (`compiled-model` feature).
+//!
+//! `build.rs` turns the XGBoost JSON model at `$SNAPBACK_COMPILED_MODEL` into
+//! one function per tree with the thresholds as constants; this wraps the
+//! generated margins in the same softmax `TreeEnsemble` uses, so both score a
+//! given model identically. The app enables it via
+//! `Classifier::set_compiled_model`; a model loaded by the `ModelRegistry`
+//! still takes precedence.
+
+use crate::engine::tensor::{FeatureTensor, FEATURE_COUNT};
+use crate::engine::tree_model::softmax_probas;
+
+include!(concat!(env!("OUT_DIR"), "/compiled_model.rs"));
+
+/// Class probabilities in `STATE_LABELS` order.
+pub fn predict_probas(features: &FeatureTensor) -> [f64; 4] {
+    softmax_probas(&margins(&features.0), &LABEL_INDEX)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::engine::tree_model::TreeEnsemble;
+    use std::path::Path;
+
+    /// Rows and probabilities from the Python reference; CI builds the
+    /// feature against `model.json` here.
+    fn fixture_dir() -> std::path::PathBuf {
+        Path::new(env!("CARGO_MANIFEST_DIR")).join("../ml/tests/fixtures/tree_model")
+    }
+
+    fn golden_rows() -> Vec<(FeatureTensor, Vec<f64>)> {
+        let golden = std::fs::read_to_string(fixture_dir().join("golden_probas.csv")).unwrap();
+        golden
+            .lines()
+            .skip(1)
+            .map(|line| {
+                let cells: Vec<f64> = line.split(',').map(|c| c.parse().unwrap()).collect();
+                let mut tensor = FeatureTensor::zeroed();
+                for (slot, value) in tensor.0.iter_mut().zip(&cells) {
+                    *slot = *value as f32;
+                }
+                (tensor, cells[FEATURE_COUNT..].to_vec())
+            })
+            .collect()
+    }
+
+    #[test]
+    fn matches_interpreted_evaluator() {
+        let model = TreeEnsemble::load(Path::new(SOURCE_PATH)).unwrap();
+        assert_eq!(model.tree_count(), TREE_COUNT);
+        assert_eq!(model.fingerprint(), FINGERPRINT);
+        for (tensor, _) in golden_rows() {
+            assert_eq!(
+                margins(&tensor.0)[..],
+                model.margins(&tensor)[..CLASS_COUNT]
+            );
+            assert_eq!(predict_probas(&tensor), model.predict_probas(&tensor));
+        }
+    }
+
+    #[test]
+    fn matches_reference_probabilities() {
+        let fixture = fixture_dir().join("model.json");
+        let source = std::fs::read(SOURCE_PATH).unwrap();
+        if source != std::fs::read(&fixture).unwrap() {
+            eprintln!("compiled model is not {}; skipping", fixture.display());
+            return;
+        }
+        for (row, (tensor, expected)) in golden_rows().iter().enumerate() {
+            let probas = predict_probas(tensor);
+            for (got, want) in probas.iter().zip(expected) {
+                assert!(
+                    (got - want).abs() <= 1e-6,
+                    "row {row}: {probas:?} vs {expected:?}"
+                );
+            }
+        }
+    }
+}
@@ -1,15 +1,42 @@
-use std::collections::VecDeque;
+use std::collections::HashMap;
+use std::sync::Arc;
 
 use chrono::{Datelike, Timelike, Utc};
 
+use crate::clock::us_to_secs;
 use crate::engine::app_context::classify;
-use crate::types::{
-    AppRuleRecord, CaptureEvent, EventType,
+use crate::engine::horizons::{
+    BucketRing, HorizonFeatures, DEFAULT_HORIZONS_SECS, HORIZON_15MIN, HORIZON_2MIN, HORIZON_COUNT,
 };
+use crate::engine::sketch::WindowedSketch;
+use crate::engine::stats::{linear_slope, mean, std_dev};
+use crate::engine::tensor::{FeatureIndex, FeatureTensor};
+use crate::engine::window::{EventWindow, Horizon, WindowView};
+use crate::types::{AppRuleRecord, CaptureEvent, EventType};
+
+/// Where the user is, kept apart from the numeric features. The strings are
+/// shared with the extractor, so cloning a snapshot copies no text.
+#[derive(Debug, Clone)]
+pub struct FeatureContext {
+    pub app_name: Arc<str>,
+    pub window_title: Arc<str>,
+    pub productivity_category: &'static str,
+}
+
+impl FeatureContext {
+    pub fn new(app_name: &str, window_title: &str) -> Self {
+        Self {
+            app_name: Arc::from(app_name),
+            window_title: Arc::from(window_title),
+            productivity_category: "Unknown",
+        }
+    }
+}
 
 #[derive(Debug, Clone)]
 pub struct FeatureVector {
-    pub timestamp: f64,
+    /// Microseconds since the Unix epoch (event time, not wall time).
+    pub timestamp_us: i64,
     pub seconds_since_session_start: i64,
     pub hour_of_day: u32,
     pub day_of_week: u32,
@@ -19,6 +46,15 @@ pub struct FeatureVector {
     pub keystroke_interval_mean: f64,
     pub keystroke_interval_std: f64,
     pub keystroke_interval_trend: f64,
+    /// Approximate (±2%) keystroke-interval quantiles over ~30 s, in seconds.
+    pub keystroke_interval_p10: f64,
+    pub keystroke_interval_p50: f64,
+    pub keystroke_interval_p90: f64,
+    /// Keystrokes per typing burst (runs without a pause over 1 s) that
+    /// ended in the last ~30 s.
+    pub burst_length_p10: f64,
+    pub burst_length_p50: f64,
+    pub burst_length_p90: f64,
     pub mouse_move_count: usize,
     pub mouse_distance_pixels: f64,
     pub mouse_speed_mean: f64,
@@ -34,23 +70,26 @@ pub struct FeatureVector {
     pub longest_active_stretch_5min: i64,
     pub window_title_length: usize,
     pub window_title_changed_30s: bool,
-    pub app_name: String,
-    pub window_title: String,
+    /// Raw title rewrites per minute over the short window, including ones the
+    /// capture debouncer collapsed.
+    pub title_churn_rate_30s: f64,
+    pub context: FeatureContext,
     pub is_browser: bool,
     pub is_ide: bool,
     pub is_communication: bool,
     pub is_entertainment: bool,
     pub is_productivity: bool,
     pub focus_momentum: f64,
-    pub productivity_category: String,
     pub is_pseudo_productive: bool,
+    /// Activity over each of `DEFAULT_HORIZONS_SECS`, shortest first.
+    pub horizons: [HorizonFeatures; HORIZON_COUNT],
 }
 
 impl FeatureVector {
-    pub fn empty(timestamp: f64) -> Self {
-        let dt = Utc::now();
+    pub fn empty(timestamp_us: i64) -> Self {
+        let dt = datetime_at(timestamp_us);
         Self {
-            timestamp,
+            timestamp_us,
             seconds_since_session_start: 0,
             hour_of_day: dt.hour(),
             day_of_week: dt.weekday().num_days_from_monday(),
@@ -60,6 +99,12 @@ impl FeatureVector {
             keystroke_interval_mean: 0.0,
             keystroke_interval_std: 0.0,
             keystroke_interval_trend: 0.0,
+            keystroke_interval_p10: 0.0,
+            keystroke_interval_p50: 0.0,
+            keystroke_interval_p90: 0.0,
+            burst_length_p10: 0.0,
+            burst_length_p50: 0.0,
+            burst_length_p90: 0.0,
             mouse_move_count: 0,
             mouse_distance_pixels: 0.0,
             mouse_speed_mean: 0.0,
@@ -75,83 +120,150 @@ impl FeatureVector {
             longest_active_stretch_5min: 0,
             window_title_length: 0,
             window_title_changed_30s: false,
-            app_name: String::new(),
-            window_title: String::new(),
+            title_churn_rate_30s: 0.0,
+            context: FeatureContext::new("", ""),
             is_browser: false,
             is_ide: false,
             is_communication: false,
             is_entertainment: false,
             is_productivity: false,
             focus_momentum: 0.0,
-            productivity_category: "Unknown".to_string(),
             is_pseudo_productive: false,
+            horizons: DEFAULT_HORIZONS_SECS.map(|span_secs| HorizonFeatures {
+                span_secs,
+                ..HorizonFeatures::default()
+            }),
         }
     }
-}
 
-fn mean(values: &[f64]) -> f64 {
-    if values.is_empty() {
-        return 0.0;
+    /// The numeric features in model column order.
+    pub fn tensor(&self) -> FeatureTensor {
+        use FeatureIndex as F;
+        let flag = |b: bool| if b { 1.0 } else { 0.0 };
+        let mut t = FeatureTensor::zeroed();
+        t[F::SecondsSinceSessionStart] = self.seconds_since_session_start as f32;
+        t[F::HourOfDay] = self.hour_of_day as f32;
+        t[F::DayOfWeek] = self.day_of_week as f32;
+        t[F::MinutesSinceLastBreak] = self.minutes_since_last_break as f32;
+        t[F::KeystrokeCount] = self.keystroke_count as f32;
+        t[F::KeystrokeRate] = self.keystroke_rate as f32;
+        t[F::KeystrokeIntervalMean] = self.keystroke_interval_mean as f32;
+        t[F::KeystrokeIntervalStd] = self.keystroke_interval_std as f32;
+        t[F::KeystrokeIntervalTrend] = self.keystroke_interval_trend as f32;
+        t[F::KeystrokeIntervalP10] = self.keystroke_interval_p10 as f32;
+        t[F::KeystrokeIntervalP50] = self.keystroke_interval_p50 as f32;
+        t[F::KeystrokeIntervalP90] = self.keystroke_interval_p90 as f32;
+        t[F::BurstLengthP10] = self.burst_length_p10 as f32;
+        t[F::BurstLengthP50] = self.burst_length_p50 as f32;
+        t[F::BurstLengthP90] = self.burst_length_p90 as f32;
+        t[F::MouseMoveCount] = self.mouse_move_count as f32;
+        t[F::MouseDistancePixels] = self.mouse_distance_pixels as f32;
+        t[F::MouseSpeedMean] = self.mouse_speed_mean as f32;
+        t[F::MouseSpeedStd] = self.mouse_speed_std as f32;
+        t[F::MouseAccelerationMean] = self.mouse_acceleration_mean as f32;
+        t[F::MouseClickCount] = self.mouse_click_count as f32;
+        t[F::ContextSwitches30s] = self.context_switches_30s as f32;
+        t[F::ContextSwitches5min] = self.context_switches_5min as f32;
+        t[F::TimeInCurrentApp] = self.time_in_current_app as f32;
+        t[F::UniqueApps5min] = self.unique_apps_5min as f32;
+        t[F::IdleTime30s] = self.idle_time_30s as f32;
+        t[F::IdleEventCount5min] = self.idle_event_count_5min as f32;
+        t[F::LongestActiveStretch5min] = self.longest_active_stretch_5min as f32;
+        t[F::WindowTitleLength] = self.window_title_length as f32;
+        t[F::WindowTitleChanged30s] = flag(self.window_title_changed_30s);
+        t[F::IsBrowser] = flag(self.is_browser);
+        t[F::IsIde] = flag(self.is_ide);
+        t[F::IsCommunication] = flag(self.is_communication);
+        t[F::IsEntertainment] = flag(self.is_entertainment);
+        t[F::IsProductivity] = flag(self.is_productivity);
+        t[F::FocusMomentum] = self.focus_momentum as f32;
+        t[F::IsPseudoProductive] = flag(self.is_pseudo_productive);
+        let (short, long) = (&self.horizons[HORIZON_2MIN], &self.horizons[HORIZON_15MIN]);
+        t[F::SwitchesPerMin2min] = short.switches_per_min as f32;
+        t[F::KeystrokeRate2min] = short.keystroke_rate as f32;
+        t[F::IdleTime2min] = short.idle_secs as f32;
+        t[F::SwitchesPerMin15min] = long.switches_per_min as f32;
+        t[F::KeystrokeRate15min] = long.keystroke_rate as f32;
+        t[F::IdleTime15min] = long.idle_secs as f32;
+        t
     }
-    values.iter().sum::<f64>() / values.len() as f64
 }
 
-fn std_dev(values: &[f64]) -> f64 {
-    if values.len() < 2 {
-        return 0.0;
-    }
-    let avg = mean(values);
-    let variance = values.iter().map(|v| (v - avg).powi(2)).sum::<f64>() / (values.len() - 1) as f64;
-    variance.sqrt()
+fn datetime_at(timestamp_us: i64) -> chrono::DateTime<Utc> {
+    chrono::DateTime::<Utc>::from_timestamp_micros(timestamp_us).unwrap_or_default()
 }
 
-fn linear_slope(values: &[f64]) -> f64 {
-    if values.len() < 2 {
-        return 0.0;
-    }
-    let xs: Vec<f64> = (0..values.len()).map(|i| i as f64).collect();
-    let mean_x = mean(&xs);
-    let mean_y = mean(values);
-    let num: f64 = xs
-        .iter()
-        .zip(values.iter())
-        .map(|(x, y)| (x - mean_x) * (y - mean_y))
-        .sum();
-    let den: f64 = xs.iter().map(|x| (x - mean_x).powi(2)).sum();
-    if den == 0.0 {
-        0.0
-    } else {
-        num / den
-    }
+/// Keystrokes further apart than this split typing bursts.
+const BURST_GAP_US: i64 = 1_000_000;
+/// Sub-sketches per timing window; eviction granularity is span / slots.
+const SKETCH_SLOTS: usize = 6;
+const TIMING_QUANTILES: [f64; 3] = [0.1, 0.5, 0.9];
+
+/// Idle start/end positions in time order. Idle events are rare, so merging
+/// the two index lists by sorting is cheap.
+fn idle_positions(window: WindowView) -> Vec<usize> {
+    let mut positions: Vec<usize> = window
+        .positions(EventType::IdleStart)
+        .chain(window.positions(EventType::IdleEnd))
+        .collect();
+    positions.sort_unstable();
+    positions
 }
 
 pub struct FeatureExtractor {
-    window_seconds: f64,
-    long_window_seconds: f64,
-    break_threshold_seconds: f64,
-    events_30s: VecDeque<CaptureEvent>,
-    events_5min: VecDeque<CaptureEvent>,
-    session_start_ts: Option<f64>,
-    last_break_ts: Option<f64>,
-    current_app_name: String,
-    current_window_title: String,
-    current_app_start_ts: Option<f64>,
+    window_us: i64,
+    long_window_us: i64,
+    break_threshold_us: i64,
+    /// The 5-minute window; the 30 s window is a horizon inside it.
+    events: EventWindow,
+    short_window: Horizon,
+    activity: BucketRing,
+    interval_sketch: WindowedSketch,
+    burst_sketch: WindowedSketch,
+    last_key_us: Option<i64>,
+    burst_len: u32,
+    app_ids: HashMap<String, u32>,
+    app_names: Vec<Arc<str>>,
+    session_start_us: Option<i64>,
+    last_break_us: Option<i64>,
+    current_app_name: Arc<str>,
+    current_window_title: Arc<str>,
+    current_app_start_us: Option<i64>,
     focus_momentum: f64,
 }
 
 impl FeatureExtractor {
     pub fn new() -> Self {
+        Self::with_horizons(DEFAULT_HORIZONS_SECS)
+    }
+
+    /// `horizons_secs` sets the spans behind `FeatureVector::horizons`, and
+    /// so behind the `*_2min` and `*_15min` columns, in that order. Models
+    /// are trained on `DEFAULT_HORIZONS_SECS`; other spans are for
+    /// experiments. The fixed 30 s / 5 min fields are unaffected.
+    pub fn with_horizons(horizons_secs: [u32; HORIZON_COUNT]) -> Self {
+        let window_us = 30_000_000;
+        let long_window_us = 300_000_000;
+        let mut events = EventWindow::new(long_window_us);
+        let short_window = events.add_horizon(window_us);
         Self {
-            window_seconds: 30.0,
-            long_window_seconds: 300.0,
-            break_threshold_seconds: 300.0,
-            events_30s: VecDeque::new(),
-            events_5min: VecDeque::new(),
-            session_start_ts: None,
-            last_break_ts: None,
-            current_app_name: String::new(),
-            current_window_title: String::new(),
-            current_app_start_ts: None,
+            window_us,
+            long_window_us,
+            break_threshold_us: 300_000_000,
+            events,
+            short_window,
+            activity: BucketRing::new(horizons_secs),
+            interval_sketch: WindowedSketch::new(window_us, SKETCH_SLOTS),
+            burst_sketch: WindowedSketch::new(window_us, SKETCH_SLOTS),
+            last_key_us: None,
+            burst_len: 0,
+            app_ids: HashMap::new(),
+            app_names: Vec::new(),
+            session_start_us: None,
+            last_break_us: None,
+            current_app_name: Arc::from(""),
+            current_window_title: Arc::from(""),
+            current_app_start_us: None,
             focus_momentum: 0.0,
         }
     }
@@ -161,208 +273,206 @@ impl FeatureExtractor {
     }
 
     pub fn update(&mut self, event: &CaptureEvent, rules: &[AppRuleRecord]) -> FeatureVector {
-        let now = event.timestamp_secs;
-        if self.session_start_ts.is_none() {
-            self.session_start_ts = Some(now);
-            self.last_break_ts = Some(now);
-            self.current_app_name = event.app_name.clone();
-            self.current_window_title = event.window_title.clone();
-            self.current_app_start_ts = Some(now);
+        let now = event.timestamp_us;
+        let app_id = self.intern_app(&event.app_name);
+        if self.session_start_us.is_none() {
+            self.session_start_us = Some(now);
+            self.last_break_us = Some(now);
+            self.current_app_name = self.app_names[app_id as usize].clone();
+            self.current_window_title = Arc::from(event.window_title.as_str());
+            self.current_app_start_us = Some(now);
         }
 
-        self.events_30s.push_back(event.clone());
-        self.events_5min.push_back(event.clone());
-        self.trim(now);
+        self.events.push(event, app_id);
+        self.events.trim(now);
+        self.activity.record(event);
+        self.update_typing_sketches(event, now);
         self.update_break_state(event, now);
-        self.update_current_app(event, now);
+        self.update_current_app(event, app_id, now);
         self.extract_features(now, rules)
     }
 
-    pub fn extract_features(&self, now: f64, rules: &[AppRuleRecord]) -> FeatureVector {
-        if self.events_5min.is_empty() {
+    fn intern_app(&mut self, app_name: &str) -> u32 {
+        if let Some(&id) = self.app_ids.get(app_name) {
+            return id;
+        }
+        let id = self.app_ids.len() as u32;
+        self.app_ids.insert(app_name.to_string(), id);
+        self.app_names.push(Arc::from(app_name));
+        id
+    }
+
+    pub fn extract_features(&self, now: i64, rules: &[AppRuleRecord]) -> FeatureVector {
+        let events = &self.events;
+        let short = events.view(self.short_window);
+        let long = events.full();
+        if long.is_empty() {
             return FeatureVector::empty(now);
         }
 
-        let oldest_30s = self.events_30s.front().map(|e| e.timestamp_secs).unwrap_or(now);
-        let span_30s = (self.window_seconds.min(now - oldest_30s)).max(1e-6);
+        let oldest_30s = short.oldest_us().unwrap_or(now);
+        let span_30s = us_to_secs(self.window_us.min(now - oldest_30s)).max(1e-6);
 
-        let keystrokes: Vec<&CaptureEvent> = self
-            .events_30s
-            .iter()
-            .filter(|e| e.event_type == EventType::KeyPress)
-            .collect();
-        let key_times: Vec<f64> = keystrokes.iter().map(|e| e.timestamp_secs).collect();
-        let intervals: Vec<f64> = key_times
-            .windows(2)
-            .map(|w| w[1] - w[0])
-            .collect();
-
-        let mouse_moves: Vec<&CaptureEvent> = self
-            .events_30s
-            .iter()
-            .filter(|e| e.event_type == EventType::MouseMove)
-            .collect();
-        let mouse_clicks: Vec<&CaptureEvent> = self
-            .events_30s
-            .iter()
-            .filter(|e| e.event_type == EventType::MouseClick)
-            .collect();
+        let keystroke_count = short.count(EventType::KeyPress);
+        let mut intervals = Vec::with_capacity(keystroke_count.saturating_sub(1));
+        let mut prev_key: Option<i64> = None;
+        for pos in short.positions(EventType::KeyPress) {
+            let ts = events.timestamp(pos);
+            if let Some(prev) = prev_key {
+                intervals.push(us_to_secs(ts - prev));
+            }
+            prev_key = Some(ts);
+        }
 
-        let mut speeds = Vec::new();
-        let mut distances = Vec::new();
-        let mut accelerations = Vec::new();
-        for (i, event) in mouse_moves.iter().enumerate() {
-            let speed = event.mouse_speed as f64;
+        let mouse_move_count = short.count(EventType::MouseMove);
+        let mut speeds = Vec::with_capacity(mouse_move_count);
+        let mut distances = Vec::with_capacity(mouse_move_count.saturating_sub(1));
+        let mut accelerations = Vec::with_capacity(mouse_move_count.saturating_sub(1));
+        let mut prev_move: Option<(i64, f64)> = None;
+        for pos in short.positions(EventType::MouseMove) {
+            let ts = events.timestamp(pos);
+            let speed = events.mouse_speed(pos) as f64;
             speeds.push(speed);
-            if i > 0 {
-                let prev = mouse_moves[i - 1];
-                let dt = (event.timestamp_secs - prev.timestamp_secs).max(1e-6);
+            if let Some((prev_ts, prev_speed)) = prev_move {
+                let dt = us_to_secs(ts - prev_ts).max(1e-6);
                 distances.push(speed * dt);
-                let prev_speed = speeds[i - 1];
                 accelerations.push((speed - prev_speed).abs() / dt);
             }
+            prev_move = Some((ts, speed));
         }
 
-        let context_switches_30s = self
-            .events_30s
-            .iter()
-            .filter(|e| e.event_type == EventType::WindowFocusChange)
-            .count();
-        let context_switches_5min = self
-            .events_5min
-            .iter()
-            .filter(|e| e.event_type == EventType::WindowFocusChange)
-            .count();
-        let unique_apps_5min = self
-            .events_5min
-            .iter()
-            .map(|e| e.app_name.as_str())
-            .collect::<std::collections::HashSet<_>>()
-            .len();
-
         let time_in_current_app = self
-            .current_app_start_ts
-            .map(|start| (now - start) as i64)
+            .current_app_start_us
+            .map(|start| (now - start) / 1_000_000)
             .unwrap_or(0);
 
-        let idle_events_30s: Vec<&CaptureEvent> = self
-            .events_30s
-            .iter()
-            .filter(|e| matches!(e.event_type, EventType::IdleStart | EventType::IdleEnd))
-            .collect();
-        let idle_time_30s: f64 = idle_events_30s
-            .iter()
-            .map(|e| e.idle_duration_ms as f64 / 1000.0)
-            .sum();
-
-        let idle_events_5min: Vec<&CaptureEvent> = self
-            .events_5min
-            .iter()
-            .filter(|e| matches!(e.event_type, EventType::IdleStart | EventType::IdleEnd))
+        let idle_time_30s = short.idle_ms_total() as f64 / 1000.0;
+
+        let idle_timestamps: Vec<i64> = idle_positions(long)
+            .into_iter()
+            .map(|pos| events.timestamp(pos))
             .collect();
-        let idle_timestamps: Vec<f64> = idle_events_5min.iter().map(|e| e.timestamp_secs).collect();
+        let idle_event_count_5min = idle_timestamps.len();
         let longest_active_stretch_5min = if idle_timestamps.is_empty() {
-            self.long_window_seconds as i64
+            self.long_window_us / 1_000_000
         } else {
-            let window_start = now - self.long_window_seconds;
+            let window_start = now - self.long_window_us;
             let mut boundaries = vec![window_start];
             boundaries.extend(idle_timestamps);
             boundaries.push(now);
             boundaries
                 .windows(2)
-                .map(|w| (w[1] - w[0]) as i64)
+                .map(|w| (w[1] - w[0]) / 1_000_000)
                 .max()
                 .unwrap_or(0)
         };
 
-        let window_title_changed_30s = self
-            .events_30s
-            .iter()
-            .any(|e| e.event_type == EventType::WindowTitleChange);
-
         let ctx = classify(&self.current_app_name, &self.current_window_title, rules);
-        let productivity_category = ctx.productivity_category().to_string();
         let is_ent = ctx.is_entertainment || ctx.title_is_distracting;
 
         let minutes_since_last_break = self
-            .last_break_ts
-            .map(|ts| ((now - ts) / 60.0).max(0.0) as i64)
+            .last_break_us
+            .map(|ts| ((now - ts) / 60_000_000).max(0))
             .unwrap_or(0);
 
-        let dt = chrono::DateTime::<Utc>::from_timestamp(now as i64, 0).unwrap_or_else(Utc::now);
+        let interval_q = self.interval_sketch.quantiles(TIMING_QUANTILES);
+        let burst_q = self.burst_sketch.quantiles(TIMING_QUANTILES);
+        let dt = datetime_at(now);
 
         FeatureVector {
-            timestamp: now,
-            seconds_since_session_start: (now - self.session_start_ts.unwrap_or(now)) as i64,
+            timestamp_us: now,
+            seconds_since_session_start: (now - self.session_start_us.unwrap_or(now)) / 1_000_000,
             hour_of_day: dt.hour(),
             day_of_week: dt.weekday().num_days_from_monday(),
             minutes_since_last_break,
-            keystroke_count: keystrokes.len(),
-            keystroke_rate: keystrokes.len() as f64 / span_30s,
+            keystroke_count,
+            keystroke_rate: keystroke_count as f64 / span_30s,
             keystroke_interval_mean: mean(&intervals),
             keystroke_interval_std: std_dev(&intervals),
             keystroke_interval_trend: linear_slope(&intervals),
-            mouse_move_count: mouse_moves.len(),
+            keystroke_interval_p10: interval_q[0],
+            keystroke_interval_p50: interval_q[1],
+            keystroke_interval_p90: interval_q[2],
+            burst_length_p10: burst_q[0],
+            burst_length_p50: burst_q[1],
+            burst_length_p90: burst_q[2],
+            mouse_move_count,
             mouse_distance_pixels: distances.iter().sum(),
             mouse_speed_mean: mean(&speeds),
             mouse_speed_std: std_dev(&speeds),
             mouse_acceleration_mean: mean(&accelerations),
-            mouse_click_count: mouse_clicks.len(),
-            context_switches_30s,
-            context_switches_5min,
+            mouse_click_count: short.count(EventType::MouseClick),
+            context_switches_30s: short.count(EventType::WindowFocusChange),
+            context_switches_5min: long.count(EventType::WindowFocusChange),
             time_in_current_app,
-            unique_apps_5min,
+            unique_apps_5min: events.unique_apps(),
             idle_time_30s,
-            idle_event_count_5min: idle_events_5min.len(),
+            idle_event_count_5min,
             longest_active_stretch_5min,
             window_title_length: self.current_window_title.len(),
-            window_title_changed_30s,
-            app_name: self.current_app_name.clone(),
-            window_title: self.current_window_title.clone(),
+            window_title_changed_30s: short.count(EventType::WindowTitleChange) > 0,
+            title_churn_rate_30s: short.title_churn_total() as f64 * 60.0
+                / us_to_secs(self.window_us),
+            context: FeatureContext {
+                app_name: self.current_app_name.clone(),
+                window_title: self.current_window_title.clone(),
+                productivity_category: ctx.productivity_category(),
+            },
             is_browser: ctx.is_browser,
             is_ide: ctx.is_ide,
             is_communication: ctx.is_communication,
             is_entertainment: is_ent,
             is_productivity: ctx.is_productivity,
             focus_momentum: self.focus_momentum,
-            productivity_category,
             is_pseudo_productive: false,
+            horizons: self.activity.features(),
         }
     }
 
-    fn trim(&mut self, now: f64) {
-        while self
-            .events_30s
-            .front()
-            .is_some_and(|e| now - e.timestamp_secs > self.window_seconds)
-        {
-            self.events_30s.pop_front();
+    /// A burst ends at the first keystroke after a long pause, or at any
+    /// event once the pause has lasted that long, whichever comes first.
+    fn update_typing_sketches(&mut self, event: &CaptureEvent, now: i64) {
+        self.interval_sketch.advance(now);
+        self.burst_sketch.advance(now);
+        let paused = self
+            .last_key_us
+            .is_some_and(|last| now - last > BURST_GAP_US);
+        if paused && self.burst_len > 0 {
+            self.burst_sketch.record(now, self.burst_len as f64);
+            self.burst_len = 0;
         }
-        while self
-            .events_5min
-            .front()
-            .is_some_and(|e| now - e.timestamp_secs > self.long_window_seconds)
-        {
-            self.events_5min.pop_front();
+        if event.event_type != EventType::KeyPress {
+            return;
         }
+        if let Some(last) = self.last_key_us {
+            self.interval_sketch.record(now, us_to_secs(now - last));
+        }
+        self.burst_len += 1;
+        self.last_key_us = Some(now);
     }
 
-    fn update_break_state(&mut self, event: &CaptureEvent, now: f64) {
+    fn update_break_state(&mut self, event: &CaptureEvent, now: i64) {
         if matches!(event.event_type, EventType::IdleStart | EventType::IdleEnd) {
-            let duration = event.idle_duration_ms as f64 / 1000.0;
-            if duration >= self.break_threshold_seconds {
-                self.last_break_ts = Some(now);
+            let duration_us = event.idle_duration_ms as i64 * 1_000;
+            if duration_us >= self.break_threshold_us {
+                self.last_break_us = Some(now);
             }
         }
     }
 
-    fn update_current_app(&mut self, event: &CaptureEvent, now: f64) {
+    fn update_current_app(&mut self, event: &CaptureEvent, app_id: u32, now: i64) {
         if event.event_type == EventType::WindowFocusChange {
-            self.current_app_name = event.app_name.clone();
-            self.current_window_title = event.window_title.clone();
-            self.current_app_start_ts = Some(now);
+            self.current_app_name = self.app_names[app_id as usize].clone();
+            self.set_window_title(&event.window_title);
+            self.current_app_start_us = Some(now);
         } else if event.event_type == EventType::WindowTitleChange {
-            self.current_window_title = event.window_title.clone();
+            self.set_window_title(&event.window_title);
+        }
+    }
+
+    fn set_window_title(&mut self, title: &str) {
+        if *self.current_window_title != *title {
+            self.current_window_title = Arc::from(title);
         }
     }
 }
@@ -372,3 +482,222 @@ impl Default for FeatureExtractor {
         Self::new()
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use std::path::{Path, PathBuf};
+
+    use super::*;
+    use crate::engine::tensor::{FEATURE_COUNT, FEATURE_NAMES};
+    use crate::journal::{segment_paths, JournalConfig, JournalSegment, JournalWriter};
+
+    /// Same tolerances as `ml/tests/test_feature_parity.py`.
+    const ABS_TOL: f64 = 1e-6;
+    const REL_TOL: f64 = 1e-5;
+    /// Golden rows are kept for every Nth event, plus the last.
+    const GOLDEN_STRIDE: usize = 3;
+
+    fn parity_dir() -> PathBuf {
+        Path::new(env!("CARGO_MANIFEST_DIR")).join("../ml/tests/fixtures/parity")
+    }
+
+    fn golden_header() -> String {
+        format!("event,productivity_category,{}", FEATURE_NAMES.join(","))
+    }
+
+    /// About twenty minutes of mixed activity: typing bursts, mouse work,
+    /// switches across every app category, idle gaps and one long break.
+    fn fixture_events() -> Vec<CaptureEvent> {
+        const APPS: [(&str, &[&str]); 8] = [
+            ("Cursor", &["main.rs — snapback", "features.rs — snapback"]),
+            (
+                "Google Chrome",
+                &["Rust std docs", "Cats - YouTube", "r/rust - Reddit"],
+            ),
+            ("Slack", &["#engineering"]),
+            ("Spotify", &["Spotify Premium"]),
+            ("Notion", &["Sprint notes", "Ретроспектива"]),
+            ("Terminal", &["cargo test — zsh"]),
+            ("Finder", &["Downloads"]),
+            ("", &[""]),
+        ];
+        const BREAK_AT: usize = 700;
+        let mut state: u64 = 0x9E37_79B9_7F4A_7C15;
+        let mut next = |n: u64| {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            state % n
+        };
+
+        let mut ts = 1_700_000_123_456_789_i64;
+        let (mut app, mut title) = (0, 0);
+        let mut events = Vec::new();
+        for i in 0..1_200 {
+            ts += match next(100) {
+                0..=4 => 1_500_000 + next(4_500_000) as i64,
+                _ => 10_000 + next(400_000) as i64,
+            };
+            let event_type = if i == BREAK_AT {
+                ts += 320_000_000;
+                EventType::IdleEnd
+            } else {
+                match next(100) {
+                    0..=2 => EventType::WindowFocusChange,
+                    3..=5 => EventType::WindowTitleChange,
+                    6 => EventType::IdleStart,
+                    7 => EventType::IdleEnd,
+                    8..=49 => EventType::KeyPress,
+                    50 | 51 => EventType::KeyRelease,
+                    52..=79 => EventType::MouseMove,
+                    _ => EventType::MouseClick,
+                }
+            };
+            match event_type {
+                EventType::WindowFocusChange => {
+                    app = next(APPS.len() as u64) as usize;
+                    title = 0;
+                }
+                EventType::WindowTitleChange => title = next(APPS[app].1.len() as u64) as usize,
+                _ => {}
+            }
+            let idle_duration_ms = match event_type {
+                EventType::IdleEnd if i == BREAK_AT => 320_000,
+                EventType::IdleStart | EventType::IdleEnd => 2_000 + next(60_000) as u32,
+                _ => 0,
+            };
+            events.push(CaptureEvent {
+                event_type,
+                timestamp_us: ts,
+                app_name: APPS[app].0.to_string(),
+                window_title: APPS[app].1[title].to_string(),
+                mouse_x: next(1_920) as i32,
+                mouse_y: next(1_080) as i32,
+                mouse_speed: match event_type {
+                    EventType::MouseMove => next(2_000) as u32,
+                    _ => 0,
+                },
+                idle_duration_ms,
+                title_churn: match event_type {
+                    EventType::WindowTitleChange => next(4) as u32,
+                    _ => 0,
+                },
+            });
+        }
+        events
+    }
+
+    #[test]
+    fn custom_horizons_replace_the_defaults() {
+        let mut custom = FeatureExtractor::with_horizons([60, 120]);
+        let mut default = FeatureExtractor::new();
+        let (mut a, mut b) = (None, None);
+        for event in &fixture_events()[..400] {
+            a = Some(custom.update(event, &[]));
+            b = Some(default.update(event, &[]));
+        }
+        let (a, b) = (a.unwrap(), b.unwrap());
+        assert_eq!(a.horizons.map(|h| h.span_secs), [60, 120]);
+        assert_eq!(a.horizons[1], b.horizons[HORIZON_2MIN]);
+        assert!(a.horizons[0].event_count <= a.horizons[1].event_count);
+    }
+
+    fn replay_fixture(dir: &Path) -> Vec<FeatureVector> {
+        let mut extractor = FeatureExtractor::new();
+        let mut features = Vec::new();
+        for path in segment_paths(dir).unwrap() {
+            let segment = JournalSegment::open(&path).unwrap();
+            for event in segment.events() {
+                features.push(extractor.update(&event.unwrap().to_capture_event(), &[]));
+            }
+        }
+        features
+    }
+
+    /// Rewrites the journal and golden vectors. Only run on purpose, when a
+    /// feature's definition changes.
+    fn write_fixture(dir: &Path) {
+        std::fs::create_dir_all(dir).unwrap();
+        for entry in std::fs::read_dir(dir).unwrap() {
+            std::fs::remove_file(entry.unwrap().path()).unwrap();
+        }
+        {
+            let journal =
+                JournalWriter::spawn(dir.to_path_buf(), JournalConfig::default()).unwrap();
+            for event in fixture_events() {
+                journal.append(event);
+            }
+        }
+
+        let features = replay_fixture(dir);
+        let mut golden = golden_header();
+        golden.push('\n');
+        for (i, f) in features.iter().enumerate() {
+            if i % GOLDEN_STRIDE != 0 && i + 1 != features.len() {
+                continue;
+            }
+            golden.push_str(&format!("{i},{}", f.context.productivity_category));
+            for value in f.tensor().as_slice() {
+                golden.push_str(&format!(",{value}"));
+            }
+            golden.push('\n');
+        }
+        std::fs::write(dir.join("golden_features.csv"), golden).unwrap();
+    }
+
+    /// Golden vectors shared with the Python extractor. Set
+    /// `SNAPBACK_UPDATE_PARITY=1` to regenerate after an intended change.
+    #[test]
+    fn features_match_golden_vectors() {
+        let dir = parity_dir();
+        if std::env::var_os("SNAPBACK_UPDATE_PARITY").is_some() {
+            write_fixture(&dir);
+        }
+        let features = replay_fixture(&dir);
+        let golden = std::fs::read_to_string(dir.join("golden_features.csv")).unwrap();
+        let mut lines = golden.lines();
+        assert_eq!(lines.next(), Some(golden_header().as_str()));
+
+        let mut drift = Vec::new();
+        let mut rows = 0;
+        for line in lines {
+            let cells: Vec<&str> = line.split(',').collect();
+            assert_eq!(
+                cells.len(),
+                FEATURE_COUNT + 2,
+                "malformed golden row: {line}"
+            );
+            let idx: usize = cells[0].parse().unwrap();
+            let actual = &features[idx];
+            if actual.context.productivity_category != cells[1] {
+                drift.push(format!(
+                    "event {idx}: productivity_category {} vs golden {}",
+                    actual.context.productivity_category, cells[1]
+                ));
+            }
+            let tensor = actual.tensor();
+            for ((name, cell), &value) in
+                FEATURE_NAMES.iter().zip(&cells[2..]).zip(tensor.as_slice())
+            {
+                let expected: f64 = cell.parse().unwrap();
+                let value = value as f64;
+                if (value - expected).abs() > ABS_TOL + REL_TOL * expected.abs() {
+                    drift.push(format!(
+                        "event {idx}: {name} = {value} vs golden {expected}"
+                    ));
+                }
+            }
+            rows += 1;
+        }
+        assert!(
+            rows * GOLDEN_STRIDE >= features.len(),
+            "golden file is missing rows"
+        );
+        assert!(
+            drift.is_empty(),
+            "{} values drifted from golden vectors:\n{}",
+            drift.len(),
+            drift[..drift.len().min(20)].join("\n")
+        );
+    }
+}
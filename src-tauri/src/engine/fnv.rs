@@ -0,0 +1,20 @@
+//! FNV-1a fingerprints of model files and parameter sets, so state learned
+//! against one (calibration bins, checkpoints) is not reused with another.
+//! `build.rs` includes this file by path for the `compiled-model` feature.
+
+pub const OFFSET: u64 = 0xcbf2_9ce4_8422_2325;
+const PRIME: u64 = 0x0100_0000_01b3;
+
+/// Folds `bytes` into `hash`.
+pub const fn extend(mut hash: u64, bytes: &[u8]) -> u64 {
+    let mut i = 0;
+    while i < bytes.len() {
+        hash = (hash ^ bytes[i] as u64).wrapping_mul(PRIME);
+        i += 1;
+    }
+    hash
+}
+
+pub const fn hash(bytes: &[u8]) -> u64 {
+    extend(OFFSET, bytes)
+}
@@ -0,0 +1,347 @@
+//! Short-horizon forecast of a slide into distraction.
+//!
+//! `distraction_risk` describes the current second. `DistractionForecaster`
+//! estimates the chance that the smoothed state turns DISTRACTED within each
+//! of `HORIZONS_SECS`, from exponentially smoothed scores: fast and slow
+//! averages of risk, their trend, thrash, drift, focus, and how recently the
+//! user was last distracted. Each horizon has a logistic head that starts
+//! from hand-set weights and keeps learning from what actually happened:
+//! every tick's inputs wait in a ring buffer until the horizon has passed,
+//! then train the head on whether a distraction began in the meantime. All
+//! state is fixed-size; a tick is a few dozen multiply-adds per horizon.
+
+use serde::Serialize;
+
+use crate::engine::classifier::PredictionScores;
+use crate::engine::stats;
+
+pub const HORIZONS: usize = 3;
+pub const HORIZONS_SECS: [u32; HORIZONS] = [30, 60, 120];
+const INPUTS: usize = 8;
+/// Ticks held for training; covers the longest horizon at 1 Hz with slack.
+const RING: usize = 256;
+const FAST_HALF_LIFE_SECS: f64 = 10.0;
+const SLOW_HALF_LIFE_SECS: f64 = 60.0;
+/// Time scale of the "distracted recently" input.
+const RECENT_DISTRACTION_SECS: f64 = 60.0;
+/// After a gap this long the averages restart from the current scores.
+const RESET_GAP_US: i64 = 300_000_000;
+/// A held tick whose horizon ended longer than this before the current tick
+/// matured during an event gap: what happened in it was never seen.
+const LATE_MATURITY_US: i64 = 5_000_000;
+const LEARNING_RATE: f64 = 0.01;
+/// Pull of the learned weights back toward `PRIOR_WEIGHTS`.
+const PRIOR_PULL: f64 = 1e-3;
+
+/// Starting weights per horizon, in input order: bias, fast risk, slow risk,
+/// risk trend, thrash, drift, lack of focus, recent distraction.
+const PRIOR_WEIGHTS: [[f64; INPUTS]; HORIZONS] = [
+    [-4.0, 3.0, 1.0, 2.0, 1.5, 1.0, 1.0, 1.0],
+    [-3.5, 3.0, 1.5, 1.5, 1.5, 1.0, 1.0, 1.0],
+    [-3.0, 2.5, 2.0, 1.0, 1.5, 1.0, 1.0, 1.0],
+];
+
+/// Payload of the `distraction_forecast` event.
+#[derive(Debug, Clone, Copy, Serialize)]
+#[serde(rename_all = "camelCase")]
+pub struct DistractionForecast {
+    pub timestamp_us: i64,
+    pub horizon_secs: [u32; HORIZONS],
+    /// Chance a distraction begins within each horizon.
+    pub probability: [f64; HORIZONS],
+}
+
+#[derive(Debug, Clone, Copy, Default)]
+struct Pending {
+    timestamp_us: i64,
+    inputs: [f64; INPUTS],
+    /// Ticks already distracted say nothing about a transition.
+    trainable: bool,
+    /// When the first distraction after this tick began.
+    first_onset_us: Option<i64>,
+}
+
+#[derive(Debug, Clone)]
+pub struct DistractionForecaster {
+    weights: [[f64; INPUTS]; HORIZONS],
+    risk_fast: f64,
+    risk_slow: f64,
+    thrash: f64,
+    drift: f64,
+    focus: f64,
+    last_us: Option<i64>,
+    last_distracted_us: Option<i64>,
+    was_distracted: bool,
+    ring: [Pending; RING],
+    /// Ticks ever pushed, and per horizon the oldest one not yet trained on.
+    pushed: usize,
+    cursors: [usize; HORIZONS],
+}
+
+impl Default for DistractionForecaster {
+    fn default() -> Self {
+        Self {
+            weights: PRIOR_WEIGHTS,
+            risk_fast: 0.0,
+            risk_slow: 0.0,
+            thrash: 0.0,
+            drift: 0.0,
+            focus: 0.0,
+            last_us: None,
+            last_distracted_us: None,
+            was_distracted: false,
+            ring: [Pending::default(); RING],
+            pushed: 0,
+            cursors: [0; HORIZONS],
+        }
+    }
+}
+
+fn decay(dt_secs: f64, half_life_secs: f64) -> f64 {
+    0.5_f64.powf(dt_secs / half_life_secs)
+}
+
+fn sigmoid(x: f64) -> f64 {
+    1.0 / (1.0 + (-x).exp())
+}
+
+impl DistractionForecaster {
+    /// Folds in one tick's scores, trains on ticks whose horizon has just
+    /// passed, and forecasts from the updated averages.
+    pub fn observe(&mut self, timestamp_us: i64, scores: &PredictionScores) -> DistractionForecast {
+        self.smooth(timestamp_us, scores);
+
+        let distracted = scores.smoothed_state == "DISTRACTED";
+        if distracted {
+            if !self.was_distracted {
+                self.mark_onset(timestamp_us);
+            }
+            self.last_distracted_us = Some(timestamp_us);
+        }
+        self.was_distracted = distracted;
+
+        self.train_matured(timestamp_us);
+
+        let inputs = self.inputs(timestamp_us);
+        for cursor in &mut self.cursors {
+            *cursor = (*cursor).max((self.pushed + 1).saturating_sub(RING));
+        }
+        self.ring[self.pushed % RING] = Pending {
+            timestamp_us,
+            inputs,
+            trainable: !distracted,
+            first_onset_us: None,
+        };
+        self.pushed += 1;
+
+        DistractionForecast {
+            timestamp_us,
+            horizon_secs: HORIZONS_SECS,
+            probability: std::array::from_fn(|h| sigmoid(stats::dot(&self.weights[h], &inputs))),
+        }
+    }
+
+    fn smooth(&mut self, timestamp_us: i64, scores: &PredictionScores) {
+        let risk = scores.distraction_risk;
+        let focus = scores.focus_score / 100.0;
+        let gap = self.last_us.map(|last| timestamp_us - last);
+        self.last_us = Some(timestamp_us);
+        let Some(gap) = gap.filter(|gap| *gap <= RESET_GAP_US) else {
+            self.risk_fast = risk;
+            self.risk_slow = risk;
+            self.thrash = scores.thrash_score;
+            self.drift = scores.drift_score;
+            self.focus = focus;
+            return;
+        };
+        let dt = gap.max(0) as f64 / 1e6;
+        let fast = decay(dt, FAST_HALF_LIFE_SECS);
+        let slow = decay(dt, SLOW_HALF_LIFE_SECS);
+        self.risk_fast = fast * self.risk_fast + (1.0 - fast) * risk;
+        self.risk_slow = slow * self.risk_slow + (1.0 - slow) * risk;
+        self.thrash = fast * self.thrash + (1.0 - fast) * scores.thrash_score;
+        self.drift = fast * self.drift + (1.0 - fast) * scores.drift_score;
+        self.focus = slow * self.focus + (1.0 - slow) * focus;
+    }
+
+    fn inputs(&self, timestamp_us: i64) -> [f64; INPUTS] {
+        let recent = self.last_distracted_us.map_or(0.0, |at| {
+            (-((timestamp_us - at).max(0) as f64 / 1e6) / RECENT_DISTRACTION_SECS).exp()
+        });
+        [
+            1.0,
+            self.risk_fast,
+            self.risk_slow,
+            self.risk_fast - self.risk_slow,
+            self.thrash,
+            self.drift,
+            1.0 - self.focus,
+            recent,
+        ]
+    }
+
+    /// Records the onset on every held tick that has not seen one yet; those
+    /// are the newest ones, so the walk stops at the first tick that has.
+    fn mark_onset(&mut self, onset_us: i64) {
+        let held = self.pushed.min(RING);
+        for idx in (self.pushed - held..self.pushed).rev() {
+            let pending = &mut self.ring[idx % RING];
+            if pending.first_onset_us.is_some() {
+                break;
+            }
+            pending.first_onset_us = Some(onset_us);
+        }
+    }
+
+    /// One SGD step per horizon for each held tick that horizon has passed:
+    /// did a distraction begin within the horizon after it? Ticks whose
+    /// horizon ended in an event gap are dropped untrained.
+    fn train_matured(&mut self, now_us: i64) {
+        for (h, cursor) in self.cursors.iter_mut().enumerate() {
+            let horizon_us = HORIZONS_SECS[h] as i64 * 1_000_000;
+            while *cursor < self.pushed {
+                let pending = self.ring[*cursor % RING];
+                if now_us - pending.timestamp_us < horizon_us {
+                    break;
+                }
+                *cursor += 1;
+                let horizon_end_us = pending.timestamp_us + horizon_us;
+                if !pending.trainable || now_us - horizon_end_us > LATE_MATURITY_US {
+                    continue;
+                }
+                let began = pending
+                    .first_onset_us
+                    .is_some_and(|onset| onset <= horizon_end_us);
+                let weights = &mut self.weights[h];
+                let error =
+                    sigmoid(stats::dot(weights, &pending.inputs)) - if began { 1.0 } else { 0.0 };
+                for ((w, x), prior) in weights
+                    .iter_mut()
+                    .zip(&pending.inputs)
+                    .zip(&PRIOR_WEIGHTS[h])
+                {
+                    *w -= LEARNING_RATE * (error * x + PRIOR_PULL * (*w - prior));
+                }
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::engine::features::{FeatureContext, FeatureVector};
+    use crate::engine::Classifier;
+    use crate::types::FocusMode;
+
+    fn scored(risk: f64, state: &str) -> PredictionScores {
+        let features = FeatureVector {
+            context: FeatureContext::new("Cursor", "forecast.rs — Snapback"),
+            ..FeatureVector::empty(0)
+        };
+        let mut scores = Classifier::new(FocusMode::Normal).predict(&features, None, &[]);
+        scores.distraction_risk = risk;
+        scores.focus_score = 100.0 * (1.0 - risk);
+        scores.smoothed_state = state.to_string();
+        scores
+    }
+
+    #[test]
+    fn rising_risk_raises_the_forecast() {
+        let mut forecaster = DistractionForecaster::default();
+        let calm = forecaster.observe(0, &scored(0.05, "DEEP_FOCUS"));
+        let mut rising = calm;
+        for second in 1..30_i64 {
+            let risk = 0.05 + 0.02 * second as f64;
+            rising = forecaster.observe(second * 1_000_000, &scored(risk, "PRODUCTIVE"));
+        }
+        for h in 0..HORIZONS {
+            assert!(rising.probability[h] > calm.probability[h], "{rising:?}");
+        }
+        // Longer horizons never look safer under the starting weights.
+        assert!(calm.probability[0] <= calm.probability[2]);
+    }
+
+    #[test]
+    fn ticks_before_an_event_gap_are_not_trained_on() {
+        let mut forecaster = DistractionForecaster::default();
+        for second in 0..10_i64 {
+            forecaster.observe(second * 1_000_000, &scored(0.2, "PRODUCTIVE"));
+        }
+        // Back after 3 minutes, already distracted: nothing says whether
+        // the slide began within 30 s of the ticks before the gap.
+        forecaster.observe(190_000_000, &scored(0.8, "DISTRACTED"));
+        assert_eq!(forecaster.weights, PRIOR_WEIGHTS);
+        assert!(forecaster.cursors.iter().all(|c| *c == 10));
+
+        // A slide that began after the horizon is a negative for it, even
+        // when the next tick only arrives a few seconds later.
+        let mut forecaster = DistractionForecaster::default();
+        forecaster.observe(0, &scored(0.2, "PRODUCTIVE"));
+        forecaster.observe(34_000_000, &scored(0.8, "DISTRACTED"));
+        assert!(forecaster.weights[0][0] < PRIOR_WEIGHTS[0][0]);
+        assert_eq!(forecaster.weights[1], PRIOR_WEIGHTS[1]);
+    }
+
+    #[test]
+    fn a_later_onset_does_not_hide_one_within_the_horizon() {
+        let mut forecaster = DistractionForecaster::default();
+        forecaster.observe(0, &scored(0.2, "PRODUCTIVE"));
+        forecaster.observe(20_000_000, &scored(0.8, "DISTRACTED"));
+        forecaster.observe(25_000_000, &scored(0.2, "PRODUCTIVE"));
+        // The tick at 0 matures here, after a second slide has begun; the
+        // one at 20 s still counts for it.
+        forecaster.observe(32_000_000, &scored(0.8, "DISTRACTED"));
+        assert!(forecaster.weights[0][0] > PRIOR_WEIGHTS[0][0]);
+        assert_eq!(forecaster.weights[1], PRIOR_WEIGHTS[1]);
+    }
+
+    #[test]
+    fn learns_a_recurring_slide_from_outcomes() {
+        // Every 100 s: 80 s calm at a steady risk, then 20 s distracted. Only
+        // the time since the last distraction tells the calm ticks apart.
+        fn run(forecaster: &mut DistractionForecaster, seconds: std::ops::Range<i64>) {
+            for second in seconds {
+                let state = if second % 100 >= 80 {
+                    "DISTRACTED"
+                } else {
+                    "PRODUCTIVE"
+                };
+                forecaster.observe(second * 1_000_000, &scored(0.2, state));
+            }
+        }
+        // Forecast `offset` seconds into the cycle that starts at `start`.
+        fn forecast_at(
+            forecaster: &DistractionForecaster,
+            start: i64,
+            offset: i64,
+        ) -> DistractionForecast {
+            let mut probe = forecaster.clone();
+            run(&mut probe, start..start + offset);
+            probe.observe((start + offset) * 1_000_000, &scored(0.2, "PRODUCTIVE"))
+        }
+
+        let mut forecaster = DistractionForecaster::default();
+        run(&mut forecaster, 0..100);
+        // The prior reads a recent distraction as a warning sign...
+        let (early, late) = (
+            forecast_at(&forecaster, 100, 5),
+            forecast_at(&forecaster, 100, 75),
+        );
+        assert!(early.probability[0] > late.probability[0]);
+
+        run(&mut forecaster, 100..20_000);
+        assert!(forecaster.pushed - forecaster.cursors[HORIZONS - 1] <= RING);
+        // ...while here the next slide is due 75 s after the last one began.
+        let (early, late) = (
+            forecast_at(&forecaster, 20_000, 5),
+            forecast_at(&forecaster, 20_000, 75),
+        );
+        assert!(
+            late.probability[0] > early.probability[0],
+            "{early:?} {late:?}"
+        );
+        // Every calm tick is within 120 s of the next slide.
+        assert!(early.probability[2] > 0.7, "{early:?}");
+    }
+}
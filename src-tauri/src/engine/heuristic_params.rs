@@ -0,0 +1,250 @@
+//! Tunable constants of the heuristic classifier.
+//!
+//! Every weight, scale and threshold of the heuristic mix lives in one flat
+//! array indexed by `Param`, so the kernel reads constants from a single
+//! cache-resident block and a tuner can treat them as a vector.
+//! `heuristics.json` in the app data dir overrides any subset by name, e.g.
+//! `{"thrash.switches_30s_weight": 0.5}`; `PARAM_NAMES` mirrors the keys
+//! ml/heuristics.py reads and writes.
+
+use std::collections::BTreeMap;
+use std::ops::Index;
+use std::path::Path;
+
+use crate::engine::fnv;
+use crate::types::FocusMode;
+
+pub const PARAMS_FILE: &str = "heuristics.json";
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(usize)]
+pub enum Param {
+    ThrashSwitches30sScale,
+    ThrashSwitches5minScale,
+    ThrashExtraAppsScale,
+    ThrashSwitches30sWeight,
+    ThrashSwitches5minWeight,
+    ThrashExtraAppsWeight,
+    DriftChurnScale,
+    DriftChangedBase,
+    DriftChangedChurnWeight,
+    DriftChurnWeight,
+    DriftMinKeystrokes,
+    DriftKeystrokeStdScale,
+    DriftSwitches30sScale,
+    DriftTitleWeight,
+    DriftKeystrokeWeight,
+    DriftSwitchWeight,
+    DriftGoalBiasWeight,
+    ContextWorkApp,
+    ContextBrowserOrChat,
+    ContextOther,
+    DeepSettledScale,
+    DeepMinKeystrokes,
+    DeepKeystrokeStdScale,
+    DeepUntypedSteadiness,
+    DeepSwitches30sScale,
+    DeepSettledWeight,
+    DeepTypingWeight,
+    DeepSwitchWeight,
+    DeepStabilityWeight,
+    DeepShare,
+    DistractedThrashWeight,
+    DistractedIdleScale,
+    DistractedIdleWeight,
+    DistractedKeystrokeRateScale,
+    DistractedLowTypingWeight,
+    DistractedAppTimeScale,
+    DistractedShortStayWeight,
+    DistractedEntertainmentWeight,
+    DistractedCommunicationWeight,
+    DistractedGoalBiasWeight,
+    PseudoDistractedDamping,
+    RiskThrashWeight,
+    OverrideThrash,
+    OverrideDrift,
+    RiskThresholdDeep,
+    RiskThresholdNormal,
+    RiskThresholdRecovery,
+}
+
+pub const PARAM_COUNT: usize = Param::RiskThresholdRecovery as usize + 1;
+
+pub const PARAM_NAMES: [&str; PARAM_COUNT] = [
+    "thrash.switches_30s_scale",
+    "thrash.switches_5min_scale",
+    "thrash.extra_apps_scale",
+    "thrash.switches_30s_weight",
+    "thrash.switches_5min_weight",
+    "thrash.extra_apps_weight",
+    "drift.churn_scale",
+    "drift.changed_base",
+    "drift.changed_churn_weight",
+    "drift.churn_weight",
+    "drift.min_keystrokes",
+    "drift.keystroke_std_scale",
+    "drift.switches_30s_scale",
+    "drift.title_weight",
+    "drift.keystroke_weight",
+    "drift.switch_weight",
+    "drift.goal_bias_weight",
+    "context.work_app",
+    "context.browser_or_chat",
+    "context.other",
+    "deep.settled_scale",
+    "deep.min_keystrokes",
+    "deep.keystroke_std_scale",
+    "deep.untyped_steadiness",
+    "deep.switches_30s_scale",
+    "deep.settled_weight",
+    "deep.typing_weight",
+    "deep.switch_weight",
+    "deep.stability_weight",
+    "deep.share",
+    "distracted.thrash_weight",
+    "distracted.idle_scale",
+    "distracted.idle_weight",
+    "distracted.keystroke_rate_scale",
+    "distracted.low_typing_weight",
+    "distracted.app_time_scale",
+    "distracted.short_stay_weight",
+    "distracted.entertainment_weight",
+    "distracted.communication_weight",
+    "distracted.goal_bias_weight",
+    "pseudo.distracted_damping",
+    "risk.thrash_weight",
+    "override.thrash",
+    "override.drift",
+    "risk_threshold.deep",
+    "risk_threshold.normal",
+    "risk_threshold.recovery",
+];
+
+/// The hand-tuned values the heuristic shipped with.
+const DEFAULTS: [f64; PARAM_COUNT] = [
+    4.0, 10.0, 5.0, 0.45, 0.25, 0.30, // thrash
+    12.0, 0.7, 0.3, 0.7, 3.0, 1.2, 3.0, 0.45, 0.30, 0.25, 0.25, // drift
+    1.0, 0.85, 0.4, // context
+    180.0, 4.0, 1.0, 0.3, 2.0, 0.35, 0.25, 0.20, 0.20, 0.65, // deep
+    0.30, 8.0, 0.15, 4.0, 0.10, 120.0, 0.10, 0.20, 0.05, 0.35, // distracted
+    0.6, 0.15, 0.75, 0.55, // mix and overrides
+    0.55, 0.7, 0.85, // risk thresholds
+];
+
+#[derive(Debug, thiserror::Error)]
+pub enum HeuristicParamsError {
+    #[error("read heuristics: {0}")]
+    Io(#[from] std::io::Error),
+    #[error("parse heuristics: {0}")]
+    Json(#[from] serde_json::Error),
+    #[error("unknown heuristic parameter `{0}`")]
+    Unknown(String),
+    #[error("heuristic parameter `{name}` = {value} is not a finite non-negative number")]
+    Invalid { name: &'static str, value: f64 },
+}
+
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct HeuristicParams(pub [f64; PARAM_COUNT]);
+
+impl Default for HeuristicParams {
+    fn default() -> Self {
+        Self(DEFAULTS)
+    }
+}
+
+impl Index<Param> for HeuristicParams {
+    type Output = f64;
+
+    #[inline(always)]
+    fn index(&self, param: Param) -> &f64 {
+        &self.0[param as usize]
+    }
+}
+
+impl HeuristicParams {
+    pub fn load(path: &Path) -> Result<Self, HeuristicParamsError> {
+        Self::from_json(&std::fs::read_to_string(path)?)
+    }
+
+    /// Defaults overridden by the named values in `json`.
+    pub fn from_json(json: &str) -> Result<Self, HeuristicParamsError> {
+        let overrides: BTreeMap<String, f64> = serde_json::from_str(json)?;
+        let mut params = Self::default();
+        for (name, value) in overrides {
+            let idx = PARAM_NAMES
+                .iter()
+                .position(|known| *known == name)
+                .ok_or(HeuristicParamsError::Unknown(name))?;
+            params.0[idx] = value;
+        }
+        params.validate()?;
+        Ok(params)
+    }
+
+    /// Every parameter is a weight, scale or threshold; scales divide, so
+    /// zero ones are rejected too.
+    fn validate(&self) -> Result<(), HeuristicParamsError> {
+        for (idx, &value) in self.0.iter().enumerate() {
+            let name = PARAM_NAMES[idx];
+            let is_scale = name.ends_with("_scale");
+            if !value.is_finite() || value < 0.0 || (is_scale && value == 0.0) {
+                return Err(HeuristicParamsError::Invalid { name, value });
+            }
+        }
+        Ok(())
+    }
+
+    /// Identifies this parameter set: equal values, equal fingerprint.
+    pub fn fingerprint(&self) -> u64 {
+        self.0.iter().fold(fnv::OFFSET, |hash, value| {
+            fnv::extend(hash, &value.to_bits().to_le_bytes())
+        })
+    }
+
+    pub fn risk_threshold(&self, mode: FocusMode) -> f64 {
+        match mode {
+            FocusMode::Deep => self[Param::RiskThresholdDeep],
+            FocusMode::Normal => self[Param::RiskThresholdNormal],
+            FocusMode::Recovery => self[Param::RiskThresholdRecovery],
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn names_line_up_with_the_enum() {
+        assert_eq!(
+            PARAM_NAMES[Param::ThrashSwitches30sScale as usize],
+            "thrash.switches_30s_scale"
+        );
+        assert_eq!(PARAM_NAMES[Param::DeepShare as usize], "deep.share");
+        assert_eq!(
+            PARAM_NAMES[Param::RiskThresholdRecovery as usize],
+            "risk_threshold.recovery"
+        );
+        let params = HeuristicParams::default();
+        assert_eq!(params[Param::DistractedAppTimeScale], 120.0);
+        assert_eq!(params.risk_threshold(FocusMode::Normal), 0.7);
+    }
+
+    #[test]
+    fn file_overrides_only_named_values() {
+        let params = HeuristicParams::from_json(r#"{"override.drift": 0.6}"#).unwrap();
+        assert_eq!(params[Param::OverrideDrift], 0.6);
+        let mut expected = HeuristicParams::default();
+        expected.0[Param::OverrideDrift as usize] = 0.6;
+        assert_eq!(params, expected);
+
+        assert!(matches!(
+            HeuristicParams::from_json(r#"{"thrash.switch_weight": 0.5}"#),
+            Err(HeuristicParamsError::Unknown(_))
+        ));
+        assert!(matches!(
+            HeuristicParams::from_json(r#"{"deep.settled_scale": 0}"#),
+            Err(HeuristicParamsError::Invalid { .. })
+        ));
+    }
+}
@@ -0,0 +1,264 @@
+//! Activity totals over several trailing horizons (2 min and 15 min for the
+//! model columns) from one ring of per-second buckets. Each horizon keeps a running total of its
+//! completed seconds; when the clock crosses a second, the finished bucket
+//! is added and the one falling off is subtracted. That is O(horizons) per
+//! second and O(1) per event, however long the horizons are. Horizons may
+//! be longer than the event buffer since only the buckets are retained.
+//! The horizon count is a const parameter, so reading every total fills a
+//! fixed-size array and allocates nothing.
+
+use crate::types::{CaptureEvent, EventType};
+
+pub const HORIZON_COUNT: usize = 2;
+/// Only horizons that feed model columns are kept; the 30 s and 5 min
+/// windows have exact event-window features of their own.
+pub const DEFAULT_HORIZONS_SECS: [u32; HORIZON_COUNT] = [120, 900];
+/// Positions in `DEFAULT_HORIZONS_SECS` of the horizons behind
+/// `FeatureIndex::*2min` and `*15min`.
+pub const HORIZON_2MIN: usize = 0;
+pub const HORIZON_15MIN: usize = 1;
+const _: () = assert!(DEFAULT_HORIZONS_SECS[HORIZON_2MIN] == 120);
+const _: () = assert!(DEFAULT_HORIZONS_SECS[HORIZON_15MIN] == 900);
+
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+struct ActivityBucket {
+    events: u32,
+    keystrokes: u32,
+    mouse_moves: u32,
+    mouse_clicks: u32,
+    context_switches: u32,
+    title_changes: u32,
+    idle_ms: u64,
+    title_churn: u32,
+}
+
+impl ActivityBucket {
+    fn record(&mut self, event: &CaptureEvent) {
+        self.events += 1;
+        self.title_churn += event.title_churn;
+        match event.event_type {
+            EventType::KeyPress => self.keystrokes += 1,
+            EventType::MouseMove => self.mouse_moves += 1,
+            EventType::MouseClick => self.mouse_clicks += 1,
+            EventType::WindowFocusChange => self.context_switches += 1,
+            EventType::WindowTitleChange => self.title_changes += 1,
+            EventType::IdleStart | EventType::IdleEnd => {
+                self.idle_ms += event.idle_duration_ms as u64
+            }
+            EventType::KeyRelease => {}
+        }
+    }
+
+    fn add(&mut self, other: &Self) {
+        self.events += other.events;
+        self.keystrokes += other.keystrokes;
+        self.mouse_moves += other.mouse_moves;
+        self.mouse_clicks += other.mouse_clicks;
+        self.context_switches += other.context_switches;
+        self.title_changes += other.title_changes;
+        self.idle_ms += other.idle_ms;
+        self.title_churn += other.title_churn;
+    }
+
+    fn subtract(&mut self, other: &Self) {
+        self.events -= other.events;
+        self.keystrokes -= other.keystrokes;
+        self.mouse_moves -= other.mouse_moves;
+        self.mouse_clicks -= other.mouse_clicks;
+        self.context_switches -= other.context_switches;
+        self.title_changes -= other.title_changes;
+        self.idle_ms -= other.idle_ms;
+        self.title_churn -= other.title_churn;
+    }
+}
+
+/// Totals over the trailing `span_secs` whole seconds, the current one
+/// included.
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct HorizonFeatures {
+    pub span_secs: u32,
+    pub event_count: u32,
+    pub keystroke_count: u32,
+    pub mouse_move_count: u32,
+    pub mouse_click_count: u32,
+    pub context_switches: u32,
+    pub title_changes: u32,
+    pub idle_secs: f64,
+    pub title_churn: u32,
+    /// Keystrokes per second over the span.
+    pub keystroke_rate: f64,
+    pub switches_per_min: f64,
+}
+
+#[derive(Clone, Copy)]
+struct HorizonTotal {
+    span_secs: u32,
+    /// Completed seconds only; the current bucket is added on read.
+    completed: ActivityBucket,
+}
+
+pub struct BucketRing<const N: usize = HORIZON_COUNT> {
+    buckets: Vec<ActivityBucket>,
+    /// Unix second of the newest bucket, once anything has been recorded.
+    current_sec: Option<i64>,
+    horizons: [HorizonTotal; N],
+}
+
+impl<const N: usize> BucketRing<N> {
+    /// Spans shorter than a second count as one; the ring is as long as the
+    /// longest span.
+    pub fn new(spans_secs: [u32; N]) -> Self {
+        let horizons = spans_secs.map(|span_secs| HorizonTotal {
+            span_secs: span_secs.max(1),
+            completed: ActivityBucket::default(),
+        });
+        let len = horizons.iter().map(|h| h.span_secs).max().unwrap_or(1);
+        Self {
+            buckets: vec![ActivityBucket::default(); len as usize],
+            current_sec: None,
+            horizons,
+        }
+    }
+
+    fn slot(&self, sec: i64) -> usize {
+        sec.rem_euclid(self.buckets.len() as i64) as usize
+    }
+
+    /// Record one event. Events stamped before the current second (capture
+    /// threads can race by a few ms) count toward the current second.
+    pub fn record(&mut self, event: &CaptureEvent) {
+        let sec = event.timestamp_us.div_euclid(1_000_000);
+        self.advance_to(sec);
+        let slot = self.slot(self.current_sec.unwrap_or(sec));
+        self.buckets[slot].record(event);
+    }
+
+    /// Move the current second forward, settling every second passed.
+    pub fn advance_to(&mut self, sec: i64) {
+        let Some(current) = self.current_sec else {
+            self.current_sec = Some(sec);
+            return;
+        };
+        if sec <= current {
+            return;
+        }
+        if sec - current >= self.buckets.len() as i64 {
+            self.buckets.fill(ActivityBucket::default());
+            for horizon in &mut self.horizons {
+                horizon.completed = ActivityBucket::default();
+            }
+            self.current_sec = Some(sec);
+            return;
+        }
+
+        for next in current + 1..=sec {
+            let finished = self.buckets[self.slot(next - 1)];
+            for horizon in &mut self.horizons {
+                horizon.completed.add(&finished);
+                // `next - span` is the oldest second this horizon no longer
+                // covers. For the longest horizon it shares `next`'s slot, so
+                // subtract before clearing.
+                let leaving = next - horizon.span_secs as i64;
+                if leaving <= current {
+                    let slot = leaving.rem_euclid(self.buckets.len() as i64) as usize;
+                    horizon.completed.subtract(&self.buckets[slot]);
+                }
+            }
+            let slot = self.slot(next);
+            self.buckets[slot] = ActivityBucket::default();
+        }
+        self.current_sec = Some(sec);
+    }
+
+    /// Totals for each horizon, in the order the spans were given.
+    pub fn features(&self) -> [HorizonFeatures; N] {
+        let current = self
+            .current_sec
+            .map(|sec| self.buckets[self.slot(sec)])
+            .unwrap_or_default();
+        self.horizons.map(|horizon| {
+            let mut total = horizon.completed;
+            total.add(&current);
+            let span = horizon.span_secs as f64;
+            HorizonFeatures {
+                span_secs: horizon.span_secs,
+                event_count: total.events,
+                keystroke_count: total.keystrokes,
+                mouse_move_count: total.mouse_moves,
+                mouse_click_count: total.mouse_clicks,
+                context_switches: total.context_switches,
+                title_changes: total.title_changes,
+                idle_secs: total.idle_ms as f64 / 1000.0,
+                title_churn: total.title_churn,
+                keystroke_rate: total.keystrokes as f64 / span,
+                switches_per_min: total.context_switches as f64 * 60.0 / span,
+            }
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn event(event_type: EventType, secs: i64) -> CaptureEvent {
+        CaptureEvent {
+            event_type,
+            timestamp_us: secs * 1_000_000 + 250_000,
+            app_name: String::new(),
+            window_title: String::new(),
+            mouse_x: 0,
+            mouse_y: 0,
+            mouse_speed: 0,
+            idle_duration_ms: 0,
+            title_churn: 0,
+        }
+    }
+
+    /// Rolling totals must equal a brute-force count over the same seconds.
+    #[test]
+    fn rolling_totals_match_a_direct_count() {
+        let spans = [10, 30, 120, 900];
+        let mut ring = BucketRing::new(spans);
+        let mut history: Vec<(i64, EventType)> = Vec::new();
+        let mut sec = 1_700_000_000;
+        for i in 0..5_000i64 {
+            // Irregular gaps, including some longer than the short horizons.
+            sec += [0, 1, 0, 3, 0, 0, 17, 1][(i % 8) as usize];
+            let kind = if i % 7 == 0 {
+                EventType::WindowFocusChange
+            } else {
+                EventType::KeyPress
+            };
+            ring.record(&event(kind, sec));
+            history.push((sec, kind));
+
+            if i % 97 == 0 {
+                for features in ring.features() {
+                    let from = sec - features.span_secs as i64;
+                    let in_span = history.iter().filter(|(s, _)| *s > from);
+                    let switches = in_span
+                        .clone()
+                        .filter(|(_, k)| *k == EventType::WindowFocusChange)
+                        .count();
+                    assert_eq!(features.event_count as usize, in_span.count());
+                    assert_eq!(features.context_switches as usize, switches);
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn long_gap_clears_every_horizon() {
+        let mut ring = BucketRing::new([10, 900]);
+        ring.record(&event(EventType::WindowFocusChange, 100));
+        ring.record(&event(EventType::KeyPress, 160));
+        let features = ring.features();
+        assert_eq!(features[0].event_count, 1);
+        assert_eq!(features[1].context_switches, 1);
+        assert!((features[1].switches_per_min - 60.0 / 900.0).abs() < 1e-12);
+
+        ring.record(&event(EventType::KeyPress, 5_000));
+        assert!(ring.features().iter().all(|h| h.event_count == 1));
+    }
+}
@@ -1,9 +1,25 @@
 pub mod app_context;
+pub mod calibration;
 pub mod classifier;
 pub mod features;
+pub mod fnv;
 pub mod focus_modes;
+pub mod forecast;
 pub mod goal_alignment;
+pub mod heuristic_params;
+pub mod horizons;
+pub mod model_registry;
+pub mod online_model;
+pub mod sketch;
+pub mod smoothing;
+pub mod stats;
+pub mod tensor;
+pub mod tree_model;
+pub mod window;
+pub mod xgboost_json;
 
+#[cfg(feature = "compiled-model")]
+pub mod compiled_model;
 #[cfg(feature = "onnx")]
 pub mod onnx_model;
 
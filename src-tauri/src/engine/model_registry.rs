@@ -0,0 +1,316 @@
+//! Tree models that can be replaced while the app runs.
+//!
+//! A watcher thread polls `model.json` and `model.candidate.json` in the app
+//! data dir and loads and validates changed files off the engine thread.
+//! Models sit behind `Arc`s that the watcher swaps in under a write lock held
+//! only for the pointer store, so predictions never wait on a load. A
+//! candidate model runs in shadow: it is scored next to whatever the
+//! classifier currently answers with, and only disagreement and latency are
+//! recorded. Promote it by renaming it to `model.json`.
+
+use std::path::{Path, PathBuf};
+use std::sync::{Arc, Weak};
+use std::thread;
+use std::time::{Duration, Instant, SystemTime};
+
+use parking_lot::{Mutex, RwLock};
+
+use crate::engine::tensor::{FeatureTensor, FEATURE_COUNT};
+use crate::engine::tree_model::{self, TreeEnsemble, TreeModelError};
+
+pub const CANDIDATE_FILE: &str = "model.candidate.json";
+pub const POLL_INTERVAL: Duration = Duration::from_secs(5);
+/// Shadow predictions between disagreement log lines.
+const SHADOW_LOG_EVERY: u64 = 1_000;
+
+/// Cheap change detection without a file-watching dependency.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+struct Fingerprint {
+    modified: Option<SystemTime>,
+    len: u64,
+}
+
+impl Fingerprint {
+    fn of(path: &Path) -> Option<Self> {
+        let meta = std::fs::metadata(path).ok()?;
+        Some(Self {
+            modified: meta.modified().ok(),
+            len: meta.len(),
+        })
+    }
+}
+
+struct Slot {
+    path: PathBuf,
+    model: RwLock<Option<Arc<TreeEnsemble>>>,
+    /// Last file state acted on, so a bad file is reported once.
+    seen: Mutex<Option<Fingerprint>>,
+}
+
+impl Slot {
+    fn new(path: PathBuf) -> Self {
+        Self {
+            path,
+            model: RwLock::new(None),
+            seen: Mutex::new(None),
+        }
+    }
+
+    fn get(&self) -> Option<Arc<TreeEnsemble>> {
+        self.model.read().clone()
+    }
+
+    /// Reloads the file if it changed; true when the served model changed.
+    fn refresh(&self) -> bool {
+        let fingerprint = Fingerprint::of(&self.path);
+        {
+            let mut seen = self.seen.lock();
+            if *seen == fingerprint {
+                return false;
+            }
+            *seen = fingerprint;
+        }
+
+        if fingerprint.is_none() {
+            let removed = self.model.write().take().is_some();
+            if removed {
+                log::info!("{} removed; unloaded", self.path.display());
+            }
+            return removed;
+        }
+        match load_validated(&self.path) {
+            Ok(model) => {
+                log::info!(
+                    "loaded tree model from {} ({} trees)",
+                    self.path.display(),
+                    model.tree_count()
+                );
+                let model = Arc::new(model);
+                // The old model is dropped by whichever side releases it last.
+                *self.model.write() = Some(model);
+                true
+            }
+            Err(err) => {
+                log::warn!("ignoring {}: {err}", self.path.display());
+                false
+            }
+        }
+    }
+}
+
+/// Loads `path` and checks that it scores a blank and an all-missing row
+/// to a finite distribution before it is allowed to serve.
+pub fn load_validated(path: &Path) -> Result<TreeEnsemble, TreeModelError> {
+    let model = TreeEnsemble::load(path)?;
+    let missing = FeatureTensor([f32::NAN; FEATURE_COUNT]);
+    for row in [FeatureTensor::zeroed(), missing] {
+        let probas = model.predict_probas(&row);
+        let sum: f64 = probas.iter().sum();
+        if probas.iter().any(|p| !p.is_finite()) || (sum - 1.0).abs() > 1e-3 {
+            return Err(TreeModelError::Malformed(format!(
+                "probabilities {probas:?} do not form a distribution"
+            )));
+        }
+    }
+    Ok(model)
+}
+
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct ShadowReport {
+    pub predictions: u64,
+    /// Predictions whose most likely label differed from the served one.
+    pub disagreements: u64,
+    pub current_mean_ns: u64,
+    pub candidate_mean_ns: u64,
+}
+
+impl ShadowReport {
+    pub fn disagreement_rate(&self) -> f64 {
+        if self.predictions == 0 {
+            return 0.0;
+        }
+        self.disagreements as f64 / self.predictions as f64
+    }
+}
+
+#[derive(Default)]
+struct ShadowStats {
+    predictions: u64,
+    disagreements: u64,
+    current_ns: u128,
+    candidate_ns: u128,
+}
+
+impl ShadowStats {
+    fn report(&self) -> ShadowReport {
+        let mean = |total: u128| (total / u128::from(self.predictions.max(1))) as u64;
+        ShadowReport {
+            predictions: self.predictions,
+            disagreements: self.disagreements,
+            current_mean_ns: mean(self.current_ns),
+            candidate_mean_ns: mean(self.candidate_ns),
+        }
+    }
+}
+
+pub struct ModelRegistry {
+    active: Slot,
+    candidate: Slot,
+    shadow: Mutex<ShadowStats>,
+}
+
+impl ModelRegistry {
+    /// Loads whatever models `dir` holds now; call `spawn_watcher` to follow
+    /// later changes.
+    pub fn open(dir: &Path) -> Arc<Self> {
+        let registry = Arc::new(Self {
+            active: Slot::new(dir.join(tree_model::MODEL_FILE)),
+            candidate: Slot::new(dir.join(CANDIDATE_FILE)),
+            shadow: Mutex::new(ShadowStats::default()),
+        });
+        registry.refresh();
+        registry
+    }
+
+    /// Polls the model files until the registry is dropped.
+    pub fn spawn_watcher(self: &Arc<Self>, interval: Duration) -> thread::JoinHandle<()> {
+        let registry: Weak<Self> = Arc::downgrade(self);
+        thread::spawn(move || loop {
+            thread::sleep(interval);
+            let Some(registry) = registry.upgrade() else {
+                break;
+            };
+            registry.refresh();
+        })
+    }
+
+    /// Picks up changed model files; true when either served model changed.
+    pub fn refresh(&self) -> bool {
+        let active = self.active.refresh();
+        let candidate = self.candidate.refresh();
+        if candidate {
+            // A new candidate starts a fresh comparison.
+            *self.shadow.lock() = ShadowStats::default();
+        }
+        active || candidate
+    }
+
+    /// The model predictions are served from.
+    pub fn active(&self) -> Option<Arc<TreeEnsemble>> {
+        self.active.get()
+    }
+
+    pub fn is_shadowing(&self) -> bool {
+        self.candidate.model.read().is_some()
+    }
+
+    /// Scores the candidate on the same row the classifier just answered
+    /// with `current`, which took `current_time` to compute.
+    pub fn shadow(&self, features: &FeatureTensor, current: &[f64; 4], current_time: Duration) {
+        let Some(candidate) = self.candidate.get() else {
+            return;
+        };
+        let started = Instant::now();
+        let probas = candidate.predict_probas(features);
+        let candidate_time = started.elapsed();
+
+        let mut stats = self.shadow.lock();
+        stats.predictions += 1;
+        stats.disagreements += u64::from(argmax(&probas) != argmax(current));
+        stats.current_ns += current_time.as_nanos();
+        stats.candidate_ns += candidate_time.as_nanos();
+        if stats.predictions % SHADOW_LOG_EVERY == 0 {
+            let report = stats.report();
+            log::info!(
+                "shadow model: {:.1}% disagreement over {} predictions, {} ns vs {} ns current",
+                report.disagreement_rate() * 100.0,
+                report.predictions,
+                report.candidate_mean_ns,
+                report.current_mean_ns
+            );
+        }
+    }
+
+    pub fn shadow_report(&self) -> ShadowReport {
+        self.shadow.lock().report()
+    }
+}
+
+fn argmax(probas: &[f64; 4]) -> usize {
+    let mut best = 0;
+    for (idx, p) in probas.iter().enumerate() {
+        if *p > probas[best] {
+            best = idx;
+        }
+    }
+    best
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn fixture_model() -> Vec<u8> {
+        let path = Path::new(env!("CARGO_MANIFEST_DIR"))
+            .join("../ml/tests/fixtures/tree_model")
+            .join(tree_model::MODEL_FILE);
+        std::fs::read(path).unwrap()
+    }
+
+    fn temp_dir() -> PathBuf {
+        let dir = std::env::temp_dir().join(format!("snapback_models_{}", uuid::Uuid::new_v4()));
+        std::fs::create_dir_all(&dir).unwrap();
+        dir
+    }
+
+    #[test]
+    fn reload_swaps_valid_models_and_keeps_serving_on_bad_ones() {
+        let dir = temp_dir();
+        let registry = ModelRegistry::open(&dir);
+        assert!(registry.active().is_none());
+        assert!(!registry.refresh());
+
+        let model_path = dir.join(tree_model::MODEL_FILE);
+        std::fs::write(&model_path, fixture_model()).unwrap();
+        assert!(registry.refresh());
+        let first = registry.active().unwrap();
+
+        // A half-written file must not replace the serving model.
+        std::fs::write(&model_path, b"{\"learner\": ").unwrap();
+        assert!(!registry.refresh());
+        assert!(Arc::ptr_eq(&first, &registry.active().unwrap()));
+
+        std::fs::remove_file(&model_path).unwrap();
+        assert!(registry.refresh());
+        assert!(registry.active().is_none());
+        let _ = std::fs::remove_dir_all(dir);
+    }
+
+    #[test]
+    fn shadow_counts_disagreements_with_the_served_answer() {
+        let dir = temp_dir();
+        std::fs::write(dir.join(CANDIDATE_FILE), fixture_model()).unwrap();
+        let registry = ModelRegistry::open(&dir);
+        assert!(registry.active().is_none());
+        assert!(registry.is_shadowing());
+
+        let row = FeatureTensor::zeroed();
+        let candidate = registry.candidate.get().unwrap().predict_probas(&row);
+        let mut other = [0.0; 4];
+        other[(argmax(&candidate) + 1) % 4] = 1.0;
+
+        let took = Duration::from_micros(2);
+        registry.shadow(&row, &candidate, took);
+        registry.shadow(&row, &other, took);
+        registry.shadow(&row, &other, took);
+        let report = registry.shadow_report();
+        assert_eq!(report.predictions, 3);
+        assert_eq!(report.disagreements, 2);
+        assert_eq!(report.current_mean_ns, 2_000);
+
+        std::fs::remove_file(dir.join(CANDIDATE_FILE)).unwrap();
+        assert!(registry.refresh());
+        assert!(!registry.is_shadowing());
+        let _ = std::fs::remove_dir_all(dir);
+    }
+}
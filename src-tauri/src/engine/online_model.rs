@@ -0,0 +1,236 @@
+//! Softmax regression learned on the device from the user's own labels.
+//!
+//! Every label is one SGD step on the feature row it describes. Inputs are
+//! standardised with running means and variances kept next to the weights,
+//! so the model needs no offline scaling. All state is fixed-size arrays:
+//! predicting or updating allocates nothing and takes a few hundred
+//! nanoseconds. `Classifier` mixes its probabilities into the served ones
+//! with a weight that grows with the number of labels seen.
+
+use crate::engine::tensor::{FeatureTensor, FEATURE_COUNT, FEATURE_NAMES};
+use crate::engine::{fnv, stats};
+
+const CLASSES: usize = 4;
+/// Standardised features plus a constant bias input.
+const WIDTH: usize = FEATURE_COUNT + 1;
+const LEARNING_RATE: f64 = 0.1;
+/// Labels after which the step size has halved.
+const LEARNING_RATE_HALF_LIFE: f64 = 300.0;
+const L2: f64 = 1e-4;
+/// Standardised inputs are clipped to this many standard deviations.
+const CLIP: f64 = 5.0;
+/// Labels at which the model gets half the weight in the blend.
+const HALF_CONFIDENCE_LABELS: f64 = 50.0;
+/// Checkpoint size: the layout hash, the update count, then every f64 of
+/// state.
+const CHECKPOINT_BYTES: usize = 8 * (2 + CLASSES * WIDTH + 2 * FEATURE_COUNT);
+/// Identifies the feature layout a checkpoint was written for. Two layouts
+/// of the same width (a renamed or reordered column) differ here, not in size.
+const LAYOUT_HASH: u64 = layout_hash(&FEATURE_NAMES);
+
+/// FNV-1a over the names, each followed by a 0 byte.
+const fn layout_hash(names: &[&str]) -> u64 {
+    let mut hash = fnv::OFFSET;
+    let mut i = 0;
+    while i < names.len() {
+        hash = fnv::extend(fnv::extend(hash, names[i].as_bytes()), &[0]);
+        i += 1;
+    }
+    hash
+}
+
+#[derive(Debug, Clone, PartialEq)]
+pub struct OnlineModel {
+    weights: [[f64; WIDTH]; CLASSES],
+    mean: [f64; FEATURE_COUNT],
+    /// Running sum of squared deviations from `mean` (Welford).
+    m2: [f64; FEATURE_COUNT],
+    updates: u64,
+}
+
+impl Default for OnlineModel {
+    fn default() -> Self {
+        Self {
+            weights: [[0.0; WIDTH]; CLASSES],
+            mean: [0.0; FEATURE_COUNT],
+            m2: [0.0; FEATURE_COUNT],
+            updates: 0,
+        }
+    }
+}
+
+impl OnlineModel {
+    pub fn updates(&self) -> u64 {
+        self.updates
+    }
+
+    /// Share of the served probabilities this model should get; 0 untrained.
+    pub fn confidence(&self) -> f64 {
+        let labels = self.updates as f64;
+        labels / (labels + HALF_CONFIDENCE_LABELS)
+    }
+
+    /// Class probabilities in `STATE_LABELS` order.
+    pub fn predict_probas(&self, features: &FeatureTensor) -> [f64; CLASSES] {
+        self.probas(&self.inputs(features))
+    }
+
+    /// One SGD step toward `class` (a `STATE_LABELS` index) for `features`.
+    pub fn update(&mut self, features: &FeatureTensor, class: usize) {
+        if class >= CLASSES {
+            return;
+        }
+        self.observe_scale(features);
+        let x = self.inputs(features);
+        let probas = self.probas(&x);
+        let rate = LEARNING_RATE / (1.0 + self.updates as f64 / LEARNING_RATE_HALF_LIFE);
+        for (c, weights) in self.weights.iter_mut().enumerate() {
+            let error = probas[c] - if c == class { 1.0 } else { 0.0 };
+            for (w, xi) in weights.iter_mut().zip(&x) {
+                *w -= rate * (error * xi + L2 * *w);
+            }
+        }
+    }
+
+    fn observe_scale(&mut self, features: &FeatureTensor) {
+        self.updates += 1;
+        let n = self.updates as f64;
+        for (i, &value) in features.0.iter().enumerate() {
+            // Missing values count as the mean, leaving the estimate as is.
+            let value = value as f64;
+            let value = if value.is_finite() {
+                value
+            } else {
+                self.mean[i]
+            };
+            let delta = value - self.mean[i];
+            self.mean[i] += delta / n;
+            self.m2[i] += delta * (value - self.mean[i]);
+        }
+    }
+
+    fn inputs(&self, features: &FeatureTensor) -> [f64; WIDTH] {
+        let mut x = [0.0; WIDTH];
+        x[FEATURE_COUNT] = 1.0;
+        if self.updates < 2 {
+            return x;
+        }
+        let n = (self.updates - 1) as f64;
+        for (i, &value) in features.0.iter().enumerate() {
+            let std = (self.m2[i] / n).sqrt();
+            let value = value as f64;
+            if value.is_finite() && std > 0.0 {
+                x[i] = ((value - self.mean[i]) / std).clamp(-CLIP, CLIP);
+            }
+        }
+        x
+    }
+
+    fn probas(&self, x: &[f64; WIDTH]) -> [f64; CLASSES] {
+        let logits: [f64; CLASSES] = std::array::from_fn(|c| stats::dot(&self.weights[c], x));
+        let max = logits.iter().copied().fold(f64::NEG_INFINITY, f64::max);
+        let exp = logits.map(|logit| (logit - max).exp());
+        let total: f64 = exp.iter().sum();
+        exp.map(|e| e / total)
+    }
+
+    /// Little-endian checkpoint for the `online_model` table.
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut bytes = Vec::with_capacity(CHECKPOINT_BYTES);
+        bytes.extend_from_slice(&LAYOUT_HASH.to_le_bytes());
+        bytes.extend_from_slice(&self.updates.to_le_bytes());
+        let values = self
+            .weights
+            .iter()
+            .flatten()
+            .chain(&self.mean)
+            .chain(&self.m2);
+        for value in values {
+            bytes.extend_from_slice(&value.to_le_bytes());
+        }
+        bytes
+    }
+
+    /// Restores a `to_bytes` checkpoint; `None` when it was written for a
+    /// different feature layout.
+    pub fn from_bytes(bytes: &[u8]) -> Option<Self> {
+        if bytes.len() != CHECKPOINT_BYTES {
+            return None;
+        }
+        let mut words = bytes
+            .chunks_exact(8)
+            .map(|chunk| <[u8; 8]>::try_from(chunk).expect("8-byte chunk"));
+        if u64::from_le_bytes(words.next()?) != LAYOUT_HASH {
+            return None;
+        }
+        let mut model = Self {
+            updates: u64::from_le_bytes(words.next()?),
+            ..Self::default()
+        };
+        let values = model
+            .weights
+            .iter_mut()
+            .flatten()
+            .chain(&mut model.mean)
+            .chain(&mut model.m2);
+        for (value, word) in values.zip(words) {
+            *value = f64::from_le_bytes(word);
+        }
+        Some(model)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::engine::tensor::FeatureIndex;
+
+    fn row(switches: f32, keystroke_rate: f32) -> FeatureTensor {
+        let mut tensor = FeatureTensor([0.0; FEATURE_COUNT]);
+        tensor.0[FeatureIndex::ContextSwitches30s as usize] = switches;
+        tensor.0[FeatureIndex::KeystrokeRate as usize] = keystroke_rate;
+        tensor.0[FeatureIndex::IdleTime30s as usize] = f32::NAN;
+        tensor
+    }
+
+    #[test]
+    fn learns_separable_labels() {
+        let mut model = OnlineModel::default();
+        assert_eq!(model.confidence(), 0.0);
+        assert_eq!(model.predict_probas(&row(0.0, 0.0)), [0.25; 4]);
+        for i in 0..200 {
+            let jitter = (i % 7) as f32 * 0.1;
+            model.update(&row(6.0 + jitter, 0.5), 0);
+            model.update(&row(jitter, 4.0 + jitter), 3);
+        }
+        let distracted = model.predict_probas(&row(6.3, 0.5));
+        let deep = model.predict_probas(&row(0.3, 4.3));
+        assert!(distracted[0] > 0.9, "{distracted:?}");
+        assert!(deep[3] > 0.9, "{deep:?}");
+        assert!((deep.iter().sum::<f64>() - 1.0).abs() < 1e-12);
+        assert!(model.confidence() > 0.8);
+    }
+
+    #[test]
+    fn checkpoint_round_trips() {
+        let mut model = OnlineModel::default();
+        for i in 0..10 {
+            model.update(&row(i as f32, 2.0), i % 4);
+        }
+        let bytes = model.to_bytes();
+        assert_eq!(bytes.len(), CHECKPOINT_BYTES);
+        assert_eq!(OnlineModel::from_bytes(&bytes), Some(model));
+        assert_eq!(OnlineModel::from_bytes(&bytes[8..]), None);
+    }
+
+    #[test]
+    fn checkpoint_from_another_layout_is_rejected() {
+        let mut renamed = FEATURE_NAMES;
+        renamed.swap(0, 1);
+        assert_ne!(layout_hash(&renamed), LAYOUT_HASH);
+
+        let mut bytes = OnlineModel::default().to_bytes();
+        bytes[..8].copy_from_slice(&layout_hash(&renamed).to_le_bytes());
+        assert_eq!(OnlineModel::from_bytes(&bytes), None);
+    }
+}
@@ -1,11 +1,219 @@
-#[cfg(feature = "onnx")]
-use crate::engine::features::FeatureVector;
-#[cfg(feature = "onnx")]
-use crate::engine::classifier::PredictionScores;
-
-#[cfg(feature = "onnx")]
-pub fn predict(_features: &FeatureVector) -> Option<PredictionScores> {
-    // Placeholder: load `model.onnx` from app data dir and run `ort` session.
-    // Build with: cargo build --features onnx
-    None
+//! ONNX model inference behind the `onnx` feature.
+//!
+//! `model.onnx` in the app data dir (written by `ml/export_onnx.py`) is loaded
+//! on first use into one process-wide session. The session runs
+//! single-threaded so inference never competes with the UI for cores, and the
+//! input tensor is a view over the caller's `FeatureTensor`, so nothing is
+//! copied per call. Any load or run failure returns `None` and the classifier
+//! keeps its heuristic scores.
+
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::OnceLock;
+
+use ort::session::builder::GraphOptimizationLevel;
+use ort::session::Session;
+use ort::value::TensorRef;
+use parking_lot::Mutex;
+
+use crate::engine::fnv;
+use crate::engine::tensor::{FeatureTensor, FEATURE_COUNT};
+
+pub const MODEL_FILE: &str = "model.onnx";
+const INPUT_NAME: &str = "input";
+/// skl2onnx's class-probability output, exported without ZipMap.
+const PROBABILITY_OUTPUT: &str = "probabilities";
+const CLASS_COUNT: usize = 4;
+
+#[derive(Debug, thiserror::Error)]
+pub enum OnnxError {
+    #[error("reading model: {0}")]
+    Io(#[from] std::io::Error),
+    #[error("onnx runtime: {0}")]
+    Runtime(String),
+    #[error("model output: {0}")]
+    Output(String),
+}
+
+fn runtime_err(err: impl std::fmt::Display) -> OnnxError {
+    OnnxError::Runtime(err.to_string())
+}
+
+pub struct OnnxModel {
+    session: Session,
+    /// `fnv::hash` of the model file.
+    fingerprint: u64,
+}
+
+impl OnnxModel {
+    pub fn load(path: &Path) -> Result<Self, OnnxError> {
+        let fingerprint = fnv::hash(&std::fs::read(path)?);
+        let session = Session::builder()
+            .map_err(runtime_err)?
+            .with_optimization_level(GraphOptimizationLevel::Level3)
+            .map_err(runtime_err)?
+            .with_intra_threads(1)
+            .map_err(runtime_err)?
+            .with_inter_threads(1)
+            .map_err(runtime_err)?
+            .commit_from_file(path)
+            .map_err(runtime_err)?;
+        Ok(Self {
+            session,
+            fingerprint,
+        })
+    }
+
+    pub fn fingerprint(&self) -> u64 {
+        self.fingerprint
+    }
+
+    /// Class probabilities in `STATE_LABELS` order.
+    pub fn predict_probas(&mut self, features: &FeatureTensor) -> Result<[f64; 4], OnnxError> {
+        let probas = self.predict_batch(std::slice::from_ref(features))?;
+        Ok(probas[0])
+    }
+
+    /// One session run over all `rows` (the exported input has a dynamic
+    /// batch dimension).
+    pub fn predict_batch(&mut self, rows: &[FeatureTensor]) -> Result<Vec<[f64; 4]>, OnnxError> {
+        // SAFETY: `FeatureTensor` is `repr(C)` over `[f32; FEATURE_COUNT]`,
+        // so a slice of them is `rows.len() * FEATURE_COUNT` contiguous f32s.
+        let values = unsafe {
+            std::slice::from_raw_parts(rows.as_ptr().cast::<f32>(), rows.len() * FEATURE_COUNT)
+        };
+        let input = TensorRef::from_array_view(([rows.len(), FEATURE_COUNT], values))
+            .map_err(runtime_err)?;
+        let outputs = self
+            .session
+            .run(ort::inputs![INPUT_NAME => input])
+            .map_err(runtime_err)?;
+        let output = outputs
+            .get(PROBABILITY_OUTPUT)
+            .ok_or_else(|| OnnxError::Output(format!("no `{PROBABILITY_OUTPUT}` output")))?;
+        let (_, values) = output.try_extract_tensor::<f32>().map_err(runtime_err)?;
+        if values.len() != rows.len() * CLASS_COUNT {
+            return Err(OnnxError::Output(format!(
+                "expected {} class probabilities, got {}",
+                rows.len() * CLASS_COUNT,
+                values.len()
+            )));
+        }
+
+        Ok(values
+            .chunks_exact(CLASS_COUNT)
+            .map(|row| {
+                let mut probas = [0.0; CLASS_COUNT];
+                for (slot, value) in probas.iter_mut().zip(row) {
+                    *slot = f64::from(*value);
+                }
+                probas
+            })
+            .collect())
+    }
+}
+
+static MODEL_PATH: OnceLock<PathBuf> = OnceLock::new();
+static MODEL: OnceLock<Option<Mutex<OnnxModel>>> = OnceLock::new();
+static RUN_FAILURE_LOGGED: AtomicBool = AtomicBool::new(false);
+
+/// Points the lazy session at `<app_data_dir>/model.onnx`; call once at startup.
+pub fn init(app_data_dir: &Path) {
+    let _ = MODEL_PATH.set(app_data_dir.join(MODEL_FILE));
+}
+
+fn shared_model() -> Option<&'static Mutex<OnnxModel>> {
+    MODEL
+        .get_or_init(|| {
+            let path = MODEL_PATH.get()?;
+            if !path.exists() {
+                log::info!("no ONNX model at {}; using heuristics", path.display());
+                return None;
+            }
+            match OnnxModel::load(path) {
+                Ok(model) => {
+                    log::info!("loaded ONNX model from {}", path.display());
+                    Some(Mutex::new(model))
+                }
+                Err(err) => {
+                    log::warn!("failed to load {}: {err}; using heuristics", path.display());
+                    None
+                }
+            }
+        })
+        .as_ref()
+}
+
+/// `OnnxModel::fingerprint` of the shared model, or `None` when none loads.
+pub fn fingerprint() -> Option<u64> {
+    shared_model().map(|model| model.lock().fingerprint())
+}
+
+/// Model probabilities, or `None` when no model is loaded or the run fails.
+pub fn predict(features: &FeatureTensor) -> Option<[f64; 4]> {
+    predict_batch(std::slice::from_ref(features)).map(|probas| probas[0])
+}
+
+/// `predict` for many rows in one session run.
+pub fn predict_batch(rows: &[FeatureTensor]) -> Option<Vec<[f64; 4]>> {
+    let model = shared_model()?;
+    match model.lock().predict_batch(rows) {
+        Ok(probas) => Some(probas),
+        Err(err) => {
+            if !RUN_FAILURE_LOGGED.swap(true, Ordering::Relaxed) {
+                log::warn!("ONNX prediction failed: {err}; using heuristics");
+            }
+            None
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::engine::tensor::FEATURE_NAMES;
+
+    /// Holds `model.onnx`, the tree fixture exported by
+    /// `ml/tests/test_export_onnx.py`.
+    fn fixture_dir() -> PathBuf {
+        Path::new(env!("CARGO_MANIFEST_DIR")).join("../ml/tests/fixtures/tree_model")
+    }
+
+    #[test]
+    fn fixture_matches_reference_probabilities() {
+        let path = fixture_dir().join(MODEL_FILE);
+        let mut model = OnnxModel::load(&path).unwrap();
+        assert_eq!(
+            model.fingerprint(),
+            fnv::hash(&std::fs::read(&path).unwrap())
+        );
+
+        let golden = std::fs::read_to_string(fixture_dir().join("golden_probas.csv")).unwrap();
+        let mut lines = golden.lines();
+        let header: Vec<&str> = lines.next().unwrap().split(',').collect();
+        assert_eq!(&header[..FEATURE_COUNT], &FEATURE_NAMES[..]);
+        let (rows, expected): (Vec<FeatureTensor>, Vec<Vec<f64>>) = lines
+            .map(|line| {
+                let cells: Vec<f64> = line.split(',').map(|c| c.parse().unwrap()).collect();
+                let mut tensor = FeatureTensor::zeroed();
+                for (slot, value) in tensor.0.iter_mut().zip(&cells) {
+                    *slot = *value as f32;
+                }
+                (tensor, cells[FEATURE_COUNT..].to_vec())
+            })
+            .unzip();
+        assert!(!rows.is_empty());
+
+        let batch = model.predict_batch(&rows).unwrap();
+        assert_eq!(batch.len(), rows.len());
+        for (idx, (probas, reference)) in batch.iter().zip(&expected).enumerate() {
+            for (got, want) in probas.iter().zip(reference) {
+                assert!(
+                    (got - want).abs() <= 1e-5,
+                    "row {idx}: {probas:?} vs {reference:?}"
+                );
+            }
+        }
+        assert_eq!(model.predict_probas(&rows[0]).unwrap(), batch[0]);
+    }
 }
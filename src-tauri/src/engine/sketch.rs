@@ -0,0 +1,195 @@
+//! Fixed-memory streaming quantiles (DDSketch) for timing features.
+//!
+//! Values land in logarithmic bins, each within `RELATIVE_ACCURACY` of its
+//! midpoint, so any quantile is accurate to ±2% whatever the input rate. Bin
+//! counts can be added and subtracted, which is how `WindowedSketch` evicts:
+//! it keeps one sub-sketch per time slot and subtracts a slot from the
+//! running total when it leaves the window. Mirrored by `ml/sketch.py`.
+
+pub const RELATIVE_ACCURACY: f64 = 0.02;
+/// Values at or below this share the zero bin and read back as 0.
+pub const MIN_VALUE: f64 = 1e-3;
+/// With the constants above this covers values up to ~8e5.
+const BINS: usize = 512;
+
+fn gamma() -> f64 {
+    (1.0 + RELATIVE_ACCURACY) / (1.0 - RELATIVE_ACCURACY)
+}
+
+fn bin_for(value: f64) -> usize {
+    if !(value > MIN_VALUE) {
+        return 0;
+    }
+    let key = ((value / MIN_VALUE).ln() / gamma().ln()).ceil();
+    (key as usize).min(BINS - 1)
+}
+
+/// Midpoint (in relative terms) of bin `key`'s range `(MIN·γ^(k-1), MIN·γ^k]`.
+fn bin_value(key: usize) -> f64 {
+    if key == 0 {
+        return 0.0;
+    }
+    let g = gamma();
+    MIN_VALUE * 2.0 * g.powi(key as i32) / (g + 1.0)
+}
+
+#[derive(Clone)]
+pub struct DDSketch {
+    bins: Box<[u32; BINS]>,
+    count: u32,
+}
+
+impl DDSketch {
+    pub fn new() -> Self {
+        Self {
+            bins: Box::new([0; BINS]),
+            count: 0,
+        }
+    }
+
+    pub fn add(&mut self, value: f64) {
+        self.bins[bin_for(value)] += 1;
+        self.count += 1;
+    }
+
+    /// Remove counts previously added to this sketch as well.
+    pub fn subtract(&mut self, other: &Self) {
+        for (bin, n) in self.bins.iter_mut().zip(other.bins.iter()) {
+            *bin -= n;
+        }
+        self.count -= other.count;
+    }
+
+    pub fn clear(&mut self) {
+        self.bins.fill(0);
+        self.count = 0;
+    }
+
+    /// Estimates for ascending quantiles `qs`, in one pass over the bins.
+    /// An empty sketch reports zeros.
+    pub fn quantiles<const N: usize>(&self, qs: [f64; N]) -> [f64; N] {
+        let mut out = [0.0; N];
+        if self.count == 0 {
+            return out;
+        }
+        let last = (self.count - 1) as f64;
+        let mut next = 0;
+        let mut seen = 0u64;
+        for (key, &n) in self.bins.iter().enumerate() {
+            if n == 0 {
+                continue;
+            }
+            seen += n as u64;
+            while next < N && (qs[next].clamp(0.0, 1.0) * last).floor() < seen as f64 {
+                out[next] = bin_value(key);
+                next += 1;
+            }
+            if next == N {
+                break;
+            }
+        }
+        out
+    }
+}
+
+impl Default for DDSketch {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+/// A sketch over the trailing `slots × slot_us` of event time. Eviction is
+/// per slot, so the covered span is between `(slots - 1) × slot_us` and
+/// `slots × slot_us`.
+pub struct WindowedSketch {
+    slot_us: i64,
+    /// Ring of (slot id, sub-sketch); `i64::MIN` marks an empty slot.
+    slots: Vec<(i64, DDSketch)>,
+    newest_slot: i64,
+    total: DDSketch,
+}
+
+impl WindowedSketch {
+    pub fn new(span_us: i64, slots: usize) -> Self {
+        let slots = slots.max(1);
+        Self {
+            slot_us: (span_us / slots as i64).max(1),
+            slots: vec![(i64::MIN, DDSketch::new()); slots],
+            newest_slot: i64::MIN,
+            total: DDSketch::new(),
+        }
+    }
+
+    /// Drop slots that ended before the window ending at `now_us`.
+    pub fn advance(&mut self, now_us: i64) {
+        let oldest_live = now_us.div_euclid(self.slot_us) - (self.slots.len() as i64 - 1);
+        for (id, sketch) in &mut self.slots {
+            if *id != i64::MIN && *id < oldest_live {
+                self.total.subtract(sketch);
+                sketch.clear();
+                *id = i64::MIN;
+            }
+        }
+    }
+
+    /// Add `value` at event time `at_us`. Late values (capture threads can
+    /// race slightly) count toward the newest slot.
+    pub fn record(&mut self, at_us: i64, value: f64) {
+        let id = at_us.div_euclid(self.slot_us).max(self.newest_slot);
+        self.newest_slot = id;
+        self.advance(at_us.max(id * self.slot_us));
+        let idx = id.rem_euclid(self.slots.len() as i64) as usize;
+        // After `advance`, the slot is either this one or empty.
+        let (slot_id, sketch) = &mut self.slots[idx];
+        *slot_id = id;
+        sketch.add(value);
+        self.total.add(value);
+    }
+
+    pub fn quantiles<const N: usize>(&self, qs: [f64; N]) -> [f64; N] {
+        self.total.quantiles(qs)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn quantiles_are_within_relative_accuracy() {
+        let mut sketch = DDSketch::new();
+        let mut values: Vec<f64> = (1..=10_000).map(|i| 0.01 * (i as f64).powf(1.3)).collect();
+        for &v in &values {
+            sketch.add(v);
+        }
+        values.sort_by(f64::total_cmp);
+        let qs = [0.1, 0.5, 0.9];
+        let estimates = sketch.quantiles(qs);
+        for (q, estimate) in qs.iter().zip(estimates) {
+            let exact = values[(q * (values.len() - 1) as f64).floor() as usize];
+            assert!(
+                (estimate - exact).abs() <= RELATIVE_ACCURACY * exact,
+                "q={q} estimate={estimate} exact={exact}"
+            );
+        }
+        assert_eq!(DDSketch::new().quantiles([0.5]), [0.0]);
+    }
+
+    #[test]
+    fn windowed_sketch_forgets_old_slots() {
+        let mut window = WindowedSketch::new(30_000_000, 6);
+        for i in 0..100 {
+            window.record(i * 100_000, 0.1);
+        }
+        assert_eq!(window.total.count, 100);
+        for i in 0..10 {
+            window.record(60_000_000 + i * 100_000, 2.0);
+        }
+        assert_eq!(window.total.count, 10);
+        let [p50] = window.quantiles([0.5]);
+        assert!((p50 - 2.0).abs() <= 2.0 * RELATIVE_ACCURACY);
+
+        window.advance(200_000_000);
+        assert_eq!(window.total.count, 0);
+    }
+}
@@ -0,0 +1,221 @@
+//! Temporal smoothing of the per-second focus state.
+//!
+//! `Classifier::predict` decides every second on its own, so a state that
+//! hovers near a class boundary flickers. `StateFilter` runs an HMM forward
+//! filter over the served class probabilities: the belief from the previous
+//! second is pushed through a transition matrix and weighted by this
+//! second's probabilities, which act as emission likelihoods. The transition
+//! matrix starts sticky and is re-estimated online from the filter's own
+//! expected transitions (decayed, so it follows the user's recent rhythm).
+//! Those counts favour staying put by construction, so the stay probability
+//! is bounded to keep real changes coming through within a few seconds.
+//! Each step is a fixed 4×4 update.
+
+use crate::engine::classifier::{state_label, PredictionScores};
+
+const STATES: usize = 4;
+/// Prior chance of staying in a state from one second to the next.
+const PRIOR_STAY: f64 = 0.95;
+/// Bounds on the learned chance of staying in a state.
+const STAY_RANGE: (f64, f64) = (0.8, 0.97);
+/// Pseudo-counts per row behind the prior.
+const PRIOR_COUNTS: f64 = 100.0;
+/// Per-step decay of the learned transition counts (~17 min memory).
+const COUNT_DECAY: f64 = 0.999;
+/// Keeps one confident second from ruling a state out entirely.
+const EMISSION_FLOOR: f64 = 0.01;
+/// After a gap this long the previous belief says nothing; start over.
+const RESET_GAP_US: i64 = 300_000_000;
+
+#[derive(Debug, Clone)]
+pub struct StateFilter {
+    belief: [f64; STATES],
+    last_us: Option<i64>,
+    /// Decayed expected transition counts, without the prior.
+    counts: [[f64; STATES]; STATES],
+    transitions: [[f64; STATES]; STATES],
+}
+
+impl Default for StateFilter {
+    fn default() -> Self {
+        let counts = [[0.0; STATES]; STATES];
+        Self {
+            belief: [1.0 / STATES as f64; STATES],
+            last_us: None,
+            transitions: with_prior(&counts),
+            counts,
+        }
+    }
+}
+
+fn prior(from: usize, to: usize) -> f64 {
+    if from == to {
+        PRIOR_STAY
+    } else {
+        (1.0 - PRIOR_STAY) / (STATES - 1) as f64
+    }
+}
+
+fn with_prior(counts: &[[f64; STATES]; STATES]) -> [[f64; STATES]; STATES] {
+    std::array::from_fn(|from| {
+        let row: [f64; STATES] =
+            std::array::from_fn(|to| counts[from][to] + PRIOR_COUNTS * prior(from, to));
+        let total: f64 = row.iter().sum();
+        let stay = (row[from] / total).clamp(STAY_RANGE.0, STAY_RANGE.1);
+        let scale = (1.0 - stay) / (total - row[from]);
+        std::array::from_fn(|to| if to == from { stay } else { row[to] * scale })
+    })
+}
+
+impl StateFilter {
+    /// Current transition estimate, `[from][to]` in `STATE_LABELS` order.
+    pub fn transitions(&self) -> &[[f64; STATES]; STATES] {
+        &self.transitions
+    }
+
+    /// Advances the filter by one prediction and fills in
+    /// `smoothed_probas`/`smoothed_state`. A state forced by one of the
+    /// classifier's overrides (blocked app, thrash, drift, risk threshold)
+    /// is a rule, not a noisy guess, and is kept as is.
+    pub fn smooth(&mut self, timestamp_us: i64, scores: &mut PredictionScores) {
+        let emission = scores.probas.map(|p| p.max(EMISSION_FLOOR));
+        let fresh = self
+            .last_us
+            .map_or(true, |last| timestamp_us - last > RESET_GAP_US);
+        self.last_us = Some(timestamp_us);
+
+        if fresh {
+            let total: f64 = emission.iter().sum();
+            self.belief = emission.map(|e| e / total);
+        } else {
+            let mut joint = [[0.0; STATES]; STATES];
+            let mut posterior = [0.0; STATES];
+            for (from, row) in joint.iter_mut().enumerate() {
+                for (to, cell) in row.iter_mut().enumerate() {
+                    *cell = self.belief[from] * self.transitions[from][to] * emission[to];
+                    posterior[to] += *cell;
+                }
+            }
+            let total: f64 = posterior.iter().sum();
+            for (counts, joint) in self.counts.iter_mut().zip(&joint) {
+                for (count, cell) in counts.iter_mut().zip(joint) {
+                    *count = *count * COUNT_DECAY + cell / total;
+                }
+            }
+            self.transitions = with_prior(&self.counts);
+            self.belief = posterior.map(|p| p / total);
+        }
+
+        scores.smoothed_probas = self.belief;
+        if scores.overridden {
+            scores.smoothed_state = scores.focus_state.clone();
+        } else {
+            scores.smoothed_state = state_label(&self.belief).to_string();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::engine::features::{FeatureContext, FeatureVector};
+    use crate::engine::Classifier;
+    use crate::types::FocusMode;
+
+    fn scored(probas: [f64; STATES]) -> PredictionScores {
+        let features = FeatureVector {
+            context: FeatureContext::new("Cursor", "smoothing.rs — Snapback"),
+            ..FeatureVector::empty(0)
+        };
+        let mut scores = Classifier::new(FocusMode::Normal).predict(&features, None, &[]);
+        scores.focus_state = state_label(&probas).to_string();
+        scores.probas = probas;
+        scores
+    }
+
+    #[test]
+    fn single_second_blips_do_not_flip_the_state() {
+        let deep = [0.05, 0.1, 0.35, 0.5];
+        let blip = [0.05, 0.1, 0.5, 0.35];
+        let productive = [0.05, 0.1, 0.7, 0.15];
+        let mut filter = StateFilter::default();
+        let mut flips = 0;
+        let mut last = String::new();
+        for second in 0..120_i64 {
+            let probas = if second % 10 == 5 { blip } else { deep };
+            let mut scores = scored(probas);
+            filter.smooth(second * 1_000_000, &mut scores);
+            if second > 0 && scores.smoothed_state != last {
+                flips += 1;
+            }
+            last = scores.smoothed_state;
+            assert!((scores.smoothed_probas.iter().sum::<f64>() - 1.0).abs() < 1e-12);
+        }
+        assert_eq!(flips, 0);
+        assert_eq!(last, "DEEP_FOCUS");
+
+        // A sustained change still comes through within a few seconds.
+        let mut switched_after = None;
+        for second in 120..140_i64 {
+            let mut scores = scored(productive);
+            filter.smooth(second * 1_000_000, &mut scores);
+            if scores.smoothed_state == "PRODUCTIVE" {
+                switched_after.get_or_insert(second - 120);
+            }
+        }
+        assert!(switched_after.is_some_and(|s| s <= 5), "{switched_after:?}");
+        for row in filter.transitions() {
+            assert!((row.iter().sum::<f64>() - 1.0).abs() < 1e-12);
+        }
+    }
+
+    #[test]
+    fn overrides_and_gaps_pass_through() {
+        let mut filter = StateFilter::default();
+        let mut deep = scored([0.05, 0.1, 0.35, 0.5]);
+        filter.smooth(0, &mut deep);
+        let mut forced = scored([0.05, 0.1, 0.35, 0.5]);
+        forced.focus_state = "DISTRACTED".to_string();
+        forced.overridden = true;
+        filter.smooth(1_000_000, &mut forced);
+        assert_eq!(forced.smoothed_state, "DISTRACTED");
+
+        let mut later = scored([0.7, 0.1, 0.1, 0.1]);
+        filter.smooth(1_000_000 + RESET_GAP_US + 1, &mut later);
+        assert_eq!(later.smoothed_state, "DISTRACTED");
+    }
+
+    #[test]
+    fn forced_state_holds_even_when_it_is_the_argmax() {
+        let mut filter = StateFilter::default();
+        for second in 0..10_i64 {
+            let mut deep = scored([0.05, 0.1, 0.35, 0.5]);
+            filter.smooth(second * 1_000_000, &mut deep);
+            assert_eq!(deep.smoothed_state, "DEEP_FOCUS");
+        }
+
+        let features = FeatureVector {
+            context: FeatureContext::new("Google Chrome", "YouTube"),
+            is_browser: true,
+            is_entertainment: true,
+            context_switches_30s: 3,
+            unique_apps_5min: 4,
+            idle_time_30s: 20.0,
+            time_in_current_app: 600,
+            ..FeatureVector::empty(0)
+        };
+        let rules = vec![crate::types::AppRuleRecord {
+            id: 1,
+            pattern: "youtube".to_string(),
+            rule_type: crate::types::AppRuleKind::Block,
+            note: None,
+            created_at: String::new(),
+            updated_at: String::new(),
+        }];
+        let mut blocked = Classifier::new(FocusMode::Normal).predict(&features, None, &rules);
+        assert_eq!(state_label(&blocked.probas), "DISTRACTED");
+        assert!(blocked.overridden);
+        filter.smooth(10_000_000, &mut blocked);
+        assert_eq!(blocked.smoothed_state, "DISTRACTED");
+    }
+}
@@ -0,0 +1,281 @@
+//! Summary statistics over feature windows.
+//!
+//! The kernels accumulate in four independent lanes so the compiler can keep
+//! them in vector registers. On x86_64 the same code is also compiled with
+//! AVX2 enabled and picked at startup when the CPU supports it. The lane
+//! layout is fixed and nothing is fused, so every path returns bit-identical
+//! results and replays stay reproducible across machines.
+
+use std::sync::OnceLock;
+
+const LANES: usize = 4;
+
+#[inline(always)]
+fn sum_lanes(values: &[f64]) -> f64 {
+    let mut acc = [0.0; LANES];
+    let chunks = values.chunks_exact(LANES);
+    let tail = chunks.remainder();
+    for chunk in chunks {
+        for lane in 0..LANES {
+            acc[lane] += chunk[lane];
+        }
+    }
+    let mut total = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    for v in tail {
+        total += v;
+    }
+    total
+}
+
+#[inline(always)]
+fn sum_sq_dev_lanes(values: &[f64], center: f64) -> f64 {
+    let mut acc = [0.0; LANES];
+    let chunks = values.chunks_exact(LANES);
+    let tail = chunks.remainder();
+    for chunk in chunks {
+        for lane in 0..LANES {
+            let d = chunk[lane] - center;
+            acc[lane] += d * d;
+        }
+    }
+    let mut total = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    for v in tail {
+        let d = v - center;
+        total += d * d;
+    }
+    total
+}
+
+/// `(Σ yᵢ, Σ i·yᵢ)` in one pass.
+#[inline(always)]
+fn sum_and_index_weighted_lanes(values: &[f64]) -> (f64, f64) {
+    let mut sum = [0.0; LANES];
+    let mut weighted = [0.0; LANES];
+    let mut index = [0.0, 1.0, 2.0, 3.0];
+    let chunks = values.chunks_exact(LANES);
+    let tail = chunks.remainder();
+    for chunk in chunks {
+        for lane in 0..LANES {
+            sum[lane] += chunk[lane];
+            weighted[lane] += index[lane] * chunk[lane];
+            index[lane] += LANES as f64;
+        }
+    }
+    let mut total = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+    let mut total_weighted = (weighted[0] + weighted[1]) + (weighted[2] + weighted[3]);
+    let mut i = (values.len() - tail.len()) as f64;
+    for v in tail {
+        total += v;
+        total_weighted += i * v;
+        i += 1.0;
+    }
+    (total, total_weighted)
+}
+
+/// `Σ aᵢ·bᵢ` over the shorter of the two slices.
+#[inline(always)]
+fn dot_lanes(a: &[f64], b: &[f64]) -> f64 {
+    let len = a.len().min(b.len());
+    let (a, b) = (&a[..len], &b[..len]);
+    let mut acc = [0.0; LANES];
+    let chunks = a.chunks_exact(LANES).zip(b.chunks_exact(LANES));
+    for (x, y) in chunks {
+        for lane in 0..LANES {
+            acc[lane] += x[lane] * y[lane];
+        }
+    }
+    let mut total = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+    let done = len - len % LANES;
+    for (x, y) in a[done..].iter().zip(&b[done..]) {
+        total += x * y;
+    }
+    total
+}
+
+struct Kernels {
+    name: &'static str,
+    sum: fn(&[f64]) -> f64,
+    sum_sq_dev: fn(&[f64], f64) -> f64,
+    sum_and_index_weighted: fn(&[f64]) -> (f64, f64),
+    dot: fn(&[f64], &[f64]) -> f64,
+}
+
+static PORTABLE: Kernels = Kernels {
+    name: "portable",
+    sum: sum_lanes,
+    sum_sq_dev: sum_sq_dev_lanes,
+    sum_and_index_weighted: sum_and_index_weighted_lanes,
+    dot: dot_lanes,
+};
+
+#[cfg(target_arch = "x86_64")]
+mod avx2 {
+    //! The portable kernels recompiled with AVX2. Only reachable through
+    //! `KERNELS`, which checks the CPU first.
+
+    #[target_feature(enable = "avx2")]
+    unsafe fn sum(values: &[f64]) -> f64 {
+        super::sum_lanes(values)
+    }
+
+    #[target_feature(enable = "avx2")]
+    unsafe fn sum_sq_dev(values: &[f64], center: f64) -> f64 {
+        super::sum_sq_dev_lanes(values, center)
+    }
+
+    #[target_feature(enable = "avx2")]
+    unsafe fn sum_and_index_weighted(values: &[f64]) -> (f64, f64) {
+        super::sum_and_index_weighted_lanes(values)
+    }
+
+    #[target_feature(enable = "avx2")]
+    unsafe fn dot(a: &[f64], b: &[f64]) -> f64 {
+        super::dot_lanes(a, b)
+    }
+
+    pub(super) static KERNELS: super::Kernels = super::Kernels {
+        name: "avx2",
+        sum: |v| unsafe { sum(v) },
+        sum_sq_dev: |v, c| unsafe { sum_sq_dev(v, c) },
+        sum_and_index_weighted: |v| unsafe { sum_and_index_weighted(v) },
+        dot: |a, b| unsafe { dot(a, b) },
+    };
+}
+
+fn kernels() -> &'static Kernels {
+    static SELECTED: OnceLock<&'static Kernels> = OnceLock::new();
+    SELECTED.get_or_init(|| {
+        #[cfg(target_arch = "x86_64")]
+        if is_x86_feature_detected!("avx2") {
+            return &avx2::KERNELS;
+        }
+        &PORTABLE
+    })
+}
+
+/// Which kernel set `mean`/`std_dev`/`linear_slope`/`dot` dispatch to.
+pub fn kernel_name() -> &'static str {
+    kernels().name
+}
+
+pub fn mean(values: &[f64]) -> f64 {
+    if values.is_empty() {
+        return 0.0;
+    }
+    (kernels().sum)(values) / values.len() as f64
+}
+
+/// Sample standard deviation (n - 1), two-pass for stability.
+pub fn std_dev(values: &[f64]) -> f64 {
+    if values.len() < 2 {
+        return 0.0;
+    }
+    let k = kernels();
+    let avg = (k.sum)(values) / values.len() as f64;
+    ((k.sum_sq_dev)(values, avg) / (values.len() - 1) as f64).sqrt()
+}
+
+/// Least-squares slope of `values` against their index. With xᵢ = i the
+/// x-terms have closed forms, so this is one pass and no allocation.
+pub fn linear_slope(values: &[f64]) -> f64 {
+    let n = values.len();
+    if n < 2 {
+        return 0.0;
+    }
+    let (sum_y, sum_iy) = (kernels().sum_and_index_weighted)(values);
+    let n = n as f64;
+    let mean_x = (n - 1.0) / 2.0;
+    let sxx = n * (n * n - 1.0) / 12.0;
+    (sum_iy - mean_x * sum_y) / sxx
+}
+
+/// Dot product of two equally long slices (extra elements are ignored).
+pub fn dot(a: &[f64], b: &[f64]) -> f64 {
+    (kernels().dot)(a, b)
+}
+
+/// The straightforward iterator versions, kept as the reference for tests
+/// and `--benchmark --stats`.
+pub mod scalar {
+    pub fn mean(values: &[f64]) -> f64 {
+        if values.is_empty() {
+            return 0.0;
+        }
+        values.iter().sum::<f64>() / values.len() as f64
+    }
+
+    pub fn std_dev(values: &[f64]) -> f64 {
+        if values.len() < 2 {
+            return 0.0;
+        }
+        let avg = mean(values);
+        let variance =
+            values.iter().map(|v| (v - avg).powi(2)).sum::<f64>() / (values.len() - 1) as f64;
+        variance.sqrt()
+    }
+
+    pub fn linear_slope(values: &[f64]) -> f64 {
+        if values.len() < 2 {
+            return 0.0;
+        }
+        let xs: Vec<f64> = (0..values.len()).map(|i| i as f64).collect();
+        let mean_x = mean(&xs);
+        let mean_y = mean(values);
+        let num: f64 = xs
+            .iter()
+            .zip(values.iter())
+            .map(|(x, y)| (x - mean_x) * (y - mean_y))
+            .sum();
+        let den: f64 = xs.iter().map(|x| (x - mean_x).powi(2)).sum();
+        if den == 0.0 {
+            0.0
+        } else {
+            num / den
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn close(a: f64, b: f64) -> bool {
+        (a - b).abs() <= 1e-9 * a.abs().max(b.abs()).max(1.0)
+    }
+
+    #[test]
+    fn kernels_agree_with_scalar_reference() {
+        for n in [0, 1, 2, 3, 4, 5, 7, 8, 31, 256, 1_001] {
+            let values: Vec<f64> = (0..n)
+                .map(|i| ((i * 7_919) % 113) as f64 * 0.01 + i as f64 * 0.002)
+                .collect();
+            assert!(close(mean(&values), scalar::mean(&values)), "mean n={n}");
+            assert!(
+                close(std_dev(&values), scalar::std_dev(&values)),
+                "std n={n}"
+            );
+            assert!(
+                close(linear_slope(&values), scalar::linear_slope(&values)),
+                "slope n={n}"
+            );
+            assert_eq!(
+                (PORTABLE.sum)(&values).to_bits(),
+                (kernels().sum)(&values).to_bits()
+            );
+            let weights: Vec<f64> = values.iter().map(|v| 1.5 - v).collect();
+            let naive: f64 = values.iter().zip(&weights).map(|(a, b)| a * b).sum();
+            assert!(close(dot(&values, &weights), naive), "dot n={n}");
+            assert_eq!(
+                (PORTABLE.dot)(&values, &weights).to_bits(),
+                dot(&values, &weights).to_bits()
+            );
+        }
+    }
+
+    #[test]
+    fn slope_of_a_line_is_exact() {
+        let values: Vec<f64> = (0..100).map(|i| 3.0 - 0.5 * i as f64).collect();
+        assert_eq!(linear_slope(&values), -0.5);
+        assert_eq!(linear_slope(&[2.0, 2.0, 2.0]), 0.0);
+    }
+}
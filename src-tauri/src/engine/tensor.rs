@@ -0,0 +1,176 @@
+//! Fixed-width numeric view of a `FeatureVector`, laid out in the column
+//! order the training pipeline uses (`ml/training_pipeline.py`,
+//! `default_feature_columns`). `ml/tests/test_feature_columns.py` reads
+//! `FEATURE_NAMES` from this file, so the two cannot drift apart silently.
+
+use std::ops::{Index, IndexMut};
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+#[repr(usize)]
+pub enum FeatureIndex {
+    SecondsSinceSessionStart,
+    HourOfDay,
+    DayOfWeek,
+    MinutesSinceLastBreak,
+    KeystrokeCount,
+    KeystrokeRate,
+    KeystrokeIntervalMean,
+    KeystrokeIntervalStd,
+    KeystrokeIntervalTrend,
+    KeystrokeIntervalP10,
+    KeystrokeIntervalP50,
+    KeystrokeIntervalP90,
+    BurstLengthP10,
+    BurstLengthP50,
+    BurstLengthP90,
+    MouseMoveCount,
+    MouseDistancePixels,
+    MouseSpeedMean,
+    MouseSpeedStd,
+    MouseAccelerationMean,
+    MouseClickCount,
+    ContextSwitches30s,
+    ContextSwitches5min,
+    TimeInCurrentApp,
+    UniqueApps5min,
+    IdleTime30s,
+    IdleEventCount5min,
+    LongestActiveStretch5min,
+    WindowTitleLength,
+    WindowTitleChanged30s,
+    IsBrowser,
+    IsIde,
+    IsCommunication,
+    IsEntertainment,
+    IsProductivity,
+    FocusMomentum,
+    IsPseudoProductive,
+    SwitchesPerMin2min,
+    KeystrokeRate2min,
+    IdleTime2min,
+    SwitchesPerMin15min,
+    KeystrokeRate15min,
+    IdleTime15min,
+}
+
+pub const FEATURE_COUNT: usize = FeatureIndex::IdleTime15min as usize + 1;
+
+pub const FEATURE_NAMES: [&str; FEATURE_COUNT] = [
+    "seconds_since_session_start",
+    "hour_of_day",
+    "day_of_week",
+    "minutes_since_last_break",
+    "keystroke_count",
+    "keystroke_rate",
+    "keystroke_interval_mean",
+    "keystroke_interval_std",
+    "keystroke_interval_trend",
+    "keystroke_interval_p10",
+    "keystroke_interval_p50",
+    "keystroke_interval_p90",
+    "burst_length_p10",
+    "burst_length_p50",
+    "burst_length_p90",
+    "mouse_move_count",
+    "mouse_distance_pixels",
+    "mouse_speed_mean",
+    "mouse_speed_std",
+    "mouse_acceleration_mean",
+    "mouse_click_count",
+    "context_switches_30s",
+    "context_switches_5min",
+    "time_in_current_app",
+    "unique_apps_5min",
+    "idle_time_30s",
+    "idle_event_count_5min",
+    "longest_active_stretch_5min",
+    "window_title_length",
+    "window_title_changed_30s",
+    "is_browser",
+    "is_ide",
+    "is_communication",
+    "is_entertainment",
+    "is_productivity",
+    "focus_momentum",
+    "is_pseudo_productive",
+    "switches_per_min_2min",
+    "keystroke_rate_2min",
+    "idle_time_2min",
+    "switches_per_min_15min",
+    "keystroke_rate_15min",
+    "idle_time_15min",
+];
+
+/// One row of model input. `repr(C)` over a plain array, so it can be handed
+/// to an inference runtime or written out as bytes without repacking.
+#[derive(Debug, Clone, Copy, PartialEq)]
+#[repr(C)]
+pub struct FeatureTensor(pub [f32; FEATURE_COUNT]);
+
+impl FeatureTensor {
+    pub fn zeroed() -> Self {
+        Self([0.0; FEATURE_COUNT])
+    }
+
+    pub fn as_slice(&self) -> &[f32] {
+        &self.0
+    }
+}
+
+impl Index<FeatureIndex> for FeatureTensor {
+    type Output = f32;
+
+    fn index(&self, index: FeatureIndex) -> &f32 {
+        &self.0[index as usize]
+    }
+}
+
+impl IndexMut<FeatureIndex> for FeatureTensor {
+    fn index_mut(&mut self, index: FeatureIndex) -> &mut f32 {
+        &mut self.0[index as usize]
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::engine::features::FeatureVector;
+
+    #[test]
+    fn tensor_columns_follow_feature_names() {
+        let features = FeatureVector {
+            keystroke_count: 7,
+            idle_time_30s: 1.5,
+            is_ide: true,
+            focus_momentum: 0.25,
+            ..FeatureVector::empty(0)
+        };
+        let tensor = features.tensor();
+        let column = |name: &str| {
+            let idx = FEATURE_NAMES.iter().position(|n| *n == name).unwrap();
+            tensor.as_slice()[idx]
+        };
+        assert_eq!(column("keystroke_count"), 7.0);
+        assert_eq!(column("idle_time_30s"), 1.5);
+        assert_eq!(column("is_ide"), 1.0);
+        assert_eq!(column("is_browser"), 0.0);
+        assert_eq!(tensor[FeatureIndex::FocusMomentum], 0.25);
+        assert_eq!(std::mem::size_of::<FeatureTensor>(), FEATURE_COUNT * 4);
+    }
+
+    #[test]
+    fn long_horizon_columns_come_from_the_2_and_15_minute_totals() {
+        use crate::engine::horizons::{HORIZON_15MIN, HORIZON_2MIN};
+
+        let mut features = FeatureVector::empty(0);
+        features.horizons[HORIZON_2MIN].switches_per_min = 3.0;
+        features.horizons[HORIZON_2MIN].idle_secs = 40.0;
+        features.horizons[HORIZON_15MIN].keystroke_rate = 0.5;
+        let tensor = features.tensor();
+        assert_eq!(tensor[FeatureIndex::SwitchesPerMin2min], 3.0);
+        assert_eq!(tensor[FeatureIndex::IdleTime2min], 40.0);
+        assert_eq!(tensor[FeatureIndex::KeystrokeRate15min], 0.5);
+        assert_eq!(tensor[FeatureIndex::KeystrokeRate2min], 0.0);
+        assert_eq!(FEATURE_NAMES[FEATURE_COUNT - 1], "idle_time_15min");
+    }
+}
@@ -0,0 +1,457 @@
+//! Pure-Rust evaluator for the XGBoost models `ml/training_pipeline.py`
+//! saves as JSON (`multi:softprob` gbtree).
+//!
+//! Every tree is padded to a complete binary tree of the ensemble's maximum
+//! depth and stored level-order in one flat array, so a prediction walks each
+//! tree with a fixed number of compare-and-index steps and no leaf checks.
+//! Leaves that sit above the bottom level are copied down into both children.
+//! Margins and softmax are computed in `f32`, like XGBoost's CPU predictor.
+
+use std::path::Path;
+
+use serde_json::Value;
+
+use crate::engine::fnv;
+use crate::engine::tensor::{FeatureTensor, FEATURE_COUNT};
+use crate::engine::xgboost_json::{self, ModelJsonError, SourceTree, CLASS_COUNT};
+
+pub use crate::engine::xgboost_json::LABEL_INDICES_ATTR;
+
+/// `train_cli --output-model` file name the app looks for in its data dir.
+pub const MODEL_FILE: &str = "model.json";
+/// Padded trees grow as 2^depth; XGBoost's default is 6.
+pub const MAX_TREE_DEPTH: usize = 10;
+
+/// Trees walked together per level.
+const TREE_LANES: usize = 8;
+const MISSING_GOES_RIGHT: u32 = 1 << 31;
+const FEATURE_MASK: u32 = !MISSING_GOES_RIGHT;
+
+#[derive(Debug, thiserror::Error)]
+pub enum TreeModelError {
+    #[error("read model: {0}")]
+    Io(#[from] std::io::Error),
+    #[error("parse model: {0}")]
+    Json(#[from] serde_json::Error),
+    #[error("unsupported model: {0}")]
+    Unsupported(String),
+    #[error("malformed model: {0}")]
+    Malformed(String),
+}
+
+impl From<ModelJsonError> for TreeModelError {
+    fn from(err: ModelJsonError) -> Self {
+        match err {
+            ModelJsonError::Unsupported(what) => Self::Unsupported(what),
+            ModelJsonError::Malformed(what) => Self::Malformed(what),
+        }
+    }
+}
+
+#[derive(Debug, Clone, Copy)]
+#[repr(C)]
+struct Split {
+    /// Feature column, with `MISSING_GOES_RIGHT` set when NaN takes the right branch.
+    feature: u32,
+    threshold: f32,
+}
+
+#[derive(Debug, Clone)]
+pub struct TreeEnsemble {
+    depth: usize,
+    splits: Vec<Split>,
+    leaves: Vec<f32>,
+    tree_class: Vec<u8>,
+    class_count: usize,
+    base_margin: [f32; CLASS_COUNT],
+    label_index: [usize; CLASS_COUNT],
+    /// `fnv::hash` of the JSON the model was read from.
+    fingerprint: u64,
+}
+
+/// Levels below `level` under `node`; errors past `MAX_TREE_DEPTH`.
+fn tree_depth(tree: &SourceTree, node: usize, level: usize) -> Result<usize, TreeModelError> {
+    if level > MAX_TREE_DEPTH {
+        return Err(TreeModelError::Unsupported(format!(
+            "tree deeper than {MAX_TREE_DEPTH}"
+        )));
+    }
+    if tree.is_leaf(node) {
+        return Ok(level);
+    }
+    let left = tree_depth(tree, tree.left[node] as usize, level + 1)?;
+    let right = tree_depth(tree, tree.right[node] as usize, level + 1)?;
+    Ok(left.max(right))
+}
+
+impl TreeEnsemble {
+    pub fn load(path: &Path) -> Result<Self, TreeModelError> {
+        Self::from_json(&std::fs::read_to_string(path)?)
+    }
+
+    pub fn from_json(json: &str) -> Result<Self, TreeModelError> {
+        let root: Value = serde_json::from_str(json)?;
+        let source = xgboost_json::parse_model(&root)?;
+        if source.num_feature > FEATURE_COUNT {
+            return Err(TreeModelError::Malformed(format!(
+                "{} features, the engine has {FEATURE_COUNT}",
+                source.num_feature
+            )));
+        }
+        let mut depth = 0;
+        for tree in &source.trees {
+            depth = depth.max(tree_depth(tree, 0, 0)?);
+        }
+
+        let internal = (1usize << depth) - 1;
+        let trees = source.trees.len();
+        let mut ensemble = Self {
+            depth,
+            splits: Vec::with_capacity(internal * trees),
+            leaves: Vec::with_capacity((internal + 1) * trees),
+            tree_class: source.tree_class,
+            class_count: source.class_count,
+            base_margin: [source.base_score; CLASS_COUNT],
+            label_index: source.label_index,
+            fingerprint: fnv::hash(json.as_bytes()),
+        };
+        for tree in &source.trees {
+            ensemble.push_tree(tree);
+        }
+        Ok(ensemble)
+    }
+
+    pub fn tree_count(&self) -> usize {
+        self.tree_class.len()
+    }
+
+    pub fn depth(&self) -> usize {
+        self.depth
+    }
+
+    pub fn fingerprint(&self) -> u64 {
+        self.fingerprint
+    }
+
+    fn push_tree(&mut self, tree: &SourceTree) {
+        let internal = (1usize << self.depth) - 1;
+        let split_base = self.splits.len();
+        let leaf_base = self.leaves.len();
+        self.splits.resize(
+            split_base + internal,
+            Split {
+                feature: 0,
+                threshold: 0.0,
+            },
+        );
+        self.leaves.resize(leaf_base + internal + 1, 0.0);
+        self.fill(tree, 0, 0, split_base, leaf_base);
+    }
+
+    /// Writes source node `node` at padded position `pos`.
+    fn fill(
+        &mut self,
+        tree: &SourceTree,
+        node: usize,
+        pos: usize,
+        split_base: usize,
+        leaf_base: usize,
+    ) {
+        let internal = (1usize << self.depth) - 1;
+        if pos >= internal {
+            // Bottom level: `node` is a leaf, or the copy of one from above.
+            self.leaves[leaf_base + pos - internal] = tree.condition[node];
+            return;
+        }
+        if tree.is_leaf(node) {
+            // NaN threshold: every value, missing or not, goes left.
+            self.splits[split_base + pos] = Split {
+                feature: 0,
+                threshold: f32::NAN,
+            };
+            self.fill(tree, node, 2 * pos + 1, split_base, leaf_base);
+            self.fill(tree, node, 2 * pos + 2, split_base, leaf_base);
+            return;
+        }
+        let missing = if tree.default_left[node] {
+            0
+        } else {
+            MISSING_GOES_RIGHT
+        };
+        self.splits[split_base + pos] = Split {
+            feature: tree.feature[node] | missing,
+            threshold: tree.condition[node],
+        };
+        self.fill(
+            tree,
+            tree.left[node] as usize,
+            2 * pos + 1,
+            split_base,
+            leaf_base,
+        );
+        self.fill(
+            tree,
+            tree.right[node] as usize,
+            2 * pos + 2,
+            split_base,
+            leaf_base,
+        );
+    }
+
+    /// Raw per-class margins (before softmax), in model class order.
+    pub fn margins(&self, features: &FeatureTensor) -> [f32; CLASS_COUNT] {
+        let x = features.as_slice();
+        let trees = self.tree_class.len();
+        let mut margins = self.base_margin;
+        let mut first = 0;
+        while first < trees {
+            // Walking several trees per level overlaps their dependent loads.
+            let leaves: &[f32] = if trees - first >= TREE_LANES {
+                &self.walk::<TREE_LANES>(x, first)
+            } else {
+                &self.walk::<1>(x, first)
+            };
+            // Summed in tree order, as XGBoost does.
+            for (tree, leaf) in (first..).zip(leaves) {
+                margins[self.tree_class[tree] as usize] += *leaf;
+            }
+            first += leaves.len();
+        }
+        margins
+    }
+
+    /// Leaf values of tree `tree` for `rows[..N]`.
+    #[inline(always)]
+    fn walk_rows<const N: usize>(&self, rows: &[FeatureTensor], tree: usize) -> [f32; N] {
+        let internal = (1usize << self.depth) - 1;
+        let splits = &self.splits[tree * internal..(tree + 1) * internal];
+        let mut pos = [0usize; N];
+        for _ in 0..self.depth {
+            for (row, pos) in rows.iter().zip(pos.iter_mut()) {
+                let split = splits[*pos];
+                let value = row.0[(split.feature & FEATURE_MASK) as usize];
+                let missing_right = split.feature & MISSING_GOES_RIGHT != 0;
+                let right = (value >= split.threshold) | (value.is_nan() & missing_right);
+                *pos = 2 * *pos + 1 + right as usize;
+            }
+        }
+        let leaves = &self.leaves[tree * (internal + 1)..(tree + 1) * (internal + 1)];
+        let mut out = [0.0; N];
+        for (out, pos) in out.iter_mut().zip(pos) {
+            *out = leaves[pos - internal];
+        }
+        out
+    }
+
+    /// Leaf values of trees `first..first + N`.
+    #[inline(always)]
+    fn walk<const N: usize>(&self, x: &[f32], first: usize) -> [f32; N] {
+        let internal = (1usize << self.depth) - 1;
+        let mut pos = [0usize; N];
+        for _ in 0..self.depth {
+            for (lane, pos) in pos.iter_mut().enumerate() {
+                let split = self.splits[(first + lane) * internal + *pos];
+                let value = x[(split.feature & FEATURE_MASK) as usize];
+                let missing_right = split.feature & MISSING_GOES_RIGHT != 0;
+                let right = (value >= split.threshold) | (value.is_nan() & missing_right);
+                *pos = 2 * *pos + 1 + right as usize;
+            }
+        }
+        let mut leaves = [0.0; N];
+        for (lane, leaf) in leaves.iter_mut().enumerate() {
+            *leaf = self.leaves[(first + lane) * (internal + 1) + pos[lane] - internal];
+        }
+        leaves
+    }
+
+    /// Class probabilities in `STATE_LABELS` order; labels the model never
+    /// saw get zero.
+    pub fn predict_probas(&self, features: &FeatureTensor) -> [f64; 4] {
+        let margins = self.margins(features);
+        softmax_probas(&margins[..self.class_count], &self.label_index)
+    }
+
+    /// `predict_probas` for each row. Each tree is walked for `TREE_LANES`
+    /// rows before moving on, so its nodes stay in cache; margins still add
+    /// up in tree order, giving the same results as row by row.
+    pub fn predict_batch(&self, rows: &[FeatureTensor]) -> Vec<[f64; 4]> {
+        let mut probas = Vec::with_capacity(rows.len());
+        let blocks = rows.chunks_exact(TREE_LANES);
+        let tail = blocks.remainder();
+        for block in blocks {
+            let mut margins = [self.base_margin; TREE_LANES];
+            for (tree, class) in self.tree_class.iter().enumerate() {
+                let leaves = self.walk_rows::<TREE_LANES>(block, tree);
+                for (margins, leaf) in margins.iter_mut().zip(leaves) {
+                    margins[*class as usize] += leaf;
+                }
+            }
+            for margins in &margins {
+                probas.push(softmax_probas(
+                    &margins[..self.class_count],
+                    &self.label_index,
+                ));
+            }
+        }
+        probas.extend(tail.iter().map(|row| self.predict_probas(row)));
+        probas
+    }
+}
+
+/// Softmax over model-class margins, scattered to `STATE_LABELS` order.
+pub(crate) fn softmax_probas(margins: &[f32], label_index: &[usize]) -> [f64; 4] {
+    let max = margins.iter().copied().fold(f32::NEG_INFINITY, f32::max);
+    let mut exp = [0.0f32; CLASS_COUNT];
+    let mut sum = 0.0f32;
+    for (slot, margin) in exp.iter_mut().zip(margins) {
+        *slot = (margin - max).exp();
+        sum += *slot;
+    }
+
+    let mut probas = [0.0; 4];
+    for (class, value) in exp[..margins.len()].iter().enumerate() {
+        probas[label_index[class]] = f64::from(value / sum);
+    }
+    probas
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::engine::tensor::{FeatureIndex, FEATURE_NAMES};
+
+    fn fixture_dir() -> std::path::PathBuf {
+        Path::new(env!("CARGO_MANIFEST_DIR")).join("../ml/tests/fixtures/tree_model")
+    }
+
+    /// Two classes, an unbalanced tree (a leaf at depth 1 next to a depth-2
+    /// subtree) and a missing-goes-right split.
+    fn small_model() -> String {
+        let keys = FeatureIndex::KeystrokeCount as usize;
+        let idle = FeatureIndex::IdleTime30s as usize;
+        format!(
+            r#"{{"learner": {{
+                "attributes": {{"{LABEL_INDICES_ATTR}": "0,3"}},
+                "objective": {{"name": "multi:softprob"}},
+                "learner_model_param": {{"base_score": "5E-1", "num_class": "2", "num_feature": "{FEATURE_COUNT}"}},
+                "gradient_booster": {{"name": "gbtree", "model": {{
+                    "tree_info": [0, 1],
+                    "trees": [
+                        {{"left_children": [1, -1, 3, -1, -1], "right_children": [2, -1, 4, -1, -1],
+                          "split_indices": [{keys}, 0, {idle}, 0, 0],
+                          "split_conditions": [5.0, -1.0, 2.0, 0.5, 1.5],
+                          "default_left": [1, 0, 0, 0, 0]}},
+                        {{"left_children": [-1], "right_children": [-1], "split_indices": [0],
+                          "split_conditions": [0.25], "default_left": [0]}}
+                    ]}}}}}}}}"#
+        )
+    }
+
+    fn tensor(keys: f32, idle: f32) -> FeatureTensor {
+        let mut tensor = FeatureTensor::zeroed();
+        tensor[FeatureIndex::KeystrokeCount] = keys;
+        tensor[FeatureIndex::IdleTime30s] = idle;
+        tensor
+    }
+
+    #[test]
+    fn padded_traversal_follows_xgboost_rules() {
+        let model = TreeEnsemble::from_json(&small_model()).unwrap();
+        assert_eq!(model.depth(), 2);
+        assert_eq!(model.tree_count(), 2);
+
+        // keys < 5 goes left to the shallow leaf; otherwise split on idle.
+        assert_eq!(model.margins(&tensor(1.0, 9.0))[0], 0.5 - 1.0);
+        assert_eq!(model.margins(&tensor(5.0, 1.0))[0], 0.5 + 0.5);
+        assert_eq!(model.margins(&tensor(7.0, 2.0))[0], 0.5 + 1.5);
+        // Missing keys default left; missing idle defaults right.
+        assert_eq!(model.margins(&tensor(f32::NAN, 0.0))[0], 0.5 - 1.0);
+        assert_eq!(model.margins(&tensor(9.0, f32::NAN))[0], 0.5 + 1.5);
+        assert_eq!(model.margins(&tensor(0.0, 0.0))[1], 0.5 + 0.25);
+
+        // Class 1 maps to DEEP_FOCUS; labels the model lacks stay at zero.
+        let probas = model.predict_probas(&tensor(7.0, 2.0));
+        let expected = 1.0 / (1.0 + (0.75f64 - 2.0).exp());
+        assert!((probas[0] - expected).abs() < 1e-6, "{probas:?}");
+        assert_eq!(probas[1], 0.0);
+        assert_eq!(probas[2], 0.0);
+        assert!((probas.iter().sum::<f64>() - 1.0).abs() < 1e-6);
+    }
+
+    #[test]
+    fn batch_matches_row_by_row() {
+        let model = TreeEnsemble::load(&fixture_dir().join("model.json")).unwrap();
+        let rows: Vec<FeatureTensor> = (0..19)
+            .map(|i| {
+                let mut row = tensor(i as f32, (i % 4) as f32);
+                if i % 5 == 0 {
+                    row.0[i % FEATURE_COUNT] = f32::NAN;
+                }
+                row
+            })
+            .collect();
+        let batch = model.predict_batch(&rows);
+        assert_eq!(batch.len(), rows.len());
+        for (row, probas) in rows.iter().zip(&batch) {
+            assert_eq!(*probas, model.predict_probas(row));
+        }
+    }
+
+    #[test]
+    fn rejects_models_it_cannot_evaluate() {
+        let two_class_unmapped = small_model().replace(LABEL_INDICES_ATTR, "other");
+        assert!(TreeEnsemble::from_json(&two_class_unmapped).is_err());
+        let binary = small_model().replace("multi:softprob", "binary:logistic");
+        assert!(matches!(
+            TreeEnsemble::from_json(&binary),
+            Err(TreeModelError::Unsupported(_))
+        ));
+        let keys = FeatureIndex::KeystrokeCount as usize;
+        let bad_feature = small_model().replace(
+            &format!("\"split_indices\": [{keys},"),
+            "\"split_indices\": [999,",
+        );
+        assert!(matches!(
+            TreeEnsemble::from_json(&bad_feature),
+            Err(TreeModelError::Malformed(_))
+        ));
+        let per_class = small_model().replace("\"5E-1\"", "\"[5E-1,2.5E-1]\"");
+        assert!(matches!(
+            TreeEnsemble::from_json(&per_class),
+            Err(TreeModelError::Unsupported(_))
+        ));
+        let shared = small_model().replace("\"5E-1\"", "\"[5E-1,5E-1]\"");
+        assert!(TreeEnsemble::from_json(&shared).is_ok());
+    }
+
+    /// `golden_probas.csv` holds feature rows and the probabilities the
+    /// Python reference (`ml/tree_model.py`, checked against xgboost itself
+    /// when installed) computes for `model.json`.
+    #[test]
+    fn matches_reference_probabilities() {
+        let model = TreeEnsemble::load(&fixture_dir().join("model.json")).unwrap();
+        let golden = std::fs::read_to_string(fixture_dir().join("golden_probas.csv")).unwrap();
+        let mut lines = golden.lines();
+        let header: Vec<&str> = lines.next().unwrap().split(',').collect();
+        assert_eq!(&header[..FEATURE_COUNT], &FEATURE_NAMES[..]);
+
+        let mut rows = 0;
+        for line in lines {
+            let cells: Vec<f64> = line.split(',').map(|c| c.parse::<f64>().unwrap()).collect();
+            let mut tensor = FeatureTensor::zeroed();
+            for (slot, value) in tensor.0.iter_mut().zip(&cells) {
+                *slot = *value as f32;
+            }
+            let probas = model.predict_probas(&tensor);
+            for (got, want) in probas.iter().zip(&cells[FEATURE_COUNT..]) {
+                assert!(
+                    (got - want).abs() <= 1e-6,
+                    "row {rows}: {probas:?} vs {:?}",
+                    &cells[FEATURE_COUNT..]
+                );
+            }
+            rows += 1;
+        }
+        assert!(rows > 0);
+    }
+}
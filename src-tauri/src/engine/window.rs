@@ -0,0 +1,293 @@
+//! Sliding window of capture events stored column-wise. Feature scans read
+//! only the columns they need (a keystroke-interval pass touches timestamps
+//! and nothing else), and per-type index lists let them skip other events.
+//!
+//! The buffer holds the longest horizon once. Shorter horizons are cursors
+//! into it, and their sums are differences of running prefix sums.
+
+use std::collections::VecDeque;
+
+use crate::types::{CaptureEvent, EventType};
+
+const EVENT_TYPES: usize = 8;
+
+fn type_slot(event_type: EventType) -> usize {
+    event_type as usize - 1
+}
+
+/// Handle to a shorter horizon registered with `EventWindow::add_horizon`.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Horizon(usize);
+
+struct Cursor {
+    span_us: i64,
+    start_seq: u64,
+}
+
+/// Events newer than `span_us`, oldest first. Each column is a ring buffer;
+/// `by_type` holds sequence numbers, so popping the front never rewrites them.
+pub struct EventWindow {
+    span_us: i64,
+    /// Sequence number of the oldest retained event.
+    head_seq: u64,
+    timestamps: VecDeque<i64>,
+    kinds: VecDeque<EventType>,
+    apps: VecDeque<u32>,
+    mouse_speeds: VecDeque<u32>,
+    /// Idle-event ms and title churn pushed before each event. Totals since
+    /// the first push never decrease, so any suffix sum is one subtraction.
+    idle_ms_before: VecDeque<u64>,
+    title_churn_before: VecDeque<u64>,
+    idle_ms_pushed: u64,
+    title_churn_pushed: u64,
+    by_type: [VecDeque<u64>; EVENT_TYPES],
+    /// Events per interned app id, for an O(1) distinct-app count.
+    app_counts: Vec<u32>,
+    unique_apps: usize,
+    cursors: Vec<Cursor>,
+}
+
+impl EventWindow {
+    pub fn new(span_us: i64) -> Self {
+        Self {
+            span_us,
+            head_seq: 0,
+            timestamps: VecDeque::new(),
+            kinds: VecDeque::new(),
+            apps: VecDeque::new(),
+            mouse_speeds: VecDeque::new(),
+            idle_ms_before: VecDeque::new(),
+            title_churn_before: VecDeque::new(),
+            idle_ms_pushed: 0,
+            title_churn_pushed: 0,
+            by_type: Default::default(),
+            app_counts: Vec::new(),
+            unique_apps: 0,
+            cursors: Vec::new(),
+        }
+    }
+
+    /// Track the trailing `span_us` as well. Spans longer than the window are
+    /// capped to it.
+    pub fn add_horizon(&mut self, span_us: i64) -> Horizon {
+        self.cursors.push(Cursor {
+            span_us: span_us.min(self.span_us),
+            start_seq: self.head_seq,
+        });
+        Horizon(self.cursors.len() - 1)
+    }
+
+    fn end_seq(&self) -> u64 {
+        self.head_seq + self.timestamps.len() as u64
+    }
+
+    pub fn push(&mut self, event: &CaptureEvent, app_id: u32) {
+        let seq = self.end_seq();
+        self.timestamps.push_back(event.timestamp_us);
+        self.kinds.push_back(event.event_type);
+        self.apps.push_back(app_id);
+        self.mouse_speeds.push_back(event.mouse_speed);
+        self.idle_ms_before.push_back(self.idle_ms_pushed);
+        self.title_churn_before.push_back(self.title_churn_pushed);
+        if matches!(event.event_type, EventType::IdleStart | EventType::IdleEnd) {
+            self.idle_ms_pushed += event.idle_duration_ms as u64;
+        }
+        self.title_churn_pushed += event.title_churn as u64;
+        self.by_type[type_slot(event.event_type)].push_back(seq);
+
+        let app = app_id as usize;
+        if app >= self.app_counts.len() {
+            self.app_counts.resize(app + 1, 0);
+        }
+        if self.app_counts[app] == 0 {
+            self.unique_apps += 1;
+        }
+        self.app_counts[app] += 1;
+    }
+
+    /// Drop events older than the span, measured back from `now`, and move
+    /// every horizon cursor up to its own cutoff.
+    pub fn trim(&mut self, now: i64) {
+        while self
+            .timestamps
+            .front()
+            .is_some_and(|&ts| now - ts > self.span_us)
+        {
+            self.pop_front();
+        }
+
+        let (head, end) = (self.head_seq, self.end_seq());
+        for cursor in &mut self.cursors {
+            let mut seq = cursor.start_seq.max(head);
+            while seq < end && now - self.timestamps[(seq - head) as usize] > cursor.span_us {
+                seq += 1;
+            }
+            cursor.start_seq = seq;
+        }
+    }
+
+    fn pop_front(&mut self) {
+        self.timestamps.pop_front();
+        let kind = self.kinds.pop_front().expect("columns have equal length");
+        let app = self.apps.pop_front().unwrap_or_default() as usize;
+        self.mouse_speeds.pop_front();
+        self.idle_ms_before.pop_front();
+        self.title_churn_before.pop_front();
+        self.by_type[type_slot(kind)].pop_front();
+        self.head_seq += 1;
+
+        self.app_counts[app] -= 1;
+        if self.app_counts[app] == 0 {
+            self.unique_apps -= 1;
+        }
+    }
+
+    /// The whole window.
+    pub fn full(&self) -> WindowView<'_> {
+        WindowView {
+            window: self,
+            start_seq: self.head_seq,
+        }
+    }
+
+    pub fn view(&self, horizon: Horizon) -> WindowView<'_> {
+        WindowView {
+            window: self,
+            start_seq: self.cursors[horizon.0].start_seq.max(self.head_seq),
+        }
+    }
+
+    pub fn timestamp(&self, pos: usize) -> i64 {
+        self.timestamps[pos]
+    }
+
+    pub fn mouse_speed(&self, pos: usize) -> u32 {
+        self.mouse_speeds[pos]
+    }
+
+    /// Distinct apps across the whole window.
+    pub fn unique_apps(&self) -> usize {
+        self.unique_apps
+    }
+
+    fn prefix_at(&self, column: &VecDeque<u64>, pushed: u64, seq: u64) -> u64 {
+        column
+            .get((seq - self.head_seq) as usize)
+            .copied()
+            .unwrap_or(pushed)
+    }
+}
+
+/// The events from a start point to the newest. Positions it yields index the
+/// parent window (0 = oldest retained event).
+#[derive(Clone, Copy)]
+pub struct WindowView<'a> {
+    window: &'a EventWindow,
+    start_seq: u64,
+}
+
+impl<'a> WindowView<'a> {
+    pub fn len(&self) -> usize {
+        (self.window.end_seq() - self.start_seq) as usize
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    pub fn oldest_us(&self) -> Option<i64> {
+        self.window
+            .timestamps
+            .get((self.start_seq - self.window.head_seq) as usize)
+            .copied()
+    }
+
+    fn type_start(&self, event_type: EventType) -> usize {
+        let start = self.start_seq;
+        self.window.by_type[type_slot(event_type)].partition_point(|&seq| seq < start)
+    }
+
+    pub fn count(&self, event_type: EventType) -> usize {
+        self.window.by_type[type_slot(event_type)].len() - self.type_start(event_type)
+    }
+
+    /// Positions of events of one type, in time order.
+    pub fn positions(&self, event_type: EventType) -> impl Iterator<Item = usize> + 'a {
+        let head = self.window.head_seq;
+        self.window.by_type[type_slot(event_type)]
+            .range(self.type_start(event_type)..)
+            .map(move |&seq| (seq - head) as usize)
+    }
+
+    pub fn idle_ms_total(&self) -> u64 {
+        let w = self.window;
+        w.idle_ms_pushed - w.prefix_at(&w.idle_ms_before, w.idle_ms_pushed, self.start_seq)
+    }
+
+    pub fn title_churn_total(&self) -> u64 {
+        let w = self.window;
+        w.title_churn_pushed
+            - w.prefix_at(&w.title_churn_before, w.title_churn_pushed, self.start_seq)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn event(event_type: EventType, secs: i64) -> CaptureEvent {
+        CaptureEvent {
+            event_type,
+            timestamp_us: secs * 1_000_000,
+            app_name: String::new(),
+            window_title: String::new(),
+            mouse_x: 0,
+            mouse_y: 0,
+            mouse_speed: secs as u32,
+            idle_duration_ms: 10,
+            title_churn: 1,
+        }
+    }
+
+    #[test]
+    fn eviction_keeps_type_indexes_and_running_counts_aligned() {
+        let mut window = EventWindow::new(10_000_000);
+        let short = window.add_horizon(3_000_000);
+        for secs in 0..30 {
+            let kind = if secs % 3 == 0 {
+                EventType::MouseMove
+            } else {
+                EventType::KeyPress
+            };
+            window.push(&event(kind, secs), (secs % 4) as u32);
+            window.trim(secs * 1_000_000);
+        }
+
+        // Seconds 19..=29 survive a 10 s span ending at 29.
+        let full = window.full();
+        assert_eq!(full.len(), 11);
+        assert_eq!(full.oldest_us(), Some(19_000_000));
+        let moves: Vec<u32> = full
+            .positions(EventType::MouseMove)
+            .map(|pos| window.mouse_speed(pos))
+            .collect();
+        assert_eq!(moves, vec![21, 24, 27]);
+        assert_eq!(full.count(EventType::KeyPress), 8);
+        assert_eq!(full.title_churn_total(), 11);
+        assert_eq!(window.unique_apps(), 4);
+
+        // The 3 s horizon covers 26..=29.
+        let recent = window.view(short);
+        assert_eq!(recent.len(), 4);
+        assert_eq!(recent.oldest_us(), Some(26_000_000));
+        assert_eq!(recent.count(EventType::MouseMove), 1);
+        assert_eq!(recent.count(EventType::KeyPress), 3);
+        assert_eq!(recent.idle_ms_total(), 0);
+
+        window.trim(60_000_000);
+        assert!(window.full().is_empty());
+        assert!(window.view(short).is_empty());
+        assert_eq!(window.view(short).title_churn_total(), 0);
+        assert_eq!(window.unique_apps(), 0);
+    }
+}
@@ -0,0 +1,254 @@
+//! Reading and validating the XGBoost JSON models `ml/training_pipeline.py`
+//! saves (`multi:softprob`/`multi:softmax` gbtree).
+//!
+//! Shared by `engine::tree_model`, which evaluates a model at run time, and
+//! `build.rs`, which compiles one into the binary for the `compiled-model`
+//! feature, so both accept exactly the same files. `build.rs` includes this
+//! file by path, so it uses nothing from the crate but `serde_json`.
+
+use std::fmt;
+
+use serde_json::Value;
+
+pub const CLASS_COUNT: usize = 4;
+/// Learner attribute written by `train_baseline`: the `STATE_LABELS` index of
+/// each model class, for models trained on a subset of labels.
+pub const LABEL_INDICES_ATTR: &str = "snapback_label_indices";
+
+#[derive(Debug)]
+pub enum ModelJsonError {
+    Unsupported(String),
+    Malformed(String),
+}
+
+impl fmt::Display for ModelJsonError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            Self::Unsupported(what) => write!(f, "unsupported model: {what}"),
+            Self::Malformed(what) => write!(f, "malformed model: {what}"),
+        }
+    }
+}
+
+/// One tree as XGBoost stores it: parallel arrays indexed by node id. Every
+/// child id is greater than its parent's, so walks always terminate.
+pub struct SourceTree {
+    pub left: Vec<i64>,
+    pub right: Vec<i64>,
+    pub feature: Vec<u32>,
+    /// Split threshold, or the leaf value at leaves.
+    pub condition: Vec<f32>,
+    pub default_left: Vec<bool>,
+}
+
+impl SourceTree {
+    pub fn is_leaf(&self, node: usize) -> bool {
+        self.left[node] < 0
+    }
+}
+
+pub struct SourceModel {
+    pub class_count: usize,
+    pub num_feature: usize,
+    /// Margin every class starts from.
+    pub base_score: f32,
+    /// `STATE_LABELS` index of each model class.
+    pub label_index: [usize; CLASS_COUNT],
+    pub trees: Vec<SourceTree>,
+    /// Model class each tree adds to.
+    pub tree_class: Vec<u8>,
+}
+
+pub fn parse_model(root: &Value) -> Result<SourceModel, ModelJsonError> {
+    let learner = &root["learner"];
+
+    let objective = learner["objective"]["name"].as_str().unwrap_or_default();
+    if objective != "multi:softprob" && objective != "multi:softmax" {
+        return Err(ModelJsonError::Unsupported(format!(
+            "objective `{objective}`"
+        )));
+    }
+    let booster = &learner["gradient_booster"];
+    if booster["name"].as_str() != Some("gbtree") {
+        return Err(ModelJsonError::Unsupported(
+            "booster other than gbtree".to_string(),
+        ));
+    }
+
+    let params = &learner["learner_model_param"];
+    let class_count = parse_number(&params["num_class"])? as usize;
+    if !(2..=CLASS_COUNT).contains(&class_count) {
+        return Err(ModelJsonError::Unsupported(format!(
+            "{class_count} classes"
+        )));
+    }
+    let num_feature = parse_number(&params["num_feature"])? as usize;
+    let base_score = parse_base_score(&params["base_score"], class_count)?;
+    let label_index = parse_label_indices(&learner["attributes"], class_count)?;
+
+    let model = &booster["model"];
+    let trees = model["trees"]
+        .as_array()
+        .ok_or_else(|| ModelJsonError::Malformed("missing `trees`".to_string()))?;
+    let tree_info = model["tree_info"]
+        .as_array()
+        .ok_or_else(|| ModelJsonError::Malformed("missing `tree_info`".to_string()))?;
+    if tree_info.len() != trees.len() {
+        return Err(ModelJsonError::Malformed(
+            "`tree_info` and `trees` differ in length".to_string(),
+        ));
+    }
+    let tree_class = tree_info
+        .iter()
+        .map(|class| {
+            class
+                .as_u64()
+                .filter(|c| (*c as usize) < class_count)
+                .map(|c| c as u8)
+        })
+        .collect::<Option<Vec<_>>>()
+        .ok_or_else(|| ModelJsonError::Malformed("bad `tree_info` entry".to_string()))?;
+    let trees = trees
+        .iter()
+        .map(|tree| parse_tree(tree, num_feature))
+        .collect::<Result<Vec<_>, _>>()?;
+
+    Ok(SourceModel {
+        class_count,
+        num_feature,
+        base_score,
+        label_index,
+        trees,
+        tree_class,
+    })
+}
+
+fn parse_number(value: &Value) -> Result<f64, ModelJsonError> {
+    match value {
+        Value::Number(n) => n.as_f64(),
+        Value::String(s) => s.trim().parse::<f64>().ok(),
+        _ => None,
+    }
+    .ok_or_else(|| ModelJsonError::Malformed(format!("expected a number, got {value}")))
+}
+
+/// A scalar string (`"5E-1"`), or a per-class list (`"[5E-1,5E-1]"`) in
+/// XGBoost 3 models; softmax only sees the shared part.
+fn parse_base_score(value: &Value, class_count: usize) -> Result<f32, ModelJsonError> {
+    if let Some(list) = value.as_str().and_then(|s| s.trim().strip_prefix('[')) {
+        let scores = list
+            .trim_end_matches(']')
+            .split(',')
+            .map(|s| s.trim().parse::<f32>())
+            .collect::<Result<Vec<_>, _>>()
+            .map_err(|_| ModelJsonError::Malformed(format!("base_score {value}")))?;
+        if scores.len() != class_count || scores.iter().any(|s| *s != scores[0]) {
+            return Err(ModelJsonError::Unsupported(
+                "per-class base_score".to_string(),
+            ));
+        }
+        return Ok(scores[0]);
+    }
+    Ok(parse_number(value)? as f32)
+}
+
+fn parse_label_indices(
+    attributes: &Value,
+    class_count: usize,
+) -> Result<[usize; CLASS_COUNT], ModelJsonError> {
+    let mut indices = [0, 1, 2, 3];
+    let Some(raw) = attributes[LABEL_INDICES_ATTR].as_str() else {
+        if class_count != CLASS_COUNT {
+            return Err(ModelJsonError::Malformed(format!(
+                "{class_count}-class model without `{LABEL_INDICES_ATTR}`"
+            )));
+        }
+        return Ok(indices);
+    };
+    let parsed: Vec<usize> = raw
+        .split(',')
+        .map(|s| s.trim().parse::<usize>())
+        .collect::<Result<_, _>>()
+        .map_err(|_| ModelJsonError::Malformed(format!("{LABEL_INDICES_ATTR} `{raw}`")))?;
+    if parsed.len() != class_count || parsed.iter().any(|idx| *idx >= CLASS_COUNT) {
+        return Err(ModelJsonError::Malformed(format!(
+            "{LABEL_INDICES_ATTR} `{raw}`"
+        )));
+    }
+    indices[..class_count].copy_from_slice(&parsed);
+    Ok(indices)
+}
+
+fn parse_tree(tree: &Value, num_feature: usize) -> Result<SourceTree, ModelJsonError> {
+    let ints = |key: &str| -> Result<Vec<i64>, ModelJsonError> {
+        tree[key]
+            .as_array()
+            .and_then(|values| values.iter().map(Value::as_i64).collect())
+            .ok_or_else(|| ModelJsonError::Malformed(format!("tree `{key}`")))
+    };
+    let left = ints("left_children")?;
+    let right = ints("right_children")?;
+    let feature = ints("split_indices")?;
+    let condition: Vec<f32> = tree["split_conditions"]
+        .as_array()
+        .and_then(|values| {
+            values
+                .iter()
+                .map(|v| v.as_f64().map(|f| f as f32))
+                .collect()
+        })
+        .ok_or_else(|| ModelJsonError::Malformed("tree `split_conditions`".to_string()))?;
+    // Older models store booleans, newer ones 0/1.
+    let default_left: Vec<bool> = tree["default_left"]
+        .as_array()
+        .and_then(|values| {
+            values
+                .iter()
+                .map(|v| v.as_bool().or_else(|| v.as_i64().map(|i| i != 0)))
+                .collect()
+        })
+        .ok_or_else(|| ModelJsonError::Malformed("tree `default_left`".to_string()))?;
+
+    let nodes = left.len();
+    if nodes == 0
+        || [
+            right.len(),
+            feature.len(),
+            condition.len(),
+            default_left.len(),
+        ]
+        .iter()
+        .any(|len| *len != nodes)
+    {
+        return Err(ModelJsonError::Malformed(
+            "tree arrays differ in length".to_string(),
+        ));
+    }
+    if tree["categories_nodes"]
+        .as_array()
+        .is_some_and(|c| !c.is_empty())
+    {
+        return Err(ModelJsonError::Unsupported(
+            "categorical splits".to_string(),
+        ));
+    }
+    for node in 0..nodes {
+        if left[node] < 0 {
+            continue;
+        }
+        let children_ok = [left[node], right[node]]
+            .iter()
+            .all(|child| *child > node as i64 && (*child as usize) < nodes);
+        if !children_ok || feature[node] < 0 || feature[node] as usize >= num_feature {
+            return Err(ModelJsonError::Malformed(format!("tree node {node}")));
+        }
+    }
+
+    Ok(SourceTree {
+        left,
+        right,
+        feature: feature.into_iter().map(|f| f as u32).collect(),
+        condition,
+        default_left,
+    })
+}
@@ -0,0 +1,152 @@
+//! On-disk layout of the raw event journal (v1). All integers are little-endian.
+//!
+//! ```text
+//! events-000001.sbj   segment header (16 B), then blocks:
+//!                       payload_len u32 | record_count u32 | crc32(payload) u32 | payload
+//!                     payload = records, each `len u16 | body[len]`
+//! events-000001.sym   symbol header (16 B), then entries: id u32 | len u32 | utf8[len]
+//! ```
+//!
+//! Records are length-prefixed so readers skip fields appended by later versions.
+//! App names and titles are interned per segment; ids index the `.sym` sidecar.
+
+use crate::types::{CaptureEvent, EventType};
+
+pub const SEGMENT_MAGIC: [u8; 4] = *b"SBJ1";
+pub const SYMBOL_MAGIC: [u8; 4] = *b"SBS1";
+pub const FORMAT_VERSION: u16 = 1;
+pub const FILE_HEADER_LEN: usize = 16;
+pub const BLOCK_HEADER_LEN: usize = 12;
+pub const SEGMENT_EXT: &str = "sbj";
+pub const SYMBOL_EXT: &str = "sym";
+
+/// ts_us i64, event_type u8, app u32, title u32, x i32, y i32, speed u32, idle u32, churn u32.
+pub const RECORD_BODY_LEN: usize = 37;
+
+pub fn segment_file_name(seq: u32) -> String {
+    format!("events-{seq:06}.{SEGMENT_EXT}")
+}
+
+pub fn symbol_file_name(seq: u32) -> String {
+    format!("events-{seq:06}.{SYMBOL_EXT}")
+}
+
+pub fn file_header(magic: [u8; 4], seq: u32) -> [u8; FILE_HEADER_LEN] {
+    let mut out = [0u8; FILE_HEADER_LEN];
+    out[0..4].copy_from_slice(&magic);
+    out[4..6].copy_from_slice(&FORMAT_VERSION.to_le_bytes());
+    out[8..12].copy_from_slice(&seq.to_le_bytes());
+    out
+}
+
+/// Append one length-prefixed record to `buf`.
+pub fn encode_record(buf: &mut Vec<u8>, event: &CaptureEvent, app_sym: u32, title_sym: u32) {
+    buf.extend_from_slice(&(RECORD_BODY_LEN as u16).to_le_bytes());
+    buf.extend_from_slice(&event.timestamp_us.to_le_bytes());
+    buf.push(event.event_type as u8);
+    buf.extend_from_slice(&app_sym.to_le_bytes());
+    buf.extend_from_slice(&title_sym.to_le_bytes());
+    buf.extend_from_slice(&event.mouse_x.to_le_bytes());
+    buf.extend_from_slice(&event.mouse_y.to_le_bytes());
+    buf.extend_from_slice(&event.mouse_speed.to_le_bytes());
+    buf.extend_from_slice(&event.idle_duration_ms.to_le_bytes());
+    buf.extend_from_slice(&event.title_churn.to_le_bytes());
+}
+
+/// Fixed part of a decoded record; strings are still symbol ids.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct RawRecord {
+    pub timestamp_us: i64,
+    pub event_type: EventType,
+    pub app_sym: u32,
+    pub title_sym: u32,
+    pub mouse_x: i32,
+    pub mouse_y: i32,
+    pub mouse_speed: u32,
+    pub idle_duration_ms: u32,
+    pub title_churn: u32,
+}
+
+/// Decode a record body. `None` if it is shorter than v1 or has an unknown type.
+pub fn decode_record(body: &[u8]) -> Option<RawRecord> {
+    if body.len() < RECORD_BODY_LEN {
+        return None;
+    }
+    let u32_at = |at: usize| u32::from_le_bytes(body[at..at + 4].try_into().unwrap());
+    Some(RawRecord {
+        timestamp_us: i64::from_le_bytes(body[0..8].try_into().unwrap()),
+        event_type: EventType::from_u8(body[8])?,
+        app_sym: u32_at(9),
+        title_sym: u32_at(13),
+        mouse_x: u32_at(17) as i32,
+        mouse_y: u32_at(21) as i32,
+        mouse_speed: u32_at(25),
+        idle_duration_ms: u32_at(29),
+        title_churn: u32_at(33),
+    })
+}
+
+const CRC32_TABLE: [u32; 256] = {
+    let mut table = [0u32; 256];
+    let mut i = 0;
+    while i < 256 {
+        let mut c = i as u32;
+        let mut k = 0;
+        while k < 8 {
+            c = if c & 1 != 0 {
+                0xEDB8_8320 ^ (c >> 1)
+            } else {
+                c >> 1
+            };
+            k += 1;
+        }
+        table[i] = c;
+        i += 1;
+    }
+    table
+};
+
+/// CRC-32 (IEEE), the same checksum as Python's `zlib.crc32`.
+pub fn crc32(data: &[u8]) -> u32 {
+    let mut crc = !0u32;
+    for &b in data {
+        crc = CRC32_TABLE[((crc ^ b as u32) & 0xFF) as usize] ^ (crc >> 8);
+    }
+    !crc
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn crc32_matches_reference_vector() {
+        assert_eq!(crc32(b"123456789"), 0xCBF4_3926);
+        assert_eq!(crc32(b""), 0);
+    }
+
+    #[test]
+    fn record_roundtrip() {
+        let event = CaptureEvent {
+            event_type: EventType::MouseMove,
+            timestamp_us: 1_700_000_000_250_000,
+            app_name: String::new(),
+            window_title: String::new(),
+            mouse_x: -20,
+            mouse_y: 640,
+            mouse_speed: 12,
+            idle_duration_ms: 0,
+            title_churn: 3,
+        };
+        let mut buf = Vec::new();
+        encode_record(&mut buf, &event, 7, 9);
+        assert_eq!(buf.len(), 2 + RECORD_BODY_LEN);
+
+        let raw = decode_record(&buf[2..]).unwrap();
+        assert_eq!(raw.timestamp_us, 1_700_000_000_250_000);
+        assert_eq!(raw.event_type, EventType::MouseMove);
+        assert_eq!((raw.app_sym, raw.title_sym), (7, 9));
+        assert_eq!((raw.mouse_x, raw.mouse_y), (-20, 640));
+        assert_eq!(raw.title_churn, 3);
+    }
+}
@@ -0,0 +1,33 @@
+//! Append-only journal of raw capture events, for retraining and for replaying
+//! the exact input behind a misclassification.
+
+use std::io::Write;
+use std::path::Path;
+
+pub mod format;
+pub mod reader;
+pub mod writer;
+
+pub use reader::{segment_paths, JournalError, JournalSegment};
+pub use writer::{JournalConfig, JournalWriter};
+
+/// Write every event under `path` to `out` as JSON lines. A damaged segment is
+/// reported on stderr and the dump carries on with the next one.
+pub fn dump(path: &Path, out: &mut impl Write) -> Result<u64, JournalError> {
+    let mut count = 0;
+    for segment_path in segment_paths(path)? {
+        let segment = JournalSegment::open(&segment_path)?;
+        for event in segment.events() {
+            match event {
+                Ok(event) => {
+                    let line = serde_json::to_string(&event.to_capture_event())
+                        .map_err(std::io::Error::from)?;
+                    writeln!(out, "{line}")?;
+                    count += 1;
+                }
+                Err(err) => eprintln!("{}: {err}", segment_path.display()),
+            }
+        }
+    }
+    Ok(count)
+}
@@ -0,0 +1,260 @@
+use std::io;
+use std::path::{Path, PathBuf};
+
+use thiserror::Error;
+
+use crate::journal::format::{
+    crc32, decode_record, BLOCK_HEADER_LEN, FILE_HEADER_LEN, FORMAT_VERSION, SEGMENT_EXT,
+    SEGMENT_MAGIC, SYMBOL_EXT, SYMBOL_MAGIC,
+};
+use crate::types::{CaptureEvent, EventType};
+
+#[derive(Debug, Error)]
+pub enum JournalError {
+    #[error("journal io error: {0}")]
+    Io(#[from] io::Error),
+    #[error("not a journal file: {0}")]
+    BadMagic(PathBuf),
+    #[error("unsupported journal version {0}")]
+    UnsupportedVersion(u16),
+    #[error("checksum mismatch in block at byte {0}")]
+    Checksum(usize),
+    #[error("truncated block at byte {0}")]
+    Truncated(usize),
+    #[error("malformed record at byte {0}")]
+    BadRecord(usize),
+    #[error("unknown symbol id {0}")]
+    UnknownSymbol(u32),
+}
+
+/// One decoded record. Strings borrow from the segment's symbol table.
+#[derive(Debug, Clone, Copy)]
+pub struct JournalEvent<'a> {
+    pub timestamp_us: i64,
+    pub event_type: EventType,
+    pub app_name: &'a str,
+    pub window_title: &'a str,
+    pub mouse_x: i32,
+    pub mouse_y: i32,
+    pub mouse_speed: u32,
+    pub idle_duration_ms: u32,
+    pub title_churn: u32,
+}
+
+impl JournalEvent<'_> {
+    pub fn to_capture_event(&self) -> CaptureEvent {
+        CaptureEvent {
+            event_type: self.event_type,
+            timestamp_us: self.timestamp_us,
+            app_name: self.app_name.to_string(),
+            window_title: self.window_title.to_string(),
+            mouse_x: self.mouse_x,
+            mouse_y: self.mouse_y,
+            mouse_speed: self.mouse_speed,
+            idle_duration_ms: self.idle_duration_ms,
+            title_churn: self.title_churn,
+        }
+    }
+}
+
+/// A whole segment loaded into memory; records are decoded in place.
+pub struct JournalSegment {
+    data: Vec<u8>,
+    symbols: Vec<String>,
+}
+
+impl JournalSegment {
+    pub fn open(path: &Path) -> Result<Self, JournalError> {
+        let data = std::fs::read(path)?;
+        check_header(path, &data, SEGMENT_MAGIC)?;
+        let symbols = read_symbols(&path.with_extension(SYMBOL_EXT))?;
+        Ok(Self { data, symbols })
+    }
+
+    /// Records in write order. A torn tail block (crash mid-write) or a bad
+    /// checksum yields one error and ends the iteration.
+    pub fn events(&self) -> JournalEvents<'_> {
+        JournalEvents {
+            segment: self,
+            offset: FILE_HEADER_LEN,
+            block_end: FILE_HEADER_LEN,
+            done: false,
+        }
+    }
+
+    fn symbol(&self, id: u32) -> Result<&str, JournalError> {
+        self.symbols
+            .get(id as usize)
+            .map(String::as_str)
+            .ok_or(JournalError::UnknownSymbol(id))
+    }
+}
+
+pub struct JournalEvents<'a> {
+    segment: &'a JournalSegment,
+    offset: usize,
+    block_end: usize,
+    done: bool,
+}
+
+impl<'a> JournalEvents<'a> {
+    fn enter_block(&mut self) -> Result<(), JournalError> {
+        let data = &self.segment.data;
+        let at = self.offset;
+        if data.len() - at < BLOCK_HEADER_LEN {
+            return Err(JournalError::Truncated(at));
+        }
+        let u32_at = |i: usize| u32::from_le_bytes(data[i..i + 4].try_into().unwrap());
+        let payload_len = u32_at(at) as usize;
+        let crc = u32_at(at + 8);
+        let start = at + BLOCK_HEADER_LEN;
+        if data.len() - start < payload_len {
+            return Err(JournalError::Truncated(at));
+        }
+        if crc32(&data[start..start + payload_len]) != crc {
+            return Err(JournalError::Checksum(at));
+        }
+        self.offset = start;
+        self.block_end = start + payload_len;
+        Ok(())
+    }
+
+    fn next_record(&mut self) -> Result<JournalEvent<'a>, JournalError> {
+        let data = &self.segment.data[..self.block_end];
+        let at = self.offset;
+        if data.len() - at < 2 {
+            return Err(JournalError::BadRecord(at));
+        }
+        let len = u16::from_le_bytes([data[at], data[at + 1]]) as usize;
+        let body = data
+            .get(at + 2..at + 2 + len)
+            .ok_or(JournalError::BadRecord(at))?;
+        let raw = decode_record(body).ok_or(JournalError::BadRecord(at))?;
+        self.offset = at + 2 + len;
+
+        Ok(JournalEvent {
+            timestamp_us: raw.timestamp_us,
+            event_type: raw.event_type,
+            app_name: self.segment.symbol(raw.app_sym)?,
+            window_title: self.segment.symbol(raw.title_sym)?,
+            mouse_x: raw.mouse_x,
+            mouse_y: raw.mouse_y,
+            mouse_speed: raw.mouse_speed,
+            idle_duration_ms: raw.idle_duration_ms,
+            title_churn: raw.title_churn,
+        })
+    }
+}
+
+impl<'a> Iterator for JournalEvents<'a> {
+    type Item = Result<JournalEvent<'a>, JournalError>;
+
+    fn next(&mut self) -> Option<Self::Item> {
+        if self.done {
+            return None;
+        }
+        if self.offset >= self.block_end {
+            if self.offset >= self.segment.data.len() {
+                return None;
+            }
+            if let Err(err) = self.enter_block() {
+                self.done = true;
+                return Some(Err(err));
+            }
+        }
+        let result = self.next_record();
+        if result.is_err() {
+            self.done = true;
+        }
+        Some(result)
+    }
+}
+
+/// Segment files under `path` in sequence order, or `path` itself if it is a file.
+pub fn segment_paths(path: &Path) -> Result<Vec<PathBuf>, JournalError> {
+    if path.is_file() {
+        return Ok(vec![path.to_path_buf()]);
+    }
+    let mut paths = Vec::new();
+    for entry in std::fs::read_dir(path)? {
+        let path = entry?.path();
+        if path.extension().and_then(|e| e.to_str()) == Some(SEGMENT_EXT) {
+            paths.push(path);
+        }
+    }
+    paths.sort();
+    Ok(paths)
+}
+
+fn check_header(path: &Path, data: &[u8], magic: [u8; 4]) -> Result<(), JournalError> {
+    if data.len() < FILE_HEADER_LEN || data[0..4] != magic {
+        return Err(JournalError::BadMagic(path.to_path_buf()));
+    }
+    let version = u16::from_le_bytes([data[4], data[5]]);
+    if version != FORMAT_VERSION {
+        return Err(JournalError::UnsupportedVersion(version));
+    }
+    Ok(())
+}
+
+/// Ids are dense and written in order, so the table is a plain vector. A torn
+/// tail entry is ignored; no sealed block can reference it.
+fn read_symbols(path: &Path) -> Result<Vec<String>, JournalError> {
+    let data = std::fs::read(path)?;
+    check_header(path, &data, SYMBOL_MAGIC)?;
+
+    let mut symbols = Vec::new();
+    let mut at = FILE_HEADER_LEN;
+    while data.len() - at >= 8 {
+        let id = u32::from_le_bytes(data[at..at + 4].try_into().unwrap());
+        let len = u32::from_le_bytes(data[at + 4..at + 8].try_into().unwrap()) as usize;
+        let Some(bytes) = data.get(at + 8..at + 8 + len) else {
+            break;
+        };
+        if id as usize != symbols.len() {
+            return Err(JournalError::BadRecord(at));
+        }
+        symbols.push(String::from_utf8_lossy(bytes).into_owned());
+        at += 8 + len;
+    }
+    Ok(symbols)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::journal::writer::{JournalConfig, JournalWriter};
+
+    #[test]
+    fn torn_tail_block_is_reported_after_intact_records() {
+        let dir = std::env::temp_dir().join(format!("snapback_journal_{}", uuid::Uuid::new_v4()));
+        {
+            let journal = JournalWriter::spawn(dir.clone(), JournalConfig::default()).unwrap();
+            for i in 0..10 {
+                journal.append(CaptureEvent {
+                    event_type: EventType::MouseClick,
+                    timestamp_us: i as i64 * 1_000_000,
+                    app_name: "Figma".to_string(),
+                    window_title: "Board".to_string(),
+                    mouse_x: i,
+                    mouse_y: 0,
+                    mouse_speed: 0,
+                    idle_duration_ms: 0,
+                    title_churn: 0,
+                });
+            }
+        }
+        let path = segment_paths(&dir).unwrap().remove(0);
+        let mut bytes = std::fs::read(&path).unwrap();
+        let intact = bytes.len();
+        bytes.extend_from_slice(&[200, 0, 0, 0, 1, 0, 0, 0, 0, 0]);
+        std::fs::write(&path, &bytes).unwrap();
+
+        let segment = JournalSegment::open(&path).unwrap();
+        let results: Vec<_> = segment.events().collect();
+        assert_eq!(results.len(), 11);
+        assert_eq!(results[9].as_ref().unwrap().mouse_x, 9);
+        assert!(matches!(results[10], Err(JournalError::Truncated(at)) if at == intact));
+        let _ = std::fs::remove_dir_all(dir);
+    }
+}
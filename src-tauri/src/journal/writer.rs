@@ -0,0 +1,317 @@
+use std::collections::HashMap;
+use std::fs::{File, OpenOptions};
+use std::io::{self, Write};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::mpsc::{self, RecvTimeoutError, SyncSender, TrySendError};
+use std::sync::Arc;
+use std::thread;
+use std::time::{Duration, Instant};
+
+use crate::journal::format::{
+    crc32, encode_record, file_header, segment_file_name, symbol_file_name, BLOCK_HEADER_LEN,
+    FILE_HEADER_LEN, RECORD_BODY_LEN, SEGMENT_EXT, SEGMENT_MAGIC, SYMBOL_MAGIC,
+};
+use crate::types::CaptureEvent;
+
+#[derive(Debug, Clone)]
+pub struct JournalConfig {
+    /// Seal a block once its payload reaches this size.
+    pub block_bytes: usize,
+    /// Seal a partial block after this long, bounding loss on a crash.
+    pub flush_interval: Duration,
+    /// Start a new segment once the current one passes this size.
+    pub segment_bytes: u64,
+    /// Events queued for the writer thread before new ones are dropped.
+    pub queue_capacity: usize,
+}
+
+impl Default for JournalConfig {
+    fn default() -> Self {
+        Self {
+            block_bytes: 64 * 1024,
+            flush_interval: Duration::from_secs(1),
+            segment_bytes: 64 * 1024 * 1024,
+            queue_capacity: 16_384,
+        }
+    }
+}
+
+/// Handle to the journal thread. `append` never blocks: if the thread falls
+/// behind, events are counted in `dropped` instead of stalling the engine loop.
+pub struct JournalWriter {
+    tx: Option<SyncSender<CaptureEvent>>,
+    dropped: Arc<AtomicU64>,
+    handle: Option<thread::JoinHandle<()>>,
+}
+
+impl JournalWriter {
+    pub fn spawn(dir: PathBuf, config: JournalConfig) -> io::Result<Self> {
+        let mut sink = SegmentSink::open(dir, config.clone())?;
+        let (tx, rx) = mpsc::sync_channel::<CaptureEvent>(config.queue_capacity);
+
+        let handle = thread::spawn(move || {
+            let mut last_flush = Instant::now();
+            loop {
+                let closed = match rx.recv_timeout(config.flush_interval) {
+                    Ok(event) => {
+                        sink.push(&event);
+                        false
+                    }
+                    Err(RecvTimeoutError::Timeout) => false,
+                    Err(RecvTimeoutError::Disconnected) => true,
+                };
+
+                let due = last_flush.elapsed() >= config.flush_interval;
+                if closed || due || sink.block_len() >= config.block_bytes {
+                    if let Err(err) = sink.seal_block() {
+                        log::warn!("journal write failed: {err}");
+                    }
+                    last_flush = Instant::now();
+                }
+                if closed {
+                    break;
+                }
+            }
+        });
+
+        Ok(Self {
+            tx: Some(tx),
+            dropped: Arc::new(AtomicU64::new(0)),
+            handle: Some(handle),
+        })
+    }
+
+    pub fn append(&self, event: CaptureEvent) {
+        let Some(tx) = self.tx.as_ref() else {
+            return;
+        };
+        if let Err(TrySendError::Full(_) | TrySendError::Disconnected(_)) = tx.try_send(event) {
+            self.dropped.fetch_add(1, Ordering::Relaxed);
+        }
+    }
+
+    pub fn dropped(&self) -> u64 {
+        self.dropped.load(Ordering::Relaxed)
+    }
+}
+
+impl Drop for JournalWriter {
+    /// Closing the channel makes the thread seal its last block and exit.
+    fn drop(&mut self) {
+        self.tx.take();
+        if let Some(handle) = self.handle.take() {
+            let _ = handle.join();
+        }
+        if self.dropped() > 0 {
+            log::warn!("journal dropped {} events under backpressure", self.dropped());
+        }
+    }
+}
+
+/// Owns the open segment and its symbol sidecar. Single-threaded; lives on the
+/// journal thread.
+struct SegmentSink {
+    dir: PathBuf,
+    config: JournalConfig,
+    seq: u32,
+    segment: File,
+    symbols: File,
+    segment_len: u64,
+    interned: HashMap<String, u32>,
+    new_symbols: Vec<u8>,
+    block: Vec<u8>,
+    block_records: u32,
+}
+
+impl SegmentSink {
+    fn open(dir: PathBuf, config: JournalConfig) -> io::Result<Self> {
+        std::fs::create_dir_all(&dir)?;
+        let seq = next_segment_seq(&dir)?;
+        let (segment, symbols) = create_segment_files(&dir, seq)?;
+        let block = Vec::with_capacity(config.block_bytes + BLOCK_HEADER_LEN + RECORD_BODY_LEN);
+        Ok(Self {
+            dir,
+            config,
+            seq,
+            segment,
+            symbols,
+            segment_len: FILE_HEADER_LEN as u64,
+            interned: HashMap::new(),
+            new_symbols: Vec::new(),
+            block,
+            block_records: 0,
+        })
+    }
+
+    fn block_len(&self) -> usize {
+        self.block.len().saturating_sub(BLOCK_HEADER_LEN)
+    }
+
+    fn push(&mut self, event: &CaptureEvent) {
+        if self.block.is_empty() {
+            self.block.resize(BLOCK_HEADER_LEN, 0);
+        }
+        let app = self.intern(&event.app_name);
+        let title = self.intern(&event.window_title);
+        encode_record(&mut self.block, event, app, title);
+        self.block_records += 1;
+    }
+
+    fn intern(&mut self, value: &str) -> u32 {
+        if let Some(&id) = self.interned.get(value) {
+            return id;
+        }
+        let id = self.interned.len() as u32;
+        self.new_symbols.extend_from_slice(&id.to_le_bytes());
+        self.new_symbols
+            .extend_from_slice(&(value.len() as u32).to_le_bytes());
+        self.new_symbols.extend_from_slice(value.as_bytes());
+        self.interned.insert(value.to_string(), id);
+        id
+    }
+
+    /// Write the pending block. Symbols go first so every durable record can
+    /// be resolved. Rotation happens only between blocks, since a block's
+    /// symbol ids belong to its segment.
+    fn seal_block(&mut self) -> io::Result<()> {
+        if self.block_records == 0 {
+            return Ok(());
+        }
+
+        let payload_len = (self.block.len() - BLOCK_HEADER_LEN) as u32;
+        let crc = crc32(&self.block[BLOCK_HEADER_LEN..]);
+        self.block[0..4].copy_from_slice(&payload_len.to_le_bytes());
+        self.block[4..8].copy_from_slice(&self.block_records.to_le_bytes());
+        self.block[8..12].copy_from_slice(&crc.to_le_bytes());
+
+        let result = self.write_block();
+        let written = self.block.len() as u64;
+        self.block.clear();
+        self.block_records = 0;
+        if let Err(err) = result {
+            // The sidecar may now disagree with the interner; start clean.
+            self.new_symbols.clear();
+            let _ = self.rotate();
+            return Err(err);
+        }
+
+        self.segment_len += written;
+        if self.segment_len >= self.config.segment_bytes {
+            self.rotate()?;
+        }
+        Ok(())
+    }
+
+    fn write_block(&mut self) -> io::Result<()> {
+        if !self.new_symbols.is_empty() {
+            self.symbols.write_all(&self.new_symbols)?;
+            self.new_symbols.clear();
+        }
+        self.segment.write_all(&self.block)
+    }
+
+    fn rotate(&mut self) -> io::Result<()> {
+        self.seq += 1;
+        let (segment, symbols) = create_segment_files(&self.dir, self.seq)?;
+        self.segment = segment;
+        self.symbols = symbols;
+        self.segment_len = FILE_HEADER_LEN as u64;
+        self.interned.clear();
+        Ok(())
+    }
+}
+
+fn create_segment_files(dir: &Path, seq: u32) -> io::Result<(File, File)> {
+    let open = |name: String| {
+        OpenOptions::new()
+            .create_new(true)
+            .append(true)
+            .open(dir.join(name))
+    };
+    let mut symbols = open(symbol_file_name(seq))?;
+    symbols.write_all(&file_header(SYMBOL_MAGIC, seq))?;
+    let mut segment = open(segment_file_name(seq))?;
+    segment.write_all(&file_header(SEGMENT_MAGIC, seq))?;
+    Ok((segment, symbols))
+}
+
+/// Each run starts a fresh segment after the highest one already on disk.
+fn next_segment_seq(dir: &Path) -> io::Result<u32> {
+    let mut max_seq = 0;
+    for entry in std::fs::read_dir(dir)? {
+        let path = entry?.path();
+        if path.extension().and_then(|e| e.to_str()) != Some(SEGMENT_EXT) {
+            continue;
+        }
+        let seq = path
+            .file_stem()
+            .and_then(|s| s.to_str())
+            .and_then(|s| s.strip_prefix("events-"))
+            .and_then(|s| s.parse::<u32>().ok());
+        if let Some(seq) = seq {
+            max_seq = max_seq.max(seq);
+        }
+    }
+    Ok(max_seq + 1)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::journal::reader::{segment_paths, JournalSegment};
+    use crate::types::EventType;
+
+    fn key_event(i: u32, app: &str, title: &str) -> CaptureEvent {
+        CaptureEvent {
+            event_type: EventType::KeyPress,
+            timestamp_us: 1_700_000_000_000_000 + i as i64 * 100_000,
+            app_name: app.to_string(),
+            window_title: title.to_string(),
+            mouse_x: 0,
+            mouse_y: 0,
+            mouse_speed: 0,
+            idle_duration_ms: 0,
+            title_churn: 0,
+        }
+    }
+
+    #[test]
+    fn rotates_segments_and_reads_back_in_order() {
+        let dir = std::env::temp_dir().join(format!("snapback_journal_{}", uuid::Uuid::new_v4()));
+        let config = JournalConfig {
+            block_bytes: 512,
+            segment_bytes: 2_048,
+            ..JournalConfig::default()
+        };
+        {
+            let journal = JournalWriter::spawn(dir.clone(), config).unwrap();
+            for i in 0..400 {
+                let app = if i % 2 == 0 { "Code" } else { "Terminal" };
+                journal.append(key_event(i, app, &format!("file{}.rs", i % 5)));
+            }
+            assert_eq!(journal.dropped(), 0);
+        }
+
+        let paths = segment_paths(&dir).unwrap();
+        assert!(paths.len() > 1, "expected rotation, got {paths:?}");
+
+        let mut seen = 0u32;
+        for path in paths {
+            let segment = JournalSegment::open(&path).unwrap();
+            for event in segment.events() {
+                let event = event.unwrap();
+                let expected = key_event(seen, "", "");
+                assert_eq!(event.timestamp_us, expected.timestamp_us);
+                assert_eq!(
+                    event.app_name,
+                    if seen % 2 == 0 { "Code" } else { "Terminal" }
+                );
+                assert_eq!(event.window_title, format!("file{}.rs", seen % 5));
+                seen += 1;
+            }
+        }
+        assert_eq!(seen, 400);
+        let _ = std::fs::remove_dir_all(dir);
+    }
+}
@@ -1,7 +1,11 @@
 mod capture;
 mod bench;
+mod clock;
 mod commands;
 mod engine;
+mod journal;
+mod pipeline;
+mod replay;
 mod snapback;
 mod state;
 mod storage;
@@ -22,6 +26,31 @@ pub fn run_from_cli(args: Vec<String>) -> i32 {
         return bench::run_benchmark(bench_args);
     }
 
+    if args.iter().any(|a| a == "--replay") {
+        return match replay::parse_replay_args(&args) {
+            Ok(replay_args) => replay::run_replay(replay_args),
+            Err(err) => {
+                eprintln!("{err}");
+                2
+            }
+        };
+    }
+
+    if let Some(pos) = args.iter().position(|a| a == "--journal-dump") {
+        let Some(path) = args.get(pos + 1) else {
+            eprintln!("--journal-dump requires a journal directory or segment file");
+            return 2;
+        };
+        let mut out = std::io::stdout().lock();
+        return match journal::dump(std::path::Path::new(path), &mut out) {
+            Ok(_) => 0,
+            Err(err) => {
+                eprintln!("journal dump failed: {err}");
+                1
+            }
+        };
+    }
+
     run();
     0
 }
@@ -41,8 +70,12 @@ pub fn run() {
                 .path()
                 .app_data_dir()
                 .expect("failed to resolve app data dir");
-            let storage = Storage::open(app_data_dir).expect("failed to open storage");
-            let app_state = AppState::new(storage);
+            let clock = clock::system_clock();
+            let storage = Storage::open_with_clock(app_data_dir.clone(), clock.clone())
+                .expect("failed to open storage");
+            #[cfg(feature = "onnx")]
+            engine::onnx_model::init(&app_data_dir);
+            let app_state = AppState::new(storage, app_data_dir, clock);
             app.manage(app_state);
 
             let handle = app.handle().clone();
@@ -63,6 +96,7 @@ pub fn run() {
             commands::submit_label,
             commands::get_session_recap,
             commands::set_focus_mode,
+            commands::set_capture_paused,
             commands::dismiss_snapback,
             commands::send_test_prediction,
             commands::refresh_permissions,
@@ -0,0 +1,90 @@
+//! Event → features → prediction → context tracking. Shared by the live engine
+//! loop and `--replay`, so both see exactly the same decisions.
+
+use std::sync::Arc;
+
+use crate::clock::Clock;
+use crate::engine::forecast::{DistractionForecast, DistractionForecaster};
+use crate::engine::smoothing::StateFilter;
+use crate::engine::{Classifier, FeatureExtractor, FeatureVector, PredictionScores};
+use crate::snapback::{ContextTracker, SnapbackEvent};
+use crate::types::{AppRuleRecord, CaptureEvent, EventType};
+
+/// Minimum spacing between predictions, in event time.
+const PREDICTION_INTERVAL_US: i64 = 1_000_000;
+
+pub struct EnginePipeline {
+    extractor: FeatureExtractor,
+    tracker: ContextTracker,
+    filter: StateFilter,
+    forecaster: DistractionForecaster,
+    forecast: Option<DistractionForecast>,
+    last_prediction_us: i64,
+}
+
+impl EnginePipeline {
+    pub fn new(clock: Arc<dyn Clock>) -> Self {
+        Self {
+            extractor: FeatureExtractor::new(),
+            tracker: ContextTracker::with_clock(clock),
+            filter: StateFilter::default(),
+            forecaster: DistractionForecaster::default(),
+            forecast: None,
+            last_prediction_us: 0,
+        }
+    }
+
+    /// Feed one event. Returns its feature vector when a prediction is due.
+    pub fn observe(
+        &mut self,
+        event: &CaptureEvent,
+        app_rules: &[AppRuleRecord],
+    ) -> Option<FeatureVector> {
+        self.tracker.set_app_rules(app_rules);
+
+        if matches!(
+            event.event_type,
+            EventType::WindowFocusChange | EventType::WindowTitleChange
+        ) {
+            self.tracker
+                .on_window_change(&event.app_name, &event.window_title);
+        } else {
+            self.tracker.on_activity();
+        }
+
+        let features = self.extractor.update(event, app_rules);
+        self.tracker
+            .set_title_churn_rate(features.title_churn_rate_30s);
+        (features.timestamp_us - self.last_prediction_us >= PREDICTION_INTERVAL_US)
+            .then_some(features)
+    }
+
+    /// Score due features, smooth the state over time, forecast from it, and
+    /// feed the result back into momentum and tracking.
+    pub fn score(
+        &mut self,
+        classifier: &Classifier,
+        features: &FeatureVector,
+        session_goal: Option<&str>,
+        app_rules: &[AppRuleRecord],
+    ) -> PredictionScores {
+        let mut scores = classifier.predict(features, session_goal, app_rules);
+        self.filter.smooth(features.timestamp_us, &mut scores);
+        self.forecast = Some(self.forecaster.observe(features.timestamp_us, &scores));
+        self.extractor
+            .update_focus_score(scores.focus_score / 100.0, 0.2);
+        self.tracker
+            .on_prediction_feedback(&scores.focus_state, session_goal);
+        self.last_prediction_us = features.timestamp_us;
+        scores
+    }
+
+    /// The forecast made with the latest scores, once.
+    pub fn take_forecast(&mut self) -> Option<DistractionForecast> {
+        self.forecast.take()
+    }
+
+    pub fn take_pending_snapback(&mut self) -> Option<SnapbackEvent> {
+        self.tracker.take_pending_snapback()
+    }
+}
@@ -0,0 +1,367 @@
+//! `--replay <journal>`: run recorded events through the live pipeline on a
+//! virtual clock, as fast as the CPU allows, and print what the app would have
+//! decided as JSON lines.
+//!
+//! `--heuristics <file>` scores with tuned `HeuristicParams`, and
+//! `--heuristic-inputs-out <csv>` records the heuristic's inputs per
+//! prediction so ml/heuristics.py can tune those parameters against labels
+//! without replaying again.
+
+use std::fs::File;
+use std::io::{self, BufWriter, Write};
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+use std::time::Instant;
+
+use serde::Serialize;
+
+use crate::clock::{us_to_secs, VirtualClock};
+use crate::engine::classifier::HEURISTIC_INPUT_NAMES;
+use crate::engine::forecast;
+use crate::engine::heuristic_params::HeuristicParams;
+use crate::engine::tensor::FEATURE_NAMES;
+use crate::engine::{Classifier, FeatureVector};
+use crate::journal::{segment_paths, JournalError, JournalSegment};
+use crate::pipeline::EnginePipeline;
+use crate::types::FocusMode;
+
+#[derive(Debug, Clone)]
+pub struct ReplayArgs {
+    pub journal: PathBuf,
+    pub out: Option<PathBuf>,
+    pub goal: Option<String>,
+    pub focus_mode: FocusMode,
+    /// Also write each prediction's feature tensor as a CSV row, in the
+    /// training pipeline's column order.
+    pub features_out: Option<PathBuf>,
+    pub heuristics: HeuristicParams,
+    pub heuristic_inputs_out: Option<PathBuf>,
+}
+
+pub fn parse_replay_args(args: &[String]) -> Result<ReplayArgs, String> {
+    let value_of = |flag: &str| {
+        args.iter()
+            .position(|a| a == flag)
+            .and_then(|idx| args.get(idx + 1))
+            .cloned()
+    };
+    let journal =
+        value_of("--replay").ok_or("--replay requires a journal directory or segment file")?;
+    let heuristics = match value_of("--heuristics") {
+        Some(path) => {
+            HeuristicParams::load(Path::new(&path)).map_err(|err| format!("{path}: {err}"))?
+        }
+        None => HeuristicParams::default(),
+    };
+    Ok(ReplayArgs {
+        journal: PathBuf::from(journal),
+        out: value_of("--out").map(PathBuf::from),
+        goal: value_of("--goal"),
+        focus_mode: value_of("--focus-mode")
+            .map(|m| FocusMode::from_str(&m))
+            .unwrap_or(FocusMode::Normal),
+        features_out: value_of("--features-out").map(PathBuf::from),
+        heuristics,
+        heuristic_inputs_out: value_of("--heuristic-inputs-out").map(PathBuf::from),
+    })
+}
+
+/// One line of replay output.
+#[derive(Debug, Serialize)]
+#[serde(tag = "kind", rename_all = "snake_case")]
+pub enum ReplayRecord<'a> {
+    Prediction {
+        timestamp_us: i64,
+        app_name: &'a str,
+        focus_score: f64,
+        distraction_risk: f64,
+        focus_state: &'a str,
+        smoothed_state: &'a str,
+        thrash_score: f64,
+        drift_score: f64,
+        goal_alignment: f64,
+        /// Chance of a distraction within each of `forecast::HORIZONS_SECS`.
+        distraction_forecast: [f64; forecast::HORIZONS],
+    },
+    Snapback {
+        timestamp_us: i64,
+        summary: &'a str,
+        app_name: &'a str,
+        window_title: &'a str,
+        file_hint: &'a str,
+        distraction_duration_secs: u32,
+    },
+}
+
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
+pub struct ReplaySummary {
+    pub events: u64,
+    pub predictions: u64,
+    pub snapbacks: u64,
+    pub damaged_segments: u64,
+}
+
+pub fn run_replay(args: ReplayArgs) -> i32 {
+    let started = Instant::now();
+    let result = match args.out.as_deref() {
+        Some(path) => match File::create(path) {
+            Ok(file) => replay_journal(&args, &mut BufWriter::new(file)),
+            Err(err) => {
+                eprintln!("cannot create {}: {err}", path.display());
+                return 1;
+            }
+        },
+        None => replay_journal(&args, &mut BufWriter::new(io::stdout().lock())),
+    };
+
+    match result {
+        Ok(summary) => {
+            eprintln!(
+                "replay events={} predictions={} snapbacks={} damaged_segments={} elapsed_ms={}",
+                summary.events,
+                summary.predictions,
+                summary.snapbacks,
+                summary.damaged_segments,
+                started.elapsed().as_millis()
+            );
+            0
+        }
+        Err(err) => {
+            eprintln!("replay failed: {err}");
+            1
+        }
+    }
+}
+
+pub fn replay_journal(
+    args: &ReplayArgs,
+    out: &mut impl Write,
+) -> Result<ReplaySummary, JournalError> {
+    let clock = Arc::new(VirtualClock::new(0));
+    let mut pipeline = EnginePipeline::new(clock.clone());
+    let mut classifier = Classifier::new(args.focus_mode);
+    classifier.set_heuristic_params(args.heuristics);
+    let goal = args.goal.as_deref();
+    let mut summary = ReplaySummary::default();
+    let mut feature_csv = match args.features_out.as_deref() {
+        Some(path) => {
+            let mut csv = BufWriter::new(File::create(path)?);
+            writeln!(
+                csv,
+                "timestamp,app_name,productivity_category,{}",
+                FEATURE_NAMES.join(",")
+            )?;
+            Some(csv)
+        }
+        None => None,
+    };
+    let mut inputs_csv = match args.heuristic_inputs_out.as_deref() {
+        Some(path) => {
+            let mut csv = BufWriter::new(File::create(path)?);
+            writeln!(csv, "timestamp,{}", HEURISTIC_INPUT_NAMES.join(","))?;
+            Some(csv)
+        }
+        None => None,
+    };
+
+    for path in segment_paths(&args.journal)? {
+        let segment = JournalSegment::open(&path)?;
+        for event in segment.events() {
+            let event = match event {
+                Ok(event) => event,
+                Err(err) => {
+                    eprintln!("{}: {err}", path.display());
+                    summary.damaged_segments += 1;
+                    break;
+                }
+            };
+            clock.set_us(event.timestamp_us);
+            summary.events += 1;
+
+            let capture = event.to_capture_event();
+            if let Some(features) = pipeline.observe(&capture, &[]) {
+                let scores = pipeline.score(&classifier, &features, goal, &[]);
+                let forecast = pipeline.take_forecast().map(|f| f.probability);
+                if let Some(csv) = feature_csv.as_mut() {
+                    write_feature_row(csv, &features)?;
+                }
+                if let Some(csv) = inputs_csv.as_mut() {
+                    let inputs = classifier.heuristic_inputs(&features, goal, &[]);
+                    write!(csv, "{}", us_to_secs(features.timestamp_us))?;
+                    for value in inputs {
+                        write!(csv, ",{value}")?;
+                    }
+                    csv.write_all(b"\n")?;
+                }
+                write_record(
+                    out,
+                    &ReplayRecord::Prediction {
+                        timestamp_us: event.timestamp_us,
+                        app_name: &features.context.app_name,
+                        focus_score: scores.focus_score,
+                        distraction_risk: scores.distraction_risk,
+                        focus_state: &scores.focus_state,
+                        smoothed_state: &scores.smoothed_state,
+                        thrash_score: scores.thrash_score,
+                        drift_score: scores.drift_score,
+                        goal_alignment: scores.goal_alignment,
+                        distraction_forecast: forecast.unwrap_or_default(),
+                    },
+                )?;
+                summary.predictions += 1;
+            }
+
+            if let Some(snapback) = pipeline.take_pending_snapback() {
+                write_record(
+                    out,
+                    &ReplayRecord::Snapback {
+                        timestamp_us: event.timestamp_us,
+                        summary: &snapback.summary,
+                        app_name: &snapback.app_name,
+                        window_title: &snapback.window_title,
+                        file_hint: &snapback.file_hint,
+                        distraction_duration_secs: snapback.distraction_duration_secs,
+                    },
+                )?;
+                summary.snapbacks += 1;
+            }
+        }
+    }
+
+    out.flush()?;
+    if let Some(csv) = feature_csv.as_mut() {
+        csv.flush()?;
+    }
+    if let Some(csv) = inputs_csv.as_mut() {
+        csv.flush()?;
+    }
+    Ok(summary)
+}
+
+fn write_feature_row(out: &mut impl Write, features: &FeatureVector) -> io::Result<()> {
+    let app = features.context.app_name.replace('"', "\"\"");
+    write!(
+        out,
+        "{},\"{}\",{}",
+        us_to_secs(features.timestamp_us),
+        app,
+        features.context.productivity_category
+    )?;
+    for value in features.tensor().as_slice() {
+        write!(out, ",{value}")?;
+    }
+    out.write_all(b"\n")
+}
+
+fn write_record(out: &mut impl Write, record: &ReplayRecord) -> io::Result<()> {
+    serde_json::to_writer(&mut *out, record)?;
+    out.write_all(b"\n")
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::journal::{JournalConfig, JournalWriter};
+    use crate::types::{CaptureEvent, EventType};
+
+    fn event(event_type: EventType, secs: i64, app: &str, title: &str) -> CaptureEvent {
+        CaptureEvent {
+            event_type,
+            timestamp_us: secs * 1_000_000,
+            app_name: app.to_string(),
+            window_title: title.to_string(),
+            mouse_x: 0,
+            mouse_y: 0,
+            mouse_speed: 0,
+            idle_duration_ms: 0,
+            title_churn: 0,
+        }
+    }
+
+    /// Ten minutes of coding, five of YouTube, then back: the recording spans
+    /// fifteen minutes but replays instantly, and must replay identically.
+    #[test]
+    fn replay_is_deterministic_and_uses_event_time() {
+        let dir = std::env::temp_dir().join(format!("snapback_replay_{}", uuid::Uuid::new_v4()));
+        {
+            let journal = JournalWriter::spawn(dir.clone(), JournalConfig::default()).unwrap();
+            let t0 = 1_700_000_000;
+            journal.append(event(
+                EventType::WindowFocusChange,
+                t0,
+                "Cursor",
+                "main.rs — snapback",
+            ));
+            for i in 1..600 {
+                journal.append(event(
+                    EventType::KeyPress,
+                    t0 + i,
+                    "Cursor",
+                    "main.rs — snapback",
+                ));
+            }
+            journal.append(event(
+                EventType::WindowFocusChange,
+                t0 + 600,
+                "Google Chrome",
+                "Cats - YouTube",
+            ));
+            for i in 1..300 {
+                journal.append(event(
+                    EventType::MouseMove,
+                    t0 + 600 + i,
+                    "Google Chrome",
+                    "Cats - YouTube",
+                ));
+            }
+            journal.append(event(
+                EventType::WindowFocusChange,
+                t0 + 900,
+                "Cursor",
+                "main.rs — snapback",
+            ));
+        }
+
+        let args = ReplayArgs {
+            journal: dir.clone(),
+            out: None,
+            goal: None,
+            focus_mode: FocusMode::Normal,
+            features_out: None,
+            heuristics: HeuristicParams::default(),
+            heuristic_inputs_out: None,
+        };
+        let mut first = Vec::new();
+        let summary = replay_journal(&args, &mut first).unwrap();
+        let mut second = Vec::new();
+        replay_journal(&args, &mut second).unwrap();
+
+        assert_eq!(first, second);
+        assert_eq!(summary.events, 901);
+        assert!(summary.predictions > 800);
+        assert_eq!(summary.snapbacks, 1);
+
+        let inputs_path = dir.join("heuristic_inputs.csv");
+        let traced = ReplayArgs {
+            heuristic_inputs_out: Some(inputs_path.clone()),
+            ..args.clone()
+        };
+        let mut third = Vec::new();
+        replay_journal(&traced, &mut third).unwrap();
+        assert_eq!(first, third);
+        let inputs = std::fs::read_to_string(&inputs_path).unwrap();
+        assert!(inputs.starts_with("timestamp,context_switches_30s,"));
+        assert_eq!(inputs.lines().count() as u64, summary.predictions + 1);
+
+        let text = String::from_utf8(first).unwrap();
+        let snapback = text
+            .lines()
+            .find(|l| l.contains("\"kind\":\"snapback\""))
+            .unwrap();
+        assert!(
+            snapback.contains("\"distraction_duration_secs\":300"),
+            "{snapback}"
+        );
+        let _ = std::fs::remove_dir_all(dir);
+    }
+}
@@ -1,5 +1,4 @@
-use std::time::{Instant, SystemTime, UNIX_EPOCH};
-
+use crate::clock::{format_rfc3339, system_clock, SharedClock};
 use crate::engine::app_context::{classify, snapback_on_task};
 use crate::snapback::title_parser::{parse_window_title, ParsedTitle};
 use crate::types::{AppRuleRecord, ContextSnapshotDto};
@@ -25,17 +24,19 @@ struct ContextSnapshot {
     app_name: String,
     window_title: String,
     parsed: ParsedTitle,
-    timestamp: String,
+    timestamp_us: i64,
 }
 
 pub struct ContextTracker {
+    clock: SharedClock,
     state: DistractionState,
     current: ContextSnapshot,
     last_focus_snapshot: Option<ContextSnapshot>,
-    distraction_started: Option<Instant>,
+    /// Clock readings in microseconds.
+    distraction_started_us: Option<i64>,
     distraction_app: String,
-    focus_started: Instant,
-    last_snapshot_at: Instant,
+    focus_started_us: i64,
+    last_snapshot_at_us: i64,
     snapshot_interval_ms: u64,
     min_distraction_ms: u64,
     pending_snapback: Option<SnapbackEvent>,
@@ -43,24 +44,39 @@ pub struct ContextTracker {
     latest_focus_state: Option<String>,
     latest_session_goal: Option<String>,
     latest_app_rules: Vec<AppRuleRecord>,
+    /// Title rewrites per minute from the feature engine; high churn means a
+    /// title-only change is transient (progress bar, build status), not worth saving.
+    title_churn_rate: f64,
+    current_is_transient: bool,
 }
 
+/// Above this rate a title-only change does not refresh the saved focus snapshot.
+const TITLE_CHURN_SNAPSHOT_LIMIT: f64 = 6.0;
+
 impl ContextTracker {
     pub fn new() -> Self {
+        Self::with_clock(system_clock())
+    }
+
+    pub fn with_clock(clock: SharedClock) -> Self {
+        let now = clock.now_us();
         Self {
+            clock,
             state: DistractionState::Focused,
-            current: empty_snapshot(),
+            current: empty_snapshot(now),
             last_focus_snapshot: None,
-            distraction_started: None,
+            distraction_started_us: None,
             distraction_app: String::new(),
-            focus_started: Instant::now(),
-            last_snapshot_at: Instant::now(),
+            focus_started_us: now,
+            last_snapshot_at_us: now,
             snapshot_interval_ms: 30_000,
             min_distraction_ms: 30_000,
             pending_snapback: None,
             latest_focus_state: None,
             latest_session_goal: None,
             latest_app_rules: Vec::new(),
+            title_churn_rate: 0.0,
+            current_is_transient: false,
         }
     }
 
@@ -79,6 +95,10 @@ impl ContextTracker {
         self.latest_session_goal = session_goal.map(|g| g.to_string());
     }
 
+    pub fn set_title_churn_rate(&mut self, per_minute: f64) {
+        self.title_churn_rate = per_minute;
+    }
+
     pub fn take_pending_snapback(&mut self) -> Option<SnapbackEvent> {
         self.pending_snapback.take()
     }
@@ -86,7 +106,7 @@ impl ContextTracker {
     pub fn dismiss_recovery(&mut self) {
         if self.state == DistractionState::Recovering {
             self.state = DistractionState::Focused;
-            self.focus_started = Instant::now();
+            self.focus_started_us = self.clock.now_us();
         }
     }
 
@@ -95,27 +115,30 @@ impl ContextTracker {
         let was_on_task = self.is_on_task(&self.current.app_name, &self.current.window_title);
         let now_on_task = self.is_on_task(app_name, window_title);
 
-        if self.state == DistractionState::Focused && self.current.is_meaningful() {
+        if self.state == DistractionState::Focused
+            && self.current.is_meaningful()
+            && !self.current_is_transient
+        {
             self.last_focus_snapshot = Some(self.current.clone());
         }
 
         match self.state {
             DistractionState::Focused if was_on_task && !now_on_task => {
                 self.state = DistractionState::Distracted;
-                self.distraction_started = Some(Instant::now());
+                self.distraction_started_us = Some(self.clock.now_us());
                 self.distraction_app = app_name.to_string();
             }
             DistractionState::Distracted if now_on_task => {
                 let duration = self
-                    .distraction_started
-                    .map(|s| s.elapsed().as_millis() as u64)
+                    .distraction_started_us
+                    .map(|s| self.elapsed_ms(s))
                     .unwrap_or(0);
                 if duration >= self.min_distraction_ms {
                     self.state = DistractionState::Recovering;
                     self.pending_snapback = self.build_snapback(duration);
                 } else {
                     self.state = DistractionState::Focused;
-                    self.focus_started = Instant::now();
+                    self.focus_started_us = self.clock.now_us();
                 }
             }
             DistractionState::Recovering if was_on_task && !now_on_task => {
@@ -124,28 +147,30 @@ impl ContextTracker {
             _ => {}
         }
 
+        self.current_is_transient = self.current.app_name == app_name
+            && self.title_churn_rate >= TITLE_CHURN_SNAPSHOT_LIMIT;
         self.current = ContextSnapshot {
             app_name: app_name.to_string(),
             window_title: window_title.to_string(),
             parsed,
-            timestamp: chrono::Utc::now().to_rfc3339(),
+            timestamp_us: self.clock.now_us(),
         };
     }
 
     pub fn on_activity(&mut self) {
         if self.state == DistractionState::Focused
-            && self.last_snapshot_at.elapsed().as_millis() as u64 >= self.snapshot_interval_ms
+            && self.elapsed_ms(self.last_snapshot_at_us) >= self.snapshot_interval_ms
         {
             if self.current.is_meaningful() && self.is_on_task(&self.current.app_name, &self.current.window_title) {
                 self.last_focus_snapshot = Some(self.current.clone());
             }
-            self.last_snapshot_at = Instant::now();
+            self.last_snapshot_at_us = self.clock.now_us();
         }
     }
 
     pub fn focus_duration_secs(&self) -> u64 {
         if self.state == DistractionState::Focused {
-            self.focus_started.elapsed().as_secs()
+            self.elapsed_ms(self.focus_started_us) / 1000
         } else {
             0
         }
@@ -158,10 +183,14 @@ impl ContextTracker {
             file_hint: self.current.parsed.file_hint.clone(),
             project_hint: self.current.parsed.project_hint.clone(),
             summary: self.current.parsed.summary.clone(),
-            timestamp: self.current.timestamp.clone(),
+            timestamp: format_rfc3339(self.current.timestamp_us),
         }
     }
 
+    fn elapsed_ms(&self, since_us: i64) -> u64 {
+        (self.clock.now_us() - since_us).max(0) as u64 / 1000
+    }
+
     fn is_on_task(&self, app_name: &str, window_title: &str) -> bool {
         let ctx = classify(app_name, window_title, &self.latest_app_rules);
         snapback_on_task(
@@ -196,25 +225,19 @@ impl ContextSnapshot {
     }
 }
 
-fn empty_snapshot() -> ContextSnapshot {
+fn empty_snapshot(timestamp_us: i64) -> ContextSnapshot {
     ContextSnapshot {
         app_name: String::new(),
         window_title: String::new(),
         parsed: ParsedTitle::default(),
-        timestamp: chrono::Utc::now().to_rfc3339(),
+        timestamp_us,
     }
 }
 
-#[allow(dead_code)]
-fn now_secs() -> u64 {
-    SystemTime::now()
-        .duration_since(UNIX_EPOCH)
-        .map(|d| d.as_secs())
-        .unwrap_or(0)
-}
-
 #[cfg(test)]
 mod tests {
+    use std::sync::Arc;
+
     use super::*;
 
     #[test]
@@ -240,6 +263,40 @@ mod tests {
         assert!(tracker.take_pending_snapback().is_none());
     }
 
+    #[test]
+    fn distraction_length_follows_the_injected_clock() {
+        let clock = Arc::new(crate::clock::VirtualClock::new(0));
+        let mut tracker = ContextTracker::with_clock(clock.clone());
+        tracker.on_window_change("Cursor", "main.rs");
+        tracker.on_prediction_feedback("DEEP_FOCUS", None);
+        tracker.on_window_change("Google Chrome", "YouTube");
+        clock.advance_us(45_000_000);
+        tracker.on_window_change("Cursor", "main.rs");
+
+        let snapback = tracker
+            .take_pending_snapback()
+            .expect("45s is past the minimum");
+        assert_eq!(snapback.distraction_duration_secs, 45);
+        assert_eq!(tracker.state(), DistractionState::Recovering);
+    }
+
+    #[test]
+    fn churning_titles_keep_the_last_stable_snapshot() {
+        let mut tracker = ContextTracker::new();
+        tracker.min_distraction_ms = 0;
+        tracker.on_prediction_feedback("PRODUCTIVE", None);
+        tracker.on_window_change("Cursor", "main.rs");
+        tracker.on_window_change("Cursor", "lib.rs");
+        tracker.set_title_churn_rate(30.0);
+        tracker.on_window_change("Cursor", "Building 10%");
+        tracker.on_window_change("Cursor", "Building 90%");
+        tracker.on_window_change("Google Chrome", "YouTube");
+        tracker.on_window_change("Cursor", "main.rs");
+
+        let snapback = tracker.take_pending_snapback().expect("snapback after distraction");
+        assert_eq!(snapback.window_title, "lib.rs");
+    }
+
     #[test]
     fn returning_to_slack_while_classifier_distracted_stays_distracted() {
         let mut tracker = ContextTracker::new();
@@ -1,40 +1,79 @@
+use std::path::{Path, PathBuf};
 use std::thread;
 
 use tauri::{AppHandle, Emitter, Manager};
 
-use crate::engine::{check_hyperfocus, Classifier, FeatureExtractor};
-use crate::snapback::ContextTracker;
+use crate::capture::CaptureController;
+use crate::clock::SharedClock;
+use crate::engine::calibration::{self, Calibration};
+use crate::engine::heuristic_params::{self, HeuristicParams};
+use crate::engine::model_registry::{self, ModelRegistry};
+use crate::engine::online_model::OnlineModel;
+use crate::engine::tensor::FeatureTensor;
+use crate::engine::{check_hyperfocus, Classifier};
+use crate::journal::{JournalConfig, JournalWriter};
+use crate::pipeline::EnginePipeline;
 use crate::storage::Storage;
 use crate::types::{
-    AppRuleRecord, CaptureEvent, EventType, FocusMode, PermissionStatus, PredictionRecord,
+    AppRuleRecord, CaptureEvent, FocusLabel, FocusMode, PermissionStatus, PredictionRecord,
     SnapbackPayload,
 };
 
 pub struct AppState {
     pub storage: parking_lot::Mutex<Storage>,
     pub permissions: parking_lot::Mutex<PermissionStatus>,
-    pub capture_running: parking_lot::Mutex<bool>,
+    pub capture: CaptureController,
     pub focus_mode: parking_lot::Mutex<FocusMode>,
     pub classifier: parking_lot::Mutex<Classifier>,
     pub latest_prediction: parking_lot::Mutex<Option<PredictionRecord>>,
+    /// The latest prediction's time, uncalibrated probabilities, inputs and
+    /// calibration source, for learning from a label that describes it.
+    latest_scored: parking_lot::Mutex<Option<(i64, [f64; 4], FeatureTensor, u64)>>,
     pub app_rules: parking_lot::Mutex<Vec<AppRuleRecord>>,
+    pub app_data_dir: PathBuf,
+    pub clock: SharedClock,
     event_rx: parking_lot::Mutex<Option<std::sync::mpsc::Receiver<CaptureEvent>>>,
 }
 
 impl AppState {
-    pub fn new(storage: Storage) -> Self {
+    pub fn new(storage: Storage, app_data_dir: PathBuf, clock: SharedClock) -> Self {
         let permissions = crate::capture::check_permissions();
         let focus_mode = FocusMode::Normal;
         let app_rules = storage.list_app_rules().unwrap_or_default();
+        let (event_tx, event_rx) = std::sync::mpsc::channel();
+        let mut classifier = Classifier::new(focus_mode);
+        classifier.set_heuristic_params(load_heuristic_params(&app_data_dir));
+        #[cfg(feature = "compiled-model")]
+        classifier.set_compiled_model(true);
+        match storage.online_model_state() {
+            Ok(Some(bytes)) => match OnlineModel::from_bytes(&bytes) {
+                Some(online) => classifier.set_online_model(online),
+                None => log::warn!("discarding online model saved for another feature layout"),
+            },
+            Ok(None) => {}
+            Err(err) => log::warn!("online model not loaded: {err}"),
+        }
+        let models = ModelRegistry::open(&app_data_dir);
+        models.spawn_watcher(model_registry::POLL_INTERVAL);
+        classifier.set_model_registry(Some(models));
+        // Only bins learned for whatever serves now apply.
+        let source = classifier.calibration_source();
+        match storage.calibration_bins(source) {
+            Ok(bins) => classifier.set_calibration(Calibration::from_bins(&bins), source),
+            Err(err) => log::warn!("calibration not loaded: {err}"),
+        }
         Self {
             storage: parking_lot::Mutex::new(storage),
             permissions: parking_lot::Mutex::new(permissions),
-            capture_running: parking_lot::Mutex::new(false),
+            capture: CaptureController::new(event_tx, clock.clone()),
             focus_mode: parking_lot::Mutex::new(focus_mode),
-            classifier: parking_lot::Mutex::new(Classifier::new(focus_mode)),
+            classifier: parking_lot::Mutex::new(classifier),
             latest_prediction: parking_lot::Mutex::new(None),
+            latest_scored: parking_lot::Mutex::new(None),
             app_rules: parking_lot::Mutex::new(app_rules),
-            event_rx: parking_lot::Mutex::new(None),
+            app_data_dir,
+            clock,
+            event_rx: parking_lot::Mutex::new(Some(event_rx)),
         }
     }
 
@@ -44,22 +83,71 @@ impl AppState {
         }
     }
 
+    /// Feeds a user label for the current moment into the classifier's
+    /// calibration and on-device model, when a recent prediction is there to
+    /// compare it with, and checkpoints both.
+    pub fn learn_from_label(&self, label: FocusLabel) {
+        let Some((predicted_us, raw_probas, tensor, source)) = *self.latest_scored.lock() else {
+            return;
+        };
+        if self.clock.now_us() - predicted_us > calibration::LABEL_WINDOW_US {
+            return;
+        }
+        let (bins, online) = {
+            let mut classifier = self.classifier.lock();
+            let bins = classifier.observe_label(label, &raw_probas, &tensor, source);
+            (bins, classifier.online_model().clone())
+        };
+        let storage = self.storage.lock();
+        if let Some(bins) = bins {
+            if let Err(err) = storage.save_calibration_bins(source, &bins) {
+                log::warn!("failed to save calibration: {err}");
+            }
+        }
+        if let Err(err) = storage.save_online_model(online.updates(), &online.to_bytes()) {
+            log::warn!("failed to save online model: {err}");
+        }
+    }
+
     pub fn start_engine(&self, app: AppHandle) -> Result<(), String> {
-        let (tx, rx) = std::sync::mpsc::channel();
-        crate::capture::start_capture_thread(tx);
-        *self.event_rx.lock() = Some(rx);
-        *self.capture_running.lock() = true;
+        self.capture.start();
 
-        thread::spawn(move || run_engine_loop(app));
+        let journal_dir = self.app_data_dir.join("journal");
+        let journal = match JournalWriter::spawn(journal_dir, JournalConfig::default()) {
+            Ok(journal) => Some(journal),
+            Err(err) => {
+                log::warn!("event journal disabled: {err}");
+                None
+            }
+        };
+
+        let clock = self.clock.clone();
+        thread::spawn(move || run_engine_loop(app, clock, journal));
         Ok(())
     }
 }
 
-fn run_engine_loop(app: AppHandle) {
-    let mut extractor = FeatureExtractor::new();
-    let mut tracker = ContextTracker::new();
-    let mut last_prediction_at = 0.0_f64;
-    let mut deep_focus_started: Option<std::time::Instant> = None;
+/// Tuned heuristic constants from the app data dir, or the built-in ones.
+fn load_heuristic_params(app_data_dir: &Path) -> HeuristicParams {
+    let path = app_data_dir.join(heuristic_params::PARAMS_FILE);
+    if !path.exists() {
+        return HeuristicParams::default();
+    }
+    match HeuristicParams::load(&path) {
+        Ok(params) => {
+            log::info!("loaded heuristic parameters from {}", path.display());
+            params
+        }
+        Err(err) => {
+            log::warn!("ignoring {}: {err}", path.display());
+            HeuristicParams::default()
+        }
+    }
+}
+
+fn run_engine_loop(app: AppHandle, clock: SharedClock, journal: Option<JournalWriter>) {
+    let mut pipeline = EnginePipeline::new(clock.clone());
+    let mut deep_focus_started_us: Option<i64> = None;
     let mut last_hyperfocus_alert_secs = 0_u64;
 
     loop {
@@ -82,22 +170,17 @@ fn run_engine_loop(app: AppHandle) {
 
         for event in events {
             let app_rules = state.app_rules.lock().clone();
-            tracker.set_app_rules(&app_rules);
-
-            if matches!(
-                event.event_type,
-                EventType::WindowFocusChange | EventType::WindowTitleChange
-            ) {
-                tracker.on_window_change(&event.app_name, &event.window_title);
-            } else {
-                tracker.on_activity();
-            }
 
-            let features = extractor.update(&event, &app_rules);
-            let now = features.timestamp;
-            if now - last_prediction_at >= 1.0 {
+            if let Some(features) = pipeline.observe(&event, &app_rules) {
                 let focus_mode = *state.focus_mode.lock();
-                state.classifier.lock().set_focus_mode(focus_mode);
+                let calibration_source = {
+                    let mut classifier = state.classifier.lock();
+                    classifier.set_focus_mode(focus_mode);
+                    if classifier.sync_calibration() {
+                        log::info!("model or heuristic parameters changed; calibration restarted");
+                    }
+                    classifier.calibrated_for()
+                };
 
                 let active_session = state.storage.lock().get_active_session().ok().flatten();
                 let session_id = active_session
@@ -106,11 +189,12 @@ fn run_engine_loop(app: AppHandle) {
                     .unwrap_or_else(|| "idle".to_string());
                 let session_goal = active_session.as_ref().map(|s| s.goal.as_str());
 
-                let scores = state
-                    .classifier
-                    .lock()
-                    .predict(&features, session_goal, &app_rules);
-                extractor.update_focus_score(scores.focus_score / 100.0, 0.2);
+                let scores = pipeline.score(
+                    &state.classifier.lock(),
+                    &features,
+                    session_goal,
+                    &app_rules,
+                );
 
                 let record = PredictionRecord {
                     session_id: session_id.clone(),
@@ -120,27 +204,35 @@ fn run_engine_loop(app: AppHandle) {
                     thrash_score: scores.thrash_score,
                     drift_score: scores.drift_score,
                     goal_alignment: scores.goal_alignment,
-                    timestamp: chrono::Utc::now().to_rfc3339(),
+                    timestamp_us: features.timestamp_us,
+                    timestamp: String::new(),
+                    smoothed_state: scores.smoothed_state.clone(),
                 };
 
                 if let Err(err) = state.storage.lock().save_prediction(&record) {
                     log::warn!("failed to save prediction: {err}");
                 }
                 *state.latest_prediction.lock() = Some(record.clone());
+                *state.latest_scored.lock() = Some((
+                    features.timestamp_us,
+                    scores.raw_probas,
+                    features.tensor(),
+                    calibration_source,
+                ));
                 let _ = app.emit("prediction", &record);
-                tracker.on_prediction_feedback(&scores.focus_state, session_goal);
-                last_prediction_at = now;
+                if let Some(forecast) = pipeline.take_forecast() {
+                    let _ = app.emit("distraction_forecast", &forecast);
+                }
 
-                if scores.focus_state == "DEEP_FOCUS" {
-                    if deep_focus_started.is_none() {
-                        deep_focus_started = Some(std::time::Instant::now());
-                    }
+                // Smoothed, so a one-second dip doesn't restart the timer.
+                if scores.smoothed_state == "DEEP_FOCUS" {
+                    deep_focus_started_us.get_or_insert_with(|| clock.now_us());
                 } else {
-                    deep_focus_started = None;
+                    deep_focus_started_us = None;
                 }
 
-                if let Some(started) = deep_focus_started {
-                    let deep_secs = started.elapsed().as_secs();
+                if let Some(started) = deep_focus_started_us {
+                    let deep_secs = ((clock.now_us() - started).max(0) / 1_000_000) as u64;
                     if let Some(alert) =
                         check_hyperfocus(focus_mode, deep_secs, last_hyperfocus_alert_secs)
                     {
@@ -149,9 +241,13 @@ fn run_engine_loop(app: AppHandle) {
                     }
                 }
             }
+
+            if let Some(journal) = journal.as_ref() {
+                journal.append(event);
+            }
         }
 
-        if let Some(snapback) = tracker.take_pending_snapback() {
+        if let Some(snapback) = pipeline.take_pending_snapback() {
             let session_id = state
                 .storage
                 .lock()
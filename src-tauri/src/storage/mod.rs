@@ -1,12 +1,14 @@
 use std::path::PathBuf;
 
-use rusqlite::{params, Connection};
+use rusqlite::{params, Connection, OptionalExtension};
 use thiserror::Error;
 use uuid::Uuid;
 
+use crate::clock::{format_rfc3339, system_clock, SharedClock};
+
 use crate::types::{
-    AppRuleKind, AppRuleRecord, ContextSnapshotDto, FocusLabel, PredictionRecord, SessionRecap,
-    SessionRecord,
+    AppRuleKind, AppRuleRecord, CalibrationBin, ContextSnapshotDto, FocusLabel, PredictionRecord,
+    SessionRecap, SessionRecord,
 };
 
 #[derive(Debug, Error)]
@@ -23,18 +25,32 @@ pub enum StorageError {
 
 pub struct Storage {
     conn: Connection,
+    clock: SharedClock,
 }
 
 impl Storage {
     pub fn open(app_data_dir: PathBuf) -> Result<Self, StorageError> {
+        Self::open_with_clock(app_data_dir, system_clock())
+    }
+
+    pub fn open_with_clock(
+        app_data_dir: PathBuf,
+        clock: SharedClock,
+    ) -> Result<Self, StorageError> {
         std::fs::create_dir_all(&app_data_dir).ok();
         let db_path = app_data_dir.join("focoflow.db");
         let conn = Connection::open(db_path)?;
-        let storage = Self { conn };
+        let storage = Self { conn, clock };
         storage.init_schema()?;
+        storage.migrate_prediction_timestamps()?;
+        storage.migrate_calibration_source()?;
         Ok(storage)
     }
 
+    fn now_rfc3339(&self) -> String {
+        format_rfc3339(self.clock.now_us())
+    }
+
     fn init_schema(&self) -> Result<(), StorageError> {
         self.conn.execute_batch(
             "
@@ -53,6 +69,7 @@ impl Storage {
                 focus_score REAL NOT NULL,
                 distraction_risk REAL NOT NULL,
                 focus_state TEXT NOT NULL,
+                ts_us INTEGER,
                 timestamp TEXT NOT NULL,
                 FOREIGN KEY (session_id) REFERENCES sessions(session_id)
             );
@@ -80,6 +97,23 @@ impl Storage {
                 timestamp TEXT NOT NULL
             );
 
+            CREATE TABLE IF NOT EXISTS calibration_bins (
+                class_index INTEGER NOT NULL,
+                bin INTEGER NOT NULL,
+                count REAL NOT NULL,
+                hits REAL NOT NULL,
+                updated_at TEXT NOT NULL,
+                source INTEGER NOT NULL DEFAULT 0,
+                PRIMARY KEY (class_index, bin)
+            );
+
+            CREATE TABLE IF NOT EXISTS online_model (
+                id INTEGER PRIMARY KEY CHECK (id = 1),
+                updates INTEGER NOT NULL,
+                state BLOB NOT NULL,
+                updated_at TEXT NOT NULL
+            );
+
             CREATE TABLE IF NOT EXISTS snapback_events (
                 id INTEGER PRIMARY KEY AUTOINCREMENT,
                 session_id TEXT NOT NULL,
@@ -103,6 +137,45 @@ impl Storage {
         Ok(())
     }
 
+    /// Databases created before `ts_us` existed get the column, backfilled from
+    /// the RFC 3339 text (to within a few microseconds), plus its indexes.
+    fn migrate_prediction_timestamps(&self) -> Result<(), StorageError> {
+        let has_ts_us: i64 = self.conn.query_row(
+            "SELECT COUNT(*) FROM pragma_table_info('predictions') WHERE name = 'ts_us'",
+            [],
+            |row| row.get(0),
+        )?;
+        if has_ts_us == 0 {
+            self.conn.execute_batch(
+                "ALTER TABLE predictions ADD COLUMN ts_us INTEGER;
+                 UPDATE predictions
+                    SET ts_us = CAST(ROUND((julianday(timestamp) - 2440587.5) * 86400000000.0) AS INTEGER);",
+            )?;
+        }
+        self.conn.execute_batch(
+            "CREATE INDEX IF NOT EXISTS idx_predictions_ts_us ON predictions(ts_us DESC);
+             CREATE INDEX IF NOT EXISTS idx_predictions_session_ts_us
+                ON predictions(session_id, ts_us DESC);",
+        )?;
+        Ok(())
+    }
+
+    /// Bins saved before they recorded their source get source 0, which no
+    /// classifier reports, so they are never loaded.
+    fn migrate_calibration_source(&self) -> Result<(), StorageError> {
+        let has_source: i64 = self.conn.query_row(
+            "SELECT COUNT(*) FROM pragma_table_info('calibration_bins') WHERE name = 'source'",
+            [],
+            |row| row.get(0),
+        )?;
+        if has_source == 0 {
+            self.conn.execute_batch(
+                "ALTER TABLE calibration_bins ADD COLUMN source INTEGER NOT NULL DEFAULT 0;",
+            )?;
+        }
+        Ok(())
+    }
+
     fn normalize_app_rule_pattern(pattern: &str) -> Result<String, StorageError> {
         let normalized = pattern.trim().to_lowercase();
         if normalized.is_empty() {
@@ -149,7 +222,7 @@ impl Storage {
         note: Option<&str>,
     ) -> Result<AppRuleRecord, StorageError> {
         let pattern = Self::normalize_app_rule_pattern(pattern)?;
-        let now = chrono::Utc::now().to_rfc3339();
+        let now = self.now_rfc3339();
 
         self.conn.execute(
             "INSERT INTO app_rules (pattern, rule_type, note, created_at, updated_at)
@@ -210,7 +283,7 @@ impl Storage {
         focus_mode: &str,
     ) -> Result<SessionRecord, StorageError> {
         let session_id = Uuid::new_v4().to_string();
-        let started_at = chrono::Utc::now().to_rfc3339();
+        let started_at = self.now_rfc3339();
         self.conn.execute(
             "INSERT INTO sessions (session_id, goal, status, focus_mode, started_at) VALUES (?1, ?2, 'ACTIVE', ?3, ?4)",
             params![session_id, goal, focus_mode, started_at],
@@ -232,7 +305,7 @@ impl Storage {
             }
         }
 
-        let ended_at = chrono::Utc::now().to_rfc3339();
+        let ended_at = self.now_rfc3339();
         let updated = self.conn.execute(
             "UPDATE sessions SET status = 'COMPLETED', ended_at = ?1 WHERE session_id = ?2 AND status = 'ACTIVE'",
             params![ended_at, session_id],
@@ -279,23 +352,27 @@ impl Storage {
         }
     }
 
+    /// Called once a second. SQLite renders the timestamp text from `ts_us`, so
+    /// the engine never formats dates on this path.
     pub fn save_prediction(&self, record: &PredictionRecord) -> Result<(), StorageError> {
-        self.conn.execute(
-            "INSERT INTO predictions (session_id, focus_score, distraction_risk, focus_state, timestamp) VALUES (?1, ?2, ?3, ?4, ?5)",
-            params![
+        self.conn
+            .prepare_cached(
+                "INSERT INTO predictions (session_id, focus_score, distraction_risk, focus_state, ts_us, timestamp)
+                 VALUES (?1, ?2, ?3, ?4, ?5, strftime('%Y-%m-%dT%H:%M:%fZ', ?5 / 1000000.0, 'unixepoch'))",
+            )?
+            .execute(params![
                 record.session_id,
                 record.focus_score,
                 record.distraction_risk,
                 record.focus_state,
-                record.timestamp,
-            ],
-        )?;
+                record.timestamp_us,
+            ])?;
         Ok(())
     }
 
     pub fn latest_prediction(&self) -> Result<Option<PredictionRecord>, StorageError> {
         let mut stmt = self.conn.prepare(
-            "SELECT session_id, focus_score, distraction_risk, focus_state, timestamp FROM predictions ORDER BY timestamp DESC LIMIT 1",
+            "SELECT session_id, focus_score, distraction_risk, focus_state, ts_us, timestamp FROM predictions ORDER BY ts_us DESC LIMIT 1",
         )?;
         let mut rows = stmt.query([])?;
         if let Some(row) = rows.next()? {
@@ -307,7 +384,9 @@ impl Storage {
                 thrash_score: 0.0,
                 drift_score: 0.0,
                 goal_alignment: 0.5,
-                timestamp: row.get(4)?,
+                timestamp_us: row.get(4)?,
+                timestamp: row.get(5)?,
+                smoothed_state: String::new(),
             }))
         } else {
             Ok(None)
@@ -316,7 +395,7 @@ impl Storage {
 
     pub fn recent_predictions(&self, limit: usize) -> Result<Vec<PredictionRecord>, StorageError> {
         let mut stmt = self.conn.prepare(
-            "SELECT session_id, focus_score, distraction_risk, focus_state, timestamp FROM predictions ORDER BY timestamp DESC LIMIT ?1",
+            "SELECT session_id, focus_score, distraction_risk, focus_state, ts_us, timestamp FROM predictions ORDER BY ts_us DESC LIMIT ?1",
         )?;
         let rows = stmt.query_map(params![limit as i64], |row| {
             Ok(PredictionRecord {
@@ -327,7 +406,9 @@ impl Storage {
                 thrash_score: 0.0,
                 drift_score: 0.0,
                 goal_alignment: 0.5,
-                timestamp: row.get(4)?,
+                timestamp_us: row.get(4)?,
+                timestamp: row.get(5)?,
+                smoothed_state: String::new(),
             })
         })?;
         Ok(rows.filter_map(Result::ok).collect())
@@ -359,7 +440,7 @@ impl Storage {
         label: FocusLabel,
         notes: Option<&str>,
     ) -> Result<(), StorageError> {
-        let timestamp = chrono::Utc::now().to_rfc3339();
+        let timestamp = self.now_rfc3339();
         self.conn.execute(
             "INSERT INTO labels (session_id, label, source, notes, timestamp) VALUES (?1, ?2, 'manual', ?3, ?4)",
             params![session_id, label as i32, notes, timestamp],
@@ -367,8 +448,88 @@ impl Storage {
         Ok(())
     }
 
+    /// Stores the bins a label changed, learned under calibration source
+    /// `source` (`Classifier::calibration_source`); one row per bin, so each
+    /// label writes a fixed handful of rows however many came before it.
+    /// Bins of any other source are dropped.
+    pub fn save_calibration_bins(
+        &self,
+        source: u64,
+        bins: &[CalibrationBin],
+    ) -> Result<(), StorageError> {
+        let now = self.now_rfc3339();
+        // Stored as the same 64 bits, read back the same way.
+        let source = source as i64;
+        self.conn
+            .prepare_cached("DELETE FROM calibration_bins WHERE source != ?1")?
+            .execute(params![source])?;
+        let mut stmt = self.conn.prepare_cached(
+            "INSERT INTO calibration_bins (class_index, bin, count, hits, updated_at, source)
+             VALUES (?1, ?2, ?3, ?4, ?5, ?6)
+             ON CONFLICT(class_index, bin) DO UPDATE SET
+                count = excluded.count,
+                hits = excluded.hits,
+                updated_at = excluded.updated_at,
+                source = excluded.source",
+        )?;
+        for bin in bins {
+            stmt.execute(params![
+                bin.class_index as i64,
+                bin.bin as i64,
+                bin.count,
+                bin.hits,
+                now,
+                source
+            ])?;
+        }
+        Ok(())
+    }
+
+    /// Bins learned under calibration source `source`.
+    pub fn calibration_bins(&self, source: u64) -> Result<Vec<CalibrationBin>, StorageError> {
+        let mut stmt = self.conn.prepare(
+            "SELECT class_index, bin, count, hits FROM calibration_bins WHERE source = ?1",
+        )?;
+        let rows = stmt.query_map(params![source as i64], |row| {
+            let class_index: i64 = row.get(0)?;
+            let bin: i64 = row.get(1)?;
+            Ok(CalibrationBin {
+                class_index: class_index as usize,
+                bin: bin as usize,
+                count: row.get(2)?,
+                hits: row.get(3)?,
+            })
+        })?;
+        Ok(rows.filter_map(Result::ok).collect())
+    }
+
+    /// Replaces the checkpoint of the on-device model (a single row).
+    pub fn save_online_model(&self, updates: u64, state: &[u8]) -> Result<(), StorageError> {
+        let now = self.now_rfc3339();
+        self.conn
+            .prepare_cached(
+                "INSERT INTO online_model (id, updates, state, updated_at)
+                 VALUES (1, ?1, ?2, ?3)
+                 ON CONFLICT(id) DO UPDATE SET
+                    updates = excluded.updates,
+                    state = excluded.state,
+                    updated_at = excluded.updated_at",
+            )?
+            .execute(params![updates as i64, state, now])?;
+        Ok(())
+    }
+
+    pub fn online_model_state(&self) -> Result<Option<Vec<u8>>, StorageError> {
+        Ok(self
+            .conn
+            .query_row("SELECT state FROM online_model WHERE id = 1", [], |row| {
+                row.get(0)
+            })
+            .optional()?)
+    }
+
     pub fn record_snapback(&self, session_id: &str, summary: &str) -> Result<(), StorageError> {
-        let timestamp = chrono::Utc::now().to_rfc3339();
+        let timestamp = self.now_rfc3339();
         self.conn.execute(
             "INSERT INTO snapback_events (session_id, summary, timestamp) VALUES (?1, ?2, ?3)",
             params![session_id, summary, timestamp],
@@ -388,7 +549,9 @@ impl Storage {
             .as_deref()
             .and_then(|s| chrono::DateTime::parse_from_rfc3339(s).ok())
             .map(|d| d.with_timezone(&chrono::Utc))
-            .unwrap_or_else(chrono::Utc::now);
+            .unwrap_or_else(|| {
+                chrono::DateTime::from_timestamp_micros(self.clock.now_us()).unwrap_or_default()
+            });
         let duration_secs = started
             .map(|s| (ended - s).num_seconds().max(0) as u64)
             .unwrap_or(0);
@@ -440,6 +603,49 @@ mod tests {
         assert_eq!(stopped.status, "COMPLETED");
     }
 
+    #[test]
+    fn calibration_bins_upsert_in_place() {
+        let dir = std::env::temp_dir().join(format!("focoflow_test_{}", Uuid::new_v4()));
+        let storage = Storage::open(dir).unwrap();
+        let bin = |count: f64, hits: f64| CalibrationBin {
+            class_index: 2,
+            bin: 5,
+            count,
+            hits,
+        };
+        storage.save_calibration_bins(7, &[bin(1.0, 0.0)]).unwrap();
+        storage.save_calibration_bins(7, &[bin(2.0, 1.0)]).unwrap();
+        assert_eq!(storage.calibration_bins(7).unwrap(), vec![bin(2.0, 1.0)]);
+    }
+
+    #[test]
+    fn calibration_bins_belong_to_one_source() {
+        let dir = std::env::temp_dir().join(format!("focoflow_test_{}", Uuid::new_v4()));
+        let storage = Storage::open(dir).unwrap();
+        let bin = |class_index: usize| CalibrationBin {
+            class_index,
+            bin: 5,
+            count: 1.0,
+            hits: 1.0,
+        };
+        storage.save_calibration_bins(u64::MAX, &[bin(0)]).unwrap();
+        assert_eq!(storage.calibration_bins(u64::MAX).unwrap(), vec![bin(0)]);
+        assert!(storage.calibration_bins(1).unwrap().is_empty());
+        storage.save_calibration_bins(1, &[bin(1)]).unwrap();
+        assert_eq!(storage.calibration_bins(1).unwrap(), vec![bin(1)]);
+        assert!(storage.calibration_bins(u64::MAX).unwrap().is_empty());
+    }
+
+    #[test]
+    fn online_model_checkpoint_is_replaced() {
+        let dir = std::env::temp_dir().join(format!("focoflow_test_{}", Uuid::new_v4()));
+        let storage = Storage::open(dir).unwrap();
+        assert_eq!(storage.online_model_state().unwrap(), None);
+        storage.save_online_model(1, &[1, 2, 3]).unwrap();
+        storage.save_online_model(2, &[4, 5]).unwrap();
+        assert_eq!(storage.online_model_state().unwrap(), Some(vec![4, 5]));
+    }
+
     #[test]
     fn app_rules_crud() {
         let dir = std::env::temp_dir().join(format!("focoflow_test_{}", Uuid::new_v4()));
@@ -475,4 +681,54 @@ mod tests {
             .unwrap_err();
         assert!(matches!(err, StorageError::InvalidAppRule(_)));
     }
+
+    #[test]
+    fn predictions_order_by_clock_and_render_timestamp_in_sql() {
+        let dir = std::env::temp_dir().join(format!("focoflow_test_{}", Uuid::new_v4()));
+        let storage = Storage::open(dir).unwrap();
+        let record = |ts_us: i64| PredictionRecord {
+            session_id: "idle".to_string(),
+            focus_score: 50.0,
+            distraction_risk: 0.3,
+            focus_state: "PRODUCTIVE".to_string(),
+            thrash_score: 0.0,
+            drift_score: 0.0,
+            goal_alignment: 0.5,
+            timestamp_us: ts_us,
+            timestamp: String::new(),
+            smoothed_state: String::new(),
+        };
+        storage.save_prediction(&record(1_700_000_002_500_000)).unwrap();
+        storage.save_prediction(&record(1_700_000_001_000_000)).unwrap();
+
+        let latest = storage.latest_prediction().unwrap().unwrap();
+        assert_eq!(latest.timestamp_us, 1_700_000_002_500_000);
+        assert_eq!(latest.timestamp, "2023-11-14T22:13:22.500Z");
+    }
+
+    #[test]
+    fn legacy_predictions_are_backfilled_with_ts_us() {
+        let dir = std::env::temp_dir().join(format!("focoflow_test_{}", Uuid::new_v4()));
+        std::fs::create_dir_all(&dir).unwrap();
+        {
+            let conn = Connection::open(dir.join("focoflow.db")).unwrap();
+            conn.execute_batch(
+                "CREATE TABLE predictions (
+                    id INTEGER PRIMARY KEY AUTOINCREMENT,
+                    session_id TEXT NOT NULL,
+                    focus_score REAL NOT NULL,
+                    distraction_risk REAL NOT NULL,
+                    focus_state TEXT NOT NULL,
+                    timestamp TEXT NOT NULL
+                );
+                INSERT INTO predictions (session_id, focus_score, distraction_risk, focus_state, timestamp)
+                VALUES ('idle', 40.0, 0.5, 'DISTRACTED', '2023-11-14T22:13:20+00:00');",
+            )
+            .unwrap();
+        }
+
+        let storage = Storage::open(dir).unwrap();
+        let latest = storage.latest_prediction().unwrap().unwrap();
+        assert!((latest.timestamp_us - 1_700_000_000_000_000).abs() < 100);
+    }
 }
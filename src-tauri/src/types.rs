@@ -13,16 +13,36 @@ pub enum EventType {
     IdleEnd = 8,
 }
 
+impl EventType {
+    pub fn from_u8(value: u8) -> Option<Self> {
+        Some(match value {
+            1 => Self::KeyPress,
+            2 => Self::KeyRelease,
+            3 => Self::MouseMove,
+            4 => Self::MouseClick,
+            5 => Self::WindowFocusChange,
+            6 => Self::WindowTitleChange,
+            7 => Self::IdleStart,
+            8 => Self::IdleEnd,
+            _ => return None,
+        })
+    }
+}
+
 #[derive(Debug, Clone, Serialize, Deserialize)]
 pub struct CaptureEvent {
     pub event_type: EventType,
-    pub timestamp_secs: f64,
+    /// Microseconds since the Unix epoch, from the engine `Clock`.
+    pub timestamp_us: i64,
     pub app_name: String,
     pub window_title: String,
     pub mouse_x: i32,
     pub mouse_y: i32,
     pub mouse_speed: u32,
     pub idle_duration_ms: u32,
+    /// Raw title rewrites folded into this window event by capture debouncing.
+    #[serde(default)]
+    pub title_churn: u32,
 }
 
 #[derive(Debug, Clone, Serialize, Deserialize)]
@@ -38,7 +58,17 @@ pub struct PredictionRecord {
     pub drift_score: f64,
     #[serde(default = "default_goal_alignment")]
     pub goal_alignment: f64,
+    /// Microseconds since the Unix epoch; the source of truth for ordering.
+    #[serde(default)]
+    pub timestamp_us: i64,
+    /// RFC 3339 text, filled in when read back from storage. Live records
+    /// leave it empty and clients format `timestamp_us`.
+    #[serde(default)]
     pub timestamp: String,
+    /// `focus_state` after temporal smoothing. Not stored: records read back
+    /// from storage leave it empty.
+    #[serde(default)]
+    pub smoothed_state: String,
 }
 
 fn default_goal_alignment() -> f64 {
@@ -106,6 +136,15 @@ pub enum FocusLabel {
     DeepFocus = 2,
 }
 
+/// One reliability bin of `engine::calibration::Calibration`.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct CalibrationBin {
+    pub class_index: usize,
+    pub bin: usize,
+    pub count: f64,
+    pub hits: f64,
+}
+
 #[derive(Debug, Clone, Serialize, Deserialize)]
 #[serde(rename_all = "camelCase")]
 pub struct LabelRequest {
@@ -139,14 +178,6 @@ impl FocusMode {
         }
     }
 
-    pub fn risk_threshold(self) -> f64 {
-        match self {
-            Self::Deep => 0.55,
-            Self::Normal => 0.7,
-            Self::Recovery => 0.85,
-        }
-    }
-
     pub fn hyperfocus_minutes(self) -> u32 {
         match self {
             Self::Deep => 90,
@@ -161,9 +192,33 @@ impl FocusMode {
 pub struct HealthStatus {
     pub status: String,
     pub capture_running: bool,
+    pub capture: CaptureHealth,
     pub permissions: PermissionStatus,
 }
 
+/// Liveness and throughput of one capture source (window poller or input hook).
+#[derive(Debug, Clone, Serialize, Deserialize)]
+#[serde(rename_all = "camelCase")]
+pub struct CaptureSourceHealth {
+    pub source: String,
+    /// False once the source thread has exited; the supervisor will restart it.
+    pub alive: bool,
+    pub events_total: u64,
+    pub events_per_sec: f64,
+    pub last_event_age_ms: Option<u64>,
+    pub last_heartbeat_age_ms: Option<u64>,
+    pub restarts: u32,
+    pub last_error: Option<String>,
+}
+
+#[derive(Debug, Clone, Serialize, Deserialize)]
+#[serde(rename_all = "camelCase")]
+pub struct CaptureHealth {
+    pub running: bool,
+    pub paused: bool,
+    pub sources: Vec<CaptureSourceHealth>,
+}
+
 /// User override: treat apps/titles matching `pattern` as on-task or distracting.
 #[derive(Debug, Clone, Copy, PartialEq, Eq, Serialize, Deserialize)]
 #[serde(rename_all = "lowercase")]